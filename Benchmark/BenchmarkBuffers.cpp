@@ -0,0 +1,68 @@
+//
+// Created: 10/18/26 by agent
+//
+// Benchmarks for the AudioBuffer and OverlapAddBuffer classes.
+//
+
+// In module includes
+#include "AudioBuffer.h"
+#include "OverlapAddBuffer.h"
+#include "BenchmarkUtils.h"
+
+// Thirdparty includes
+#include "benchmark/benchmark.h"
+
+// Std Lib includes
+#include <vector>
+
+using namespace cupcake;
+
+static void BM_AudioBufferPushPop( benchmark::State& state )
+///
+/// Pushes a chunk of samples into an AudioBuffer and pops them again, as the STFT input does for
+/// every call.
+///
+/// Args: chunk size.
+///
+{
+    const size_t chunk_size = static_cast< size_t >( state.range( 0 ) );
+    const std::vector< float > input = make_noise( chunk_size );
+    AudioBuffer< float > buffer( 44100*10 );
+
+    for( auto _ : state )
+    {
+        buffer.PushSamples( input );
+        benchmark::DoNotOptimize( buffer.Data() );
+        buffer.PopFront( chunk_size );
+    }
+
+    set_throughput_counters( state, chunk_size );
+}
+BENCHMARK( BM_AudioBufferPushPop )->RangeMultiplier( 4 )->Range( 64, 16384 );
+
+static void BM_OverlapAddBuffer( benchmark::State& state )
+///
+/// Overlap-adds a frame, reads the completed hop of samples and pops it, as the STFT synthesis
+/// does for every frame.
+///
+/// Args: frame size, hop size.
+///
+{
+    const size_t frame_size = static_cast< size_t >( state.range( 0 ) );
+    const size_t hop = static_cast< size_t >( state.range( 1 ) );
+    const std::vector< float > frame = make_noise( frame_size );
+    std::vector< float > output( hop );
+    OverlapAddBuffer< float > buffer( frame_size*4 );
+
+    for( auto _ : state )
+    {
+        buffer.PushSamples( frame );
+        buffer.IncrementWritePosition( hop );
+        buffer.Read( output );
+        buffer.PopFront( hop );
+        benchmark::DoNotOptimize( output.data() );
+    }
+
+    set_throughput_counters( state, hop );
+}
+BENCHMARK( BM_OverlapAddBuffer )->ArgsProduct( { { 512, 2048, 8192 }, { 64, 256 } } );
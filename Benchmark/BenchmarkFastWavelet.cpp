@@ -0,0 +1,376 @@
+//
+// Created: 10/18/26 by agent
+//
+// Benchmarks for the complete FastWavelet transform.
+//
+
+// In module includes
+#include "FastWavelet.h"
+#include "MultiResolutionFastWavelet.h"
+#include "ExactCQT.h"
+#include "BinRangeAnalyser.h"
+#include "ProcessingChain.h"
+#include "StreamEngine.h"
+#include "StreamingPipeline.h"
+#include "BenchmarkUtils.h"
+
+// Thirdparty includes
+#include "benchmark/benchmark.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+using namespace cupcake;
+
+template< size_t FFT_SIZE >
+static void BM_FastWaveletPushSamples( benchmark::State& state )
+///
+/// Streams chunks of samples through FastWavelet::PushSamples, with a window half the FFT size.
+///
+/// Args: hops per window, chunk size.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t hops_per_window = static_cast< size_t >( state.range( 0 ) );
+    const size_t chunk_size = static_cast< size_t >( state.range( 1 ) );
+    const std::vector< float > input = make_noise( chunk_size );
+    FastWavelet< FFT_SIZE > transform( 1.0f - 1.0f/hops_per_window, make_window( win_len ) );
+
+    for( auto _ : state )
+    {
+        auto& frames = transform.PushSamples( input );
+        benchmark::DoNotOptimize( frames.data() );
+    }
+
+    set_throughput_counters( state, chunk_size );
+}
+BENCHMARK_TEMPLATE( BM_FastWaveletPushSamples, 1024 )->ArgsProduct( { { 2, 4, 8 }, { 64, 512, 4096 } } );
+BENCHMARK_TEMPLATE( BM_FastWaveletPushSamples, 4096 )->ArgsProduct( { { 2, 4, 8 }, { 64, 512, 4096 } } );
+BENCHMARK_TEMPLATE( BM_FastWaveletPushSamples, 16384 )->ArgsProduct( { { 2, 4, 8 }, { 512, 4096 } } );
+
+template< size_t FFT_SIZE >
+static void BM_FastWaveletCallJitter( benchmark::State& state )
+///
+/// Streams ten seconds of audio through FastWavelet::PushSamples in chunks the size of an audio
+/// callback, with a window half the FFT size and four hops per window, and reports the percentiles
+/// of the time taken by each call. Calls that complete no frame are much quicker than those that
+/// do, so the high percentiles, rather than the mean, set the real-time budget. The algorithmic
+/// latency and the largest number of samples left buffered after a call are reported alongside.
+///
+/// Args: chunk size.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t chunk_size = static_cast< size_t >( state.range( 0 ) );
+    const size_t stream_length = 10*static_cast< size_t >( BENCHMARK_SAMPLE_RATE );
+    const std::vector< float > input = make_noise( stream_length );
+    FastWavelet< FFT_SIZE > transform( 0.75f, make_window( win_len ) );
+
+    std::vector< double > call_times;
+    call_times.reserve( ( stream_length/chunk_size + 1 )*16 );
+    size_t max_buffered = 0;
+    for( auto _ : state )
+    {
+        for( size_t pos=0; pos+chunk_size<=stream_length; pos+=chunk_size )
+        {
+            time_call( call_times, [&]()
+            {
+                auto& frames = transform.PushSamples( ArrayView< const float >( input.data() + pos, chunk_size ) );
+                benchmark::DoNotOptimize( frames.data() );
+            });
+            max_buffered = std::max( max_buffered, transform.GetBufferedSamples() );
+        }
+    }
+
+    set_throughput_counters( state, stream_length - stream_length%chunk_size );
+    set_percentile_counters( state, call_times );
+    state.counters["latency_samples"] = transform.GetAlgorithmicLatency();
+    state.counters["max_buffered_samples"] = max_buffered;
+}
+BENCHMARK_TEMPLATE( BM_FastWaveletCallJitter, 2048 )->Arg( 64 )->Arg( 128 )->Arg( 256 )->Arg( 512 )->Arg( 1024 );
+
+template< size_t FFT_SIZE >
+static void BM_MultiResolutionPushSamples( benchmark::State& state )
+///
+/// Streams chunks of 4096 samples through MultiResolutionFastWavelet::PushSamples, with a window half
+/// the FFT size and four hops per window. The lowest octave has the bin spacing of the FastWavelet
+/// benchmark above with an FFT 2^( octaves - 1 ) times larger.
+///
+/// Args: number of octaves.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t num_octaves = static_cast< size_t >( state.range( 0 ) );
+    const size_t chunk_size = 4096;
+    const std::vector< float > input = make_noise( chunk_size );
+    MultiResolutionFastWavelet< FFT_SIZE > transform( num_octaves, 0.75f, make_window( win_len ) );
+
+    for( auto _ : state )
+    {
+        auto& frames = transform.PushSamples( input.data(), input.size() );
+        benchmark::DoNotOptimize( frames.values.data() );
+    }
+
+    set_throughput_counters( state, chunk_size );
+}
+BENCHMARK_TEMPLATE( BM_MultiResolutionPushSamples, 1024 )->Arg( 1 )->Arg( 3 )->Arg( 5 );
+BENCHMARK_TEMPLATE( BM_MultiResolutionPushSamples, 4096 )->Arg( 1 )->Arg( 3 );
+
+template< size_t FFT_SIZE >
+static void BM_ExactCQTPushSamples( benchmark::State& state )
+///
+/// Streams chunks of 4096 samples through FastWavelet::PushSamplesExact, with a window half the FFT
+/// size and four hops per window, for comparison with BM_FastWaveletPushSamples. The lowest bin has
+/// the longest temporal kernel that fits in the window, and the kernel has the default threshold.
+///
+/// Args: bins per octave.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t bins_per_octave = static_cast< size_t >( state.range( 0 ) );
+    const size_t chunk_size = 4096;
+    const std::vector< float > input = make_noise( chunk_size );
+    FastWavelet< FFT_SIZE > transform( 0.75f, make_window( win_len ) );
+
+    const double Q = 1.0/( std::pow( 2.0, 1.0/bins_per_octave ) - 1.0 );
+    const float min_frequency = static_cast< float >( 1.01*Q*BENCHMARK_SAMPLE_RATE/win_len );
+    transform.ConfigureExact( BENCHMARK_SAMPLE_RATE, min_frequency, bins_per_octave, 0, ExactCQT< FFT_SIZE >::DEFAULT_THRESHOLD );
+
+    for( auto _ : state )
+    {
+        auto& frames = transform.PushSamplesExact( input );
+        benchmark::DoNotOptimize( frames.values.data() );
+    }
+
+    set_throughput_counters( state, chunk_size );
+}
+BENCHMARK_TEMPLATE( BM_ExactCQTPushSamples, 4096 )->Arg( 12 )->Arg( 24 )->Arg( 48 );
+
+template< size_t FFT_SIZE >
+static void BM_FastWaveletPushSamplesBinRange( benchmark::State& state )
+///
+/// Streams chunks of 4096 samples through FastWavelet::PushSamplesBinRange, with a window half the
+/// FFT size and four hops per window, keeping the bins from 30 Hz up to a maximum frequency at the
+/// default tolerance, for comparison with PushSamples.
+///
+/// Args: maximum frequency in Hz, or 0 for PushSamples, and the BinRangeMethod.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const double max_frequency = static_cast< double >( state.range( 0 ) );
+    const BinRangeMethod method = static_cast< BinRangeMethod >( state.range( 1 ) );
+    const size_t chunk_size = 4096;
+    const std::vector< float > input = make_noise( chunk_size );
+    FastWavelet< FFT_SIZE > transform( 0.75f, make_window( win_len ) );
+
+    const size_t min_bin = static_cast< size_t >( 30.0*FFT_SIZE/BENCHMARK_SAMPLE_RATE );
+    const size_t max_bin = static_cast< size_t >( std::ceil( max_frequency*FFT_SIZE/BENCHMARK_SAMPLE_RATE ) );
+    if( max_frequency > 0.0 )
+    {
+        transform.ConfigureBinRange( min_bin, max_bin, BinRangeAnalyser< FFT_SIZE >::DEFAULT_TOLERANCE, method );
+    }
+
+    for( auto _ : state )
+    {
+        if( max_frequency > 0.0 )
+        {
+            auto& frames = transform.PushSamplesBinRange( input );
+            benchmark::DoNotOptimize( frames.values.data() );
+        }
+        else
+        {
+            auto& frames = transform.PushSamples( input );
+            benchmark::DoNotOptimize( frames.data() );
+        }
+    }
+
+    set_throughput_counters( state, chunk_size );
+    state.counters["bins"] = max_frequency > 0.0 ? max_bin + 1 - min_bin : FastWavelet< FFT_SIZE >::mOutputSize;
+}
+BENCHMARK_TEMPLATE( BM_FastWaveletPushSamplesBinRange, 4096 )->Args( { 0, 0 } )
+                                                            ->Args( { 8000, BIN_RANGE_FFT } )
+                                                            ->Args( { 2000, BIN_RANGE_FFT } )
+                                                            ->Args( { 60, BIN_RANGE_FFT } )
+                                                            ->Args( { 60, BIN_RANGE_PRUNED_DFT } );
+
+template< size_t FFT_SIZE >
+static void BM_FastWaveletTransformBatch( benchmark::State& state )
+///
+/// Transforms a batch of one second clips with FastWavelet::TransformBatch, with a window half the
+/// FFT size and four hops per window.
+///
+/// Args: number of clips.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t num_clips = static_cast< size_t >( state.range( 0 ) );
+    const size_t clip_length = static_cast< size_t >( BENCHMARK_SAMPLE_RATE );
+    const std::vector< float > clips = make_noise( num_clips*clip_length );
+    FastWavelet< FFT_SIZE > transform( 0.75f, make_window( win_len ) );
+
+    const size_t num_frames = transform.GetNumFrames( clip_length );
+    std::vector< std::complex< float > > output( num_clips*num_frames*FastWavelet< FFT_SIZE >::mOutputSize );
+
+    for( auto _ : state )
+    {
+        transform.TransformBatch( clips.data(), num_clips, clip_length, nullptr, output.data(), num_frames );
+        benchmark::DoNotOptimize( output.data() );
+    }
+
+    set_throughput_counters( state, num_clips*clip_length );
+}
+BENCHMARK_TEMPLATE( BM_FastWaveletTransformBatch, 4096 )->Arg( 1 )->Arg( 16 )->UseRealTime();
+
+template< size_t FFT_SIZE >
+static void BM_FastWaveletPushSamplesParallel( benchmark::State& state )
+///
+/// Pushes twenty seconds of audio in a single call, with a window half the FFT size and four hops
+/// per window, either with FastWavelet::PushSamples or spread over a number of threads with
+/// FastWavelet::PushSamplesParallel.
+///
+/// Args: number of threads, or 0 for PushSamples.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t num_threads = static_cast< size_t >( state.range( 0 ) );
+    const size_t stream_length = 20*static_cast< size_t >( BENCHMARK_SAMPLE_RATE );
+    const std::vector< float > input = make_noise( stream_length );
+    FastWavelet< FFT_SIZE > transform( 0.75f, make_window( win_len ) );
+    if( num_threads )
+    {
+        transform.ConfigureParallel( num_threads );
+    }
+
+    for( auto _ : state )
+    {
+        auto& frames = num_threads ? transform.PushSamplesParallel( input ) : transform.PushSamples( input );
+        benchmark::DoNotOptimize( frames.data() );
+    }
+
+    set_throughput_counters( state, stream_length );
+}
+BENCHMARK_TEMPLATE( BM_FastWaveletPushSamplesParallel, 4096 )->Arg( 0 )->Arg( 1 )->Arg( 2 )->Arg( 4 )->Arg( 8 )->Arg( 16 )->Arg( 32 )->UseRealTime();
+
+template< size_t FFT_SIZE >
+static void BM_FastWaveletChain( benchmark::State& state )
+///
+/// Runs the fused window, FFT and fast CQT chain over every frame of a one second clip, with a
+/// window half the FFT size and four hops per window. This is the same work as a single push of
+/// the clip through FastWavelet, without the input buffering.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t increment = win_len/4;
+    const size_t clip_length = static_cast< size_t >( BENCHMARK_SAMPLE_RATE );
+    const std::vector< float > clip = make_noise( clip_length );
+    FastWaveletChain< FFT_SIZE > chain{ WindowStage< FFT_SIZE >( make_window( win_len ) ), FFTStage< FFT_SIZE >(), FastCQTStage< FFT_SIZE >( win_len ) };
+
+    const size_t num_frames = ( clip_length - win_len )/increment + 1;
+    std::vector< typename FastWaveletChain< FFT_SIZE >::Output > output( num_frames );
+
+    for( auto _ : state )
+    {
+        chain.ProcessFrames( clip.data(), num_frames, increment, output.data() );
+        benchmark::DoNotOptimize( output.data() );
+    }
+
+    set_throughput_counters( state, clip_length );
+}
+BENCHMARK_TEMPLATE( BM_FastWaveletChain, 1024 );
+BENCHMARK_TEMPLATE( BM_FastWaveletChain, 4096 );
+
+template< size_t FFT_SIZE >
+static void BM_StreamEngine( benchmark::State& state )
+///
+/// Pushes a 512 sample chunk into every one of many streams per call to StreamEngine::Process, with
+/// a window half the FFT size and four hops per window.
+///
+/// Args: number of streams, number of threads.
+///
+{
+    typedef StreamEngine< FFT_SIZE > engine_type;
+
+    const size_t win_len = FFT_SIZE/2;
+    const size_t chunk_size = 512;
+    const size_t num_streams = static_cast< size_t >( state.range( 0 ) );
+    const std::vector< float > input = make_noise( chunk_size );
+    engine_type engine( 0.75f, make_window( win_len ), static_cast< size_t >( state.range( 1 ) ) );
+
+    std::vector< typename engine_type::StreamInput > inputs;
+    for( size_t stream=0; stream<num_streams; ++stream )
+    {
+        inputs.push_back( { engine.AddStream(), input.data(), chunk_size } );
+    }
+    auto sink = []( size_t, uint64_t, const typename engine_type::Frame* frames, size_t ){ benchmark::DoNotOptimize( frames ); };
+
+    for( auto _ : state )
+    {
+        engine.Process( inputs.data(), inputs.size(), sink );
+    }
+
+    set_throughput_counters( state, num_streams*chunk_size );
+}
+BENCHMARK_TEMPLATE( BM_StreamEngine, 2048 )->ArgsProduct( { { 64, 1024 }, { 1, 2, 4, 8 } } )->UseRealTime();
+
+template< size_t FFT_SIZE >
+static void BM_StreamingPipeline( benchmark::State& state )
+///
+/// Streams ten seconds of audio, in chunks of 4096 samples, into a sink that sums the magnitude of
+/// every bin, with a window half the FFT size and eight hops per window. This is done either on one
+/// thread, with FastWavelet::PushSamples followed by the sink, or with each stage on its own thread
+/// through a StreamingPipeline.
+///
+/// Args: 0 for one thread, 1 for the pipeline.
+///
+{
+    typedef StreamingPipeline< FFT_SIZE > pipeline_type;
+
+    const size_t win_len = FFT_SIZE/2;
+    const size_t chunk_size = 4096;
+    const size_t stream_length = 10*static_cast< size_t >( BENCHMARK_SAMPLE_RATE );
+    const std::vector< float > input = make_noise( stream_length );
+    const std::vector< float > window = make_window( win_len );
+
+    float total = 0.0f;
+    auto sink = [&total]( uint64_t, const typename pipeline_type::Frame* frames, size_t num_frames )
+    {
+        for( size_t frame=0; frame<num_frames; ++frame )
+        {
+            for( const auto& bin : frames[frame] )
+            {
+                total += std::abs( bin );
+            }
+        }
+    };
+
+    for( auto _ : state )
+    {
+        if( state.range( 0 ) == 0 )
+        {
+            FastWavelet< FFT_SIZE > transform( 0.875f, window );
+            uint64_t num_frames = 0;
+            for( size_t pos=0; pos<stream_length; pos+=chunk_size )
+            {
+                auto& frames = transform.PushSamples( ArrayView< const float >( input.data() + pos, std::min( chunk_size, stream_length - pos ) ) );
+                sink( num_frames, frames.data(), frames.size() );
+                num_frames += frames.size();
+            }
+        }
+        else
+        {
+            pipeline_type pipeline( 0.875f, window, sink );
+            for( size_t pos=0; pos<stream_length; pos+=chunk_size )
+            {
+                pipeline.PushSamples( input.data() + pos, std::min( chunk_size, stream_length - pos ) );
+            }
+            pipeline.Finish();
+        }
+        benchmark::DoNotOptimize( total );
+    }
+
+    set_throughput_counters( state, stream_length );
+}
+BENCHMARK_TEMPLATE( BM_StreamingPipeline, 4096 )->Arg( 0 )->Arg( 1 )->UseRealTime();
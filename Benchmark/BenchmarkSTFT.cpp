@@ -0,0 +1,190 @@
+//
+// Created: 10/18/26 by agent
+//
+// Benchmarks for the STFTAnalysis, FastCQT, SpectralFeatures and STFTSynthesis classes.
+//
+// Every benchmark here is templated on the FFT size, and uses a window half the FFT size long.
+// Hops are given as the number of hops per window, so that they scale with the FFT size.
+//
+
+// In module includes
+#include "STFTAnalysis.h"
+#include "STFTSynthesis.h"
+#include "FastCQT.h"
+#include "SpectralFeatures.h"
+#include "BenchmarkUtils.h"
+
+// Thirdparty includes
+#include "benchmark/benchmark.h"
+
+// Std Lib includes
+#include <vector>
+#include <algorithm>
+
+using namespace cupcake;
+
+template< size_t FFT_SIZE >
+static void BM_STFTAnalysis( benchmark::State& state )
+///
+/// Pushes chunks of samples through the STFT analysis: buffering, windowing and FFT.
+///
+/// Args: hops per window, chunk size.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t hops_per_window = static_cast< size_t >( state.range( 0 ) );
+    const size_t chunk_size = static_cast< size_t >( state.range( 1 ) );
+    const std::vector< float > input = make_noise( chunk_size );
+    STFTAnalysis< FFT_SIZE > stft( 1.0f - 1.0f/hops_per_window, make_window( win_len ) );
+
+    for( auto _ : state )
+    {
+        auto& frames = stft.PushSamples( input );
+        benchmark::DoNotOptimize( frames.data() );
+    }
+
+    set_throughput_counters( state, chunk_size );
+}
+BENCHMARK_TEMPLATE( BM_STFTAnalysis, 1024 )->ArgsProduct( { { 2, 4, 8 }, { 64, 512, 4096 } } );
+BENCHMARK_TEMPLATE( BM_STFTAnalysis, 4096 )->ArgsProduct( { { 2, 4, 8 }, { 64, 512, 4096 } } );
+BENCHMARK_TEMPLATE( BM_STFTAnalysis, 16384 )->ArgsProduct( { { 2, 4, 8 }, { 512, 4096 } } );
+
+template< size_t FFT_SIZE >
+static void BM_FastCQT( benchmark::State& state )
+///
+/// Applies the fast CQT to a block of STFT frames in place. The frames are restored before each
+/// pass, as filtering them repeatedly decays them into denormals, which are far slower to process.
+///
+/// Args: hops per window, number of frames.
+///
+{
+    typedef typename STFTAnalysis< FFT_SIZE >::FrameBuffer frame_buffer;
+
+    const size_t win_len = FFT_SIZE/2;
+    const size_t hop = win_len/static_cast< size_t >( state.range( 0 ) );
+    const size_t num_frames = static_cast< size_t >( state.range( 1 ) );
+
+    // Use real STFT frames, so that the values are representative.
+    STFTAnalysis< FFT_SIZE > stft( 1.0f - static_cast< float >( hop )/win_len, make_window( win_len ) );
+    const frame_buffer input = stft.PushSamples( make_noise( ( num_frames - 1 )*hop + win_len ) );
+    frame_buffer frames = input;
+    FastCQT< FFT_SIZE > cqt( win_len );
+
+    for( auto _ : state )
+    {
+        frames = input;
+        cqt.ApplyInPlace( frames );
+        benchmark::DoNotOptimize( frames.data() );
+    }
+
+    state.counters["frames_per_second"] = benchmark::Counter( static_cast< double >( num_frames )*state.iterations(), benchmark::Counter::kIsRate );
+    set_throughput_counters( state, num_frames*hop );
+}
+BENCHMARK_TEMPLATE( BM_FastCQT, 1024 )->ArgsProduct( { { 2, 4, 8 }, { 1, 32 } } );
+BENCHMARK_TEMPLATE( BM_FastCQT, 4096 )->ArgsProduct( { { 2, 4, 8 }, { 1, 32 } } );
+BENCHMARK_TEMPLATE( BM_FastCQT, 16384 )->ArgsProduct( { { 2, 4, 8 }, { 1, 32 } } );
+
+template< size_t FFT_SIZE >
+static void BM_SpectralFeatures( benchmark::State& state )
+///
+/// Reduces a block of fast CQT frames to chroma, band energies, centroid and flux.
+///
+/// Args: hops per window, number of frames.
+///
+{
+    typedef typename STFTAnalysis< FFT_SIZE >::FrameBuffer frame_buffer;
+
+    const size_t win_len = FFT_SIZE/2;
+    const size_t hop = win_len/static_cast< size_t >( state.range( 0 ) );
+    const size_t num_frames = static_cast< size_t >( state.range( 1 ) );
+
+    STFTAnalysis< FFT_SIZE > stft( 1.0f - static_cast< float >( hop )/win_len, make_window( win_len ) );
+    frame_buffer frames = stft.PushSamples( make_noise( ( num_frames - 1 )*hop + win_len ) );
+    FastCQT< FFT_SIZE > cqt( win_len );
+    cqt.ApplyInPlace( frames );
+    SpectralFeatures< FFT_SIZE > features( static_cast< float >( BENCHMARK_SAMPLE_RATE ) );
+
+    for( auto _ : state )
+    {
+        auto& output = features.Process( frames.data(), frames.size() );
+        benchmark::DoNotOptimize( output.chroma.data() );
+    }
+
+    state.counters["frames_per_second"] = benchmark::Counter( static_cast< double >( num_frames )*state.iterations(), benchmark::Counter::kIsRate );
+    set_throughput_counters( state, num_frames*hop );
+}
+BENCHMARK_TEMPLATE( BM_SpectralFeatures, 1024 )->ArgsProduct( { { 4 }, { 1, 32 } } );
+BENCHMARK_TEMPLATE( BM_SpectralFeatures, 4096 )->ArgsProduct( { { 4 }, { 1, 32 } } );
+
+template< size_t FFT_SIZE >
+static void BM_STFTSynthesis( benchmark::State& state )
+///
+/// Pushes blocks of frames through the STFT synthesis: IFFT, truncation and overlap-add.
+///
+/// Args: hops per window, number of frames per push.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t hops_per_window = static_cast< size_t >( state.range( 0 ) );
+    const size_t hop = win_len/hops_per_window;
+    const size_t num_frames = static_cast< size_t >( state.range( 1 ) );
+    const std::vector< float > window = make_window( win_len );
+
+    STFTAnalysis< FFT_SIZE > stft( 1.0f - 1.0f/hops_per_window, window );
+    const typename STFTAnalysis< FFT_SIZE >::FrameBuffer frames = stft.PushSamples( make_noise( ( num_frames - 1 )*hop + win_len ) );
+    STFTSynthesis< FFT_SIZE > synthesis( stft );
+
+    for( auto _ : state )
+    {
+        auto& output = synthesis.PushFrames( frames );
+        benchmark::DoNotOptimize( output.data() );
+    }
+
+    set_throughput_counters( state, num_frames*hop );
+}
+BENCHMARK_TEMPLATE( BM_STFTSynthesis, 1024 )->ArgsProduct( { { 2, 4, 8 }, { 1, 32 } } );
+BENCHMARK_TEMPLATE( BM_STFTSynthesis, 4096 )->ArgsProduct( { { 2, 4, 8 }, { 1, 32 } } );
+BENCHMARK_TEMPLATE( BM_STFTSynthesis, 16384 )->ArgsProduct( { { 2, 4, 8 }, { 1, 32 } } );
+
+template< size_t FFT_SIZE >
+static void BM_STFTCallJitter( benchmark::State& state )
+///
+/// Streams ten seconds of audio through the STFT analysis and straight back through the synthesis,
+/// in chunks the size of an audio callback, and reports the percentiles of the time taken by each
+/// chunk, along with the algorithmic latency of each and the largest number of samples they hold
+/// between them after a chunk.
+///
+/// Args: hops per window, chunk size.
+///
+{
+    const size_t win_len = FFT_SIZE/2;
+    const size_t hops_per_window = static_cast< size_t >( state.range( 0 ) );
+    const size_t chunk_size = static_cast< size_t >( state.range( 1 ) );
+    const size_t stream_length = 10*static_cast< size_t >( BENCHMARK_SAMPLE_RATE );
+    const std::vector< float > input = make_noise( stream_length );
+    STFTAnalysis< FFT_SIZE > stft( 1.0f - 1.0f/hops_per_window, make_window( win_len ) );
+    STFTSynthesis< FFT_SIZE > synthesis( stft );
+
+    std::vector< double > call_times;
+    call_times.reserve( ( stream_length/chunk_size + 1 )*16 );
+    size_t max_buffered = 0;
+    for( auto _ : state )
+    {
+        for( size_t pos=0; pos+chunk_size<=stream_length; pos+=chunk_size )
+        {
+            time_call( call_times, [&]()
+            {
+                auto& output = synthesis.PushFrames( stft.PushSamples( input.data() + pos, chunk_size ) );
+                benchmark::DoNotOptimize( output.data() );
+            });
+            max_buffered = std::max( max_buffered, stft.GetBufferedSamples() + synthesis.GetBufferedSamples() );
+        }
+    }
+
+    set_throughput_counters( state, stream_length - stream_length%chunk_size );
+    set_percentile_counters( state, call_times );
+    state.counters["analysis_latency_samples"] = stft.GetAlgorithmicLatency();
+    state.counters["synthesis_latency_samples"] = synthesis.GetAlgorithmicLatency();
+    state.counters["max_buffered_samples"] = max_buffered;
+}
+BENCHMARK_TEMPLATE( BM_STFTCallJitter, 2048 )->ArgsProduct( { { 4 }, { 64, 128, 256, 512, 1024 } } );
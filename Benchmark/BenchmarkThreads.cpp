@@ -0,0 +1,62 @@
+//
+// Created: 10/18/26 by agent
+//
+// Benchmarks for the WorkStealingPool class.
+//
+
+// In module includes
+#include "WorkStealingPool.h"
+#include "BenchmarkUtils.h"
+
+// Thirdparty includes
+#include "benchmark/benchmark.h"
+
+// Std Lib includes
+#include <vector>
+#include <numeric>
+
+using namespace cupcake;
+
+static void BM_WorkStealingPoolSubmit( benchmark::State& state )
+///
+/// Runs a round of small tasks, of about the size of an 8 frame task in
+/// FastWavelet::PushSamplesParallel, on a WorkStealingPool, either submitted one at a time or as a
+/// single range, to compare the cost of handing out the work on different numbers of threads.
+///
+/// Args: number of threads, whether the tasks are submitted as a range.
+///
+{
+    const size_t num_threads = static_cast< size_t >( state.range( 0 ) );
+    const bool as_range = state.range( 1 ) != 0;
+    const size_t NUM_TASKS = 4096;
+    const size_t TASK_SAMPLES = 2048;
+
+    const std::vector< float > input = make_noise( NUM_TASKS*TASK_SAMPLES );
+    std::vector< float > output( NUM_TASKS );
+    WorkStealingPool pool( num_threads );
+    auto task = [&]( size_t index, size_t )
+    {
+        const float* samples = input.data() + index*TASK_SAMPLES;
+        output[index] = std::inner_product( samples, samples + TASK_SAMPLES, samples, 0.0f );
+    };
+
+    for( auto _ : state )
+    {
+        if( as_range )
+        {
+            pool.SubmitRange( NUM_TASKS, task );
+        }
+        else
+        {
+            for( size_t index=0; index<NUM_TASKS; ++index )
+            {
+                pool.Submit( [&task, index]( size_t worker ){ task( index, worker ); } );
+            }
+        }
+        pool.Wait();
+        benchmark::DoNotOptimize( output.data() );
+    }
+
+    state.SetItemsProcessed( state.iterations()*NUM_TASKS );
+}
+BENCHMARK( BM_WorkStealingPoolSubmit )->ArgsProduct( { { 1, 2, 4, 8, 16 }, { 0, 1 } } )->UseRealTime();
@@ -0,0 +1,128 @@
+//
+// Created: 10/18/26 by agent
+//
+// Shared helpers for the benchmark suite.
+//
+
+#ifndef CUPCAKE_BENCHMARK_UTILS_H
+#define CUPCAKE_BENCHMARK_UTILS_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "benchmark/benchmark.h"
+
+// Std Lib includes
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+
+namespace cupcake
+{
+
+// The sample rate used to express throughput as a real-time factor.
+const double BENCHMARK_SAMPLE_RATE = 44100.0;
+
+inline void set_throughput_counters( benchmark::State& state, size_t samples_per_iteration )
+///
+/// Reports the throughput of a benchmark in samples per second and as a real-time factor, i.e.,
+/// the number of seconds of audio at BENCHMARK_SAMPLE_RATE processed per second.
+///
+/// @param state
+///  The state of the benchmark, after all iterations have completed.
+///
+/// @param samples_per_iteration
+///  The number of audio samples each iteration accounts for.
+///
+{
+    const double num_samples = static_cast< double >( samples_per_iteration )*state.iterations();
+    state.counters["samples_per_second"] = benchmark::Counter( num_samples, benchmark::Counter::kIsRate );
+    state.counters["realtime_factor"] = benchmark::Counter( num_samples/BENCHMARK_SAMPLE_RATE, benchmark::Counter::kIsRate );
+}
+
+template< typename Call >
+inline void time_call( std::vector< double >& call_times, const Call& call )
+///
+/// Makes a call and records how long it took, for benchmarks that report the distribution of
+/// call times rather than their mean.
+///
+/// @param call_times
+///  The times of the calls so far, in microseconds, to which this call is appended.
+///
+/// @param call
+///  The call to time.
+///
+{
+    const auto start = std::chrono::steady_clock::now();
+    call();
+    const auto stop = std::chrono::steady_clock::now();
+    call_times.push_back( std::chrono::duration< double, std::micro >( stop - start ).count() );
+}
+
+inline void set_percentile_counters( benchmark::State& state, std::vector< double >& call_times )
+///
+/// Reports the 50th, 99th and 99.9th percentiles and the maximum of a set of call times, i.e.,
+/// the jitter that a real-time caller must budget for.
+///
+/// @param state
+///  The state of the benchmark, after all iterations have completed.
+///
+/// @param call_times
+///  The time of each call, in microseconds. These are reordered.
+///
+{
+    if( call_times.empty() )
+    {
+        return;
+    }
+    auto percentile = [&call_times]( double fraction )
+    {
+        const size_t rank = std::min( call_times.size() - 1, static_cast< size_t >( fraction*call_times.size() ) );
+        std::nth_element( call_times.begin(), call_times.begin() + rank, call_times.end() );
+        return call_times[rank];
+    };
+    state.counters["p50_us"] = percentile( 0.5 );
+    state.counters["p99_us"] = percentile( 0.99 );
+    state.counters["p999_us"] = percentile( 0.999 );
+    state.counters["max_us"] = *std::max_element( call_times.begin(), call_times.end() );
+}
+
+inline std::vector< float > make_noise( size_t num_samples )
+///
+/// Creates uniform white noise to feed through each stage.
+///
+/// @param num_samples
+///  The number of samples to create.
+///
+/// @return
+///  The noise samples in [-1, 1].
+///
+{
+    veclib::seed_rand();
+    std::vector< float > noise( num_samples );
+    std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    return noise;
+}
+
+inline std::vector< float > make_window( size_t win_len )
+///
+/// Creates the analysis window used by the STFT based benchmarks.
+///
+/// @param win_len
+///  The length of the window.
+///
+/// @return
+///  A hamming window.
+///
+{
+    std::vector< float > window( win_len );
+    veclib::hamming( window );
+    return window;
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_BENCHMARK_UTILS_H
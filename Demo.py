@@ -143,7 +143,7 @@ def Demo():
 
 	# Create wavelet objects
 	slow_alg = SlowWavelet( fft_len, window, overlap )
-	fast_alg = FastWavelet.FastWavelet( overlap, window )
+	fast_alg = FastWavelet.FastWavelet( overlap, window, fft_size=fft_len )
 
 	# Process signal
 	print( "Processing Slow Wavelet..." )
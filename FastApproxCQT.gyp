@@ -17,15 +17,46 @@
 
         'sources': 
         [
+          'src/Arena.h',
+          'src/Arena.cpp',
+          'src/ArrayView.h',
           'src/AudioBuffer.h',
+          'src/BinRangeAnalyser.h',
+          'src/ExactCQT.h',
           'src/FastCQT.h',
           'src/FastWavelet.h',
           'src/FastWavelet.cpp',
           'src/FastWaveletPythonBinding.cpp',
+          'src/FastWaveletRegistry.h',
+          'src/FrameStore.h',
+          'src/FrameStore.cpp',
+          'src/FrameStoreBinding.h',
+          'src/FrameDecimator.h',
+          'src/HalfBandDecimator.h',
+          'src/HalfBandDecimator.cpp',
+          'src/Kernels.h',
+          'src/Kernels.cpp',
+          'src/LockFreeAudioBuffer.h',
+          'src/LockFreeOverlapAddBuffer.h',
+          'src/MultiResolutionFastWavelet.h',
           'src/PybindArgumentConversion.h',
+          'src/OnsetDetector.h',
           'src/OverlapAddBuffer.h',
+          'src/ProcessingChain.h',
+          'src/ProcessingStats.h',
+          'src/SPSCQueue.h',
           'src/STFTAnalysis.h',
+          'src/STFTFrameAnalyser.h',
           'src/STFTSynthesis.h',
+          'src/SpectralFeatures.h',
+          'src/StreamEngine.h',
+          'src/StreamingPipeline.h',
+          'src/ThreadPool.h',
+          'src/ThreadPool.cpp',
+          'src/TransformCache.h',
+          'src/TransformCache.cpp',
+          'src/WorkStealingPool.h',
+          'src/WorkStealingPool.cpp',
         ],
 
         'link_settings': 
@@ -40,6 +71,12 @@
         'target_name': 'Test',
         'type': 'executable',
 
+        # Statistics are always compiled into the tests, so that they are tested.
+        'defines': 
+        [
+          'CUPCAKE_ENABLE_STATS=1',
+        ],
+
         'include_dirs': 
         [
           './src',
@@ -47,18 +84,71 @@
 
         'sources': 
         [
+          'src/Arena.h',
+          'src/Arena.cpp',
+          'src/ArrayView.h',
           'src/AudioBuffer.h',
+          'src/BinRangeAnalyser.h',
+          'src/ExactCQT.h',
           'src/FastCQT.h',
           'src/FastWavelet.h',
           'src/FastWavelet.cpp',
+          'src/FrameStore.h',
+          'src/FrameStore.cpp',
+          'src/FrameDecimator.h',
+          'src/HalfBandDecimator.h',
+          'src/HalfBandDecimator.cpp',
+          'src/Kernels.h',
+          'src/Kernels.cpp',
+          'src/LockFreeAudioBuffer.h',
+          'src/LockFreeOverlapAddBuffer.h',
+          'src/MultiResolutionFastWavelet.h',
+          'src/OnsetDetector.h',
           'src/OverlapAddBuffer.h',
+          'src/ProcessingChain.h',
+          'src/ProcessingStats.h',
+          'src/SPSCQueue.h',
           'src/STFTAnalysis.h',
+          'src/STFTFrameAnalyser.h',
           'src/STFTSynthesis.h',
+          'src/SpectralFeatures.h',
+          'src/StreamEngine.h',
+          'src/StreamingPipeline.h',
+          'src/ThreadPool.h',
+          'src/ThreadPool.cpp',
+          'src/TransformCache.h',
+          'src/TransformCache.cpp',
+          'src/WavFile.h',
+          'src/WavFile.cpp',
+          'src/WorkStealingPool.h',
+          'src/WorkStealingPool.cpp',
+          'test/TestAllocationFree.cpp',
+          'test/TestArena.cpp',
           'test/TestAudioBuffer.cpp',
+          'test/TestBinRangeAnalyser.cpp',
+          'test/TestExactCQT.cpp',
+          'test/TestFastWavelet.cpp',
+          'test/TestFrameStore.cpp',
+          'test/TestFrameDecimator.cpp',
+          'test/TestHalfBandDecimator.cpp',
+          'test/TestKernels.cpp',
+          'test/TestLockFreeAudioBuffer.cpp',
+          'test/TestLockFreeOverlapAddBuffer.cpp',
+          'test/TestMultiResolutionFastWavelet.cpp',
+          'test/TestOnsetDetector.cpp',
           'test/TestOverlapAddBuffer.cpp',
+          'test/TestProcessingChain.cpp',
+          'test/TestSPSCQueue.cpp',
           'test/TestSTFTAnalysis.cpp',
           'test/TestSTFTAnalysisSynthesis.cpp',
           'test/TestSTFTSynthesis.cpp',
+          'test/TestSpectralFeatures.cpp',
+          'test/TestStreamEngine.cpp',
+          'test/TestStreamingPipeline.cpp',
+          'test/TestThreadPool.cpp',
+          'test/TestTransformCache.cpp',
+          'test/TestWavFile.cpp',
+          'test/TestWorkStealingPool.cpp',
         ],
 
         'link_settings': 
@@ -71,6 +161,96 @@
           ],
         },
       },
+
+      {
+        'target_name': 'Benchmark',
+        'type': 'executable',
+
+        'include_dirs': 
+        [
+          './src',
+          './Benchmark',
+        ],
+
+        'sources': 
+        [
+          'src/Arena.h',
+          'src/Arena.cpp',
+          'src/AudioBuffer.h',
+          'src/BinRangeAnalyser.h',
+          'src/ExactCQT.h',
+          'src/FastCQT.h',
+          'src/FastWavelet.h',
+          'src/FastWavelet.cpp',
+          'src/FrameStore.h',
+          'src/FrameStore.cpp',
+          'src/FrameDecimator.h',
+          'src/HalfBandDecimator.h',
+          'src/HalfBandDecimator.cpp',
+          'src/Kernels.h',
+          'src/Kernels.cpp',
+          'src/MultiResolutionFastWavelet.h',
+          'src/OnsetDetector.h',
+          'src/OverlapAddBuffer.h',
+          'src/ProcessingChain.h',
+          'src/ProcessingStats.h',
+          'src/SPSCQueue.h',
+          'src/STFTAnalysis.h',
+          'src/STFTFrameAnalyser.h',
+          'src/STFTSynthesis.h',
+          'src/SpectralFeatures.h',
+          'src/StreamEngine.h',
+          'src/StreamingPipeline.h',
+          'src/ThreadPool.h',
+          'src/ThreadPool.cpp',
+          'src/TransformCache.h',
+          'src/TransformCache.cpp',
+          'src/WorkStealingPool.h',
+          'src/WorkStealingPool.cpp',
+          'Benchmark/BenchmarkUtils.h',
+          'Benchmark/BenchmarkBuffers.cpp',
+          'Benchmark/BenchmarkFastWavelet.cpp',
+          'Benchmark/BenchmarkSTFT.cpp',
+          'Benchmark/BenchmarkThreads.cpp',
+        ],
+
+        'link_settings': 
+        {
+          'libraries': 
+          [
+            '<(thirdparty_lib_dir)/libbenchmark.a',
+            '<(thirdparty_lib_dir)/libbenchmark_main.a',
+          ],
+        },
+      },
+
+      {
+        'target_name': 'BatchTransform',
+        'type': 'executable',
+
+        'include_dirs': 
+        [
+          './src',
+        ],
+
+        'sources': 
+        [
+          'src/Arena.h',
+          'src/Arena.cpp',
+          'src/FastCQT.h',
+          'src/FastWavelet.h',
+          'src/FrameStore.h',
+          'src/FrameStore.cpp',
+          'src/Kernels.h',
+          'src/Kernels.cpp',
+          'src/STFTFrameAnalyser.h',
+          'src/WavFile.h',
+          'src/WavFile.cpp',
+          'src/WorkStealingPool.h',
+          'src/WorkStealingPool.cpp',
+          'Tool/BatchTransform.cpp',
+        ],
+      },
     ],
   }
 
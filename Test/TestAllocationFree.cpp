@@ -0,0 +1,254 @@
+//
+// Created: 10/18/26 by agent
+//
+// Tests that the streaming hot path does not allocate once it is warmed up
+//
+
+// In module includes
+#include "FastWavelet.h"
+#include "STFTAnalysis.h"
+#include "STFTSynthesis.h"
+#include "LockFreeAudioBuffer.h"
+#include "LockFreeOverlapAddBuffer.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+using namespace cupcake;
+
+//
+// Allocation counting
+//
+// The global allocation functions are replaced for the whole test binary. They only count the
+// allocations made by a thread while it holds an AllocationCounter, so other tests are unaffected.
+//
+
+namespace
+{
+
+thread_local size_t tCounting = 0;
+thread_local size_t tNumAllocations = 0;
+
+void* counted_allocate( std::size_t size )
+///
+/// Allocates memory from malloc, counting the allocation if the calling thread is counting.
+///
+{
+    if( tCounting )
+    {
+        ++tNumAllocations;
+    }
+    void* ptr = std::malloc( size > 0 ? size : 1 );
+    if( !ptr )
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+class AllocationCounter
+///
+/// Counts the allocations made by the current thread for as long as it exists.
+///
+{
+public:
+
+    AllocationCounter() :
+        mStart( tNumAllocations )
+    ///
+    /// Constructor. Starts counting.
+    ///
+    {
+        ++tCounting;
+    }
+
+    ~AllocationCounter()
+    ///
+    /// Destructor. Stops counting.
+    ///
+    {
+        --tCounting;
+    }
+
+    size_t Count() const
+    ///
+    /// Get the number of allocations so far.
+    ///
+    /// @return
+    ///  The number of allocations made by this thread since construction.
+    ///
+    {
+        return tNumAllocations - mStart;
+    }
+
+private:
+
+    const size_t mStart;
+
+};
+
+} // namespace
+
+void* operator new( std::size_t size ) { return counted_allocate( size ); }
+void* operator new[]( std::size_t size ) { return counted_allocate( size ); }
+void operator delete( void* ptr ) noexcept { std::free( ptr ); }
+void operator delete[]( void* ptr ) noexcept { std::free( ptr ); }
+void operator delete( void* ptr, std::size_t ) noexcept { std::free( ptr ); }
+void operator delete[]( void* ptr, std::size_t ) noexcept { std::free( ptr ); }
+
+class AllocationFreeTest : public ::testing::Test
+///
+/// Test fixture for the allocation tests.
+/// Creates and holds a window and a block of white noise.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const size_t SIGNAL_LENGTH = 44100*4;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create the window and noise.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        noise.resize( SIGNAL_LENGTH );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+
+        // Pieces both smaller than a hop and much larger than the first push.
+        pieces = { 1, 255, 3000, 44100, 17, 44100*2 };
+    }
+
+    std::vector< float > window;        // The analysis window.
+    std::vector< float > noise;         // White noise.
+    std::vector< size_t > pieces;       // The sizes of successive pushes after the first.
+
+};
+
+TEST_F( AllocationFreeTest, test_counter )
+///
+/// Tests that allocations are counted while a counter exists, and only then.
+///
+{
+    size_t count = 0;
+    {
+        AllocationCounter counter;
+        std::unique_ptr< std::vector< float > > allocated( new std::vector< float >( 10 ) );
+        count = counter.Count();
+    }
+    EXPECT_EQ( count, 2u );
+
+    std::vector< float > uncounted( 10 );
+    {
+        AllocationCounter counter;
+        count = counter.Count();
+    }
+    EXPECT_EQ( count, 0u );
+}
+
+TEST_F( AllocationFreeTest, test_fast_wavelet_push_samples )
+///
+/// Tests that FastWavelet::PushSamples, and the getters of its configuration, do not allocate
+/// after the first call.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    size_t pos = WINDOW_LENGTH*2;
+    wavelet.PushSamples( ArrayView< const float >( noise.data(), pos ) );
+
+    size_t count = 0;
+    size_t num_frames = 0;
+    size_t window_size = 0;
+    size_t coeffs_size = 0;
+    {
+        AllocationCounter counter;
+        for( size_t piece : pieces )
+        {
+            num_frames += wavelet.PushSamples( ArrayView< const float >( noise.data() + pos, piece ) ).size();
+            pos += piece;
+        }
+        window_size = wavelet.GetWindow().size();
+        coeffs_size = wavelet.GetCQTCoeffs().size();
+        count = counter.Count();
+    }
+    EXPECT_EQ( count, 0u );
+    EXPECT_EQ( num_frames, wavelet.GetNumFrames( pos ) - wavelet.GetNumFrames( WINDOW_LENGTH*2 ) );
+    EXPECT_EQ( window_size, WINDOW_LENGTH );
+    EXPECT_EQ( coeffs_size, FastWavelet< FFT_SIZE >::mOutputSize );
+}
+
+TEST_F( AllocationFreeTest, test_stft_pull_samples )
+///
+/// Tests that STFTAnalysis::PullSamples does not allocate after the first call.
+///
+{
+    STFTAnalysis< FFT_SIZE > stft( OVERLAP, window );
+    LockFreeAudioBuffer< float > input( SIGNAL_LENGTH );
+    input.PushSamples( noise.data(), WINDOW_LENGTH*2 );
+    stft.PullSamples( input );
+
+    size_t count = 0;
+    {
+        AllocationCounter counter;
+        size_t pos = WINDOW_LENGTH*2;
+        for( size_t piece : pieces )
+        {
+            input.PushSamples( noise.data() + pos, piece );
+            stft.PullSamples( input );
+            pos += piece;
+        }
+        count = counter.Count();
+    }
+    EXPECT_EQ( count, 0u );
+}
+
+TEST_F( AllocationFreeTest, test_stft_synthesis_push_frames )
+///
+/// Tests that both overloads of STFTSynthesis::PushFrames, and reading the lock-free output, do
+/// not allocate after the first call.
+///
+{
+    STFTAnalysis< FFT_SIZE > stft( OVERLAP, window );
+    const STFTAnalysis< FFT_SIZE >::FrameBuffer frames = stft.PushSamples( noise.data(), 44100 );
+    ASSERT_GT( frames.size(), 2u );
+    const STFTAnalysis< FFT_SIZE >::FrameBuffer few_frames( frames.begin(), frames.begin() + 2 );
+
+    STFTSynthesis< FFT_SIZE > synthesis( stft );
+    synthesis.PushFrames( few_frames );
+
+    STFTSynthesis< FFT_SIZE > lock_free_synthesis( stft );
+    LockFreeOverlapAddBuffer< float > output( frames.size()*stft.GetIncrement() + WINDOW_LENGTH );
+    std::vector< float > samples( output.Size() );
+    lock_free_synthesis.PushFrames( few_frames, output );
+
+    size_t count = 0;
+    size_t num_samples = 0;
+    {
+        AllocationCounter counter;
+        num_samples += synthesis.PushFrames( frames ).size();
+        num_samples += synthesis.PushFrames( few_frames ).size();
+
+        lock_free_synthesis.PushFrames( frames, output );
+        const size_t num_available = output.NumSamples();
+        output.Read( samples.data(), num_available );
+        output.PopFront( num_available );
+        count = counter.Count();
+    }
+    EXPECT_EQ( count, 0u );
+    EXPECT_EQ( num_samples, ( frames.size() + 2 )*stft.GetIncrement() );
+}
@@ -0,0 +1,169 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for Arena class
+//
+
+// In module includes
+#include "Arena.h"
+#include "FastWavelet.h"
+#include "StreamEngine.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+
+using namespace cupcake;
+
+class ArenaTest : public ::testing::Test
+///
+/// Test fixture for Arena tests.
+/// Creates and holds a window and a noise signal.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const size_t SIGNAL_LENGTH = 30000;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create a window and some noise.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        signal.resize( SIGNAL_LENGTH );
+        std::generate( signal.begin(), signal.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    std::vector< float > window;    // The analysis window.
+    std::vector< float > signal;    // Noise to analyse.
+
+};
+
+TEST_F( ArenaTest, test_alignment_and_growth )
+///
+/// Tests that allocations are aligned to a cache line, do not overlap, and that an allocation
+/// larger than the remaining space maps a further block.
+///
+{
+    Arena arena( 4096 );
+    EXPECT_EQ( arena.GetNumBlocks(), 1u );
+
+    std::vector< char* > allocations;
+    const size_t sizes[] = { 1, 63, 64, 100, 1000 };
+    for( size_t size : sizes )
+    {
+        char* ptr = static_cast< char* >( arena.Allocate( size ) );
+        EXPECT_EQ( reinterpret_cast< uintptr_t >( ptr )%Arena::CACHE_LINE_SIZE, 0u );
+        std::fill( ptr, ptr + size, static_cast< char >( size ) );
+        allocations.push_back( ptr );
+    }
+    for( size_t index=0; index<allocations.size(); ++index )
+    {
+        EXPECT_TRUE( std::all_of( allocations[index], allocations[index] + sizes[index], [&]( char value ){ return value == static_cast< char >( sizes[index] ); } ) );
+    }
+    EXPECT_EQ( arena.GetNumBlocks(), 1u );
+    EXPECT_EQ( arena.GetBytesAllocated(), 1u + 63 + 64 + 100 + 1000 );
+
+    void* large = arena.Allocate( 10000 );
+    EXPECT_EQ( reinterpret_cast< uintptr_t >( large )%Arena::CACHE_LINE_SIZE, 0u );
+    EXPECT_EQ( arena.GetNumBlocks(), 2u );
+    EXPECT_GE( arena.GetBytesReserved(), 4096u + 10000 );
+}
+
+TEST_F( ArenaTest, test_vectors )
+///
+/// Tests that vectors may grow within an arena, and that vectors without an arena still work.
+///
+{
+    auto arena = std::make_shared< Arena >( 1 << 16 );
+    ArenaVector< float > in_arena{ ArenaAllocator< float >( arena ) };
+    ArenaVector< float > on_heap;
+    for( size_t index=0; index<1000; ++index )
+    {
+        in_arena.push_back( static_cast< float >( index ) );
+        on_heap.push_back( static_cast< float >( index ) );
+    }
+    EXPECT_TRUE( std::equal( in_arena.begin(), in_arena.end(), on_heap.begin() ) );
+    EXPECT_EQ( reinterpret_cast< uintptr_t >( in_arena.data() )%Arena::CACHE_LINE_SIZE, 0u );
+    EXPECT_EQ( reinterpret_cast< uintptr_t >( on_heap.data() )%Arena::CACHE_LINE_SIZE, 0u );
+
+    // The memory a vector grows out of is given back, so only its final capacity counts as allocated.
+    EXPECT_EQ( arena->GetBytesAllocated(), in_arena.capacity()*sizeof( float ) );
+    EXPECT_EQ( arena->GetNumBlocks(), 1u );
+}
+
+TEST_F( ArenaTest, test_huge_pages_fallback )
+///
+/// Tests that an arena asking for huge pages works whether or not the system has any.
+///
+{
+    Arena arena( 1 << 20, true );
+    float* data = static_cast< float* >( arena.Allocate( ( 1 << 20 )*sizeof( float ) ) );
+    std::fill( data, data + ( 1 << 20 ), 1.0f );
+    EXPECT_EQ( data[( 1 << 20 ) - 1], 1.0f );
+    if( arena.UsesHugePages() )
+    {
+        EXPECT_EQ( arena.GetBytesReserved()%( 2*1024*1024 ), 0u );
+    }
+}
+
+TEST_F( ArenaTest, test_fast_wavelet )
+///
+/// Tests that FastWavelets laid out in a shared arena give the same output as one on the heap.
+///
+{
+    auto arena = std::make_shared< Arena >( 16*1024*1024, true );
+    FastWavelet< FFT_SIZE > heap_wavelet( OVERLAP, window );
+    FastWavelet< FFT_SIZE > first_wavelet( OVERLAP, window, arena );
+    FastWavelet< FFT_SIZE > second_wavelet( OVERLAP, window, arena );
+    EXPECT_GT( arena->GetBytesAllocated(), 0u );
+
+    for( size_t pos=0; pos<SIGNAL_LENGTH; pos+=5000 )
+    {
+        std::vector< float > chunk( signal.begin() + pos, signal.begin() + pos + 5000 );
+        auto expected = heap_wavelet.PushSamples( chunk );
+        auto& first = first_wavelet.PushSamples( chunk );
+        auto& second = second_wavelet.PushSamples( chunk );
+        ASSERT_EQ( first.size(), expected.size() );
+        ASSERT_EQ( second.size(), expected.size() );
+        for( size_t frame=0; frame<expected.size(); ++frame )
+        {
+            EXPECT_TRUE( std::equal( expected[frame].begin(), expected[frame].end(), first[frame].begin() ) );
+            EXPECT_TRUE( std::equal( expected[frame].begin(), expected[frame].end(), second[frame].begin() ) );
+        }
+    }
+}
+
+TEST_F( ArenaTest, test_stream_engine_reuse )
+///
+/// Tests that removing and adding streams in an engine reuses their memory rather than growing
+/// the arena.
+///
+{
+    auto arena = std::make_shared< Arena >( 1 << 20 );
+    StreamEngine< FFT_SIZE > engine( OVERLAP, window, 1, arena );
+    const size_t stream = engine.AddStream();
+    const size_t allocated = arena->GetBytesAllocated();
+
+    for( size_t repeat=0; repeat<10; ++repeat )
+    {
+        engine.RemoveStream( stream );
+        EXPECT_EQ( engine.AddStream(), stream );
+    }
+    EXPECT_EQ( arena->GetBytesAllocated(), allocated );
+}
@@ -0,0 +1,191 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for BinRangeAnalyser class
+//
+
+// In module includes
+#include "BinRangeAnalyser.h"
+#include "FastCQT.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+using namespace cupcake;
+
+class BinRangeAnalyserTest : public ::testing::Test
+///
+/// Test fixture for BinRangeAnalyser tests.
+/// Creates and holds a window, a block of white noise and the full output frames of the noise.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const size_t SIGNAL_LENGTH = 44100;
+    const size_t MIN_BIN = 20;
+    const size_t MAX_BIN = 180;
+
+    typedef FastWavelet< FFT_SIZE >::Frame Frame;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create the window, the noise and its frames.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        noise.resize( SIGNAL_LENGTH );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+
+        FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+        increment = wavelet.GetIncrement();
+        expected = wavelet.PushSamples( noise );
+        for( const auto& frame : expected )
+        {
+            for( const auto& value : frame )
+            {
+                peak = std::max( peak, std::abs( value ) );
+            }
+        }
+    }
+
+    void ExpectNear( const BinRangeFrames& result, size_t min_bin, size_t max_bin, float tolerance )
+    ///
+    /// Checks the bins of a range against those of the full frames.
+    ///
+    {
+        ASSERT_EQ( result.first_bin, min_bin );
+        ASSERT_EQ( result.num_bins, max_bin + 1 - min_bin );
+        ASSERT_EQ( result.num_frames, expected.size() );
+        ASSERT_EQ( result.values.size(), result.num_frames*result.num_bins );
+        for( size_t frame=0; frame<expected.size(); ++frame )
+        {
+            for( size_t bin=min_bin; bin<=max_bin; ++bin )
+            {
+                const std::complex< float > value = result.values[frame*result.num_bins + bin - min_bin];
+                ASSERT_LE( std::abs( value - expected[frame][bin] ), tolerance*peak ) << "Frame " << frame << ", bin " << bin;
+            }
+        }
+    }
+
+    std::vector< float > window;            // The analysis window.
+    std::vector< float > noise;             // White noise.
+    std::vector< Frame > expected;          // The output of FastWavelet::PushSamples for the noise.
+    size_t increment = 0;
+    float peak = 0.0f;                      // The largest magnitude in the expected frames.
+
+};
+
+TEST_F( BinRangeAnalyserTest, test_zero_tolerance_is_exact )
+///
+/// Tests that, with a tolerance of zero and the FFT, any range is exactly the same bins of the full
+/// frames, as the sweep covers the whole spectrum.
+///
+{
+    FastCQT< FFT_SIZE > cqt( WINDOW_LENGTH );
+    const size_t num_frames = expected.size();
+    const size_t ranges[][2] = { { 0, FFT_SIZE/2 }, { MIN_BIN, MAX_BIN }, { FFT_SIZE/2, FFT_SIZE/2 } };
+    for( const auto& range : ranges )
+    {
+        BinRangeAnalyser< FFT_SIZE > analyser( window, cqt, range[0], range[1], 0.0f, BIN_RANGE_FFT );
+        EXPECT_EQ( analyser.GetFirstSweepBin(), 0u );
+        EXPECT_EQ( analyser.GetNumSweepBins(), FFT_SIZE/2 + 1 );
+
+        BinRangeFrames& result = analyser.Process( noise.data(), num_frames, increment );
+        ExpectNear( result, range[0], range[1], 0.0f );
+    }
+}
+
+TEST_F( BinRangeAnalyserTest, test_guard_bins )
+///
+/// Tests that a sub-range sweeps fewer bins than the whole spectrum, with guard bins on either side,
+/// and that its bins are within tolerance of the full frames.
+///
+{
+    FastCQT< FFT_SIZE > cqt( WINDOW_LENGTH );
+    const float tolerance = BinRangeAnalyser< FFT_SIZE >::DEFAULT_TOLERANCE;
+    BinRangeAnalyser< FFT_SIZE > analyser( window, cqt, MIN_BIN, MAX_BIN, tolerance, BIN_RANGE_FFT );
+    EXPECT_LT( analyser.GetFirstSweepBin(), MIN_BIN );
+    EXPECT_GT( analyser.GetFirstSweepBin() + analyser.GetNumSweepBins() - 1, MAX_BIN );
+    EXPECT_LT( analyser.GetNumSweepBins(), FFT_SIZE/2 + 1 );
+    EXPECT_EQ( analyser.GetFirstBin(), MIN_BIN );
+    EXPECT_EQ( analyser.GetNumBins(), MAX_BIN + 1 - MIN_BIN );
+
+    BinRangeFrames& result = analyser.Process( noise.data(), expected.size(), increment );
+    ExpectNear( result, MIN_BIN, MAX_BIN, 10*tolerance );
+}
+
+TEST_F( BinRangeAnalyserTest, test_pruned_dft )
+///
+/// Tests that the pruned DFT gives the same bins as the FFT, to within rounding, and that it is
+/// chosen automatically only when it sweeps few enough bins to be cheaper.
+///
+{
+    FastCQT< FFT_SIZE > cqt( WINDOW_LENGTH );
+    const float tolerance = BinRangeAnalyser< FFT_SIZE >::DEFAULT_TOLERANCE;
+    BinRangeAnalyser< FFT_SIZE > analyser( window, cqt, 2, 4, tolerance, BIN_RANGE_PRUNED_DFT );
+    EXPECT_EQ( analyser.GetMethod(), BIN_RANGE_PRUNED_DFT );
+    BinRangeFrames& result = analyser.Process( noise.data(), expected.size(), increment );
+    ExpectNear( result, 2, 4, 10*tolerance );
+
+    BinRangeAnalyser< FFT_SIZE > narrow( window, cqt, 2, 2, 0.9f );
+    EXPECT_LT( narrow.GetNumSweepBins(), 5u );
+    EXPECT_EQ( narrow.GetMethod(), BIN_RANGE_PRUNED_DFT );
+    BinRangeAnalyser< FFT_SIZE > wide( window, cqt, MIN_BIN, MAX_BIN );
+    EXPECT_EQ( wide.GetMethod(), BIN_RANGE_FFT );
+}
+
+TEST_F( BinRangeAnalyserTest, test_fast_wavelet_bin_range )
+///
+/// Tests FastWavelet::PushSamplesBinRange on a stream pushed in pieces, and that it must be
+/// configured first.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    EXPECT_THROW( wavelet.PushSamplesBinRange( ArrayView< const float >( noise.data(), noise.size() ) ), std::logic_error );
+    wavelet.ConfigureBinRange( MIN_BIN, MAX_BIN, 0.0f, BIN_RANGE_FFT );
+
+    BinRangeFrames result;
+    result.first_bin = MIN_BIN;
+    result.num_bins = MAX_BIN + 1 - MIN_BIN;
+    for( size_t pos=0, piece=1; pos<noise.size(); pos+=piece, piece=( piece*7 )%5003 + 1 )
+    {
+        const size_t num_samples = std::min( piece, noise.size() - pos );
+        BinRangeFrames& frames = wavelet.PushSamplesBinRange( ArrayView< const float >( noise.data() + pos, num_samples ) );
+        ASSERT_EQ( frames.num_bins, result.num_bins );
+        result.values.insert( result.values.end(), frames.values.begin(), frames.values.end() );
+        result.num_frames += frames.num_frames;
+    }
+    ExpectNear( result, MIN_BIN, MAX_BIN, 0.0f );
+}
+
+TEST_F( BinRangeAnalyserTest, test_invalid_arguments )
+///
+/// Tests that ranges outside the spectrum, and tolerances outside [0, 1), are rejected.
+///
+{
+    FastCQT< FFT_SIZE > cqt( WINDOW_LENGTH );
+    EXPECT_THROW( BinRangeAnalyser< FFT_SIZE >( window, cqt, 10, 9 ), std::invalid_argument );
+    EXPECT_THROW( BinRangeAnalyser< FFT_SIZE >( window, cqt, 0, FFT_SIZE/2 + 1 ), std::invalid_argument );
+    EXPECT_THROW( BinRangeAnalyser< FFT_SIZE >( window, cqt, 0, 10, 1.0f ), std::invalid_argument );
+    EXPECT_THROW( BinRangeAnalyser< FFT_SIZE >( window, cqt, 0, 10, -0.1f ), std::invalid_argument );
+    EXPECT_THROW( BinRangeAnalyser< FFT_SIZE >( std::vector< float >( FFT_SIZE + 1, 1.0f ), cqt, 0, 10 ), std::invalid_argument );
+
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    EXPECT_THROW( wavelet.ConfigureBinRange( 0, FFT_SIZE/2 + 1, 0.0f, BIN_RANGE_AUTOMATIC ), std::invalid_argument );
+}
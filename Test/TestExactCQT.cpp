@@ -0,0 +1,179 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for ExactCQT class
+//
+
+// In module includes
+#include "ExactCQT.h"
+#include "STFTFrameAnalyser.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+using namespace cupcake;
+
+class ExactCQTTest : public ::testing::Test
+///
+/// Test fixture for ExactCQT tests.
+/// Creates and holds a block of white noise and its STFT frames, with a rectangular window.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t INCREMENT = 256;
+    const size_t NUM_FRAMES = 21;           // -> Enough frames to leave a remainder after a block.
+    const float SAMPLE_RATE = 8000.0f;
+    const float MIN_FREQUENCY = 150.0f;
+    const size_t BINS_PER_OCTAVE = 12;
+
+    typedef ExactCQT< FFT_SIZE >::Frame Frame;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create the noise and its frames.
+    ///
+    {
+        rectangular.assign( FFT_SIZE, 1.0f );
+
+        veclib::seed_rand();
+        noise.resize( ( NUM_FRAMES - 1 )*INCREMENT + FFT_SIZE );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+
+        frames.resize( NUM_FRAMES );
+        STFTFrameAnalyser< FFT_SIZE > analyser( rectangular );
+        analyser.AnalyseFrames( noise.data(), NUM_FRAMES, INCREMENT, frames.data() );
+    }
+
+    std::vector< float > rectangular;       // A rectangular window the length of the FFT.
+    std::vector< float > noise;             // White noise.
+    std::vector< Frame > frames;            // The STFT frames of the noise.
+
+};
+
+TEST_F( ExactCQTTest, test_matches_time_domain )
+///
+/// Tests that, with the whole kernel, every bin of every frame matches the product of the frame's
+/// samples with the Hamming windowed complex exponential of that bin, to within the small negative
+/// frequency content of those kernels.
+///
+{
+    ExactCQT< FFT_SIZE > cqt( rectangular, SAMPLE_RATE, MIN_FREQUENCY, BINS_PER_OCTAVE, 0, 0.0f );
+    const std::vector< float >& frequencies = cqt.GetBinFrequencies();
+    ASSERT_EQ( frequencies.size(), cqt.GetNumBins() );
+    EXPECT_FLOAT_EQ( frequencies.front(), MIN_FREQUENCY );
+
+    // Every main lobe, 2*f/Q either side of f, is below the Nyquist frequency.
+    const double Q = 1.0/( std::pow( 2.0, 1.0/BINS_PER_OCTAVE ) - 1.0 );
+    EXPECT_LT( frequencies.back()*( 1.0 + 2.0/Q ), SAMPLE_RATE/2 );
+    EXPECT_GE( frequencies.back()*std::pow( 2.0, 1.0/BINS_PER_OCTAVE )*( 1.0 + 2.0/Q ), SAMPLE_RATE/2 );
+
+    ExactCQTFrames& result = cqt.Process( frames.data(), NUM_FRAMES );
+    ASSERT_EQ( result.num_frames, NUM_FRAMES );
+    ASSERT_EQ( result.num_bins, frequencies.size() );
+
+    for( size_t frame=0; frame<NUM_FRAMES; ++frame )
+    {
+        const float* samples = noise.data() + frame*INCREMENT;
+        for( size_t bin=0; bin<result.num_bins; ++bin )
+        {
+            const size_t length = static_cast< size_t >( std::ceil( Q*SAMPLE_RATE/frequencies[bin] ) );
+            const size_t start = ( FFT_SIZE - length )/2;
+            std::complex< double > expected = { 0.0, 0.0 };
+            for( size_t n=0; n<length; ++n )
+            {
+                const double hamming = 0.54 - 0.46*std::cos( 2.0*M_PI*n/( length - 1 ) );
+                const double phase = -2.0*M_PI*frequencies[bin]*( start + n - FFT_SIZE/2.0 )/SAMPLE_RATE;
+                expected += samples[start+n]*hamming/length*std::polar( 1.0, phase );
+            }
+
+            const std::complex< float > value = result.values[frame*result.num_bins + bin];
+            EXPECT_NEAR( value.real(), expected.real(), 2e-3 ) << "Frame " << frame << ", bin " << bin;
+            EXPECT_NEAR( value.imag(), expected.imag(), 2e-3 ) << "Frame " << frame << ", bin " << bin;
+        }
+    }
+}
+
+TEST_F( ExactCQTTest, test_sparse_kernel )
+///
+/// Tests that the default threshold keeps a small fraction of the kernel, and changes the output
+/// by much less than the output itself.
+///
+{
+    ExactCQT< FFT_SIZE > dense( rectangular, SAMPLE_RATE, MIN_FREQUENCY, BINS_PER_OCTAVE, 0, 0.0f );
+    ExactCQT< FFT_SIZE > sparse( rectangular, SAMPLE_RATE, MIN_FREQUENCY, BINS_PER_OCTAVE );
+    ASSERT_EQ( sparse.GetNumBins(), dense.GetNumBins() );
+    EXPECT_LT( sparse.GetNumNonZeros()*5, dense.GetNumNonZeros() );
+
+    ExactCQTFrames expected = dense.Process( frames.data(), NUM_FRAMES );
+    ExactCQTFrames& result = sparse.Process( frames.data(), NUM_FRAMES );
+    ASSERT_EQ( result.values.size(), expected.values.size() );
+    double error = 0.0;
+    double energy = 0.0;
+    for( size_t i=0; i<result.values.size(); ++i )
+    {
+        error += std::norm( result.values[i] - expected.values[i] );
+        energy += std::norm( expected.values[i] );
+    }
+    EXPECT_LT( error, 1e-3*energy );
+}
+
+TEST_F( ExactCQTTest, test_tone_frequency )
+///
+/// Tests that a tone at the centre frequency of a bin peaks in that bin, with a Hamming analysis
+/// window divided out of the kernel, and that FastWavelet gives the same frames from the STFT it
+/// shares with PushSamples.
+///
+{
+    std::vector< float > window( FFT_SIZE );
+    veclib::hamming( window );
+    const size_t num_bins = 48;
+    const size_t tone_bin = 29;
+
+    FastWavelet< FFT_SIZE > wavelet( 0.75, window );
+    EXPECT_THROW( wavelet.PushSamplesExact( noise ), std::logic_error );
+    wavelet.ConfigureExact( SAMPLE_RATE, MIN_FREQUENCY, BINS_PER_OCTAVE, num_bins, ExactCQT< FFT_SIZE >::DEFAULT_THRESHOLD );
+    const std::vector< float > frequencies = wavelet.GetExactFrequencies();
+    ASSERT_EQ( frequencies.size(), num_bins );
+
+    std::vector< float > tone( 4*FFT_SIZE );
+    for( size_t sample=0; sample<tone.size(); ++sample )
+    {
+        tone[sample] = static_cast< float >( std::sin( 2.0*M_PI*frequencies[tone_bin]*sample/SAMPLE_RATE ) );
+    }
+    ExactCQTFrames& result = wavelet.PushSamplesExact( tone );
+    ASSERT_EQ( result.num_frames, ( tone.size() - FFT_SIZE )/wavelet.GetIncrement() + 1 );
+    ASSERT_EQ( result.num_bins, num_bins );
+    for( size_t frame=0; frame<result.num_frames; ++frame )
+    {
+        const auto first = result.values.begin() + frame*num_bins;
+        const size_t peak = std::max_element( first, first + num_bins, []( std::complex< float > a, std::complex< float > b ){ return std::abs( a ) < std::abs( b ); } ) - first;
+        EXPECT_EQ( peak, tone_bin ) << "Frame " << frame;
+        EXPECT_NEAR( std::abs( first[tone_bin] ), 0.27, 0.01 ) << "Frame " << frame;
+    }
+}
+
+TEST_F( ExactCQTTest, test_invalid_arguments )
+///
+/// Tests that kernels longer than the window, bins reaching the Nyquist frequency and bad thresholds
+/// are refused.
+///
+{
+    EXPECT_THROW( ExactCQT< FFT_SIZE >( rectangular, SAMPLE_RATE, 100.0f, BINS_PER_OCTAVE ), std::invalid_argument );
+    EXPECT_THROW( ExactCQT< FFT_SIZE >( rectangular, SAMPLE_RATE, MIN_FREQUENCY, BINS_PER_OCTAVE, 100 ), std::invalid_argument );
+    EXPECT_THROW( ExactCQT< FFT_SIZE >( rectangular, SAMPLE_RATE, MIN_FREQUENCY, 0 ), std::invalid_argument );
+    EXPECT_THROW( ExactCQT< FFT_SIZE >( rectangular, SAMPLE_RATE, MIN_FREQUENCY, BINS_PER_OCTAVE, 0, 1.0f ), std::invalid_argument );
+    EXPECT_THROW( ExactCQT< FFT_SIZE >( std::vector< float >( 2*FFT_SIZE, 1.0f ), SAMPLE_RATE, MIN_FREQUENCY, BINS_PER_OCTAVE ), std::invalid_argument );
+    EXPECT_NO_THROW( ExactCQT< FFT_SIZE >( rectangular, SAMPLE_RATE, MIN_FREQUENCY, BINS_PER_OCTAVE, 50 ) );
+}
@@ -0,0 +1,282 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for FastWavelet class
+//
+
+// In module includes
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+
+using namespace cupcake;
+
+class FastWaveletTest : public ::testing::Test
+///
+/// Test fixture for FastWavelet tests.
+/// Creates and holds a window and a block of input clips.
+///
+{
+protected:
+
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const size_t NUM_CLIPS = 7;
+    const size_t CLIP_STRIDE = 44100;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create a window and some noise clips.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        clips.resize( NUM_CLIPS*CLIP_STRIDE );
+        std::generate( clips.begin(), clips.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    std::vector< float > window;    // The window used by all transforms.
+    std::vector< float > clips;     // NUM_CLIPS clips of CLIP_STRIDE samples each, stored contiguously.
+
+};
+
+template< size_t FFT_SIZE >
+void check_batch_matches_streaming( const std::vector< float >& window, float overlap, const std::vector< float >& clips, size_t num_clips, size_t clip_stride )
+///
+/// Checks that transforming a batch of clips of differing lengths gives the same frames as
+/// pushing each clip through its own FastWavelet, with zeros beyond the end of shorter clips.
+///
+{
+    FastWavelet< FFT_SIZE > batch_transform( overlap, window );
+
+    std::vector< size_t > lengths( num_clips );
+    for( size_t clip=0; clip<num_clips; ++clip )
+    {
+        lengths[clip] = clip_stride - clip*( clip_stride/num_clips );
+    }
+    lengths[num_clips-1] = window.size() - 1;   // -> Too short for a single frame.
+
+    const size_t num_frames = batch_transform.GetNumFrames( clip_stride );
+    const size_t num_bins = FastWavelet< FFT_SIZE >::mOutputSize;
+    std::vector< std::complex< float > > output( num_clips*num_frames*num_bins, std::complex< float >( 1.0, 1.0 ) );
+
+    // Run twice to check that the pool and per thread state are reusable.
+    for( int run=0; run<2; ++run )
+    {
+        batch_transform.TransformBatch( clips.data(), num_clips, clip_stride, lengths.data(), output.data(), num_frames );
+
+        for( size_t clip=0; clip<num_clips; ++clip )
+        {
+            FastWavelet< FFT_SIZE > reference( overlap, window );
+            const std::vector< float > clip_samples( clips.begin() + clip*clip_stride, clips.begin() + clip*clip_stride + lengths[clip] );
+            auto& expected = reference.PushSamples( clip_samples );
+            ASSERT_EQ( expected.size(), batch_transform.GetNumFrames( lengths[clip] ) );
+
+            for( size_t frame=0; frame<num_frames; ++frame )
+            {
+                const std::complex< float >* result = output.data() + ( clip*num_frames + frame )*num_bins;
+                for( size_t bin=0; bin<num_bins; ++bin )
+                {
+                    const std::complex< float > expected_value = frame < expected.size() ? expected[frame][bin] : std::complex< float >( 0.0, 0.0 );
+                    ASSERT_EQ( result[bin], expected_value );
+                }
+            }
+        }
+    }
+}
+
+TEST_F( FastWaveletTest, test_batch_matches_streaming )
+///
+/// Tests batch transforms against streaming transforms for the default FFT size.
+///
+{
+    check_batch_matches_streaming< 4096 >( window, OVERLAP, clips, NUM_CLIPS, CLIP_STRIDE );
+}
+
+TEST_F( FastWaveletTest, test_fft_sizes )
+///
+/// Tests batch transforms against streaming transforms for the smallest FFT size that fits the
+/// window, and checks that the output size follows the FFT size.
+///
+{
+    static_assert( FastWavelet< 1024 >::mOutputSize == veclib::get_output_FFT_size( 1024 ), "Output size must follow the FFT size" );
+    check_batch_matches_streaming< 1024 >( window, OVERLAP, clips, NUM_CLIPS, CLIP_STRIDE );
+}
+
+TEST_F( FastWaveletTest, test_batch_leaves_stream_untouched )
+///
+/// Tests that a batch transform does not disturb samples buffered by PushSamples.
+///
+{
+    FastWavelet<> transform( OVERLAP, window );
+    FastWavelet<> reference( OVERLAP, window );
+
+    const std::vector< float > first( clips.begin(), clips.begin() + WINDOW_LENGTH/2 );
+    const std::vector< float > second( clips.begin() + WINDOW_LENGTH/2, clips.begin() + 2*WINDOW_LENGTH );
+    transform.PushSamples( first );
+    reference.PushSamples( first );
+
+    const size_t num_frames = transform.GetNumFrames( CLIP_STRIDE );
+    std::vector< std::complex< float > > output( NUM_CLIPS*num_frames*FastWavelet<>::mOutputSize );
+    transform.TransformBatch( clips.data(), NUM_CLIPS, CLIP_STRIDE, nullptr, output.data(), num_frames );
+
+    auto& result = transform.PushSamples( second );
+    auto& expected = reference.PushSamples( second );
+    ASSERT_EQ( result.size(), expected.size() );
+    for( size_t frame=0; frame<result.size(); ++frame )
+    {
+        ASSERT_TRUE( result[frame] == expected[frame] );
+    }
+}
+
+TEST_F( FastWaveletTest, test_parallel_matches_serial )
+///
+/// Tests that pushing samples in parallel gives exactly the frames of PushSamples, for pushes of
+/// any size, including one longer than the STFT input buffer, mixed with serial pushes.
+///
+{
+    const size_t NUM_REPEATS = 5;           // -> 35 seconds, more than the STFT input buffer holds.
+    const size_t SERIAL_PIECE = 44100;
+
+    std::vector< float > signal;
+    for( size_t repeat=0; repeat<NUM_REPEATS; ++repeat )
+    {
+        signal.insert( signal.end(), clips.begin(), clips.end() );
+    }
+
+    FastWavelet< 1024 > reference( OVERLAP, window );
+    std::vector< FastWavelet< 1024 >::Frame > expected;
+    for( size_t pos=0; pos<signal.size(); pos+=SERIAL_PIECE )
+    {
+        auto& frames = reference.PushSamples( ArrayView< const float >( signal.data() + pos, std::min( SERIAL_PIECE, signal.size() - pos ) ) );
+        expected.insert( expected.end(), frames.begin(), frames.end() );
+    }
+
+    FastWavelet< 1024 > transform( OVERLAP, window );
+    transform.ConfigureParallel( 3 );
+    const size_t pieces[] = { 1, WINDOW_LENGTH - 2, 5*WINDOW_LENGTH + 77, 3, 44100*2, 44100*31 };
+    std::vector< FastWavelet< 1024 >::Frame > result;
+    size_t pos = 0;
+    for( size_t piece=0; pos<signal.size(); ++piece )
+    {
+        const size_t num_samples = std::min( pieces[piece%( sizeof( pieces )/sizeof( pieces[0] ) )], signal.size() - pos );
+        const ArrayView< const float > audio( signal.data() + pos, num_samples );
+        auto& frames = piece == 3 ? transform.PushSamples( audio ) : transform.PushSamplesParallel( audio );
+        result.insert( result.end(), frames.begin(), frames.end() );
+        pos += num_samples;
+    }
+
+    ASSERT_EQ( result.size(), expected.size() );
+    for( size_t frame=0; frame<expected.size(); ++frame )
+    {
+        ASSERT_TRUE( result[frame] == expected[frame] ) << "Frame " << frame;
+    }
+}
+
+TEST_F( FastWaveletTest, test_push_into )
+///
+/// Tests that pushing samples into caller owned memory, as the Python binding does, writes exactly
+/// GetNumPushFrames frames there, identical to those of PushSamples, for short pushes that leave
+/// samples buffered between calls, serially and in parallel.
+///
+{
+    typedef FastWavelet< 1024 >::FrameBuffer FrameBuffer;
+
+    FastWavelet< 1024 > reference( OVERLAP, window );
+    FastWavelet< 1024 > transform( OVERLAP, window );
+    transform.ConfigureParallel( 2 );
+    const size_t pieces[] = { WINDOW_LENGTH - 2, 3, 1, 5*WINDOW_LENGTH + 77, 0, 300 };
+    size_t pos = 0;
+    for( size_t piece=0; piece<2*sizeof( pieces )/sizeof( pieces[0] ); ++piece )
+    {
+        const size_t num_samples = pieces[piece%( sizeof( pieces )/sizeof( pieces[0] ) )];
+        const ArrayView< const float > audio( clips.data() + pos, num_samples );
+        pos += num_samples;
+
+        FrameBuffer expected = reference.PushSamples( audio );
+        FrameBuffer frames( transform.GetNumPushFrames( num_samples ) );
+        const size_t num_frames = piece%2 ? transform.PushSamplesParallelInto( audio, frames.data() ) : transform.PushSamplesInto( audio, frames.data() );
+
+        ASSERT_EQ( num_frames, expected.size() );
+        ASSERT_EQ( frames.size(), expected.size() );
+        EXPECT_TRUE( frames == expected ) << "Piece " << piece;
+        EXPECT_EQ( transform.GetBufferedSamples(), reference.GetBufferedSamples() );
+    }
+}
+
+TEST_F( FastWaveletTest, test_latency )
+///
+/// Tests that the latency is that of the STFT, and that every sample pushed is either buffered or
+/// has been stepped past by a frame.
+///
+{
+    FastWavelet<> transform( OVERLAP, window );
+    EXPECT_EQ( transform.GetAlgorithmicLatency(), WINDOW_LENGTH - 1 );
+    EXPECT_EQ( transform.GetBufferedSamples(), 0u );
+
+    const size_t pieces[] = { WINDOW_LENGTH - 1, 1, 1, 3000, 17 };
+    size_t num_samples = 0;
+    size_t num_frames = 0;
+    for( size_t piece : pieces )
+    {
+        num_frames += transform.PushSamples( ArrayView< const float >( clips.data() + num_samples, piece ) ).size();
+        num_samples += piece;
+        EXPECT_EQ( transform.GetBufferedSamples(), num_samples - num_frames*transform.GetIncrement() );
+    }
+    EXPECT_EQ( num_frames, transform.GetNumFrames( num_samples ) );
+}
+
+TEST_F( FastWaveletTest, test_stats )
+///
+/// Tests that the statistics count the frames, calls and samples pushed, and that they are reset.
+/// Without CUPCAKE_ENABLE_STATS they must all read as zero.
+///
+{
+    const size_t CHUNK_SIZE = 1000;         // -> The number of samples per push.
+    const size_t NUM_CHUNKS = 20;           // -> The number of pushes.
+
+    FastWavelet<> transform( OVERLAP, window );
+
+    size_t num_frames = 0;
+    for( size_t chunk=0; chunk<NUM_CHUNKS; ++chunk )
+    {
+        const std::vector< float > samples( clips.begin() + chunk*CHUNK_SIZE, clips.begin() + ( chunk + 1 )*CHUNK_SIZE );
+        num_frames += transform.PushSamples( samples ).size();
+    }
+
+    ProcessingStats stats = transform.GetStats();
+#if CUPCAKE_ENABLE_STATS
+    const size_t increment = static_cast< size_t >( ( 1 - OVERLAP )*WINDOW_LENGTH );
+    const size_t frame_bytes = FastWavelet<>::mOutputSize*sizeof( std::complex< float > );
+    ASSERT_EQ( stats.calls, NUM_CHUNKS );
+    ASSERT_EQ( stats.frames, num_frames );
+    ASSERT_EQ( stats.buffer_occupancy, NUM_CHUNKS*CHUNK_SIZE - num_frames*increment );
+    ASSERT_GE( stats.max_buffer_occupancy, stats.buffer_occupancy );
+    ASSERT_EQ( stats.bytes_moved, NUM_CHUNKS*CHUNK_SIZE*sizeof( float ) + 3*num_frames*frame_bytes );
+    ASSERT_GT( stats.fft_cycles, 0 );
+    ASSERT_GT( stats.cqt_cycles, 0 );
+    ASSERT_GE( stats.total_cycles, stats.buffer_cycles + stats.window_cycles + stats.fft_cycles + stats.cqt_cycles );
+#else
+    ASSERT_EQ( stats.calls, 0 );
+    ASSERT_EQ( stats.frames, 0 );
+    ASSERT_EQ( stats.total_cycles, 0 );
+#endif
+
+    transform.ResetStats();
+    stats = transform.GetStats();
+    ASSERT_EQ( stats.calls, 0 );
+    ASSERT_EQ( stats.frames, 0 );
+    ASSERT_EQ( stats.bytes_moved, 0 );
+    ASSERT_EQ( stats.total_cycles, 0 );
+    ASSERT_EQ( stats.max_buffer_occupancy, 0 );
+}
@@ -0,0 +1,138 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for FrameDecimator class
+//
+
+// In module includes
+#include "FrameDecimator.h"
+#include "FastCQT.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace cupcake;
+
+class FrameDecimatorTest : public ::testing::Test
+///
+/// Test fixture for FrameDecimator tests.
+/// Creates and holds a window and a block of white noise.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.96875;          // -> 32 hops per window.
+    const size_t SIGNAL_LENGTH = 44100;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create the window and noise.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        noise.resize( SIGNAL_LENGTH );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    std::vector< float > window;        // The analysis window.
+    std::vector< float > noise;         // White noise.
+
+};
+
+TEST_F( FrameDecimatorTest, test_effective_window_lengths )
+///
+/// Tests that the effective windows of the fast CQT shorten from the STFT window at DC, and that
+/// the decimation of each bin follows them.
+///
+{
+    FastCQT< FFT_SIZE > cqt( WINDOW_LENGTH );
+    std::vector< float > lengths = cqt.GetEffectiveWindowLengths();
+    ASSERT_EQ( lengths.size(), FrameDecimator< FFT_SIZE >::mFrameSize );
+    EXPECT_FLOAT_EQ( lengths.front(), WINDOW_LENGTH );
+    EXPECT_TRUE( std::is_sorted( lengths.rbegin(), lengths.rend() ) );
+
+    const size_t increment = WINDOW_LENGTH/32;
+    FrameDecimator< FFT_SIZE > decimator( lengths, increment );
+    const std::vector< size_t >& decimation = decimator.GetDecimation();
+    EXPECT_EQ( decimation.front(), 8u );
+    EXPECT_EQ( decimation.back(), 1u );
+    for( size_t bin=0; bin<decimation.size(); ++bin )
+    {
+        // The largest power of two with min_hops_per_window frames in each effective window.
+        EXPECT_LE( decimation[bin]*increment*FrameDecimator< FFT_SIZE >::DEFAULT_MIN_HOPS_PER_WINDOW, std::max( lengths[bin], static_cast< float >( increment*FrameDecimator< FFT_SIZE >::DEFAULT_MIN_HOPS_PER_WINDOW ) ) ) << "Bin " << bin;
+        EXPECT_GT( 2*decimation[bin]*increment*FrameDecimator< FFT_SIZE >::DEFAULT_MIN_HOPS_PER_WINDOW, lengths[bin] ) << "Bin " << bin;
+    }
+
+    EXPECT_THROW( FrameDecimator< FFT_SIZE >( lengths, 0 ), std::invalid_argument );
+    EXPECT_THROW( FrameDecimator< FFT_SIZE >( lengths, increment, 0 ), std::invalid_argument );
+    EXPECT_THROW( FrameDecimator< FFT_SIZE >( std::vector< float >( 3, 1.0f ), increment ), std::invalid_argument );
+}
+
+TEST_F( FrameDecimatorTest, test_matches_full_rate )
+///
+/// Tests that the bands cover every bin, and that each band holds every D-th full rate frame of its
+/// bins, however the stream is divided into calls.
+///
+{
+    FastWavelet< FFT_SIZE > full( OVERLAP, window );
+    auto expected = full.PushSamples( noise );
+    ASSERT_GT( expected.size(), 0u );
+
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    EXPECT_THROW( wavelet.PushSamplesDecimated( noise ), std::logic_error );
+    wavelet.ConfigureDecimation( FrameDecimator< FFT_SIZE >::DEFAULT_MIN_HOPS_PER_WINDOW );
+
+    std::vector< std::vector< std::complex< float > > > result;
+    std::vector< size_t > first_bins;
+    std::vector< size_t > decimations;
+    size_t values = 0;
+    for( size_t pos=0, piece=1; pos<noise.size(); pos+=piece, piece=( piece*7 )%1999 + 1 )
+    {
+        DecimatedFrames& frames = wavelet.PushSamplesDecimated( ArrayView< const float >( noise.data() + pos, std::min( piece, noise.size() - pos ) ) );
+        result.resize( frames.bands.size() );
+        first_bins.resize( frames.bands.size() );
+        decimations.resize( frames.bands.size() );
+        for( size_t band=0; band<frames.bands.size(); ++band )
+        {
+            const DecimatedBand& output = frames.bands[band];
+            EXPECT_EQ( output.first_frame*output.num_bins, result[band].size() );
+            result[band].insert( result[band].end(), output.values.begin(), output.values.end() );
+            first_bins[band] = output.first_bin;
+            decimations[band] = output.decimation;
+            values += output.values.size();
+        }
+    }
+
+    ASSERT_GT( result.size(), 1u );
+    EXPECT_EQ( first_bins.front(), 0u );
+    EXPECT_EQ( decimations.back(), 1u );
+    for( size_t band=0; band<result.size(); ++band )
+    {
+        const size_t end_bin = band + 1 < result.size() ? first_bins[band+1] : FastWavelet< FFT_SIZE >::mOutputSize;
+        const size_t num_bins = end_bin - first_bins[band];
+        const size_t num_frames = ( expected.size() + decimations[band] - 1 )/decimations[band];
+        ASSERT_EQ( result[band].size(), num_frames*num_bins ) << "Band " << band;
+        for( size_t frame=0; frame<num_frames; ++frame )
+        {
+            const auto& input = expected[frame*decimations[band]];
+            EXPECT_TRUE( std::equal( input.begin() + first_bins[band], input.begin() + end_bin, result[band].begin() + frame*num_bins ) ) << "Band " << band << ", frame " << frame;
+        }
+    }
+
+    // The low bands hold fewer frames.
+    EXPECT_LT( values, expected.size()*FastWavelet< FFT_SIZE >::mOutputSize );
+}
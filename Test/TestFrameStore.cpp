@@ -0,0 +1,386 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for FrameStoreWriter and FrameStoreReader classes
+//
+
+// In module includes
+#include "FrameStore.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+
+using namespace cupcake;
+
+class FrameStoreTest : public ::testing::Test
+///
+/// Test fixture for FrameStore tests.
+/// Creates and holds a window, some noise and the path of a fresh store file.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    static const size_t NUM_BINS = FFT_SIZE/2 + 1;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const size_t HOP = 256;
+    const size_t SIGNAL_LENGTH = 44100;
+
+    virtual void SetUp()
+    ///
+    /// Before each test, create a window, some noise and an empty temporary file.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        noise.resize( SIGNAL_LENGTH );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+
+        char name[] = "/tmp/cupcake_frame_store_XXXXXX";
+        const int file = mkstemp( name );
+        ASSERT_GE( file, 0 );
+        close( file );
+        path = name;
+    }
+
+    virtual void TearDown()
+    ///
+    /// After each test, remove the store file.
+    ///
+    {
+        std::remove( path.c_str() );
+    }
+
+    std::vector< std::complex< float > > MakeFrames( size_t num_frames, float offset )
+    ///
+    /// Makes frames whose values identify their frame and bin.
+    ///
+    {
+        std::vector< std::complex< float > > frames( num_frames*NUM_BINS );
+        for( size_t value=0; value<frames.size(); ++value )
+        {
+            frames[value] = std::complex< float >( offset + value, -offset - value );
+        }
+        return frames;
+    }
+
+    std::vector< float > window;        // The analysis window.
+    std::vector< float > noise;         // White noise.
+    std::string path;                   // The store file.
+
+};
+
+const size_t FrameStoreTest::FFT_SIZE;
+const size_t FrameStoreTest::NUM_BINS;
+
+TEST_F( FrameStoreTest, test_round_trip )
+///
+/// Tests that clips written in several pieces are read back exactly, by index and by name, and that
+/// the header describes the transform.
+///
+{
+    const auto first = MakeFrames( 10, 0.0f );
+    const auto second = MakeFrames( 7, 1000.0f );
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        EXPECT_EQ( writer.GetNumBins(), NUM_BINS );
+        EXPECT_EQ( writer.BeginClip( "first" ), 0u );
+        EXPECT_TRUE( writer.IsClipOpen() );
+        writer.WriteFrames( first.data(), 4 );
+        writer.WriteFrames( first.data() + 4*NUM_BINS, 6 );
+        writer.EndClip();
+        EXPECT_EQ( writer.BeginClip( "second" ), 1u );
+        writer.WriteFrames( second.data(), 7 );
+        writer.EndClip();
+        EXPECT_EQ( writer.GetNumClips(), 2u );
+        EXPECT_THROW( writer.EndClip(), std::logic_error );
+    }
+
+    FrameStoreReader reader( path );
+    EXPECT_EQ( reader.GetFFTSize(), FFT_SIZE );
+    EXPECT_EQ( reader.GetHop(), HOP );
+    EXPECT_EQ( reader.GetNumBins(), NUM_BINS );
+    EXPECT_EQ( reader.GetWindowLength(), WINDOW_LENGTH );
+    EXPECT_EQ( reader.GetWindowHash(), hash_window( window ) );
+    ASSERT_EQ( reader.GetNumClips(), 2u );
+    EXPECT_EQ( reader.GetClipName( 0 ), "first" );
+    EXPECT_EQ( reader.FindClip( "second" ), 1u );
+    EXPECT_THROW( reader.FindClip( "third" ), std::out_of_range );
+
+    ASSERT_EQ( reader.GetNumFrames( 0 ), 10u );
+    ASSERT_EQ( reader.GetNumFrames( 1 ), 7u );
+    EXPECT_TRUE( std::equal( first.begin(), first.end(), reader.GetFrames( 0 ) ) );
+    EXPECT_TRUE( std::equal( second.begin(), second.end(), reader.GetFrames( 1 ) ) );
+    EXPECT_EQ( *reader.GetFrames( 1, 3 ), second[3*NUM_BINS] );
+    EXPECT_EQ( reinterpret_cast< uintptr_t >( reader.GetFrames( 1 ) )%FRAME_STORE_ALIGNMENT, 0u );
+    EXPECT_THROW( reader.GetFrames( 1, 8 ), std::out_of_range );
+}
+
+TEST_F( FrameStoreTest, test_shared_writer )
+///
+/// Tests that frames written to one clip from several threads at once are each stored whole, and
+/// in the order each thread wrote them.
+///
+{
+    const size_t NUM_THREADS = 4;
+    const size_t FRAMES_PER_THREAD = 50;
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        writer.BeginClip( "shared" );
+        std::vector< std::thread > threads;
+        for( size_t thread=0; thread<NUM_THREADS; ++thread )
+        {
+            threads.emplace_back( [this, thread, &writer]()
+            {
+                for( size_t frame=0; frame<FRAMES_PER_THREAD; ++frame )
+                {
+                    const auto frames = MakeFrames( 1, thread*100000.0f + frame*1000.0f );
+                    writer.WriteFrames( frames.data(), 1 );
+                }
+            } );
+        }
+        for( auto& thread : threads )
+        {
+            thread.join();
+        }
+        writer.EndClip();
+    }
+
+    FrameStoreReader reader( path );
+    ASSERT_EQ( reader.GetNumFrames( 0 ), NUM_THREADS*FRAMES_PER_THREAD );
+    std::vector< size_t > next_frame( NUM_THREADS, 0 );
+    for( size_t frame=0; frame<NUM_THREADS*FRAMES_PER_THREAD; ++frame )
+    {
+        const std::complex< float >* stored = reader.GetFrames( 0, frame );
+        const size_t thread = static_cast< size_t >( stored[0].real()/100000.0f );
+        ASSERT_LT( thread, NUM_THREADS );
+        const auto expected = MakeFrames( 1, thread*100000.0f + next_frame[thread]*1000.0f );
+        EXPECT_TRUE( std::equal( expected.begin(), expected.end(), stored ) );
+        ++next_frame[thread];
+    }
+}
+
+TEST_F( FrameStoreTest, test_append )
+///
+/// Tests that reopening a store appends to it, that a later clip hides an earlier one of the same
+/// name, and that a store cannot be reopened with a different transform.
+///
+{
+    const auto first = MakeFrames( 3, 0.0f );
+    const auto second = MakeFrames( 5, 500.0f );
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        writer.BeginClip( "clip" );
+        writer.WriteFrames( first.data(), 3 );
+        writer.EndClip();
+    }
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        EXPECT_EQ( writer.GetNumClips(), 1u );
+        writer.BeginClip( "clip" );
+        writer.WriteFrames( second.data(), 5 );
+        writer.EndClip();
+    }
+
+    FrameStoreReader reader( path );
+    ASSERT_EQ( reader.GetNumClips(), 2u );
+    EXPECT_TRUE( std::equal( first.begin(), first.end(), reader.GetFrames( 0 ) ) );
+    EXPECT_EQ( reader.FindClip( "clip" ), 1u );
+    EXPECT_TRUE( std::equal( second.begin(), second.end(), reader.GetFrames( 1 ) ) );
+
+    EXPECT_THROW( FrameStoreWriter( path, FFT_SIZE, HOP/2, window ), std::runtime_error );
+    EXPECT_THROW( FrameStoreWriter( path, FFT_SIZE*2, HOP, window ), std::runtime_error );
+    std::vector< float > other_window( window );
+    other_window[0] += 0.5f;
+    EXPECT_THROW( FrameStoreWriter( path, FFT_SIZE, HOP, other_window ), std::runtime_error );
+}
+
+TEST_F( FrameStoreTest, test_unfinished_clip )
+///
+/// Tests that readers ignore a clip that is still being written, and that the next writer
+/// replaces it.
+///
+{
+    const auto frames = MakeFrames( 4, 0.0f );
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        writer.BeginClip( "done" );
+        writer.WriteFrames( frames.data(), 4 );
+        writer.EndClip();
+        writer.BeginClip( "pending" );
+        writer.WriteFrames( frames.data(), 2 );
+        writer.Flush();
+
+        FrameStoreReader reader( path );
+        ASSERT_EQ( reader.GetNumClips(), 1u );
+        EXPECT_EQ( reader.GetClipName( 0 ), "done" );
+    }
+
+    // The destructor finishes the open clip.
+    {
+        FrameStoreReader reader( path );
+        ASSERT_EQ( reader.GetNumClips(), 2u );
+        EXPECT_EQ( reader.GetNumFrames( 1 ), 2u );
+    }
+
+    // Mark the last clip unfinished, as though the writer had crashed, and append another clip.
+    {
+        FrameStoreReader reader( path );
+        const uint64_t frames_offset = reinterpret_cast< const char* >( reader.GetFrames( 1 ) ) - reinterpret_cast< const char* >( reader.GetFrames( 0 ) );
+        FILE* file = std::fopen( path.c_str(), "r+b" );
+        ASSERT_NE( file, nullptr );
+        // Both clips have short names, so each clip header is one alignment block before its frames.
+        const long clip_start = static_cast< long >( FRAME_STORE_HEADER_SIZE + frames_offset );
+        std::fseek( file, clip_start + static_cast< long >( offsetof( FrameStoreClipHeader, num_frames ) ), SEEK_SET );
+        std::fwrite( &FRAME_STORE_OPEN_CLIP, sizeof( FRAME_STORE_OPEN_CLIP ), 1, file );
+        std::fclose( file );
+    }
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        EXPECT_EQ( writer.GetNumClips(), 1u );
+        writer.BeginClip( "replacement" );
+        writer.WriteFrames( frames.data(), 3 );
+        writer.EndClip();
+    }
+
+    FrameStoreReader reader( path );
+    ASSERT_EQ( reader.GetNumClips(), 2u );
+    EXPECT_EQ( reader.GetClipName( 1 ), "replacement" );
+    EXPECT_EQ( reader.GetNumFrames( 1 ), 3u );
+    EXPECT_THROW( reader.FindClip( "pending" ), std::out_of_range );
+}
+
+TEST_F( FrameStoreTest, test_single_writer )
+///
+/// Tests that a store cannot be opened by a second writer while the first has it open, and can
+/// be once the first is closed.
+///
+{
+    const auto frames = MakeFrames( 2, 0.0f );
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        writer.BeginClip( "open" );
+        writer.WriteFrames( frames.data(), 2 );
+        EXPECT_THROW( FrameStoreWriter( path, FFT_SIZE, HOP, window ), std::runtime_error );
+        EXPECT_TRUE( writer.IsClipOpen() );
+    }
+
+    FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+    EXPECT_EQ( writer.GetNumClips(), 1u );
+}
+
+TEST_F( FrameStoreTest, test_corrupt_frame_count )
+///
+/// Tests that a frame count so large that the end of its clip overflows is reported as a
+/// truncated store, rather than passing the bounds check.
+///
+{
+    const auto frames = MakeFrames( 2, 0.0f );
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        writer.BeginClip( "clip" );
+        writer.WriteFrames( frames.data(), 2 );
+        writer.EndClip();
+    }
+
+    FILE* file = std::fopen( path.c_str(), "r+b" );
+    ASSERT_NE( file, nullptr );
+    const uint64_t frame_bytes = NUM_BINS*sizeof( std::complex< float > );
+    const uint64_t corrupt_frames = ~static_cast< uint64_t >( 0 )/frame_bytes + 2;
+    std::fseek( file, static_cast< long >( FRAME_STORE_HEADER_SIZE + offsetof( FrameStoreClipHeader, num_frames ) ), SEEK_SET );
+    std::fwrite( &corrupt_frames, sizeof( corrupt_frames ), 1, file );
+    std::fclose( file );
+
+    EXPECT_THROW( FrameStoreReader reader( path ), std::runtime_error );
+    EXPECT_THROW( FrameStoreWriter( path, FFT_SIZE, HOP, window ), std::runtime_error );
+}
+
+TEST_F( FrameStoreTest, test_fast_wavelet_stream )
+///
+/// Tests that streaming audio from FastWavelet into a store in chunks stores the same frames as
+/// pushing the audio directly.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    auto expected = wavelet.PushSamples( noise );
+
+    FastWavelet< FFT_SIZE > streaming_wavelet( OVERLAP, window );
+    size_t num_written = 0;
+    {
+        FrameStoreWriter writer( path, FFT_SIZE, HOP, window );
+        writer.BeginClip( "noise" );
+        for( size_t pos=0; pos<SIGNAL_LENGTH; pos+=5000 )
+        {
+            const size_t length = std::min< size_t >( 5000, SIGNAL_LENGTH - pos );
+            num_written += streaming_wavelet.PushSamplesToStore( ArrayView< const float >( noise.data() + pos, length ), writer );
+        }
+        writer.EndClip();
+
+        FrameStoreWriter wrong_size( path + ".other", FFT_SIZE*2, HOP, window );
+        wrong_size.BeginClip( "noise" );
+        EXPECT_THROW( streaming_wavelet.PushSamplesToStore( ArrayView< const float >( noise ), wrong_size ), std::invalid_argument );
+    }
+    std::remove( ( path + ".other" ).c_str() );
+
+    FrameStoreReader reader( path );
+    ASSERT_EQ( num_written, expected.size() );
+    ASSERT_EQ( reader.GetNumFrames( reader.FindClip( "noise" ) ), expected.size() );
+    const std::complex< float >* stored = reader.GetFrames( 0 );
+    for( size_t frame=0; frame<expected.size(); ++frame )
+    {
+        EXPECT_TRUE( std::equal( expected[frame].begin(), expected[frame].end(), stored + frame*NUM_BINS ) );
+    }
+}
+
+TEST_F( FrameStoreTest, test_fast_wavelet_wrong_hop )
+///
+/// Tests that streaming into a store written with a different hop throws, and writes nothing.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    FrameStoreWriter writer( path, FFT_SIZE, HOP*2, window );
+    writer.BeginClip( "noise" );
+    EXPECT_THROW( wavelet.PushSamplesToStore( ArrayView< const float >( noise ), writer ), std::invalid_argument );
+    EXPECT_EQ( wavelet.GetBufferedSamples(), 0u );
+    writer.EndClip();
+
+    FrameStoreReader reader( path );
+    EXPECT_EQ( reader.GetNumFrames( 0 ), 0u );
+}
+
+TEST_F( FrameStoreTest, test_fast_wavelet_wrong_window )
+///
+/// Tests that streaming into a store written with a different window of the same length throws,
+/// and writes nothing.
+///
+{
+    std::vector< float > other_window( WINDOW_LENGTH, 1.0f );
+
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    FrameStoreWriter writer( path, FFT_SIZE, HOP, other_window );
+    writer.BeginClip( "noise" );
+    EXPECT_THROW( wavelet.PushSamplesToStore( ArrayView< const float >( noise ), writer ), std::invalid_argument );
+    EXPECT_EQ( wavelet.GetBufferedSamples(), 0u );
+    writer.EndClip();
+
+    FrameStoreReader reader( path );
+    EXPECT_EQ( reader.GetNumFrames( 0 ), 0u );
+}
@@ -0,0 +1,151 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for HalfBandDecimator class
+//
+
+// In module includes
+#include "HalfBandDecimator.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+using namespace cupcake;
+
+class HalfBandDecimatorTest : public ::testing::Test
+///
+/// Test fixture for HalfBandDecimator tests.
+/// Creates and holds a block of white noise.
+///
+{
+protected:
+
+    const size_t SIGNAL_LENGTH = 4001;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create the noise.
+    ///
+    {
+        veclib::seed_rand();
+        noise.resize( SIGNAL_LENGTH );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    std::vector< float > noise;         // White noise.
+
+};
+
+TEST_F( HalfBandDecimatorTest, test_impulse_response )
+///
+/// Tests that an impulse at an even sample gives the centre tap only, and that an impulse at an odd
+/// sample gives the remaining taps, each at the output nearest its offset, once the latency has passed.
+///
+{
+    HalfBandDecimator decimator;
+    const std::vector< float >& taps = decimator.GetTaps();
+    const size_t num_taps = taps.size();
+    EXPECT_EQ( decimator.GetLatency(), 2*num_taps - 1 );
+
+    std::vector< float > output;
+    std::vector< float > impulse( 2*num_taps - 1, 0.0f );
+    impulse[0] = 1.0f;
+    EXPECT_EQ( decimator.Process( impulse.data(), impulse.size(), output ), 0u );
+    const float next = 0.0f;
+    EXPECT_EQ( decimator.Process( &next, 1, output ), 1u );
+    EXPECT_FLOAT_EQ( output[0], 0.5f );
+
+    // Odd offsets 2j + 1 reach outputs j + 1 (after the impulse) and, from output 0, -( 2j + 1 ) (before it).
+    decimator.Reset();
+    output.clear();
+    impulse.assign( 6*num_taps, 0.0f );
+    impulse[1] = 1.0f;
+    decimator.Process( impulse.data(), impulse.size(), output );
+    ASSERT_GE( output.size(), num_taps + 1 );
+    EXPECT_FLOAT_EQ( output[0], taps[num_taps-1] );
+    for( size_t j=0; j<num_taps; ++j )
+    {
+        EXPECT_FLOAT_EQ( output[j+1], taps[num_taps-1-j] );
+    }
+    for( size_t m=num_taps+1; m<output.size(); ++m )
+    {
+        EXPECT_EQ( output[m], 0.0f );
+    }
+
+    // Unity gain at DC.
+    float sum = 0.5f;
+    for( float tap : taps )
+    {
+        sum += 2*tap;
+    }
+    EXPECT_NEAR( sum, 1.0f, 1e-6 );
+}
+
+TEST_F( HalfBandDecimatorTest, test_frequency_response )
+///
+/// Tests that a tone in the passband comes through with no change in amplitude or phase, and that
+/// a tone in the stopband is removed.
+///
+{
+    const size_t settle = 2*HalfBandDecimator::DEFAULT_NUM_TAPS;
+    std::vector< float > tone( SIGNAL_LENGTH );
+
+    const double passband = 0.1;        // Cycles per input sample.
+    for( size_t sample=0; sample<tone.size(); ++sample )
+    {
+        tone[sample] = static_cast< float >( std::cos( 2.0*M_PI*passband*sample + 0.3 ) );
+    }
+    HalfBandDecimator decimator;
+    std::vector< float > output;
+    decimator.Process( tone.data(), tone.size(), output );
+    ASSERT_GT( output.size(), settle );
+    for( size_t m=settle; m<output.size(); ++m )
+    {
+        EXPECT_NEAR( output[m], tone[2*m], 1e-3 ) << "Output " << m;
+    }
+
+    const double stopband = 0.4;
+    for( size_t sample=0; sample<tone.size(); ++sample )
+    {
+        tone[sample] = static_cast< float >( std::cos( 2.0*M_PI*stopband*sample + 0.3 ) );
+    }
+    decimator.Reset();
+    output.clear();
+    decimator.Process( tone.data(), tone.size(), output );
+    for( size_t m=settle; m<output.size(); ++m )
+    {
+        EXPECT_LT( std::abs( output[m] ), 3e-4 ) << "Output " << m;
+    }
+}
+
+TEST_F( HalfBandDecimatorTest, test_streaming )
+///
+/// Tests that pushing a signal in pieces of any size, including odd sizes and single samples, gives
+/// the same output as pushing it at once.
+///
+{
+    HalfBandDecimator whole( 5 );
+    std::vector< float > expected;
+    whole.Process( noise.data(), noise.size(), expected );
+    EXPECT_EQ( expected.size(), ( noise.size() - whole.GetLatency() + 1 )/2 );
+
+    HalfBandDecimator pieces( 5 );
+    std::vector< float > result;
+    for( size_t pos=0, piece=1; pos<noise.size(); pos+=piece, piece=piece%37 + 1 )
+    {
+        pieces.Process( noise.data() + pos, std::min( piece, noise.size() - pos ), result );
+    }
+
+    ASSERT_EQ( result.size(), expected.size() );
+    for( size_t m=0; m<result.size(); ++m )
+    {
+        EXPECT_NEAR( result[m], expected[m], 1e-6 ) << "Output " << m;
+    }
+}
@@ -0,0 +1,347 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for the runtime selected processing kernels
+//
+
+// In module includes
+#include "Kernels.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using namespace cupcake;
+
+class KernelsTest : public ::testing::Test
+///
+/// Test fixture for kernel tests.
+/// Creates and holds random IIR coefficients and a block of random complex frames.
+///
+{
+protected:
+
+    const size_t FRAME_SIZE = 513;
+    const size_t MAX_FRAMES = 17;           // -> Enough frames to leave a remainder after every SIMD width.
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create the coefficients and some noise frames.
+    ///
+    {
+        veclib::seed_rand();
+
+        // Stable coefficients, i.e., with a magnitude below one, as in FastCQT.
+        coeffs.resize( FRAME_SIZE );
+        one_minus_coeffs.resize( FRAME_SIZE );
+        for( size_t bin=0; bin<FRAME_SIZE; ++bin )
+        {
+            coeffs[bin] = std::polar( static_cast< float >( veclib::make_random_number( 0.0, 0.99 ) ), static_cast< float >( veclib::make_random_number( -M_PI, M_PI ) ) );
+            one_minus_coeffs[bin] = 1.0f - coeffs[bin];
+        }
+
+        frames.resize( MAX_FRAMES*FRAME_SIZE );
+        for( auto& bin : frames )
+        {
+            bin = { static_cast< float >( veclib::make_random_number( -1.0, 1.0 ) ), static_cast< float >( veclib::make_random_number( -1.0, 1.0 ) ) };
+        }
+    }
+
+    std::vector< std::complex< float > > coeffs;                // IIR coefficients, one per bin.
+    std::vector< std::complex< float > > one_minus_coeffs;      // One minus each of the above.
+    std::vector< std::complex< float > > frames;                // MAX_FRAMES frames of FRAME_SIZE bins, stored contiguously.
+
+};
+
+void reference_sweep( std::complex< float >* frame, size_t frame_size, const std::complex< float >* coeffs )
+///
+/// The fast CQT filtering of a single frame, as originally written in FastCQT::ApplyInPlace.
+///
+{
+    const std::complex<float>* fc = coeffs;
+    std::complex<float>* last_sig_element = frame;
+    for( size_t bin=0; bin<frame_size; ++bin )
+    {
+        frame[bin] = (*fc)*(*last_sig_element) + ( 1.0f - (*fc) )*frame[bin];
+        last_sig_element = frame + bin;
+        ++fc;
+    }
+
+    --fc;
+    last_sig_element = frame + frame_size - 1;
+    for( std::complex<float>* sig_element=frame+frame_size-2; sig_element>frame; --sig_element )
+    {
+        (*sig_element) = (*fc)*(*last_sig_element) + ( 1.0f - (*fc) )*(*sig_element);
+        last_sig_element = sig_element;
+        --fc;
+    }
+
+    frame[frame_size-1] = {0,0};
+}
+
+TEST_F( KernelsTest, test_generic_matches_reference )
+///
+/// Tests that the generic fast CQT sweep gives exactly the results of the original implementation.
+///
+{
+    std::vector< std::complex< float > > expected = frames;
+    for( size_t frame=0; frame<MAX_FRAMES; ++frame )
+    {
+        reference_sweep( expected.data() + frame*FRAME_SIZE, FRAME_SIZE, coeffs.data() );
+    }
+
+    std::vector< std::complex< float > > result = frames;
+    get_supported_kernels().front()->cqt_sweep( result.data(), MAX_FRAMES, FRAME_SIZE, coeffs.data(), one_minus_coeffs.data() );
+
+    for( size_t i=0; i<result.size(); ++i )
+    {
+        EXPECT_EQ( result[i], expected[i] );
+    }
+}
+
+TEST_F( KernelsTest, test_sweep_variants )
+///
+/// Tests that every fast CQT sweep supported by this CPU matches the generic sweep to within
+/// rounding, for every number of frames up to MAX_FRAMES.
+///
+{
+    const KernelTable& generic = *get_supported_kernels().front();
+    for( auto table : get_supported_kernels() )
+    {
+        for( size_t num_frames=1; num_frames<=MAX_FRAMES; ++num_frames )
+        {
+            std::vector< std::complex< float > > expected = frames;
+            generic.cqt_sweep( expected.data(), num_frames, FRAME_SIZE, coeffs.data(), one_minus_coeffs.data() );
+
+            std::vector< std::complex< float > > result = frames;
+            table->cqt_sweep( result.data(), num_frames, FRAME_SIZE, coeffs.data(), one_minus_coeffs.data() );
+
+            for( size_t i=0; i<result.size(); ++i )
+            {
+                const float tolerance = 1e-5f*std::max( 1.0f, std::abs( expected[i] ) );
+                ASSERT_NEAR( result[i].real(), expected[i].real(), tolerance ) << table->name << ", " << num_frames << " frames, element " << i;
+                ASSERT_NEAR( result[i].imag(), expected[i].imag(), tolerance ) << table->name << ", " << num_frames << " frames, element " << i;
+            }
+        }
+    }
+}
+
+TEST_F( KernelsTest, test_elementwise_variants )
+///
+/// Tests that every element-wise kernel supported by this CPU gives exactly the results of the
+/// generic kernels, for lengths that do and do not fill the SIMD registers.
+///
+{
+    const size_t MAX_LENGTH = 67;
+    std::vector< float > a( MAX_LENGTH );
+    std::vector< float > b( MAX_LENGTH );
+    std::generate( a.begin(), a.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    std::generate( b.begin(), b.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+
+    const KernelTable& generic = *get_supported_kernels().front();
+    for( auto table : get_supported_kernels() )
+    {
+        for( size_t length=0; length<=MAX_LENGTH; ++length )
+        {
+            std::vector< float > expected( MAX_LENGTH, 0.0 );
+            std::vector< float > result( MAX_LENGTH, 0.0 );
+            generic.mult( a.data(), b.data(), expected.data(), length );
+            table->mult( a.data(), b.data(), result.data(), length );
+            EXPECT_EQ( result, expected ) << table->name << ", length " << length;
+
+            expected = b;
+            result = b;
+            generic.add_in_place( a.data(), expected.data(), length );
+            table->add_in_place( a.data(), result.data(), length );
+            EXPECT_EQ( result, expected ) << table->name << ", length " << length;
+
+            expected = a;
+            result = a;
+            generic.mult_const_in_place( expected.data(), 0.3f, length );
+            table->mult_const_in_place( result.data(), 0.3f, length );
+            EXPECT_EQ( result, expected ) << table->name << ", length " << length;
+        }
+    }
+}
+
+TEST_F( KernelsTest, test_half_band_variants )
+///
+/// Tests that the generic half-band filter computes its definition, and that every half-band filter
+/// supported by this CPU matches it to within rounding, for numbers of outputs that do and do not
+/// fill the SIMD registers.
+///
+{
+    const size_t NUM_TAPS = 7;
+    const size_t MAX_OUTPUTS = 67;
+    std::vector< float > taps( NUM_TAPS );
+    std::vector< float > centre( MAX_OUTPUTS );
+    std::vector< float > side( MAX_OUTPUTS + 2*NUM_TAPS - 1 );
+    std::generate( taps.begin(), taps.end(), std::bind( &veclib::make_random_number, -0.5, 0.5 ) );
+    std::generate( centre.begin(), centre.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    std::generate( side.begin(), side.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+
+    const KernelTable& generic = *get_supported_kernels().front();
+    std::vector< float > expected( MAX_OUTPUTS );
+    generic.half_band( centre.data(), side.data(), taps.data(), NUM_TAPS, expected.data(), MAX_OUTPUTS );
+    for( size_t n=0; n<MAX_OUTPUTS; ++n )
+    {
+        double sum = 0.5*centre[n];
+        for( size_t k=0; k<NUM_TAPS; ++k )
+        {
+            sum += taps[k]*( side[n+k] + static_cast< double >( side[n+2*NUM_TAPS-1-k] ) );
+        }
+        EXPECT_NEAR( expected[n], sum, 1e-5 ) << "Output " << n;
+    }
+
+    for( auto table : get_supported_kernels() )
+    {
+        for( size_t num_outputs=0; num_outputs<=MAX_OUTPUTS; ++num_outputs )
+        {
+            std::vector< float > result( MAX_OUTPUTS, 0.0f );
+            table->half_band( centre.data(), side.data(), taps.data(), NUM_TAPS, result.data(), num_outputs );
+            for( size_t n=0; n<MAX_OUTPUTS; ++n )
+            {
+                ASSERT_NEAR( result[n], n < num_outputs ? expected[n] : 0.0f, 1e-6f ) << table->name << ", " << num_outputs << " outputs, output " << n;
+            }
+        }
+    }
+}
+
+TEST_F( KernelsTest, test_sparse_cmul_variants )
+///
+/// Tests that the generic sparse product computes its definition, including for an empty row, and
+/// that every sparse product supported by this CPU matches it to within rounding, for numbers of
+/// frames that do and do not fill the SIMD registers. The frames are read bin by bin, i.e., as
+/// FRAME_SIZE bins of MAX_FRAMES frames each.
+///
+{
+    const size_t NUM_ROWS = 9;
+    std::vector< std::complex< float > > values;
+    std::vector< uint32_t > columns;
+    std::vector< uint32_t > row_starts = { 0 };
+    for( size_t row=0; row<NUM_ROWS; ++row )
+    {
+        const size_t row_length = row == 3 ? 0 : row*5 + 1;
+        for( size_t i=0; i<row_length; ++i )
+        {
+            values.push_back( { static_cast< float >( veclib::make_random_number( -1.0, 1.0 ) ), static_cast< float >( veclib::make_random_number( -1.0, 1.0 ) ) } );
+            columns.push_back( static_cast< uint32_t >( ( row*37 + i*11 )%FRAME_SIZE ) );
+        }
+        row_starts.push_back( static_cast< uint32_t >( values.size() ) );
+    }
+
+    const KernelTable& generic = *get_supported_kernels().front();
+    std::vector< std::complex< float > > expected( MAX_FRAMES*NUM_ROWS );
+    generic.sparse_cmul( values.data(), columns.data(), row_starts.data(), NUM_ROWS, frames.data(), MAX_FRAMES, MAX_FRAMES, expected.data(), NUM_ROWS );
+    for( size_t frame=0; frame<MAX_FRAMES; ++frame )
+    {
+        for( size_t row=0; row<NUM_ROWS; ++row )
+        {
+            std::complex< double > sum = { 0.0, 0.0 };
+            for( uint32_t i=row_starts[row]; i<row_starts[row+1]; ++i )
+            {
+                sum += std::complex< double >( values[i] )*std::complex< double >( frames[columns[i]*MAX_FRAMES + frame] );
+            }
+            EXPECT_NEAR( expected[frame*NUM_ROWS + row].real(), sum.real(), 1e-5 ) << "Frame " << frame << ", row " << row;
+            EXPECT_NEAR( expected[frame*NUM_ROWS + row].imag(), sum.imag(), 1e-5 ) << "Frame " << frame << ", row " << row;
+        }
+    }
+
+    for( auto table : get_supported_kernels() )
+    {
+        for( size_t num_frames=0; num_frames<=MAX_FRAMES; ++num_frames )
+        {
+            std::vector< std::complex< float > > result( MAX_FRAMES*NUM_ROWS );
+            table->sparse_cmul( values.data(), columns.data(), row_starts.data(), NUM_ROWS, frames.data(), MAX_FRAMES, num_frames, result.data(), NUM_ROWS );
+            for( size_t i=0; i<result.size(); ++i )
+            {
+                const std::complex< float > target = i < num_frames*NUM_ROWS ? expected[i] : std::complex< float >();
+                ASSERT_NEAR( result[i].real(), target.real(), 1e-5f ) << table->name << ", " << num_frames << " frames, element " << i;
+                ASSERT_NEAR( result[i].imag(), target.imag(), 1e-5f ) << table->name << ", " << num_frames << " frames, element " << i;
+            }
+        }
+    }
+}
+
+TEST_F( KernelsTest, test_spectral_variants )
+///
+/// Tests that the generic spectral reductions compute their definitions, and that every variant
+/// supported by this CPU gives the same powers, magnitudes and sums to within rounding, for numbers
+/// of bins that do and do not fill the SIMD registers. The powers are not compared exactly, as the
+/// compiler may fuse their multiplies and adds in variants whose targets have FMA.
+///
+{
+    std::vector< float > frequencies( FRAME_SIZE );
+    std::vector< float > previous( FRAME_SIZE );
+    std::generate( frequencies.begin(), frequencies.end(), std::bind( &veclib::make_random_number, 0.0, 1000.0 ) );
+    std::generate( previous.begin(), previous.end(), std::bind( &veclib::make_random_number, 0.0, 1.0 ) );
+
+    const KernelTable& generic = *get_supported_kernels().front();
+    std::vector< float > expected_power( FRAME_SIZE );
+    std::vector< float > expected_magnitude = previous;
+    float expected_sums[3];
+    generic.spectral_frame( frames.data(), frequencies.data(), expected_magnitude.data(), expected_power.data(), FRAME_SIZE, expected_sums );
+    double total_power = 0.0;
+    double weighted_power = 0.0;
+    double flux = 0.0;
+    for( size_t bin=0; bin<FRAME_SIZE; ++bin )
+    {
+        const double power = std::norm( std::complex< double >( frames[bin] ) );
+        EXPECT_NEAR( expected_power[bin], power, 1e-6 ) << "Bin " << bin;
+        EXPECT_NEAR( expected_magnitude[bin], std::sqrt( power ), 1e-6 ) << "Bin " << bin;
+        total_power += power;
+        weighted_power += power*frequencies[bin];
+        flux += std::max( std::sqrt( power ) - previous[bin], 0.0 );
+    }
+    EXPECT_NEAR( expected_sums[0], total_power, 1e-5*total_power );
+    EXPECT_NEAR( expected_sums[1], weighted_power, 1e-5*weighted_power );
+    EXPECT_NEAR( expected_sums[2], flux, 1e-5*flux );
+    EXPECT_NEAR( generic.sum( expected_power.data(), FRAME_SIZE ), total_power, 1e-5*total_power );
+
+    for( auto table : get_supported_kernels() )
+    {
+        for( size_t num_bins=0; num_bins<=67; ++num_bins )
+        {
+            std::vector< float > power( FRAME_SIZE, 0.0f );
+            std::vector< float > magnitude = previous;
+            float sums[3];
+            table->spectral_frame( frames.data(), frequencies.data(), magnitude.data(), power.data(), num_bins, sums );
+
+            std::vector< float > reference_power( FRAME_SIZE, 0.0f );
+            std::vector< float > reference_magnitude = previous;
+            float reference_sums[3];
+            generic.spectral_frame( frames.data(), frequencies.data(), reference_magnitude.data(), reference_power.data(), num_bins, reference_sums );
+
+            for( size_t bin=0; bin<FRAME_SIZE; ++bin )
+            {
+                ASSERT_NEAR( power[bin], reference_power[bin], 1e-6f*std::max( 1.0f, reference_power[bin] ) ) << table->name << ", " << num_bins << " bins, bin " << bin;
+                ASSERT_NEAR( magnitude[bin], reference_magnitude[bin], 1e-6f*std::max( 1.0f, reference_magnitude[bin] ) ) << table->name << ", " << num_bins << " bins, bin " << bin;
+            }
+            for( size_t i=0; i<3; ++i )
+            {
+                ASSERT_NEAR( sums[i], reference_sums[i], 1e-5f*std::max( 1.0f, reference_sums[i] ) ) << table->name << ", " << num_bins << " bins, sum " << i;
+            }
+            ASSERT_NEAR( table->sum( power.data(), num_bins ), reference_sums[0], 1e-5f*std::max( 1.0f, reference_sums[0] ) ) << table->name << ", " << num_bins << " bins";
+        }
+    }
+}
+
+TEST( KernelsSelectionTest, test_selected_is_supported )
+///
+/// Tests that the generic kernels are always available and that the kernels in use are among
+/// those supported by this CPU.
+///
+{
+    std::vector< const KernelTable* > supported = get_supported_kernels();
+    ASSERT_FALSE( supported.empty() );
+    EXPECT_EQ( std::string( supported.front()->name ), "generic" );
+    EXPECT_NE( std::find( supported.begin(), supported.end(), &get_kernels() ), supported.end() );
+}
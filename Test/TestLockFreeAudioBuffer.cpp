@@ -0,0 +1,150 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for LockFreeAudioBuffer class
+//
+
+// In module includes
+#include "LockFreeAudioBuffer.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+using namespace cupcake;
+
+class LockFreeAudioBufferTest : public ::testing::Test
+///
+/// Test fixture for lock-free audio buffer tests.
+/// Creates and holds default input signals.
+///
+{
+protected:
+
+    const size_t MAX_INPUT_SIZE = 44100*20;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create an arbitrary input to fill the buffer with.
+    ///
+    {
+        veclib::seed_rand();
+        input.resize( MAX_INPUT_SIZE );
+        std::generate( input.begin(), input.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    std::vector< float > input; // Vector for storing the input for all tests.
+
+};
+
+TEST_F( LockFreeAudioBufferTest, CircularReading )
+///
+/// Checks that data read from the buffer matches the data pushed in after the
+/// heads have wrapped around the end of the circular buffer several times.
+///
+{
+    const size_t BUFFER_SIZE = 1000;        // -> Size of the data cache in the buffer object.
+    const size_t PUSH_CHUNK_SIZE = 333;     // -> Number of samples per input call to the buffer object.
+    const size_t DEAD_SAMPLES = 10;         // -> Number of samples left in the buffer after each pop.
+    const int NUM_CYCLES = 50;              // -> Number of times to fill, check and clear the buffer.
+
+    LockFreeAudioBuffer< float > buffer( BUFFER_SIZE );
+
+    size_t input_pointer = 0;
+    size_t read_pointer = 0;
+    for( int cycle=0; cycle<NUM_CYCLES; ++cycle )
+    {
+        while( buffer.SpaceRemaining() >= PUSH_CHUNK_SIZE )
+        {
+            ASSERT_TRUE( buffer.PushSamples( input.data() + input_pointer, PUSH_CHUNK_SIZE ) );
+            input_pointer += PUSH_CHUNK_SIZE;
+        }
+
+        const float* the_data = buffer.Data();
+        ASSERT_EQ( buffer.NumSamples(), input_pointer - read_pointer );
+        for( size_t i=0; i<buffer.NumSamples(); ++i )
+        {
+            ASSERT_EQ( the_data[i], input[read_pointer + i] );
+        }
+
+        size_t num_to_pop = buffer.NumSamples() - DEAD_SAMPLES;
+        buffer.PopFront( num_to_pop );
+        read_pointer += num_to_pop;
+    }
+}
+
+TEST_F( LockFreeAudioBufferTest, RejectsOverflow )
+///
+/// Checks that a push that does not fit is rejected without modifying the buffer.
+///
+{
+    const size_t BUFFER_SIZE = 100;
+
+    LockFreeAudioBuffer< float > buffer( BUFFER_SIZE );
+
+    ASSERT_TRUE( buffer.PushSamples( input.data(), BUFFER_SIZE - 10 ) );
+    ASSERT_FALSE( buffer.PushSamples( input.data(), 11 ) );
+    ASSERT_EQ( buffer.NumSamples(), BUFFER_SIZE - 10 );
+    ASSERT_TRUE( buffer.PushSamples( input.data(), 10 ) );
+    ASSERT_EQ( buffer.SpaceRemaining(), 0 );
+
+    buffer.PopFront( BUFFER_SIZE*2 );
+    ASSERT_EQ( buffer.NumSamples(), 0 );
+    ASSERT_EQ( buffer.SpaceRemaining(), BUFFER_SIZE );
+}
+
+TEST_F( LockFreeAudioBufferTest, ProducerConsumerThreads )
+///
+/// Checks that when one thread pushes samples and another thread reads and pops them,
+/// the consumer sees every sample exactly once and in order.
+///
+{
+    const size_t BUFFER_SIZE = 4096;        // -> Size of the data cache in the buffer object.
+    const size_t PUSH_CHUNK_SIZE = 64;      // -> Number of samples per push, as from an audio callback.
+    const size_t NUM_SAMPLES = 44100*10;    // -> Total number of samples sent between the threads.
+
+    LockFreeAudioBuffer< float > buffer( BUFFER_SIZE );
+
+    std::thread producer( [&]()
+    {
+        size_t input_pointer = 0;
+        while( input_pointer < NUM_SAMPLES )
+        {
+            size_t chunk = std::min( PUSH_CHUNK_SIZE, NUM_SAMPLES - input_pointer );
+            if( buffer.PushSamples( input.data() + input_pointer, chunk ) )
+            {
+                input_pointer += chunk;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    size_t read_pointer = 0;
+    bool all_match = true;
+    while( read_pointer < NUM_SAMPLES )
+    {
+        size_t num_samples = buffer.NumSamples();
+        const float* the_data = buffer.Data();
+        for( size_t i=0; i<num_samples; ++i )
+        {
+            all_match &= ( the_data[i] == input[read_pointer + i] );
+        }
+        buffer.PopFront( num_samples );
+        read_pointer += num_samples;
+    }
+
+    producer.join();
+
+    ASSERT_TRUE( all_match );
+    ASSERT_EQ( read_pointer, NUM_SAMPLES );
+    ASSERT_EQ( buffer.NumSamples(), 0 );
+}
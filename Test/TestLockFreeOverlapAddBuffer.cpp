@@ -0,0 +1,136 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for LockFreeOverlapAddBuffer class
+//
+
+// In module includes
+#include "LockFreeOverlapAddBuffer.h"
+#include "OverlapAddBuffer.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+using namespace cupcake;
+
+class LockFreeOverlapAddBufferTest : public ::testing::Test
+///
+/// Test fixture for lock-free overlap-add buffer tests.
+/// Creates and holds default input signals.
+///
+{
+protected:
+
+    const size_t MAX_INPUT_SIZE = 44100*20;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create an arbitrary input to fill the buffer with.
+    ///
+    {
+        veclib::seed_rand();
+        input_noise.resize( MAX_INPUT_SIZE );
+        std::generate( input_noise.begin(), input_noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    std::vector< float > input_noise; // Vector for storing the input for all tests.
+
+};
+
+TEST_F( LockFreeOverlapAddBufferTest, test_matches_overlap_add_buffer )
+///
+/// Tests that overlap-adding frames into the lock-free buffer gives the same output as
+/// the OverlapAddBuffer class when used from a single thread.
+///
+{
+    const size_t FRAME_SIZE = 256;          // -> The number of samples added at each write position.
+    const size_t INCREMENT = 64;            // -> The number of samples the write position moves between frames.
+    const size_t BUFFER_SIZE = 1001;        // -> The size of both buffers.
+    const size_t NUM_FRAMES = 500;          // -> The number of frames to overlap-add.
+
+    OverlapAddBuffer< float > reference( BUFFER_SIZE );
+    LockFreeOverlapAddBuffer< float > buffer( BUFFER_SIZE );
+
+    for( size_t frame=0; frame<NUM_FRAMES; ++frame )
+    {
+        const std::vector< float > samples( input_noise.begin() + frame*FRAME_SIZE, input_noise.begin() + ( frame + 1 )*FRAME_SIZE );
+
+        reference.PushSamples( samples );
+        reference.IncrementWritePosition( INCREMENT );
+        ASSERT_TRUE( buffer.PushSamples( samples ) );
+        buffer.IncrementWritePosition( INCREMENT );
+
+        ASSERT_EQ( buffer.NumSamples(), reference.NumSamples() );
+
+        std::vector< float > expected( reference.NumSamples() );
+        std::vector< float > output( buffer.NumSamples() );
+        reference.Read( expected );
+        buffer.Read( output );
+        for( size_t samp=0; samp<output.size(); ++samp )
+        {
+            ASSERT_EQ( output[samp], expected[samp] );
+        }
+        reference.PopFront( expected.size() );
+        buffer.PopFront( output.size() );
+    }
+}
+
+TEST_F( LockFreeOverlapAddBufferTest, test_producer_consumer_threads )
+///
+/// Tests that when one thread overlap-adds constant frames and another thread drains
+/// the completed samples, the consumer sees the expected steady-state sum.
+///
+{
+    const size_t FRAME_SIZE = 512;          // -> The number of samples added at each write position.
+    const size_t INCREMENT = 128;           // -> The number of samples the write position moves between frames.
+    const size_t BUFFER_SIZE = 2048;        // -> The size of the buffer shared between the threads.
+    const size_t NUM_FRAMES = 5000;         // -> The number of frames to overlap-add.
+    const size_t READ_CHUNK_SIZE = 100;     // -> The number of samples drained at a time, as from an audio callback.
+
+    LockFreeOverlapAddBuffer< float > buffer( BUFFER_SIZE );
+    const std::vector< float > ones( FRAME_SIZE, 1.0 );
+
+    std::thread producer( [&]()
+    {
+        size_t frame = 0;
+        while( frame < NUM_FRAMES )
+        {
+            if( buffer.SpaceRemaining() >= FRAME_SIZE )
+            {
+                ASSERT_TRUE( buffer.PushSamples( ones ) );
+                buffer.IncrementWritePosition( INCREMENT );
+                ++frame;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    const size_t NUM_OUTPUT_SAMPLES = NUM_FRAMES*INCREMENT;
+    std::vector< float > output( NUM_OUTPUT_SAMPLES );
+    size_t read_pointer = 0;
+    while( read_pointer < NUM_OUTPUT_SAMPLES )
+    {
+        size_t num_samples = std::min( buffer.NumSamples(), std::min( READ_CHUNK_SIZE, NUM_OUTPUT_SAMPLES - read_pointer ) );
+        buffer.Read( output.data() + read_pointer, num_samples );
+        buffer.PopFront( num_samples );
+        read_pointer += num_samples;
+    }
+
+    producer.join();
+
+    // After the first frame has fully overlapped, every sample is the sum of FRAME_SIZE/INCREMENT frames.
+    for( size_t samp=FRAME_SIZE; samp<NUM_OUTPUT_SAMPLES; ++samp )
+    {
+        ASSERT_EQ( output[samp], static_cast< float >( FRAME_SIZE/INCREMENT ) );
+    }
+}
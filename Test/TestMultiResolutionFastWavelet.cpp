@@ -0,0 +1,205 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for MultiResolutionFastWavelet class
+//
+
+// In module includes
+#include "MultiResolutionFastWavelet.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+using namespace cupcake;
+
+class MultiResolutionFastWaveletTest : public ::testing::Test
+///
+/// Test fixture for MultiResolutionFastWavelet tests.
+/// Creates and holds a window and a block of white noise.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const float SAMPLE_RATE = 44100.0f;
+    const size_t SIGNAL_LENGTH = 44100;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create the window and noise.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        noise.resize( SIGNAL_LENGTH );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    std::vector< float > window;        // The analysis window.
+    std::vector< float > noise;         // White noise.
+
+};
+
+TEST_F( MultiResolutionFastWaveletTest, test_single_octave )
+///
+/// Tests that a single octave gives exactly the frames of FastWavelet.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    auto expected = wavelet.PushSamples( noise );
+
+    MultiResolutionFastWavelet< FFT_SIZE > octaves( 1, OVERLAP, window );
+    EXPECT_EQ( octaves.GetNumBins(), FastWavelet< FFT_SIZE >::mOutputSize );
+    MultiResolutionFrames& result = octaves.PushSamples( noise.data(), noise.size() );
+    ASSERT_EQ( result.num_frames, expected.size() );
+    ASSERT_EQ( result.num_bins, FastWavelet< FFT_SIZE >::mOutputSize );
+    for( size_t frame=0; frame<expected.size(); ++frame )
+    {
+        EXPECT_TRUE( std::equal( expected[frame].begin(), expected[frame].end(), result.values.begin() + frame*result.num_bins ) );
+    }
+
+    EXPECT_THROW( MultiResolutionFastWavelet< FFT_SIZE >( 0, OVERLAP, window ), std::invalid_argument );
+}
+
+TEST_F( MultiResolutionFastWaveletTest, test_bin_frequencies )
+///
+/// Tests that the stitched bins run from DC to Nyquist without gaps, with the bin spacing halving
+/// in each lower octave.
+///
+{
+    const size_t num_octaves = 4;
+    MultiResolutionFastWavelet< FFT_SIZE > octaves( num_octaves, OVERLAP, window );
+    EXPECT_EQ( octaves.GetNumOctaves(), num_octaves );
+    EXPECT_EQ( octaves.GetNumBins(), FFT_SIZE/2 + 1 + ( num_octaves - 1 )*FFT_SIZE/8 );
+
+    std::vector< float > frequencies = octaves.GetBinFrequencies( SAMPLE_RATE );
+    ASSERT_EQ( frequencies.size(), octaves.GetNumBins() );
+    EXPECT_EQ( frequencies.front(), 0.0f );
+    EXPECT_FLOAT_EQ( frequencies.back(), SAMPLE_RATE/2 );
+
+    float spacing = SAMPLE_RATE/( FFT_SIZE << ( num_octaves - 1 ) );
+    for( size_t bin=1; bin<frequencies.size(); ++bin )
+    {
+        const float step = frequencies[bin] - frequencies[bin-1];
+        if( step > spacing*1.5f )
+        {
+            spacing *= 2;
+        }
+        EXPECT_NEAR( step, spacing, spacing*1e-3 ) << "Bin " << bin;
+    }
+    EXPECT_FLOAT_EQ( spacing, SAMPLE_RATE/FFT_SIZE );
+}
+
+TEST_F( MultiResolutionFastWaveletTest, test_streaming )
+///
+/// Tests that pushing samples in blocks of any size gives the same frames as pushing them at once,
+/// and that the lowest octave is silent until its first frame is complete.
+///
+{
+    const size_t num_octaves = 3;
+    MultiResolutionFastWavelet< FFT_SIZE > whole( num_octaves, OVERLAP, window );
+    MultiResolutionFrames expected = whole.PushSamples( noise.data(), noise.size() );
+    EXPECT_EQ( expected.num_frames, ( SIGNAL_LENGTH - WINDOW_LENGTH )/whole.GetIncrement() + 1 );
+
+    // The lowest octave's window covers four times as many samples as the top octave's.
+    const size_t lowest_bins = FFT_SIZE/4;
+    const size_t silent_frames = ( 4*WINDOW_LENGTH - WINDOW_LENGTH )/whole.GetIncrement();
+    for( size_t frame=0; frame<silent_frames; ++frame )
+    {
+        const auto first = expected.values.begin() + frame*expected.num_bins;
+        EXPECT_TRUE( std::all_of( first, first + lowest_bins, []( std::complex< float > x ){ return x == std::complex< float >(); } ) ) << "Frame " << frame;
+    }
+    EXPECT_NE( std::abs( expected.values[( silent_frames + 2 )*expected.num_bins + lowest_bins/2] ), 0.0f );
+
+    MultiResolutionFastWavelet< FFT_SIZE > pieces( num_octaves, OVERLAP, window );
+    std::vector< std::complex< float > > result;
+    for( size_t pos=0, piece=1; pos<noise.size(); pos+=piece, piece=( piece*7 )%1999 + 1 )
+    {
+        MultiResolutionFrames& frames = pieces.PushSamples( noise.data() + pos, std::min( piece, noise.size() - pos ) );
+        EXPECT_EQ( frames.num_bins, expected.num_bins );
+        result.insert( result.end(), frames.values.begin(), frames.values.end() );
+    }
+
+    ASSERT_EQ( result.size(), expected.values.size() );
+    for( size_t i=0; i<result.size(); ++i )
+    {
+        const float tolerance = 1e-4f*std::max( 1.0f, std::abs( expected.values[i] ) );
+        ASSERT_NEAR( result[i].real(), expected.values[i].real(), tolerance ) << "Element " << i;
+        ASSERT_NEAR( result[i].imag(), expected.values[i].imag(), tolerance ) << "Element " << i;
+    }
+}
+
+TEST_F( MultiResolutionFastWaveletTest, test_tone_frequency )
+///
+/// Tests that tones in the lowest, a middle and the top octave peak in the bins nearest their
+/// frequency.
+///
+{
+    const size_t num_octaves = 4;
+    const std::vector< double > tones = { 55.0, 440.0, 5000.0 };
+    for( double tone : tones )
+    {
+        std::vector< float > signal( 3*SIGNAL_LENGTH );
+        for( size_t sample=0; sample<signal.size(); ++sample )
+        {
+            signal[sample] = static_cast< float >( 0.5*std::sin( 2.0*M_PI*tone*sample/SAMPLE_RATE ) );
+        }
+
+        MultiResolutionFastWavelet< FFT_SIZE > octaves( num_octaves, OVERLAP, window );
+        MultiResolutionFrames& frames = octaves.PushSamples( signal.data(), signal.size() );
+        ASSERT_GT( frames.num_frames, 0u );
+
+        const auto last = frames.values.begin() + ( frames.num_frames - 1 )*frames.num_bins;
+        const size_t peak = std::max_element( last, last + frames.num_bins, []( std::complex< float > a, std::complex< float > b ){ return std::abs( a ) < std::abs( b ); } ) - last;
+
+        std::vector< float > frequencies = octaves.GetBinFrequencies( SAMPLE_RATE );
+        const float spacing = frequencies[peak+1] - frequencies[peak];
+        EXPECT_NEAR( frequencies[peak], tone, spacing ) << tone << " Hz";
+    }
+}
+
+TEST_F( MultiResolutionFastWaveletTest, test_latency )
+///
+/// Tests that a single octave has the latency of the STFT, and that the lowest octave's bins are
+/// silent until the first top octave frame to end at or after its latency.
+///
+{
+    MultiResolutionFastWavelet< FFT_SIZE > single( 1, OVERLAP, window );
+    EXPECT_EQ( single.GetAlgorithmicLatency(), WINDOW_LENGTH - 1 );
+
+    const size_t num_octaves = 3;
+    MultiResolutionFastWavelet< FFT_SIZE > octaves( num_octaves, OVERLAP, window );
+    const size_t latency = octaves.GetAlgorithmicLatency();
+    EXPECT_GE( latency, 4*( WINDOW_LENGTH - 1 ) );
+    EXPECT_EQ( octaves.GetBufferedSamples(), 0u );
+
+    const size_t lowest_bins = FFT_SIZE/4;
+    size_t frame = 0;
+    for( size_t pos=0, piece=1; pos<noise.size(); pos+=piece, piece=( piece*7 )%1999 + 1 )
+    {
+        const size_t num_samples = std::min( piece, noise.size() - pos );
+        MultiResolutionFrames& frames = octaves.PushSamples( noise.data() + pos, num_samples );
+        for( size_t i=0; i<frames.num_frames; ++i, ++frame )
+        {
+            const auto first = frames.values.begin() + i*frames.num_bins;
+            const bool silent = std::all_of( first, first + lowest_bins, []( std::complex< float > x ){ return x == std::complex< float >(); } );
+            EXPECT_EQ( silent, frame*octaves.GetIncrement() + WINDOW_LENGTH - 1 < latency ) << "Frame " << frame;
+        }
+        EXPECT_LE( octaves.GetBufferedSamples(), latency );
+        EXPECT_LE( octaves.GetBufferedSamples(), pos + num_samples );
+    }
+}
@@ -0,0 +1,134 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for OnsetDetector class
+//
+
+// In module includes
+#include "OnsetDetector.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+
+using namespace cupcake;
+
+class OnsetDetectorTest : public ::testing::Test
+///
+/// Test fixture for OnsetDetector tests.
+/// Creates and holds a window and a signal of silence with tone bursts at known times.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const float SAMPLE_RATE = 44100.0f;
+    const size_t SIGNAL_LENGTH = 5*44100;
+    const size_t BURST_SPACING = 22050;
+    const size_t BURST_LENGTH = 8820;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create a window and the signal, with each burst at a different pitch.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        signal.assign( SIGNAL_LENGTH, 0.0f );
+        for( size_t burst=BURST_SPACING/2; burst+BURST_LENGTH<SIGNAL_LENGTH; burst+=BURST_SPACING )
+        {
+            const double frequency = 220.0*( bursts.size() + 1 );
+            for( size_t sample=burst; sample<burst+BURST_LENGTH; ++sample )
+            {
+                // Fade out slowly, so that only the start of the burst is a transient.
+                const double gain = std::min( 1.0, ( burst + BURST_LENGTH - sample )/2048.0 );
+                signal[sample] = static_cast< float >( 0.5*gain*std::sin( 2.0*M_PI*frequency*( sample - burst )/SAMPLE_RATE ) );
+            }
+            bursts.push_back( burst );
+        }
+    }
+
+    std::vector< float > window;        // The analysis window.
+    std::vector< float > signal;        // Silence with tone bursts.
+    std::vector< size_t > bursts;       // The first sample of each burst.
+
+};
+
+TEST_F( OnsetDetectorTest, test_detects_bursts )
+///
+/// Tests that there is one onset at the start of each burst, and that pushing the signal in small
+/// chunks reports the same onsets, each within the latency of the frame it occurs in.
+///
+{
+    const size_t increment = static_cast< size_t >( ( 1 - OVERLAP )*WINDOW_LENGTH );
+
+    // Push the whole signal at once.
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    wavelet.ConfigureOnsets( SAMPLE_RATE, 0.05f, 3, 3, 1, 10, 1 );
+    std::vector< uint64_t > onsets = wavelet.PushSamplesOnsets( ArrayView< const float >( signal ) ).onset_frames;
+    OnsetFrames& flushed = wavelet.FlushOnsets();
+    onsets.insert( onsets.end(), flushed.onset_frames.begin(), flushed.onset_frames.end() );
+
+    ASSERT_EQ( onsets.size(), bursts.size() );
+    for( size_t onset=0; onset<onsets.size(); ++onset )
+    {
+        // The first frame to include the start of the burst.
+        const int64_t expected = static_cast< int64_t >( ( bursts[onset] + increment - WINDOW_LENGTH )/increment + 1 );
+        EXPECT_LE( std::abs( static_cast< int64_t >( onsets[onset] ) - expected ), 2 );
+    }
+
+    // Push the signal in chunks of a little more than a hop, so frames arrive one or two at a time.
+    FastWavelet< FFT_SIZE > chunked_wavelet( OVERLAP, window );
+    OnsetDetector< FFT_SIZE > detector( increment/SAMPLE_RATE );
+    ASSERT_EQ( detector.GetLatencyFrames(), 1u );
+    std::vector< uint64_t > chunked_onsets;
+    for( size_t pos=0; pos<SIGNAL_LENGTH; pos+=300 )
+    {
+        std::vector< float > chunk( signal.begin() + pos, signal.begin() + std::min( pos + 300, SIGNAL_LENGTH ) );
+        auto& frames = chunked_wavelet.PushSamples( chunk );
+        OnsetFrames& output = detector.Process( frames.data(), frames.size() );
+        ASSERT_EQ( output.novelty.size(), frames.size() );
+        for( size_t onset=0; onset<output.onset_frames.size(); ++onset )
+        {
+            EXPECT_GE( output.onset_frames[onset] + detector.GetLatencyFrames() + frames.size(), detector.GetNumFrames() );
+            EXPECT_NEAR( output.onset_times[onset], output.onset_frames[onset]*increment/SAMPLE_RATE, 1e-5 );
+            chunked_onsets.push_back( output.onset_frames[onset] );
+        }
+    }
+    OnsetFrames& chunked_flushed = detector.Flush();
+    chunked_onsets.insert( chunked_onsets.end(), chunked_flushed.onset_frames.begin(), chunked_flushed.onset_frames.end() );
+    EXPECT_EQ( chunked_onsets, onsets );
+}
+
+TEST_F( OnsetDetectorTest, test_reset )
+///
+/// Tests that after a reset, the same frames give the same novelty and onsets as a new detector.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    auto frames = wavelet.PushSamples( signal );
+
+    OnsetDetector< FFT_SIZE > fresh_detector( 0.01 );
+    const OnsetFrames expected = fresh_detector.Process( frames.data(), frames.size() );
+    EXPECT_FALSE( expected.onset_frames.empty() );
+
+    OnsetDetector< FFT_SIZE > detector( 0.01 );
+    detector.Process( frames.data(), frames.size()/2 );
+    detector.Reset();
+    EXPECT_EQ( detector.GetNumFrames(), 0u );
+    OnsetFrames& output = detector.Process( frames.data(), frames.size() );
+    EXPECT_EQ( output.novelty, expected.novelty );
+    EXPECT_EQ( output.onset_frames, expected.onset_frames );
+}
@@ -0,0 +1,148 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for ProcessingChain class
+//
+
+// In module includes
+#include "ProcessingChain.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+using namespace cupcake;
+
+class ProcessingChainTest : public ::testing::Test
+///
+/// Test fixture for ProcessingChain tests.
+/// Creates and holds a window and a block of noise.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 512;
+    const size_t INCREMENT = 128;           // -> An overlap of 0.75.
+    const size_t NUM_SAMPLES = 44100;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create a window and some noise.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        samples.resize( NUM_SAMPLES );
+        std::generate( samples.begin(), samples.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    size_t NumFrames() const
+    ///
+    /// The number of complete frames in the noise.
+    ///
+    {
+        return ( NUM_SAMPLES - WINDOW_LENGTH )/INCREMENT + 1;
+    }
+
+    std::vector< float > window;    // The analysis window.
+    std::vector< float > samples;   // NUM_SAMPLES samples of noise.
+
+};
+
+TEST_F( ProcessingChainTest, test_matches_fast_wavelet )
+///
+/// Tests that the fused window, FFT and fast CQT chain gives the same frames as FastWavelet.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( 1.0f - static_cast< float >( INCREMENT )/WINDOW_LENGTH, window );
+    auto& expected = wavelet.PushSamples( samples );
+    ASSERT_EQ( expected.size(), NumFrames() );
+
+    FastWaveletChain< FFT_SIZE > chain{ WindowStage< FFT_SIZE >( window ), FFTStage< FFT_SIZE >(), FastCQTStage< FFT_SIZE >( WINDOW_LENGTH ) };
+    std::vector< FastWaveletChain< FFT_SIZE >::Output > result( NumFrames() );
+    chain.ProcessFrames( samples.data(), result.size(), INCREMENT, result.data() );
+
+    for( size_t frame=0; frame<result.size(); ++frame )
+    {
+        for( size_t bin=0; bin<result[frame].size(); ++bin )
+        {
+            const float tolerance = 1e-5f*std::max( 1.0f, std::abs( expected[frame][bin] ) );
+            ASSERT_NEAR( result[frame][bin].real(), expected[frame][bin].real(), tolerance );
+            ASSERT_NEAR( result[frame][bin].imag(), expected[frame][bin].imag(), tolerance );
+        }
+    }
+}
+
+TEST_F( ProcessingChainTest, test_magnitude_pooling )
+///
+/// Tests that magnitude and pooling stages appended to a chain pool the magnitudes of the spectrum.
+///
+{
+    const size_t POOLING = 4;
+    const size_t SPECTRUM_SIZE = veclib::get_output_FFT_size( FFT_SIZE );
+
+    auto spectrum_chain = make_processing_chain( WindowStage< FFT_SIZE >( window ), FFTStage< FFT_SIZE >() );
+    auto pooled_chain = make_processing_chain( WindowStage< FFT_SIZE >( window ),
+                                               FFTStage< FFT_SIZE >(),
+                                               MagnitudeStage< SPECTRUM_SIZE >(),
+                                               PoolingStage< SPECTRUM_SIZE, POOLING >() );
+
+    decltype( spectrum_chain )::Output spectrum;
+    decltype( pooled_chain )::Output pooled;
+    ASSERT_EQ( pooled.size(), ( SPECTRUM_SIZE + POOLING - 1 )/POOLING );
+
+    for( size_t frame=0; frame<NumFrames(); frame+=17 )
+    {
+        spectrum_chain.ProcessFrame( samples.data() + frame*INCREMENT, spectrum );
+        pooled_chain.ProcessFrame( samples.data() + frame*INCREMENT, pooled );
+
+        for( size_t group=0; group<pooled.size(); ++group )
+        {
+            const size_t last = std::min( ( group + 1 )*POOLING, SPECTRUM_SIZE );
+            float expected = 0.0f;
+            for( size_t bin=group*POOLING; bin<last; ++bin )
+            {
+                expected += std::abs( spectrum[bin] );
+            }
+            expected /= static_cast< float >( last - group*POOLING );
+            EXPECT_NEAR( pooled[group], expected, 1e-5f*std::max( 1.0f, expected ) );
+        }
+    }
+}
+
+TEST_F( ProcessingChainTest, test_synthesis )
+///
+/// Tests that analysing and synthesising a frame gives back the windowed frame, normalised as in
+/// STFTSynthesis and zero beyond the window.
+///
+{
+    auto chain = make_processing_chain( WindowStage< FFT_SIZE >( window ), FFTStage< FFT_SIZE >(), SynthesisStage< FFT_SIZE >( INCREMENT, window ) );
+    const float normalisation = STFTSynthesis< FFT_SIZE >::ComputeNormalizationMultiplier( INCREMENT, window );
+
+    decltype( chain )::Output output;
+    for( size_t frame=0; frame<NumFrames(); frame+=17 )
+    {
+        const float* input = samples.data() + frame*INCREMENT;
+        chain.ProcessFrame( input, output );
+
+        for( size_t sample=0; sample<WINDOW_LENGTH; ++sample )
+        {
+            EXPECT_NEAR( output[sample], input[sample]*window[sample]*normalisation, 1e-5 );
+        }
+        for( size_t sample=WINDOW_LENGTH; sample<FFT_SIZE; ++sample )
+        {
+            EXPECT_EQ( output[sample], 0.0f );
+        }
+    }
+}
@@ -0,0 +1,126 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for SPSCQueue class
+//
+
+// In module includes
+#include "SPSCQueue.h"
+
+// Thirdparty includes
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <thread>
+#include <memory>
+#include <stdexcept>
+#include <chrono>
+
+using namespace cupcake;
+
+TEST( SPSCQueueTest, test_bounded )
+///
+/// Checks that a queue takes up to its capacity, hands items back in order, and can be refilled
+/// after its heads wrap around.
+///
+{
+    const size_t CAPACITY = 3;
+    SPSCQueue< std::unique_ptr< int > > queue( CAPACITY );
+    EXPECT_EQ( queue.Capacity(), CAPACITY );
+
+    int next_in = 0;
+    int next_out = 0;
+    for( int cycle=0; cycle<5; ++cycle )
+    {
+        for( size_t i=0; i<CAPACITY; ++i )
+        {
+            std::unique_ptr< int > item( new int( next_in++ ) );
+            ASSERT_TRUE( queue.TryPush( item ) );
+            EXPECT_FALSE( item );
+        }
+        std::unique_ptr< int > extra( new int( -1 ) );
+        EXPECT_FALSE( queue.TryPush( extra ) );
+        EXPECT_TRUE( extra );
+        EXPECT_EQ( queue.Size(), CAPACITY );
+
+        std::unique_ptr< int > item;
+        while( queue.TryPop( item ) )
+        {
+            EXPECT_EQ( *item, next_out++ );
+        }
+        EXPECT_EQ( queue.Size(), 0u );
+    }
+    EXPECT_EQ( next_out, next_in );
+
+    EXPECT_THROW( SPSCQueue< int >( 0 ), std::invalid_argument );
+}
+
+TEST( SPSCQueueTest, test_threads )
+///
+/// Checks that every item pushed by a producer thread reaches a consumer thread in order through a
+/// small queue, and that Pop returns false once the queue is closed and empty.
+///
+{
+    const int NUM_ITEMS = 100000;
+    SPSCQueue< int > queue( 4 );
+
+    std::thread producer( [&queue, NUM_ITEMS]()
+    {
+        for( int i=0; i<NUM_ITEMS; ++i )
+        {
+            int item = i;
+            queue.Push( item );
+        }
+        queue.Close();
+    } );
+
+    std::vector< int > received;
+    int item;
+    while( queue.Pop( item ) )
+    {
+        received.push_back( item );
+    }
+    producer.join();
+
+    ASSERT_EQ( received.size(), static_cast< size_t >( NUM_ITEMS ) );
+    for( int i=0; i<NUM_ITEMS; ++i )
+    {
+        ASSERT_EQ( received[i], i );
+    }
+    EXPECT_FALSE( queue.Pop( item ) );
+}
+
+TEST( SPSCQueueTest, test_blocking )
+///
+/// Checks that a producer and consumer that have given up spinning and blocked are woken by the
+/// other side's pop, push and close.
+///
+{
+    SPSCQueue< int > queue( 1 );
+    const std::chrono::milliseconds PAUSE( 50 );
+
+    // The consumer blocks on an empty queue until the producer pushes, then the producer blocks on a
+    // full queue until the consumer pops.
+    std::thread producer( [&queue, PAUSE]()
+    {
+        std::this_thread::sleep_for( PAUSE );
+        for( int i=0; i<3; ++i )
+        {
+            int item = i;
+            queue.Push( item );
+        }
+        std::this_thread::sleep_for( PAUSE );
+        queue.Close();
+    } );
+
+    int item;
+    for( int i=0; i<3; ++i )
+    {
+        ASSERT_TRUE( queue.Pop( item ) );
+        EXPECT_EQ( item, i );
+        std::this_thread::sleep_for( PAUSE );
+    }
+    EXPECT_FALSE( queue.Pop( item ) );
+    producer.join();
+}
@@ -14,6 +14,7 @@
 
 // Std Lib includes
 #include <vector>
+#include <thread>
 #include <functional>
 #include <numeric>
 #include <algorithm>
@@ -292,3 +293,105 @@ TEST_F( STFTAnalysisTest, test_small_inputs )
     // @todo [matthew.mccallum 05.15.17]: Write this test
     ASSERT_TRUE(false);
 }
+
+TEST_F( STFTAnalysisTest, test_lock_free_input )
+///
+/// Check that when an audio thread pushes small chunks into a lock-free buffer and the STFT
+/// pulls frames from it on another thread, the frames match those from pushing all samples at once.
+///
+{
+    const size_t FFT_SIZE = 2048;           // -> The size of the FFT operation (in terms of input samples per frame)
+    const float FFT_OVERLAP = 0.875;        // -> The fractional overlap between successive STFT windows
+    const size_t INPUT_NUM_SAMPLES = 44100; // -> The number of samples to put through the STFT
+    const size_t CALLBACK_SIZE = 64;        // -> The number of samples pushed by each call of the audio thread
+    const size_t QUEUE_SIZE = 4096;         // -> The size of the lock-free buffer between the threads
+    
+    std::vector< float > input( input_uniform_noise.begin(), input_uniform_noise.begin() + INPUT_NUM_SAMPLES );
+    
+    STFTAnalysis< FFT_SIZE > reference_STFT( FFT_OVERLAP, hamming_window );
+    const std::vector< std::array< std::complex< float >, reference_STFT.GetOutputSize() > > reference( reference_STFT.PushSamples( input ) );
+    
+    STFTAnalysis< FFT_SIZE > STFT( FFT_OVERLAP, hamming_window );
+    LockFreeAudioBuffer< float > queue( QUEUE_SIZE );
+    
+    std::thread audio_thread( [&]()
+    {
+        size_t input_pointer = 0;
+        while( input_pointer < INPUT_NUM_SAMPLES )
+        {
+            size_t chunk = std::min( CALLBACK_SIZE, INPUT_NUM_SAMPLES - input_pointer );
+            if( queue.PushSamples( input.data() + input_pointer, chunk ) )
+            {
+                input_pointer += chunk;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    std::vector< std::array< std::complex< float >, STFT.GetOutputSize() > > output;
+    while( output.size() < reference.size() )
+    {
+        const std::vector< std::array< std::complex< float >, STFT.GetOutputSize() > >& frames = STFT.PullSamples( queue );
+        output.insert( output.end(), frames.begin(), frames.end() );
+    }
+    
+    audio_thread.join();
+    
+    ASSERT_EQ( output.size(), reference.size() );
+    for( size_t frame=0; frame<output.size(); ++frame )
+    {
+        for( size_t bin=0; bin<STFT.GetOutputSize(); ++bin )
+        {
+            ASSERT_EQ( output[frame][bin], reference[frame][bin] );
+        }
+    }
+}
+
+TEST_F( STFTAnalysisTest, test_direct_input )
+///
+/// Check that PushSamplesDirect hands over the samples of the same frames as PushSamples, in
+/// pieces of any size, and leaves the output buffer as it was.
+///
+{
+    const size_t FFT_SIZE = 2048;           // -> The size of the FFT operation (in terms of input samples per frame)
+    const float FFT_OVERLAP = 0.75;         // -> The fractional overlap between successive STFT windows
+    const size_t INPUT_NUM_SAMPLES = 44100; // -> The number of samples to put through the STFT
+    
+    const std::vector< float > input( input_uniform_noise.begin(), input_uniform_noise.begin() + INPUT_NUM_SAMPLES );
+    
+    STFTAnalysis< FFT_SIZE > reference_STFT( FFT_OVERLAP, hamming_window );
+    const std::vector< std::array< std::complex< float >, reference_STFT.GetOutputSize() > > reference( reference_STFT.PushSamples( input ) );
+    
+    STFTAnalysis< FFT_SIZE > STFT( FFT_OVERLAP, hamming_window );
+    STFTFrameAnalyser< FFT_SIZE > analyser( hamming_window );
+    const auto& held = STFT.PushSamples( input.data(), WINDOW_LENGTH );
+    ASSERT_EQ( held.size(), 1u );
+    const auto held_frame = held[0];
+    
+    std::vector< std::array< std::complex< float >, STFT.GetOutputSize() > > output( 1, held_frame );
+    size_t input_pointer = WINDOW_LENGTH;
+    for( size_t piece=1; input_pointer<INPUT_NUM_SAMPLES; piece=( piece*7 )%4999 + 1 )
+    {
+        const size_t chunk = std::min( piece, INPUT_NUM_SAMPLES - input_pointer );
+        const size_t num_output = output.size();
+        const size_t num_frames = STFT.PushSamplesDirect( input.data() + input_pointer, chunk, [&]( const float* samples, size_t num_frames )
+        {
+            const size_t first = output.size();
+            output.resize( first + num_frames );
+            analyser.AnalyseFrames( samples, num_frames, STFT.GetIncrement(), output.data() + first );
+        });
+        ASSERT_EQ( output.size(), num_output + num_frames );
+        input_pointer += chunk;
+    }
+    
+    ASSERT_EQ( held.size(), 1u );
+    ASSERT_EQ( held[0], held_frame );
+    ASSERT_EQ( output.size(), reference.size() );
+    for( size_t frame=0; frame<output.size(); ++frame )
+    {
+        ASSERT_EQ( output[frame], reference[frame] ) << "Frame " << frame;
+    }
+}
@@ -133,6 +133,51 @@ TEST_F( STFTAnalysisSynthesisTest, test_noise_reconstruction )
     }
 }
 
+TEST_F( STFTAnalysisSynthesisTest, test_latency )
+///
+/// Test that samples pushed one at a time come out of the analysis and synthesis after the
+/// algorithmic latency each reports, and that the buffered samples account for the rest.
+///
+{
+    static const size_t FFT_SIZE = 2048;        // -> Padding beyond the window adds no latency.
+    
+    const float OVERLAP = 0.75;
+    const size_t NUM_FRAMES = 20;
+    
+    STFTAnalysis< FFT_SIZE > analyzer( OVERLAP, hamming_window );
+    STFTSynthesis< FFT_SIZE > synthesizer( analyzer );
+    const size_t increment = analyzer.GetIncrement();
+    EXPECT_EQ( analyzer.GetAlgorithmicLatency(), WINDOW_LENGTH - 1 );
+    EXPECT_EQ( synthesizer.GetAlgorithmicLatency(), WINDOW_LENGTH - increment );
+    EXPECT_EQ( synthesizer.GetBufferedSamples(), 0u );
+    
+    size_t num_frames = 0;
+    size_t num_output = 0;
+    size_t max_delay = 0;
+    for( size_t samp=0; num_frames<NUM_FRAMES; ++samp )
+    {
+        const auto& frames = analyzer.PushSamples( input_uniform_noise.data() + samp, 1 );
+        if( !frames.empty() )
+        {
+            // The frame starting at num_frames*increment is output with the latency of the analysis.
+            ASSERT_EQ( frames.size(), 1u );
+            EXPECT_EQ( samp, num_frames*increment + analyzer.GetAlgorithmicLatency() );
+            ++num_frames;
+            
+            // Each frame completes a hop of output, and holds the rest back.
+            const size_t first_output = num_output;
+            num_output += synthesizer.PushFrames( frames ).size();
+            EXPECT_EQ( num_output, num_frames*increment );
+            EXPECT_EQ( synthesizer.GetBufferedSamples(), synthesizer.GetAlgorithmicLatency() );
+            max_delay = std::max( max_delay, samp - first_output );
+        }
+        EXPECT_EQ( analyzer.GetBufferedSamples(), samp + 1 - num_frames*increment );
+    }
+    
+    // End to end, no sample waits for longer than the analysis latency.
+    EXPECT_EQ( max_delay, analyzer.GetAlgorithmicLatency() );
+}
+
 TEST_F( STFTAnalysisSynthesisTest, test_sinusoid_filtering )
 ///
 /// Test that when we input a combination of sinusoids to the STFT analysis object
@@ -187,3 +187,41 @@ TEST_F( STFTSynthesisTest, test_STFT_parameters )
     // @todo [matthew.mccallum 05.15.17]: Write this test
     ASSERT_TRUE(false);
 }
+
+TEST_F( STFTSynthesisTest, test_lock_free_output )
+///
+/// Test that synthesising into a lock-free overlap-add buffer gives the same signal as the
+/// output of PushFrames, once the consumer has drained the buffer.
+///
+{
+    static const size_t FFT_SIZE = 1024;                            // -> Number of input samples to the FFT operation (after zero-padding)
+    
+    const size_t NUM_INPUT_FRAMES = 100;                            // -> The number of spectrum frames to input into the STFT synthesis object for this test
+    const float OVERLAP = 0.75;                                     // -> The fractional overlap in the STFT synthesis between successive windows
+    const float TOLERANCE = 0.00001;                                // -> The allowable deviation of the output from the expected signal
+    
+    STFTSynthesis< FFT_SIZE > reference_synthesizer( OVERLAP, hamming_window );
+    STFTSynthesis< FFT_SIZE > synthesizer( OVERLAP, hamming_window );
+    LockFreeOverlapAddBuffer< float > output_buffer( NUM_INPUT_FRAMES*synthesizer.GetIncrement() + hamming_window.size() );
+    
+    // Create random spectra
+    std::vector< std::array< std::complex< float >, synthesizer.GetInputSize() > > spectral_input( NUM_INPUT_FRAMES, std::array< std::complex< float >, synthesizer.GetInputSize() >() );
+    for( auto& frame : spectral_input )
+    {
+        for( auto& bin : frame )
+        {
+            bin = std::complex< float >( veclib::make_random_number( -1.0, 1.0 ), veclib::make_random_number( -1.0, 1.0 ) );
+        }
+    }
+    
+    std::vector< float > expected( reference_synthesizer.PushFrames( spectral_input ) );
+    ASSERT_EQ( synthesizer.PushFrames( spectral_input, output_buffer ), NUM_INPUT_FRAMES );
+    ASSERT_EQ( output_buffer.NumSamples(), expected.size() );
+    
+    std::vector< float > output( output_buffer.NumSamples() );
+    output_buffer.Read( output );
+    for( size_t samp=0; samp<output.size(); ++samp )
+    {
+        EXPECT_NEAR( output[samp], expected[samp], TOLERANCE );
+    }
+}
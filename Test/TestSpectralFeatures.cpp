@@ -0,0 +1,143 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for SpectralFeatures class
+//
+
+// In module includes
+#include "SpectralFeatures.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+using namespace cupcake;
+
+class SpectralFeaturesTest : public ::testing::Test
+///
+/// Test fixture for SpectralFeatures tests.
+/// Creates and holds a window, a noise signal and a sinusoid at A4.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 4096;
+    const size_t WINDOW_LENGTH = 4096;
+    const float OVERLAP = 0.75;
+    const float SAMPLE_RATE = 44100.0f;
+    const size_t SIGNAL_LENGTH = 44100;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create a window, some noise and a sinusoid.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        noise.resize( SIGNAL_LENGTH );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+
+        sinusoid.resize( SIGNAL_LENGTH );
+        for( size_t sample=0; sample<SIGNAL_LENGTH; ++sample )
+        {
+            sinusoid[sample] = static_cast< float >( std::sin( 2.0*M_PI*440.0*sample/SAMPLE_RATE ) );
+        }
+    }
+
+    std::vector< float > window;        // The analysis window.
+    std::vector< float > noise;         // White noise.
+    std::vector< float > sinusoid;      // A sinusoid at 440 Hz.
+
+};
+
+TEST_F( SpectralFeaturesTest, test_sinusoid )
+///
+/// Tests that a sinusoid at A4 has its chroma energy in pitch class A, its centroid near 440 Hz,
+/// and almost no flux once it is steady.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    wavelet.ConfigureFeatures( SAMPLE_RATE, 8, 27.5f, 440.0f );
+    SpectralFeatureFrames& features = wavelet.PushSamplesFeatures( ArrayView< const float >( sinusoid ) );
+    ASSERT_GT( features.num_frames, 2u );
+    ASSERT_EQ( features.chroma.size(), features.num_frames*12 );
+    ASSERT_EQ( features.bands.size(), features.num_frames*8 );
+
+    for( size_t frame=0; frame<features.num_frames; ++frame )
+    {
+        const float* chroma = features.chroma.data() + frame*12;
+        EXPECT_EQ( std::max_element( chroma, chroma + 12 ) - chroma, 9 );
+        EXPECT_NEAR( features.centroid[frame], 440.0f, 44.0f );
+    }
+    for( size_t frame=1; frame<features.num_frames; ++frame )
+    {
+        EXPECT_LT( features.flux[frame], 1e-2f*features.flux[0] );
+    }
+}
+
+TEST_F( SpectralFeaturesTest, test_matches_reference )
+///
+/// Tests the features of noise, pushed in chunks, against a direct computation from the output
+/// frames. Chroma and band energies must both account for all power above the lowest frequency.
+///
+{
+    const float min_frequency = 55.0f;
+    const size_t num_bands = 6;
+
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    SpectralFeatures< FFT_SIZE > features( SAMPLE_RATE, num_bands, min_frequency );
+    ASSERT_EQ( features.GetBandEdges().size(), num_bands + 1 );
+    EXPECT_NEAR( features.GetBandEdges().back(), SAMPLE_RATE/2, 1e-2f );
+
+    std::vector< float > previous_magnitude( FastWavelet< FFT_SIZE >::mOutputSize, 0.0f );
+    for( size_t pos=0; pos<SIGNAL_LENGTH; pos+=10000 )
+    {
+        std::vector< float > chunk( noise.begin() + pos, noise.begin() + std::min( pos + 10000, SIGNAL_LENGTH ) );
+        auto& frames = wavelet.PushSamples( chunk );
+        SpectralFeatureFrames& output = features.Process( frames.data(), frames.size() );
+        ASSERT_EQ( output.num_frames, frames.size() );
+
+        for( size_t frame=0; frame<frames.size(); ++frame )
+        {
+            double total_power = 0.0;
+            double weighted_power = 0.0;
+            double power_above_min = 0.0;
+            double flux = 0.0;
+            for( size_t bin=0; bin<frames[frame].size(); ++bin )
+            {
+                const double power = std::norm( frames[frame][bin] );
+                const double frequency = bin*SAMPLE_RATE/FFT_SIZE;
+                total_power += power;
+                weighted_power += power*frequency;
+                power_above_min += frequency >= min_frequency ? power : 0.0;
+                flux += std::max( std::abs( frames[frame][bin] ) - previous_magnitude[bin], 0.0f );
+                previous_magnitude[bin] = std::abs( frames[frame][bin] );
+            }
+
+            const float chroma_sum = std::accumulate( output.chroma.begin() + frame*12, output.chroma.begin() + ( frame + 1 )*12, 0.0f );
+            const float band_sum = std::accumulate( output.bands.begin() + frame*num_bands, output.bands.begin() + ( frame + 1 )*num_bands, 0.0f );
+            EXPECT_NEAR( chroma_sum, power_above_min, 1e-3*power_above_min );
+            EXPECT_NEAR( band_sum, power_above_min, 1e-3*power_above_min );
+            EXPECT_NEAR( output.centroid[frame], weighted_power/total_power, 1e-3*weighted_power/total_power );
+            EXPECT_NEAR( output.flux[frame], flux, 1e-3*flux );
+        }
+    }
+
+    // After a reset, flux is measured against silence again.
+    features.Reset();
+    auto& frames = wavelet.PushSamples( noise );
+    SpectralFeatureFrames& output = features.Process( frames.data(), 1 );
+    const float magnitude_sum = std::accumulate( frames[0].begin(), frames[0].end(), 0.0f, []( float sum, const std::complex< float >& value ){ return sum + std::abs( value ); } );
+    EXPECT_NEAR( output.flux[0], magnitude_sum, 1e-3*magnitude_sum );
+}
@@ -0,0 +1,162 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for StreamEngine class
+//
+
+// In module includes
+#include "StreamEngine.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <mutex>
+#include <cmath>
+
+using namespace cupcake;
+
+class StreamEngineTest : public ::testing::Test
+///
+/// Test fixture for StreamEngine tests.
+/// Creates and holds a window and a noise signal for each stream.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const size_t NUM_STREAMS = 12;
+    const size_t STREAM_LENGTH = 20000;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create a window and some noise.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        signals.resize( NUM_STREAMS );
+        for( auto& signal : signals )
+        {
+            signal.resize( STREAM_LENGTH );
+            std::generate( signal.begin(), signal.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+        }
+    }
+
+    std::vector< float > window;                    // The window used by all streams.
+    std::vector< std::vector< float > > signals;    // The samples of each stream.
+
+};
+
+TEST_F( StreamEngineTest, test_matches_fast_wavelet )
+///
+/// Tests that streams pushed in chunks of differing sizes, with some streams skipping some calls,
+/// give the same frames as one FastWavelet per stream.
+///
+{
+    typedef StreamEngine< FFT_SIZE > engine_type;
+
+    engine_type engine( OVERLAP, window, 4 );
+    std::vector< size_t > streams;
+    for( size_t stream=0; stream<NUM_STREAMS; ++stream )
+    {
+        streams.push_back( engine.AddStream() );
+    }
+    ASSERT_EQ( engine.GetNumStreams(), NUM_STREAMS );
+
+    // Collect the frames of each stream, in order of frame index.
+    std::mutex frames_mutex;
+    std::vector< std::vector< engine_type::Frame > > frames( NUM_STREAMS );
+    auto sink = [&]( size_t stream, uint64_t first_frame, const engine_type::Frame* block, size_t num_frames )
+    {
+        std::lock_guard< std::mutex > lock( frames_mutex );
+        auto& stream_frames = frames[stream];
+        stream_frames.resize( std::max< size_t >( stream_frames.size(), first_frame + num_frames ) );
+        std::copy( block, block + num_frames, stream_frames.begin() + first_frame );
+    };
+
+    // Push each stream in chunks whose size varies by stream and by call, from less than a hop to several windows.
+    std::vector< size_t > positions( NUM_STREAMS, 0 );
+    for( size_t call=0; std::any_of( positions.begin(), positions.end(), [this]( size_t pos ){ return pos < STREAM_LENGTH; } ); ++call )
+    {
+        std::vector< engine_type::StreamInput > inputs;
+        for( size_t stream=0; stream<NUM_STREAMS; ++stream )
+        {
+            if( positions[stream] >= STREAM_LENGTH || ( call + stream )%5 == 0 )
+            {
+                continue;
+            }
+            const size_t chunk = std::min( 37 + ( ( call*7919 + stream*104729 )%4000 ), STREAM_LENGTH - positions[stream] );
+            inputs.push_back( { streams[stream], signals[stream].data() + positions[stream], chunk } );
+            positions[stream] += chunk;
+        }
+        engine.Process( inputs.data(), inputs.size(), sink );
+    }
+
+    for( size_t stream=0; stream<NUM_STREAMS; ++stream )
+    {
+        FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+        auto& expected = wavelet.PushSamples( signals[stream] );
+        ASSERT_EQ( frames[stream].size(), expected.size() );
+
+        for( size_t frame=0; frame<expected.size(); ++frame )
+        {
+            for( size_t bin=0; bin<expected[frame].size(); ++bin )
+            {
+                const float tolerance = 1e-5f*std::max( 1.0f, std::abs( expected[frame][bin] ) );
+                ASSERT_NEAR( frames[stream][frame][bin].real(), expected[frame][bin].real(), tolerance );
+                ASSERT_NEAR( frames[stream][frame][bin].imag(), expected[frame][bin].imag(), tolerance );
+            }
+        }
+    }
+}
+
+TEST_F( StreamEngineTest, test_stream_lifetime )
+///
+/// Tests that streams may be removed and added again, that a new stream starts afresh, and that
+/// the state held per stream is small.
+///
+{
+    typedef StreamEngine< FFT_SIZE > engine_type;
+
+    engine_type engine( OVERLAP, window, 2 );
+    EXPECT_LT( engine.GetStreamStateBytes(), WINDOW_LENGTH*sizeof( float ) + 256 );
+
+    const size_t first = engine.AddStream();
+    const size_t second = engine.AddStream();
+    engine.RemoveStream( first );
+    EXPECT_EQ( engine.GetNumStreams(), 1u );
+
+    // Leave a partial frame in the second stream, then replace the first.
+    uint64_t num_frames = 0;
+    auto sink = [&]( size_t, uint64_t first_frame, const engine_type::Frame*, size_t count ){ num_frames = std::max< uint64_t >( num_frames, first_frame + count ); };
+    engine_type::StreamInput partial = { second, signals[0].data(), WINDOW_LENGTH - 1 };
+    engine.Process( &partial, 1, sink );
+    EXPECT_EQ( num_frames, 0u );
+
+    const size_t third = engine.AddStream();
+    EXPECT_EQ( third, first );
+
+    // A whole window completes a frame in the fresh stream, and one more sample does so in the other.
+    engine_type::StreamInput inputs[] = { { third, signals[1].data(), WINDOW_LENGTH }, { second, signals[0].data() + WINDOW_LENGTH - 1, 1 } };
+    std::vector< size_t > frames_per_stream( 2, 0 );
+    std::mutex mutex;
+    engine.Process( inputs, 2, [&]( size_t stream, uint64_t first_frame, const engine_type::Frame*, size_t count )
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        EXPECT_EQ( first_frame, 0u );
+        frames_per_stream[stream == second ? 1 : 0] += count;
+    });
+    EXPECT_EQ( frames_per_stream[0], 1u );
+    EXPECT_EQ( frames_per_stream[1], 1u );
+}
@@ -0,0 +1,145 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for StreamingPipeline class
+//
+
+// In module includes
+#include "StreamingPipeline.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+
+using namespace cupcake;
+
+class StreamingPipelineTest : public ::testing::Test
+///
+/// Test fixture for StreamingPipeline tests.
+/// Creates and holds a window and a block of white noise.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.875;
+    const size_t SIGNAL_LENGTH = 44100*2;
+
+    typedef StreamingPipeline< FFT_SIZE >::Frame Frame;
+
+    virtual void SetUp()
+    ///
+    /// Before all the tests, create the window and noise.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        noise.resize( SIGNAL_LENGTH );
+        std::generate( noise.begin(), noise.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+    }
+
+    std::vector< float > window;        // The analysis window.
+    std::vector< float > noise;         // White noise.
+
+};
+
+TEST_F( StreamingPipelineTest, test_matches_fast_wavelet )
+///
+/// Tests that the sink receives exactly the frames of FastWavelet, in order, with pushes both smaller
+/// and larger than a block.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    auto expected = wavelet.PushSamples( noise );
+
+    std::vector< Frame > result;
+    StreamingPipeline< FFT_SIZE > pipeline( OVERLAP, window, [&result]( uint64_t first_frame, const Frame* frames, size_t num_frames )
+    {
+        ASSERT_EQ( first_frame, result.size() );
+        result.insert( result.end(), frames, frames + num_frames );
+    } );
+    EXPECT_EQ( pipeline.GetIncrement(), wavelet.GetIncrement() );
+
+    for( size_t pos=0, piece=1; pos<noise.size(); pos+=piece, piece=( piece*13 )%20011 + 1 )
+    {
+        pipeline.PushSamples( noise.data() + pos, std::min( piece, noise.size() - pos ) );
+    }
+    pipeline.Finish();
+    EXPECT_THROW( pipeline.PushSamples( noise.data(), noise.size() ), std::logic_error );
+
+    ASSERT_EQ( result.size(), expected.size() );
+    for( size_t frame=0; frame<expected.size(); ++frame )
+    {
+        EXPECT_TRUE( std::equal( expected[frame].begin(), expected[frame].end(), result[frame].begin() ) ) << "Frame " << frame;
+    }
+}
+
+TEST_F( StreamingPipelineTest, test_backpressure )
+///
+/// Tests that a slow sink holds back the caller, so that no more than the queues and the stages can
+/// hold is ever pushed ahead of the sink.
+///
+{
+    const size_t capacity = 1;
+    const size_t block_size = StreamingPipeline< FFT_SIZE >::MAX_BLOCK_SAMPLES;
+    const size_t increment = static_cast< size_t >( ( 1 - OVERLAP )*WINDOW_LENGTH );
+    std::atomic< size_t > sunk_samples( 0 );
+    StreamingPipeline< FFT_SIZE > pipeline( OVERLAP, window, [&sunk_samples, increment]( uint64_t first_frame, const Frame* frames, size_t num_frames )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+        sunk_samples += num_frames*increment;
+    }, capacity );
+
+    // Each of the three queues holds one block, and each of the three stages one more.
+    const size_t max_ahead = ( 3*capacity + 3 + 1 )*block_size + WINDOW_LENGTH;
+    size_t max_seen = 0;
+    for( size_t pos=0; pos<noise.size(); pos+=block_size )
+    {
+        pipeline.PushSamples( noise.data() + pos, std::min( block_size, noise.size() - pos ) );
+        const size_t pushed = std::min( pos + block_size, noise.size() );
+        max_seen = std::max( max_seen, pushed - std::min( pushed, sunk_samples.load() ) );
+    }
+    pipeline.Finish();
+
+    EXPECT_LE( max_seen, max_ahead );
+    EXPECT_GE( sunk_samples.load(), noise.size() - WINDOW_LENGTH );
+}
+
+TEST_F( StreamingPipelineTest, test_sink_error )
+///
+/// Tests that an exception thrown by the sink is rethrown to the caller, by every later call, and
+/// that the sink is not called again.
+///
+{
+    std::atomic< size_t > calls( 0 );
+    StreamingPipeline< FFT_SIZE > pipeline( OVERLAP, window, [&calls]( uint64_t first_frame, const Frame* frames, size_t num_frames )
+    {
+        ++calls;
+        throw std::runtime_error( "Sink failed" );
+    } );
+
+    EXPECT_THROW(
+    {
+        for( size_t pos=0; pos<noise.size(); pos+=1024 )
+        {
+            pipeline.PushSamples( noise.data() + pos, std::min< size_t >( 1024, noise.size() - pos ) );
+        }
+        pipeline.Finish();
+    }, std::runtime_error );
+    EXPECT_THROW( pipeline.Finish(), std::runtime_error );
+    EXPECT_EQ( calls.load(), 1u );
+}
@@ -0,0 +1,95 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for ThreadPool class
+//
+
+// In module includes
+#include "ThreadPool.h"
+
+// Thirdparty includes
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <atomic>
+#include <thread>
+
+using namespace cupcake;
+
+TEST( ThreadPoolTest, test_every_task_runs_once )
+///
+/// Tests that every task index is run exactly once, by a valid worker, across several
+/// successive loops on the same pool.
+///
+{
+    const size_t NUM_THREADS = 4;           // -> The number of workers in the pool, including the caller.
+    const size_t NUM_TASKS = 1000;          // -> The number of tasks in each loop.
+    const size_t NUM_LOOPS = 20;            // -> The number of loops run on the pool.
+
+    ThreadPool pool( NUM_THREADS );
+    ASSERT_EQ( pool.GetNumThreads(), NUM_THREADS );
+
+    for( size_t loop=0; loop<NUM_LOOPS; ++loop )
+    {
+        std::vector< std::atomic< size_t > > counts( NUM_TASKS );
+        for( auto& count : counts )
+        {
+            count = 0;
+        }
+        std::atomic< bool > workers_valid( true );
+
+        pool.ParallelFor( NUM_TASKS, [&]( size_t task, size_t worker )
+        {
+            counts[task]++;
+            if( worker >= NUM_THREADS )
+            {
+                workers_valid = false;
+            }
+        });
+
+        ASSERT_TRUE( workers_valid );
+        for( auto& count : counts )
+        {
+            ASSERT_EQ( count, 1 );
+        }
+    }
+
+    // An empty loop returns immediately.
+    pool.ParallelFor( 0, []( size_t, size_t ){ FAIL(); } );
+}
+
+TEST( ThreadPoolTest, test_concurrent_callers )
+///
+/// Tests that loops started from several threads at once on the same pool are each run
+/// to completion.
+///
+{
+    const size_t NUM_THREADS = 3;           // -> The number of workers in the pool, including the caller.
+    const size_t NUM_CALLERS = 4;           // -> The number of threads sharing the pool.
+    const size_t NUM_TASKS = 500;           // -> The number of tasks in each loop.
+
+    ThreadPool pool( NUM_THREADS );
+    std::vector< std::atomic< size_t > > totals( NUM_CALLERS );
+    std::vector< std::thread > callers;
+    for( size_t caller=0; caller<NUM_CALLERS; ++caller )
+    {
+        totals[caller] = 0;
+        callers.emplace_back( [&, caller]()
+        {
+            pool.ParallelFor( NUM_TASKS, [&]( size_t task, size_t )
+            {
+                totals[caller] += task;
+            });
+        });
+    }
+    for( auto& caller : callers )
+    {
+        caller.join();
+    }
+
+    for( auto& total : totals )
+    {
+        ASSERT_EQ( total, NUM_TASKS*( NUM_TASKS - 1 )/2 );
+    }
+}
@@ -0,0 +1,249 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for TransformCache class
+//
+
+// In module includes
+#include "TransformCache.h"
+#include "FastWavelet.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace cupcake;
+
+class TransformCacheTest : public ::testing::Test
+///
+/// Test fixture for TransformCache tests.
+/// Creates and holds a window, a few noise clips and an empty cache directory.
+///
+{
+protected:
+
+    static const size_t FFT_SIZE = 1024;
+    const size_t WINDOW_LENGTH = 1024;
+    const float OVERLAP = 0.75;
+    const size_t CLIP_LENGTH = 22050;
+    const size_t NUM_CLIPS = 3;
+
+    virtual void SetUp()
+    ///
+    /// Before each test, create a window, the clips and a temporary directory.
+    ///
+    {
+        window.resize( WINDOW_LENGTH );
+        veclib::hamming( window );
+
+        veclib::seed_rand();
+        clips.resize( NUM_CLIPS, std::vector< float >( CLIP_LENGTH ) );
+        for( auto& clip : clips )
+        {
+            std::generate( clip.begin(), clip.end(), std::bind( &veclib::make_random_number, -1.0, 1.0 ) );
+        }
+
+        char name[] = "/tmp/cupcake_transform_cache_XXXXXX";
+        ASSERT_NE( mkdtemp( name ), nullptr );
+        directory = name;
+    }
+
+    virtual void TearDown()
+    ///
+    /// After each test, remove the directory and everything in it.
+    ///
+    {
+        if( DIR* dir = opendir( directory.c_str() ) )
+        {
+            while( struct dirent* item = readdir( dir ) )
+            {
+                std::remove( ( directory + "/" + item->d_name ).c_str() );
+            }
+            closedir( dir );
+        }
+        rmdir( directory.c_str() );
+    }
+
+    std::vector< float > window;                    // The analysis window.
+    std::vector< std::vector< float > > clips;      // Clips of white noise.
+    std::string directory;                          // The cache directory.
+
+};
+
+TEST_F( TransformCacheTest, test_hasher )
+///
+/// Tests that hashing bytes in pieces gives the same key as hashing them at once, and that
+/// changing any byte, or appending zeros, changes the key.
+///
+{
+    const std::vector< float >& clip = clips[0];
+    const size_t num_bytes = 1001*sizeof( float );
+
+    TransformHasher whole;
+    whole.Update( clip.data(), num_bytes );
+    const TransformKey expected = whole.Finish();
+    EXPECT_EQ( expected.ToString().size(), 32u );
+
+    TransformHasher pieces;
+    const char* bytes = reinterpret_cast< const char* >( clip.data() );
+    for( size_t pos=0, piece=1; pos<num_bytes; pos+=piece, piece=piece%23 + 1 )
+    {
+        pieces.Update( bytes + pos, std::min( piece, num_bytes - pos ) );
+    }
+    EXPECT_TRUE( pieces.Finish() == expected );
+
+    std::vector< float > changed( clip.begin(), clip.begin() + 1001 );
+    changed[500] = std::nextafter( changed[500], 2.0f );
+    TransformHasher changed_hasher;
+    changed_hasher.Update( changed.data(), num_bytes );
+    EXPECT_FALSE( changed_hasher.Finish() == expected );
+
+    const std::vector< float > zeros( 8, 0.0f );
+    TransformHasher short_zeros;
+    short_zeros.Update( zeros.data(), 4*sizeof( float ) );
+    TransformHasher long_zeros;
+    long_zeros.Update( zeros.data(), 8*sizeof( float ) );
+    EXPECT_FALSE( short_zeros.Finish() == long_zeros.Finish() );
+}
+
+TEST_F( TransformCacheTest, test_hit_and_miss )
+///
+/// Tests that the first transform of a clip is computed and stored, giving the same frames as a
+/// freshly constructed FastWavelet, and that later transforms of it, by this or another cache,
+/// are found rather than computed. A different overlap must not find them.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    TransformCache cache( directory, 1 << 30 );
+
+    std::shared_ptr< FrameStoreReader > first = cache.Transform( wavelet, ArrayView< const float >( clips[0] ) );
+    EXPECT_EQ( cache.GetNumMisses(), 1u );
+    EXPECT_EQ( cache.GetNumHits(), 0u );
+    EXPECT_GT( cache.GetSizeBytes(), 0u );
+
+    FastWavelet< FFT_SIZE > fresh( OVERLAP, window );
+    auto expected = fresh.PushSamples( clips[0] );
+    ASSERT_EQ( first->GetNumClips(), 1u );
+    ASSERT_EQ( first->GetNumFrames( 0 ), expected.size() );
+    EXPECT_EQ( first->GetHop(), wavelet.GetIncrement() );
+    const std::complex< float >* frames = first->GetFrames( 0 );
+    for( size_t frame=0; frame<expected.size(); ++frame )
+    {
+        EXPECT_TRUE( std::equal( expected[frame].begin(), expected[frame].end(), frames + frame*FastWavelet< FFT_SIZE >::mOutputSize ) );
+    }
+
+    std::shared_ptr< FrameStoreReader > second = cache.Transform( wavelet, ArrayView< const float >( clips[0] ) );
+    EXPECT_EQ( cache.GetNumHits(), 1u );
+    ASSERT_EQ( second->GetNumFrames( 0 ), expected.size() );
+    EXPECT_TRUE( std::equal( frames, frames + expected.size()*FastWavelet< FFT_SIZE >::mOutputSize, second->GetFrames( 0 ) ) );
+
+    TransformCache other_cache( directory, 1 << 30 );
+    other_cache.Transform( wavelet, ArrayView< const float >( clips[0] ) );
+    EXPECT_EQ( other_cache.GetNumHits(), 1u );
+
+    FastWavelet< FFT_SIZE > other_overlap( 0.5f, window );
+    other_cache.Transform( other_overlap, ArrayView< const float >( clips[0] ) );
+    EXPECT_EQ( other_cache.GetNumMisses(), 1u );
+    EXPECT_FALSE( TransformCache::MakeKey( wavelet, ArrayView< const float >( clips[0] ) ) ==
+                  TransformCache::MakeKey( other_overlap, ArrayView< const float >( clips[0] ) ) );
+}
+
+TEST_F( TransformCacheTest, test_eviction )
+///
+/// Tests that the cache keeps within its size limit by deleting the least recently used transform,
+/// and that transforms already returned stay readable after they are deleted.
+///
+{
+    FastWavelet< FFT_SIZE > wavelet( OVERLAP, window );
+    std::shared_ptr< FrameStoreReader > first;
+    uint64_t entry_size = 0;
+    {
+        TransformCache sizing_cache( directory, 1 << 30 );
+        first = sizing_cache.Transform( wavelet, ArrayView< const float >( clips[0] ) );
+        entry_size = sizing_cache.GetSizeBytes();
+    }
+
+    // Room for two transforms. File times have a coarse resolution, so wait between uses.
+    TransformCache cache( directory, 2*entry_size + entry_size/2 );
+    const auto pause = [](){ std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) ); };
+    pause();
+    cache.Transform( wavelet, ArrayView< const float >( clips[1] ) );
+    pause();
+    cache.Transform( wavelet, ArrayView< const float >( clips[0] ) );
+    EXPECT_EQ( cache.GetNumHits(), 1u );
+    pause();
+    cache.Transform( wavelet, ArrayView< const float >( clips[2] ) );
+    EXPECT_EQ( cache.GetSizeBytes(), 2*entry_size );
+
+    // The second clip was used least recently, so it is gone, and the first is not.
+    const uint64_t hits = cache.GetNumHits();
+    EXPECT_FALSE( cache.Find( TransformCache::MakeKey( wavelet, ArrayView< const float >( clips[1] ) ) ) );
+    EXPECT_TRUE( cache.Find( TransformCache::MakeKey( wavelet, ArrayView< const float >( clips[0] ) ) ) );
+    EXPECT_EQ( cache.GetNumHits(), hits + 1 );
+
+    // A cache too small for anything deletes transforms as they are made, but they can still be read.
+    TransformCache tiny_cache( directory, 0 );
+    tiny_cache.Evict();
+    EXPECT_EQ( tiny_cache.GetSizeBytes(), 0u );
+    std::shared_ptr< FrameStoreReader > evicted = tiny_cache.Transform( wavelet, ArrayView< const float >( clips[1] ) );
+    EXPECT_EQ( tiny_cache.GetSizeBytes(), 0u );
+    EXPECT_EQ( evicted->GetNumFrames( 0 ), first->GetNumFrames( 0 ) );
+    EXPECT_TRUE( std::isfinite( std::abs( evicted->GetFrames( 0 )[evicted->GetNumBins()*10] ) ) );
+}
+
+TEST_F( TransformCacheTest, test_stale_temporary_files )
+///
+/// Tests that eviction deletes temporary files left behind by crashed writers, but not those of
+/// transforms that may still be being written, and that temporary files are not counted as cached
+/// transforms.
+///
+{
+    const std::string stale_path = directory + "/00000000000000000000000000000001.cfs.tmp.1.0";
+    const std::string fresh_path = directory + "/00000000000000000000000000000002.cfs.tmp.1.1";
+    for( const std::string& path : { stale_path, fresh_path } )
+    {
+        FILE* file = std::fopen( path.c_str(), "wb" );
+        ASSERT_NE( file, nullptr );
+        std::fputs( "partial transform", file );
+        std::fclose( file );
+    }
+
+    // Make the stale file an hour old.
+    struct timespec times[2];
+    clock_gettime( CLOCK_REALTIME, &times[0] );
+    times[0].tv_sec -= 60*60;
+    times[1] = times[0];
+    ASSERT_EQ( utimensat( AT_FDCWD, stale_path.c_str(), times, 0 ), 0 );
+
+    TransformCache cache( directory, 1 << 30 );
+    EXPECT_EQ( cache.GetSizeBytes(), 0u );
+    EXPECT_NE( access( stale_path.c_str(), F_OK ), 0 );
+    EXPECT_EQ( access( fresh_path.c_str(), F_OK ), 0 );
+
+    // Transforms inserted alongside the temporary files are counted and found as usual.
+    const size_t num_bins = FFT_SIZE/2 + 1;
+    std::vector< std::complex< float > > frames( 4*num_bins, std::complex< float >( 1.0f, -1.0f ) );
+    TransformKey key = { 3, 4 };
+    std::shared_ptr< FrameStoreReader > reader = cache.Insert( key, FFT_SIZE, WINDOW_LENGTH/4, window, frames.data(), 4 );
+    ASSERT_TRUE( reader );
+    EXPECT_EQ( reader->GetNumFrames( 0 ), 4u );
+    EXPECT_GT( cache.GetSizeBytes(), 0u );
+    EXPECT_TRUE( cache.Find( key ) );
+}
@@ -0,0 +1,222 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for WavFile class
+//
+
+// In module includes
+#include "WavFile.h"
+
+// Thirdparty includes
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+using namespace cupcake;
+
+class WavFileTest : public ::testing::Test
+///
+/// Test fixture for WavFile tests.
+/// Creates and holds the path of a temporary file, and writes WAV files to it.
+///
+{
+protected:
+
+    virtual void SetUp()
+    ///
+    /// Before each test, create an empty temporary file.
+    ///
+    {
+        char name[] = "/tmp/cupcake_wav_file_XXXXXX";
+        const int file = mkstemp( name );
+        ASSERT_GE( file, 0 );
+        close( file );
+        path = name;
+    }
+
+    virtual void TearDown()
+    ///
+    /// After each test, remove the file.
+    ///
+    {
+        std::remove( path.c_str() );
+    }
+
+    static void Append( std::vector< unsigned char >& bytes, uint64_t value, size_t num_bytes )
+    ///
+    /// Appends a little endian integer.
+    ///
+    {
+        for( size_t byte=0; byte<num_bytes; ++byte )
+        {
+            bytes.push_back( static_cast< unsigned char >( value >> ( 8*byte ) ) );
+        }
+    }
+
+    void Write( uint16_t format, uint16_t num_channels, uint16_t bits, const std::vector< unsigned char >& samples, bool extensible=false, bool extra_chunk=false )
+    ///
+    /// Writes a WAV file with the given format and raw sample data.
+    ///
+    {
+        std::vector< unsigned char > body = { 'W', 'A', 'V', 'E' };
+        if( extra_chunk )
+        {
+            // An odd sized chunk, which is followed by a byte of padding.
+            body.insert( body.end(), { 'L', 'I', 'S', 'T' } );
+            Append( body, 3, 4 );
+            body.insert( body.end(), { 'a', 'b', 'c', 0 } );
+        }
+
+        body.insert( body.end(), { 'f', 'm', 't', ' ' } );
+        Append( body, extensible ? 40 : 16, 4 );
+        Append( body, extensible ? 0xfffe : format, 2 );
+        Append( body, num_channels, 2 );
+        Append( body, 44100, 4 );
+        Append( body, 44100*num_channels*bits/8, 4 );
+        Append( body, num_channels*bits/8, 2 );
+        Append( body, bits, 2 );
+        if( extensible )
+        {
+            Append( body, 22, 2 );
+            Append( body, bits, 2 );
+            Append( body, 0, 4 );
+            Append( body, format, 2 );
+            body.insert( body.end(), 14, 0 );
+        }
+
+        body.insert( body.end(), { 'd', 'a', 't', 'a' } );
+        Append( body, samples.size(), 4 );
+        body.insert( body.end(), samples.begin(), samples.end() );
+
+        std::vector< unsigned char > file = { 'R', 'I', 'F', 'F' };
+        Append( file, body.size(), 4 );
+        file.insert( file.end(), body.begin(), body.end() );
+
+        FILE* output = std::fopen( path.c_str(), "wb" );
+        ASSERT_NE( output, nullptr );
+        std::fwrite( file.data(), 1, file.size(), output );
+        std::fclose( output );
+    }
+
+    std::string path;       // The WAV file.
+
+};
+
+TEST_F( WavFileTest, test_int16_stereo )
+///
+/// Tests that 16 bit stereo samples are decoded and averaged, from any starting frame.
+///
+{
+    const std::vector< int16_t > samples = { 0, 16384, -32768, -32768, 32767, 16383, 100, -100 };
+    std::vector< unsigned char > bytes;
+    for( int16_t sample : samples )
+    {
+        Append( bytes, static_cast< uint16_t >( sample ), 2 );
+    }
+    Write( 1, 2, 16, bytes, false, true );
+
+    WavFile wav( path );
+    EXPECT_EQ( wav.GetNumFrames(), 4u );
+    EXPECT_EQ( wav.GetNumChannels(), 2u );
+    EXPECT_EQ( wav.GetSampleRate(), 44100u );
+    EXPECT_EQ( wav.GetSampleFormat(), WAV_FORMAT_INT16 );
+    EXPECT_EQ( wav.GetFloatSamples(), nullptr );
+
+    std::vector< float > output( 4 );
+    wav.ReadMono( 0, 4, output.data() );
+    EXPECT_FLOAT_EQ( output[0], 0.25f );
+    EXPECT_FLOAT_EQ( output[1], -1.0f );
+    EXPECT_FLOAT_EQ( output[2], ( 32767.0f + 16383.0f )/65536.0f );
+    EXPECT_FLOAT_EQ( output[3], 0.0f );
+
+    wav.ReadMono( 2, 2, output.data() );
+    EXPECT_FLOAT_EQ( output[0], ( 32767.0f + 16383.0f )/65536.0f );
+    EXPECT_THROW( wav.ReadMono( 3, 2, output.data() ), std::out_of_range );
+}
+
+TEST_F( WavFileTest, test_int24_extensible )
+///
+/// Tests that packed 24 bit samples in a WAVE_FORMAT_EXTENSIBLE file are decoded, including their sign.
+///
+{
+    const std::vector< int32_t > samples = { 4194304, -8388608, -1, 8388607 };
+    std::vector< unsigned char > bytes;
+    for( int32_t sample : samples )
+    {
+        Append( bytes, static_cast< uint32_t >( sample ), 3 );
+    }
+    Write( 1, 1, 24, bytes, true );
+
+    WavFile wav( path );
+    EXPECT_EQ( wav.GetSampleFormat(), WAV_FORMAT_INT24 );
+    ASSERT_EQ( wav.GetNumFrames(), 4u );
+    std::vector< float > output( 4 );
+    wav.ReadMono( 0, 4, output.data() );
+    for( size_t sample=0; sample<samples.size(); ++sample )
+    {
+        EXPECT_FLOAT_EQ( output[sample], samples[sample]/8388608.0f );
+    }
+}
+
+TEST_F( WavFileTest, test_float )
+///
+/// Tests that mono 32 bit float samples are read straight from the mapping, and that 64 bit
+/// float samples are decoded.
+///
+{
+    const std::vector< float > samples = { 0.5f, -0.25f, 1.5f, 0.125f, -1.0f };
+    std::vector< unsigned char > bytes( samples.size()*sizeof( float ) );
+    std::memcpy( bytes.data(), samples.data(), bytes.size() );
+    Write( 3, 1, 32, bytes );
+    {
+        WavFile wav( path );
+        EXPECT_EQ( wav.GetSampleFormat(), WAV_FORMAT_FLOAT32 );
+        ASSERT_NE( wav.GetFloatSamples(), nullptr );
+        ASSERT_EQ( wav.GetNumFrames(), samples.size() );
+        EXPECT_TRUE( std::equal( samples.begin(), samples.end(), wav.GetFloatSamples() ) );
+    }
+
+    const std::vector< double > doubles = { 0.5, -0.25, 0.75 };
+    bytes.resize( doubles.size()*sizeof( double ) );
+    std::memcpy( bytes.data(), doubles.data(), bytes.size() );
+    Write( 3, 1, 64, bytes );
+    {
+        WavFile wav( path );
+        EXPECT_EQ( wav.GetSampleFormat(), WAV_FORMAT_FLOAT64 );
+        EXPECT_EQ( wav.GetFloatSamples(), nullptr );
+        std::vector< float > output( 3 );
+        wav.ReadMono( 0, 3, output.data() );
+        EXPECT_EQ( output, std::vector< float >( { 0.5f, -0.25f, 0.75f } ) );
+    }
+}
+
+TEST_F( WavFileTest, test_invalid_files )
+///
+/// Tests that files that are not WAV files, or have unsupported formats, are rejected, and that a
+/// data chunk claiming more samples than the file holds is cut short.
+///
+{
+    EXPECT_THROW( WavFile{ path }, std::runtime_error );
+    EXPECT_THROW( WavFile( path + ".missing" ), std::runtime_error );
+
+    Write( 1, 1, 12, std::vector< unsigned char >( 12, 0 ) );
+    EXPECT_THROW( WavFile{ path }, std::runtime_error );
+
+    Write( 2, 1, 16, std::vector< unsigned char >( 12, 0 ) );
+    EXPECT_THROW( WavFile{ path }, std::runtime_error );
+
+    // Cut the last sample in half.
+    Write( 1, 1, 16, std::vector< unsigned char >( 12, 0 ) );
+    ASSERT_EQ( truncate( path.c_str(), 44 + 11 ), 0 );
+    WavFile wav( path );
+    EXPECT_EQ( wav.GetNumFrames(), 5u );
+}
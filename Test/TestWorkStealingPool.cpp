@@ -0,0 +1,142 @@
+//
+// Created: 10/18/26 by agent
+//
+// Test class for WorkStealingPool class
+//
+
+// In module includes
+#include "WorkStealingPool.h"
+
+// Thirdparty includes
+#include "gtest/gtest.h"
+
+// Std Lib includes
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+using namespace cupcake;
+
+TEST( WorkStealingPoolTest, test_every_job_runs_once )
+///
+/// Tests that every submitted job is run exactly once, by a valid worker, across several rounds
+/// of submitting and waiting on the same pool.
+///
+{
+    const size_t NUM_THREADS = 4;           // -> The number of workers in the pool.
+    const size_t NUM_JOBS = 1000;           // -> The number of jobs in each round.
+    const size_t NUM_ROUNDS = 20;           // -> The number of rounds run on the pool.
+
+    WorkStealingPool pool( NUM_THREADS );
+    ASSERT_EQ( pool.GetNumThreads(), NUM_THREADS );
+
+    for( size_t round=0; round<NUM_ROUNDS; ++round )
+    {
+        std::vector< std::atomic< size_t > > counts( NUM_JOBS );
+        for( auto& count : counts )
+        {
+            count = 0;
+        }
+        std::atomic< bool > workers_valid( true );
+
+        for( size_t job=0; job<NUM_JOBS; ++job )
+        {
+            pool.Submit( [&, job]( size_t worker )
+            {
+                counts[job]++;
+                if( worker >= NUM_THREADS )
+                {
+                    workers_valid = false;
+                }
+            });
+        }
+        pool.Wait();
+
+        ASSERT_TRUE( workers_valid );
+        for( auto& count : counts )
+        {
+            ASSERT_EQ( count, 1 );
+        }
+    }
+
+    // Waiting with nothing submitted returns immediately.
+    pool.Wait();
+}
+
+TEST( WorkStealingPoolTest, test_range_runs_each_task_once )
+///
+/// Tests that every task of a submitted range is run exactly once, by a valid worker, for ranges
+/// shorter than, equal to and longer than the number of workers, and that an empty range is
+/// accepted.
+///
+{
+    const size_t NUM_THREADS = 4;           // -> The number of workers in the pool.
+
+    WorkStealingPool pool( NUM_THREADS );
+    for( size_t num_tasks : { size_t( 0 ), size_t( 1 ), size_t( 3 ), NUM_THREADS, size_t( 1001 ) } )
+    {
+        std::vector< std::atomic< size_t > > counts( num_tasks );
+        for( auto& count : counts )
+        {
+            count = 0;
+        }
+        std::atomic< bool > workers_valid( true );
+
+        pool.SubmitRange( num_tasks, [&]( size_t task, size_t worker )
+        {
+            counts[task]++;
+            if( worker >= NUM_THREADS )
+            {
+                workers_valid = false;
+            }
+        });
+        pool.Wait();
+
+        ASSERT_TRUE( workers_valid );
+        for( auto& count : counts )
+        {
+            ASSERT_EQ( count, 1 );
+        }
+    }
+}
+
+TEST( WorkStealingPoolTest, test_nested_jobs_are_stolen )
+///
+/// Tests that jobs submitted from within a job are waited on, and that when a single job submits
+/// many slow jobs to its own worker, the other workers steal and run some of them.
+///
+{
+    const size_t NUM_THREADS = 4;           // -> The number of workers in the pool.
+    const size_t NUM_CHILDREN = 64;         // -> The number of jobs submitted by the first job.
+
+    WorkStealingPool pool( NUM_THREADS );
+    std::atomic< size_t > num_run( 0 );
+    std::vector< std::atomic< size_t > > runs_per_worker( NUM_THREADS );
+    for( auto& runs : runs_per_worker )
+    {
+        runs = 0;
+    }
+
+    pool.Submit( [&]( size_t )
+    {
+        for( size_t child=0; child<NUM_CHILDREN; ++child )
+        {
+            pool.Submit( [&]( size_t worker )
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                runs_per_worker[worker]++;
+                num_run++;
+            });
+        }
+    });
+    pool.Wait();
+
+    EXPECT_EQ( num_run, NUM_CHILDREN );
+    size_t num_workers_used = 0;
+    for( auto& runs : runs_per_worker )
+    {
+        num_workers_used += runs > 0 ? 1 : 0;
+    }
+    EXPECT_GT( num_workers_used, 1u );
+}
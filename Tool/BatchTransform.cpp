@@ -0,0 +1,377 @@
+//
+// Created: 10/18/26 by agent
+//
+// Command line tool transforming directories of WAV files into a frame store, using every core.
+//
+// Usage: BatchTransform [options] <output store> <WAV file or directory>...
+//
+// Each file becomes one clip of the store, named by its path. Files are memory-mapped and split
+// into blocks of frames, and the blocks of all files are transformed on a work-stealing pool, with
+// the STFT and CQT run directly on the mapped samples (or on the block's decoded samples, for
+// files that are not mono 32 bit float). Clips are written in the order the files were given.
+//
+
+// In module includes
+#include "FastWavelet.h"
+#include "STFTFrameAnalyser.h"
+#include "FastCQT.h"
+#include "FrameStore.h"
+#include "WavFile.h"
+#include "WorkStealingPool.h"
+
+// Thirdparty includes
+#include "sig_gen.h"
+
+// Std Lib includes
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace cupcake;
+
+namespace
+{
+
+struct Options
+///
+/// The settings given on the command line.
+///
+{
+    size_t fft_size = 4096;
+    size_t window_length = 0;           // Zero for the FFT size.
+    float overlap = 0.75f;
+    size_t num_threads = 0;             // Zero for one per core.
+    size_t frames_per_task = 64;
+    size_t max_memory = 1024;           // Megabytes of frames held before being written.
+    std::string output;
+    std::vector< std::string > inputs;
+};
+
+void print_usage( const char* program )
+{
+    std::fprintf( stderr,
+                  "Usage: %s [options] <output store> <WAV file or directory>...\n"
+                  "\n"
+                  "Transforms every WAV file given, or found under the directories given, appending\n"
+                  "one clip per file to a frame store. Multichannel files are mixed down to mono.\n"
+                  "\n"
+                  "Options:\n"
+                  "  --fft-size N          FFT size, a power of two from 256 to 16384 (default 4096)\n"
+                  "  --window-length N     Analysis window length, at most the FFT size (default FFT size)\n"
+                  "  --overlap X           Overlap of successive windows, in [0, 1) (default 0.75)\n"
+                  "  --threads N           Worker threads (default one per core)\n"
+                  "  --frames-per-task N   Frames transformed by each job (default 64)\n"
+                  "  --max-memory MB       Frames held in memory before being written (default 1024)\n",
+                  program );
+}
+
+bool parse_options( int argc, char** argv, Options& options )
+///
+/// Reads the command line.
+///
+/// @return
+///  Whether the command line was valid.
+///
+{
+    std::vector< std::string > positional;
+    for( int arg=1; arg<argc; ++arg )
+    {
+        const std::string name( argv[arg] );
+        if( name.compare( 0, 2, "--" ) != 0 )
+        {
+            positional.push_back( name );
+            continue;
+        }
+        if( arg + 1 >= argc )
+        {
+            return false;
+        }
+
+        const char* value = argv[++arg];
+        if( name == "--fft-size" ) options.fft_size = std::strtoul( value, nullptr, 10 );
+        else if( name == "--window-length" ) options.window_length = std::strtoul( value, nullptr, 10 );
+        else if( name == "--overlap" ) options.overlap = std::strtof( value, nullptr );
+        else if( name == "--threads" ) options.num_threads = std::strtoul( value, nullptr, 10 );
+        else if( name == "--frames-per-task" ) options.frames_per_task = std::strtoul( value, nullptr, 10 );
+        else if( name == "--max-memory" ) options.max_memory = std::strtoul( value, nullptr, 10 );
+        else return false;
+    }
+
+    if( positional.size() < 2 || options.frames_per_task == 0 || options.overlap < 0.0f || options.overlap >= 1.0f )
+    {
+        return false;
+    }
+    options.output = positional[0];
+    options.inputs.assign( positional.begin() + 1, positional.end() );
+    if( options.window_length == 0 )
+    {
+        options.window_length = options.fft_size;
+    }
+    return options.window_length <= options.fft_size;
+}
+
+bool is_wav_file( const std::string& name )
+{
+    if( name.size() < 4 )
+    {
+        return false;
+    }
+    std::string extension = name.substr( name.size() - 4 );
+    std::transform( extension.begin(), extension.end(), extension.begin(), ::tolower );
+    return extension == ".wav";
+}
+
+void find_wav_files( const std::string& path, std::vector< std::string >& files )
+///
+/// Adds a path to the list of files, or if it is a directory, every WAV file beneath it in sorted order.
+///
+{
+    struct stat info;
+    if( stat( path.c_str(), &info ) != 0 || !S_ISDIR( info.st_mode ) )
+    {
+        files.push_back( path );
+        return;
+    }
+
+    std::vector< std::string > entries;
+    if( DIR* dir = opendir( path.c_str() ) )
+    {
+        while( struct dirent* item = readdir( dir ) )
+        {
+            const std::string name( item->d_name );
+            if( name != "." && name != ".." )
+            {
+                entries.push_back( path + "/" + name );
+            }
+        }
+        closedir( dir );
+    }
+    std::sort( entries.begin(), entries.end() );
+
+    for( const std::string& entry : entries )
+    {
+        if( stat( entry.c_str(), &info ) == 0 && S_ISDIR( info.st_mode ) )
+        {
+            find_wav_files( entry, files );
+        }
+        else if( is_wav_file( entry ) )
+        {
+            files.push_back( entry );
+        }
+    }
+}
+
+template< size_t FFT_SIZE >
+struct FileJob
+///
+/// A file being transformed: its mapping, and its frames as they are filled in by the pool.
+///
+{
+    typedef typename STFTFrameAnalyser< FFT_SIZE >::Frame Frame;
+
+    std::string name;
+    std::unique_ptr< WavFile > wav;
+    std::vector< Frame > frames;
+    std::atomic< size_t > remaining_tasks;
+};
+
+template< size_t FFT_SIZE >
+int run( const Options& options, const std::vector< std::string >& files )
+///
+/// Transforms the files with a given FFT size.
+///
+/// @return
+///  The exit status of the program.
+///
+{
+    typedef FileJob< FFT_SIZE > job_type;
+    typedef typename job_type::Frame frame_type;
+
+    std::vector< float > window( options.window_length );
+    veclib::hamming( window );
+    const size_t increment = std::max< size_t >( static_cast< size_t >( ( 1 - options.overlap )*window.size() ), 1 );
+    const size_t max_bytes = options.max_memory << 20;
+
+    FrameStoreWriter store( options.output, FFT_SIZE, increment, window );
+    FastCQT< FFT_SIZE > cqt( window.size() );
+    std::mutex done_mutex;
+    std::condition_variable done_condition;
+    std::deque< std::unique_ptr< job_type > > in_flight;
+    std::vector< std::unique_ptr< STFTFrameAnalyser< FFT_SIZE > > > analysers;
+    std::vector< std::vector< float > > scratch;
+
+    // The pool is destroyed first, finishing any jobs still using the state above.
+    WorkStealingPool pool( options.num_threads );
+    scratch.resize( pool.GetNumThreads() );
+    for( size_t worker=0; worker<pool.GetNumThreads(); ++worker )
+    {
+        analysers.emplace_back( new STFTFrameAnalyser< FFT_SIZE >( window ) );
+    }
+
+    size_t bytes_in_flight = 0;
+    size_t num_failed = 0;
+    double total_seconds = 0.0;
+    size_t total_frames = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Waits for the oldest file to be transformed, then writes it to the store.
+    const auto write_oldest = [&]()
+    {
+        job_type& job = *in_flight.front();
+        {
+            std::unique_lock< std::mutex > lock( done_mutex );
+            done_condition.wait( lock, [&job](){ return job.remaining_tasks.load() == 0; } );
+        }
+
+        store.BeginClip( job.name );
+        store.WriteFrames( reinterpret_cast< const std::complex< float >* >( job.frames.data() ), job.frames.size() );
+        store.EndClip();
+
+        const double seconds = static_cast< double >( job.wav->GetNumFrames() )/job.wav->GetSampleRate();
+        std::printf( "%s: %.1f s, %zu frames\n", job.name.c_str(), seconds, job.frames.size() );
+        total_seconds += seconds;
+        total_frames += job.frames.size();
+        bytes_in_flight -= job.frames.size()*sizeof( frame_type );
+        in_flight.pop_front();
+    };
+
+    for( const std::string& file : files )
+    {
+        std::unique_ptr< job_type > job( new job_type() );
+        job->name = file;
+        try
+        {
+            job->wav.reset( new WavFile( file ) );
+        }
+        catch( const std::runtime_error& error )
+        {
+            std::fprintf( stderr, "Skipping %s\n", error.what() );
+            ++num_failed;
+            continue;
+        }
+
+        // Hold back until there is room for this file's frames.
+        const size_t num_frames = STFTFrameAnalyser< FFT_SIZE >::GetNumFrames( job->wav->GetNumFrames(), window.size(), increment );
+        const size_t bytes = num_frames*sizeof( frame_type );
+        while( !in_flight.empty() && bytes_in_flight + bytes > max_bytes )
+        {
+            write_oldest();
+        }
+        job->frames.resize( num_frames );
+        bytes_in_flight += bytes;
+
+        const size_t num_tasks = ( num_frames + options.frames_per_task - 1 )/options.frames_per_task;
+        job->remaining_tasks = num_tasks;
+        job_type* job_pointer = job.get();
+        in_flight.push_back( std::move( job ) );
+
+        for( size_t task=0; task<num_tasks; ++task )
+        {
+            const size_t first_frame = task*options.frames_per_task;
+            const size_t task_frames = std::min( options.frames_per_task, num_frames - first_frame );
+            pool.Submit( [&, job_pointer, first_frame, task_frames]( size_t worker )
+            {
+                const WavFile& wav = *job_pointer->wav;
+                const size_t first_sample = first_frame*increment;
+                const float* samples = wav.GetFloatSamples();
+                if( samples )
+                {
+                    samples += first_sample;
+                }
+                else
+                {
+                    // Decode just the samples this block needs.
+                    std::vector< float >& buffer = scratch[worker];
+                    buffer.resize( ( task_frames - 1 )*increment + window.size() );
+                    wav.ReadMono( first_sample, buffer.size(), buffer.data() );
+                    samples = buffer.data();
+                }
+
+                frame_type* output = job_pointer->frames.data() + first_frame;
+                analysers[worker]->AnalyseFrames( samples, task_frames, increment, output );
+                cqt.ApplyInPlace( output, task_frames );
+
+                if( --job_pointer->remaining_tasks == 0 )
+                {
+                    std::lock_guard< std::mutex > lock( done_mutex );
+                    done_condition.notify_all();
+                }
+            });
+        }
+    }
+
+    while( !in_flight.empty() )
+    {
+        write_oldest();
+    }
+    store.Flush();
+
+    const double elapsed = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+    const double megabytes = total_frames*sizeof( frame_type )/1048576.0;
+    std::printf( "\n%zu files (%zu skipped), %.1f s of audio, %zu frames in %.2f s on %zu threads\n",
+                 files.size() - num_failed, num_failed, total_seconds, total_frames, elapsed, pool.GetNumThreads() );
+    std::printf( "%.1fx real time, %.0f frames/s, %.1f MB/s written\n",
+                 total_seconds/elapsed, total_frames/elapsed, megabytes/elapsed );
+    return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+template< size_t... FFT_SIZES >
+int run( const Options& options, const std::vector< std::string >& files, std::index_sequence< FFT_SIZES... > )
+///
+/// Runs the transform specialised for the FFT size chosen.
+///
+{
+    typedef int (*run_type)( const Options&, const std::vector< std::string >& );
+    const size_t sizes[] = { FFT_SIZES... };
+    const run_type runs[] = { &run< FFT_SIZES >... };
+    for( size_t size=0; size<sizeof...( FFT_SIZES ); ++size )
+    {
+        if( sizes[size] == options.fft_size )
+        {
+            return runs[size]( options, files );
+        }
+    }
+
+    std::fprintf( stderr, "Unsupported FFT size: %zu\n", options.fft_size );
+    return EXIT_FAILURE;
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+    Options options;
+    if( !parse_options( argc, argv, options ) )
+    {
+        print_usage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    std::vector< std::string > files;
+    for( const std::string& input : options.inputs )
+    {
+        find_wav_files( input, files );
+    }
+
+    try
+    {
+        return run( options, files, FastWaveletFFTSizes() );
+    }
+    catch( const std::exception& error )
+    {
+        std::fprintf( stderr, "%s\n", error.what() );
+        return EXIT_FAILURE;
+    }
+}
@@ -6,6 +6,7 @@
 #
 # Dependencies covered here:
 #   - GTest
+#   - Google Benchmark
 #   - GYP
 #
 
@@ -64,6 +65,37 @@ pushd "${ROOT_DIR}"
 
     popd
 
+    ###################################################
+    #                GOOGLE BENCHMARK                 #
+    ###################################################
+
+    echo " "
+    echo "Installing Google Benchmark..."
+    echo " "
+
+    BENCHMARK_BUILD_DIR="${THIRDPARTY_DIR}/benchmark/"
+    mkdir -p "${BENCHMARK_BUILD_DIR}"
+    pushd "${BENCHMARK_BUILD_DIR}"
+
+        BENCHMARK_LIB_DIR="./benchmark"
+
+        if [ ! -e "${BENCHMARK_LIB_DIR}/README.md" ]; then
+            git clone --branch v1.7.1 https://github.com/google/benchmark.git ${BENCHMARK_LIB_DIR}
+        fi
+
+        if [ ! -e ${LIB_DIR}/libbenchmark.a ]; then
+            pushd "${BENCHMARK_LIB_DIR}"
+                cmake -DCMAKE_BUILD_TYPE=Release -DBENCHMARK_ENABLE_TESTING=OFF -DBENCHMARK_ENABLE_GTEST_TESTS=OFF .
+                make benchmark benchmark_main
+            popd
+
+            cp "${BENCHMARK_LIB_DIR}"/src/libbenchmark.a "${LIB_DIR}"/libbenchmark.a
+            cp "${BENCHMARK_LIB_DIR}"/src/libbenchmark_main.a "${LIB_DIR}"/libbenchmark_main.a
+            cp -r "${BENCHMARK_LIB_DIR}"/include/ "${INCLUDE_DIR}"
+        fi
+
+    popd
+
     ###################################################
     #                      GYP                        #
     ###################################################
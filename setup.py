@@ -10,6 +10,13 @@ root_dir = os.path.dirname(os.path.realpath(__file__))
 
 sources = [os.path.join( 'src', 'FastWavelet.cpp' ),
            os.path.join( 'src', 'FastWaveletPythonBinding.cpp' ),
+           os.path.join( 'src', 'ThreadPool.cpp' ),
+           os.path.join( 'src', 'WorkStealingPool.cpp' ),
+           os.path.join( 'src', 'Kernels.cpp' ),
+           os.path.join( 'src', 'Arena.cpp' ),
+           os.path.join( 'src', 'FrameStore.cpp' ),
+           os.path.join( 'src', 'TransformCache.cpp' ),
+           os.path.join( 'src', 'HalfBandDecimator.cpp' ),
            os.path.join( 'VecLib', 'src', 'FFT.cpp' ),
            os.path.join( 'VecLib', 'src', 'sig_gen.cpp' ),
            os.path.join( 'VecLib', 'src', 'vector_functions.cpp' )]
@@ -25,6 +32,12 @@ libraries = [os.path.join( root_dir, 'VecLib', 'thirdparty', 'lib', 'libippcore.
 
 library_dirs = [os.path.join( root_dir, 'VecLib', 'thirdparty', 'lib', '' )]
 
+# Per-stage timing and counters (FastWavelet.GetStats) are compiled in when the environment
+# variable CUPCAKE_ENABLE_STATS=1 is set at build time.
+define_macros = []
+if os.environ.get( 'CUPCAKE_ENABLE_STATS', '0' ) == '1':
+    define_macros.append( ( 'CUPCAKE_ENABLE_STATS', '1' ) )
+
 extra_compile_args = ['-std=c++14',
                       '-Wno-deprecated-register',
                       '-Wno-deprecated-declarations', 
@@ -50,6 +63,7 @@ FastWavelet = Extension( 'FastWavelet',
                          libraries = libraries,
                          library_dirs = library_dirs,
                          sources = sources,
+                         define_macros = define_macros,
                          extra_compile_args = extra_compile_args,
                          extra_link_args = extra_link_args )
 
@@ -65,21 +79,89 @@ setup ( name = 'FastWavelet',
 
             Methods:
 
-                FastWavelet( window )
+                FastWavelet( overlap, window, fft_size=4096 )
+                    Arg overlap:
+                        The fraction of the window length that successive STFT frames overlap.
                     Arg window:
                         A 1D numpy array containing the windowing function used for STFT
                         analysis.
+                    Arg fft_size:
+                        The FFT size of the STFT, which must be no smaller than the window.
+                        One of 256, 512, 1024, 2048, 4096, 8192 or 16384, each of which is
+                        compiled separately, so smaller windows may use a smaller (and much
+                        cheaper) FFT at full speed.
                     Return:
                         An object used to compute the Fast Wavelet transform here
 
+                Threading:
+                    The transform is computed with the GIL released, so several FastWavelet
+                    objects can be driven concurrently from a pool of python threads. Calls
+                    on a single FastWavelet object from several threads are serialized, as
+                    each object holds streaming state. Input arrays must not be modified by
+                    another thread while a call that reads them is in progress.
+
                 FastWavelet.PushSamples( samples )
                     Arg samples:
                         A 1D numpy array containing audio samples for which to take the
-                        Fast Wavelet transform.
+                        Fast Wavelet transform. Contiguous float32 arrays are read in place,
+                        any other array is converted with a single cast and copy.
                     Return:
                         A 2D complex numpy array containing the output of the Fast Wavelet
                         transform of all input samples (plus any internally buffered state).
 
+                FastWavelet.ConfigureParallel( num_threads=0 )
+                    Sets the number of threads used by PushSamplesParallel, or one per core
+                    for zero. Without this, PushSamplesParallel uses one thread per core.
+
+                FastWavelet.PushSamplesParallel( samples )
+                    As PushSamples, but with the frames spread over a pool of threads, for
+                    transforming long recordings in a single call. The output is identical to
+                    that of PushSamples, and the two share one stream of samples.
+
+                FastWavelet.TransformBatch( clips, lengths=None )
+                    Arg clips:
+                        A 2D numpy array with one audio clip per row. Each clip is transformed
+                        as though it were pushed through its own newly created FastWavelet
+                        object, across a pool of threads. This does not affect the samples
+                        buffered by PushSamples.
+                    Arg lengths:
+                        An optional 1D integer array holding the number of valid samples in
+                        each row of clips. By default every row is used in full.
+                    Return:
+                        A 3D complex numpy array of shape (clips, frames, bins). The number of
+                        frames is that of a clip the full width of the clips array, and frames
+                        beyond the end of a shorter clip are zero.
+
+                FastWavelet.GetFFTSize()
+                    Return:
+                        The FFT size chosen at construction, which sets the number of
+                        frequency bins in each output frame.
+
+                FastWavelet.GetAlgorithmicLatency()
+                    Return:
+                        The delay in samples from the first sample of a frame being pushed to
+                        the frame being output, i.e., the window length less one. Pushing in
+                        chunks adds up to a chunk more. This applies to every PushSamples method
+                        but PushSamplesOctaves, including PushSamplesDecimated.
+
+                FastWavelet.GetBufferedSamples()
+                    Return:
+                        The number of samples pushed that are still buffered, awaiting future
+                        frames, by every PushSamples method but PushSamplesOctaves.
+
+                FastWavelet.GetStats()
+                    Return:
+                        A dictionary of statistics recorded by PushSamples since construction or
+                        the last ResetStats: calls, total_cycles, and the time spent in each stage
+                        (buffer_cycles, window_cycles, fft_cycles, cqt_cycles), along with frames
+                        produced, bytes_moved, and the buffer_occupancy (samples waiting in the input
+                        buffer) after the last call and its maximum. Times are in the unit given by
+                        counter_unit. Statistics are only recorded when the module is built with
+                        CUPCAKE_ENABLE_STATS=1, as given by enabled, otherwise they are all zero.
+
+                FastWavelet.ResetStats()
+                    Sets all statistics back to zero.
+
                 FastWavelet.GetWindow()
                     Return:
                         A 1D numpy array containing the windowing function used for STFT analysis.
@@ -89,5 +171,96 @@ setup ( name = 'FastWavelet',
                         A 1D complex numpy array containing the IIR filter coefficients used for 
                         smoothing across frequency to allow adaptive windowing length.
 
+                FastWavelet.ConfigureOctaves( num_octaves )
+                    Sets up a separate multi-resolution stream, in which each of the num_octaves - 1
+                    octaves below the top octave is decimated to half the sample rate of the one
+                    above and analysed with the same window, FFT size and overlap.
+
+                FastWavelet.PushSamplesOctaves( samples )
+                    Return:
+                        A 2D complex numpy array of shape (frames, bins), with one frame per hop
+                        of the top octave, stitched from every octave from low to high frequency.
+
+                FastWavelet.GetOctaveFrequencies( sample_rate )
+                    Return:
+                        A 1D numpy array of the frequency in Hz of each bin of PushSamplesOctaves.
+
+                FastWavelet.GetOctaveLatency()
+                    Return:
+                        The delay in samples of PushSamplesOctaves, i.e., that of its lowest
+                        octave, whose window is longest and follows every decimator.
+
+                FastWavelet.GetOctaveBufferedSamples()
+                    Return:
+                        The number of samples pushed to PushSamplesOctaves that are still
+                        buffered, awaiting future frames.
+
+                FastWavelet.ConfigureExact( sample_rate, min_frequency, bins_per_octave=12, num_bins=0, threshold=0.0054 )
+                    Sets up an exact constant-Q transform of the STFT frames, by a sparse spectral
+                    kernel, as an alternative to the fast approximation of PushSamples. Bins are
+                    spaced geometrically from min_frequency, whose temporal kernel must fit within
+                    the window. By default there are as many bins as fit below the Nyquist frequency.
+                    Kernel values below threshold times the peak of their kernel are dropped.
+
+                FastWavelet.PushSamplesExact( samples )
+                    Return:
+                        A 2D complex numpy array of shape (frames, bins). This shares its STFT, and
+                        so its stream of samples, with PushSamples.
+
+                FastWavelet.GetExactFrequencies()
+                    Return:
+                        A 1D numpy array of the frequency in Hz of each bin of PushSamplesExact.
+
+                FastWavelet.ConfigureDecimation( min_hops_per_window=4 )
+                    Sets up the multi-rate output of PushSamplesDecimated. Bins are grouped into
+                    bands, and each band keeps one frame in every 2^k, such that at least
+                    min_hops_per_window frames remain within the effective window length of each
+                    bin in the fast CQT.
+
+                FastWavelet.PushSamplesDecimated( samples )
+                    As PushSamples, but returns a list with a dictionary for each band, from low to
+                    high frequency, holding its first_bin, its decimation, the index of its first
+                    frame in frames of that band (first_frame), and a 2D complex numpy array of its
+                    frames, of shape (frames, bins).
+
+                FastWavelet.ConfigureBinRange( min_bin, max_bin, tolerance=1e-4, method='auto' )
+                    Sets up PushSamplesBinRange to compute only the FFT bins min_bin to max_bin
+                    inclusive. The CQT sweeps are limited to the range plus enough guard bins
+                    either side for their error to fall below tolerance, relative to the
+                    spectrum at the edges of the sweep, and zero gives exactly the bins of
+                    PushSamples. The method is 'fft' for a full FFT, 'dft' for a DFT of only
+                    the swept bins, or 'auto' for whichever is expected to be cheaper.
+
+                FastWavelet.PushSamplesBinRange( samples )
+                    As PushSamples, but returns a 2D complex numpy array of shape (frames, bins)
+                    holding only the bins of the range. The two share one stream of samples.
+
+                FastWavelet.PushSamplesToStore( audio, store )
+                    As PushSamples, but appends the output frames to the clip open in a
+                    FrameStoreWriter, rather than returning them. Returns the number of frames.
+
+                FrameStoreWriter( path, fft_size, hop, window )
+                    Opens an append-only file of frames, creating it if it does not exist.
+                    An existing file must have been written with the same transform. Frames
+                    are grouped into named clips with BeginClip( name ), WriteFrames( frames )
+                    and EndClip(). Clips left unfinished are ignored by readers.
+
+                FrameStoreReader( path )
+                    Maps a frame store written by FrameStoreWriter. Clips are found by index
+                    or with FindClip( name ), and GetFrames( clip, start=0, stop=None ) returns
+                    a 2D complex numpy array of shape (frames, bins) that views the file
+                    directly, without copying.
+
+                TransformCache( directory, max_bytes )
+                    A cache of transforms on disk, keyed by a hash of the samples and the
+                    transform configuration. The least recently used transforms are deleted
+                    once the directory holds more than max_bytes.
+
+                FastWavelet.TransformCached( audio, cache )
+                    Transforms a whole clip, as though it were pushed through a newly created
+                    FastWavelet object, through a TransformCache. Clips already in the cache
+                    are mapped from disk rather than computed. Returns a read-only 2D complex
+                    numpy array viewing the cached frames.
+
         ''',
         ext_modules = [FastWavelet] )
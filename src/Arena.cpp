@@ -0,0 +1,283 @@
+//
+// Created: 10/18/26 by agent
+//
+// Region based memory for laying out the buffers of many objects together.
+//
+
+// In module includes
+#include "Arena.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define CUPCAKE_ARENA_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using namespace cupcake;
+
+namespace
+{
+
+// The size of a huge page on x86-64 and most aarch64 systems. Mappings requesting huge pages are
+// rounded up to a multiple of this.
+const size_t HUGE_PAGE_SIZE = 2*1024*1024;
+
+size_t round_up( size_t value, size_t multiple )
+{
+    return ( ( value + multiple - 1 )/multiple )*multiple;
+}
+
+} // namespace
+
+void* cupcake::aligned_allocate( size_t num_bytes, size_t alignment )
+///
+/// Allocates memory from the heap at the given alignment.
+///
+/// @param num_bytes
+///  The size of the allocation.
+///
+/// @param alignment
+///  The alignment in bytes, which must be a power of two and a multiple of sizeof( void* ).
+///
+/// @return
+///  The allocated memory, to be released with aligned_free. Throws std::bad_alloc on failure.
+///
+{
+    void* ptr = nullptr;
+#ifdef _WIN32
+    ptr = _aligned_malloc( num_bytes > 0 ? num_bytes : 1, alignment );
+#else
+    if( posix_memalign( &ptr, alignment, num_bytes > 0 ? num_bytes : 1 ) != 0 )
+    {
+        ptr = nullptr;
+    }
+#endif
+    if( !ptr )
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void cupcake::aligned_free( void* ptr )
+///
+/// Releases memory allocated with aligned_allocate.
+///
+/// @param ptr
+///  The memory to release, or null.
+///
+{
+#ifdef _WIN32
+    _aligned_free( ptr );
+#else
+    free( ptr );
+#endif
+}
+
+Arena::Arena( size_t block_size, bool huge_pages ) :
+    mBlockSize( block_size > 0 ? block_size : CACHE_LINE_SIZE ),
+    mRequestHugePages( huge_pages ),
+    mBytesAllocated( 0 ),
+    mUsesHugePages( false )
+///
+/// Constructor. Maps the first block of memory.
+///
+/// @param block_size
+///  The size in bytes of each block of memory mapped by the arena. Ideally this is large enough
+///  for everything that will be allocated from the arena, so that it is all laid out in one block.
+///
+/// @param huge_pages
+///  Whether to back the arena with huge pages. If the system has none available, the arena falls
+///  back to normal pages, advising the kernel that it may use transparent huge pages for them.
+///
+{
+    AddBlock( mBlockSize );
+}
+
+Arena::~Arena()
+///
+/// Destructor. Releases all blocks.
+///
+{
+    for( auto& block : mBlocks )
+    {
+#ifdef CUPCAKE_ARENA_MMAP
+        if( block.mapped )
+        {
+            munmap( block.data, block.size );
+            continue;
+        }
+#endif
+        aligned_free( block.data );
+    }
+}
+
+void* Arena::Allocate( size_t num_bytes, size_t alignment )
+///
+/// Takes memory from the arena.
+///
+/// @param num_bytes
+///  The size of the allocation.
+///
+/// @param alignment
+///  The alignment in bytes, which must be a power of two no larger than a page.
+///
+/// @return
+///  The allocated memory, which remains valid until the arena is destroyed. Throws std::bad_alloc
+///  if no more memory can be mapped.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+
+    Block* block = &mBlocks.back();
+    uintptr_t address = round_up( reinterpret_cast< uintptr_t >( block->data ) + block->used, alignment );
+    if( address + num_bytes > reinterpret_cast< uintptr_t >( block->data ) + block->size )
+    {
+        AddBlock( num_bytes + alignment );
+        block = &mBlocks.back();
+        address = round_up( reinterpret_cast< uintptr_t >( block->data ), alignment );
+    }
+
+    block->used = address + num_bytes - reinterpret_cast< uintptr_t >( block->data );
+    mBytesAllocated += num_bytes;
+    return reinterpret_cast< void* >( address );
+}
+
+void Arena::Deallocate( void* ptr, size_t num_bytes )
+///
+/// Returns memory to the arena. Only the most recent allocation is actually reused, so that a
+/// container that grows straight after being allocated does not waste the space it grew out of.
+/// All other memory is released with the arena.
+///
+/// @param ptr
+///  The memory returned by Allocate.
+///
+/// @param num_bytes
+///  The size of the allocation.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+
+    Block& block = mBlocks.back();
+    if( static_cast< char* >( ptr ) + num_bytes == block.data + block.used )
+    {
+        block.used -= num_bytes;
+    }
+    mBytesAllocated -= num_bytes;
+}
+
+const size_t Arena::GetBytesAllocated() const
+///
+/// Get the number of bytes currently allocated from the arena, not counting alignment padding.
+///
+/// @return
+///  The bytes in use.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mBytesAllocated;
+}
+
+const size_t Arena::GetBytesReserved() const
+///
+/// Get the total size of the memory mapped by the arena.
+///
+/// @return
+///  The size of all blocks in bytes.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    size_t total = 0;
+    for( auto& block : mBlocks )
+    {
+        total += block.size;
+    }
+    return total;
+}
+
+const size_t Arena::GetNumBlocks() const
+///
+/// Get the number of separate blocks the arena has mapped. This is one unless an allocation
+/// did not fit in the first block.
+///
+/// @return
+///  The number of blocks.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mBlocks.size();
+}
+
+const bool Arena::UsesHugePages() const
+///
+/// Get whether the arena's first block is explicitly backed by huge pages. This is false if they
+/// were not requested or none were available, in which case transparent huge pages may still apply.
+///
+/// @return
+///  Whether huge pages are in use.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mUsesHugePages;
+}
+
+void Arena::AddBlock( size_t min_size )
+///
+/// Maps a further block of memory, at least the configured block size.
+///
+/// @param min_size
+///  The smallest block that will do.
+///
+{
+    Block block;
+    block.size = round_up( std::max( min_size, mBlockSize ), CACHE_LINE_SIZE );
+    block.used = 0;
+    block.data = nullptr;
+    block.mapped = false;
+
+#ifdef CUPCAKE_ARENA_MMAP
+#ifdef MAP_HUGETLB
+    if( mRequestHugePages )
+    {
+        const size_t huge_size = round_up( block.size, HUGE_PAGE_SIZE );
+        void* data = mmap( nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+        if( data != MAP_FAILED )
+        {
+            block.data = static_cast< char* >( data );
+            block.size = huge_size;
+            block.mapped = true;
+            mUsesHugePages = mBlocks.empty() ? true : mUsesHugePages;
+        }
+    }
+#endif
+    if( !block.data )
+    {
+        void* data = mmap( nullptr, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if( data == MAP_FAILED )
+        {
+            throw std::bad_alloc();
+        }
+        block.data = static_cast< char* >( data );
+        block.mapped = true;
+#ifdef MADV_HUGEPAGE
+        if( mRequestHugePages )
+        {
+            madvise( data, block.size, MADV_HUGEPAGE );
+        }
+#endif
+    }
+#else
+    block.data = static_cast< char* >( aligned_allocate( block.size, CACHE_LINE_SIZE ) );
+#endif
+
+    mBlocks.push_back( block );
+}
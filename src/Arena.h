@@ -0,0 +1,181 @@
+//
+// Created: 10/18/26 by agent
+//
+// Region based memory for laying out the buffers of many objects together.
+//
+
+#ifndef CUPCAKE_ARENA_H
+#define CUPCAKE_ARENA_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <cstddef>
+
+namespace cupcake
+{
+
+class Arena
+///
+/// A large block of memory from which buffers are handed out in order, each aligned to a cache
+/// line, and which is only released when the arena is destroyed.
+///
+/// Sharing one arena between the buffers of an object, or of many objects (e.g. a set of streams),
+/// lays them out together in a few large mappings rather than many separate heap allocations.
+/// This keeps the allocator out of the way when many analysers are created at once, and when huge
+/// pages are requested, lets the buffers be covered by far fewer TLB entries.
+///
+/// If an allocation does not fit in the remaining space, a further block of at least the same size
+/// is mapped, so an arena never runs out of memory before the system does.
+///
+/// Allocation is thread safe. The arena must outlive everything allocated from it, which
+/// ArenaAllocator ensures by holding a reference to it.
+///
+{
+
+public:
+
+    Arena( size_t block_size, bool huge_pages=false );
+    ~Arena();
+
+    Arena( const Arena& ) = delete;
+    Arena& operator=( const Arena& ) = delete;
+
+    void* Allocate( size_t num_bytes, size_t alignment=CACHE_LINE_SIZE );
+    void Deallocate( void* ptr, size_t num_bytes );
+
+    const size_t GetBytesAllocated() const;
+    const size_t GetBytesReserved() const;
+    const size_t GetNumBlocks() const;
+    const bool UsesHugePages() const;
+
+    static const size_t CACHE_LINE_SIZE = 64;
+
+private:
+
+    struct Block
+    ///
+    /// A single contiguous mapping.
+    ///
+    {
+        char* data;
+        size_t size;
+        size_t used;
+        bool mapped;        // Whether this was mapped with mmap, rather than allocated from the heap.
+    };
+
+    //
+    // Configuration
+    //
+    const size_t mBlockSize;
+    const bool mRequestHugePages;
+
+    //
+    // Data
+    //
+    std::vector< Block > mBlocks;
+    size_t mBytesAllocated;
+    bool mUsesHugePages;
+
+    //
+    // Thread safety
+    //
+    mutable std::mutex mMutex;
+
+    //
+    // Helpers
+    //
+    void AddBlock( size_t min_size );
+
+};
+
+void* aligned_allocate( size_t num_bytes, size_t alignment );
+void aligned_free( void* ptr );
+
+template< typename T >
+class ArenaAllocator
+///
+/// A standard library allocator that takes memory from an Arena. A default constructed allocator,
+/// with no arena, allocates cache line aligned memory from the heap instead, so containers using
+/// this allocator behave as usual unless an arena is given.
+///
+{
+
+public:
+
+    typedef T value_type;
+
+    ArenaAllocator() noexcept {};
+    ArenaAllocator( std::shared_ptr< Arena > arena ) noexcept : mArena( std::move( arena ) ) {};
+    template< typename U >
+    ArenaAllocator( const ArenaAllocator< U >& other ) noexcept : mArena( other.GetArena() ) {};
+
+    T* allocate( size_t n );
+    void deallocate( T* ptr, size_t n ) noexcept;
+
+    const std::shared_ptr< Arena >& GetArena() const noexcept { return mArena; };
+
+private:
+
+    //
+    // Mechanics
+    //
+    std::shared_ptr< Arena > mArena;
+
+};
+
+template< typename T >
+T* ArenaAllocator< T >::allocate( size_t n )
+///
+/// Allocates memory for n objects, aligned to a cache line.
+///
+{
+    const size_t alignment = alignof( T ) > Arena::CACHE_LINE_SIZE ? alignof( T ) : Arena::CACHE_LINE_SIZE;
+    void* ptr = mArena ? mArena->Allocate( n*sizeof( T ), alignment ) : aligned_allocate( n*sizeof( T ), alignment );
+    return static_cast< T* >( ptr );
+}
+
+template< typename T >
+void ArenaAllocator< T >::deallocate( T* ptr, size_t n ) noexcept
+///
+/// Returns memory for n objects. Memory taken from an arena is only reused if it was the most
+/// recent allocation, otherwise it is released with the arena.
+///
+{
+    if( mArena )
+    {
+        mArena->Deallocate( ptr, n*sizeof( T ) );
+    }
+    else
+    {
+        aligned_free( ptr );
+    }
+}
+
+template< typename T, typename U >
+bool operator==( const ArenaAllocator< T >& a, const ArenaAllocator< U >& b ) noexcept
+{
+    return a.GetArena() == b.GetArena();
+}
+
+template< typename T, typename U >
+bool operator!=( const ArenaAllocator< T >& a, const ArenaAllocator< U >& b ) noexcept
+{
+    return !( a == b );
+}
+
+// A std::vector whose memory may come from an arena.
+template< typename T >
+using ArenaVector = std::vector< T, ArenaAllocator< T > >;
+
+} // namespace cupcake
+
+#endif // CUPCAKE_ARENA_H
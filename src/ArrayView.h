@@ -0,0 +1,102 @@
+//
+// Created: 10/18/26 by agent
+//
+// Non-owning view of a contiguous block of elements.
+//
+
+#ifndef CUPCAKE_ARRAY_VIEW_H
+#define CUPCAKE_ARRAY_VIEW_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <cstddef>
+
+namespace cupcake
+{
+
+template< typename T >
+class ArrayView
+///
+/// A pointer and a length, describing memory that is owned elsewhere (e.g. by a std::vector
+/// or a numpy array). This lets samples be read in place rather than being copied into a
+/// vector first. The viewed memory must outlive the view.
+///
+{
+
+public:
+
+    ArrayView();
+    ArrayView( T* data, size_t size );
+    template< typename U >
+    ArrayView( const std::vector< U >& vector );
+
+    T* data() const { return mData; };
+    size_t size() const { return mSize; };
+    bool empty() const { return mSize == 0; };
+    T* begin() const { return mData; };
+    T* end() const { return mData + mSize; };
+    T& operator[]( size_t index ) const { return mData[index]; };
+
+private:
+
+    //
+    // Data
+    //
+    T* mData;
+    size_t mSize;
+
+};
+
+template< typename T >
+ArrayView< T >::ArrayView() :
+    mData( nullptr ),
+    mSize( 0 )
+///
+/// Default Constructor - creates an empty view.
+///
+{
+
+}
+
+template< typename T >
+ArrayView< T >::ArrayView( T* data, size_t size ) :
+    mData( data ),
+    mSize( size )
+///
+/// Constructor.
+///
+/// @param data
+///  A pointer to the first element in the view.
+///
+/// @param size
+///  The number of elements in the view.
+///
+{
+
+}
+
+template< typename T >
+template< typename U >
+ArrayView< T >::ArrayView( const std::vector< U >& vector ) :
+    mData( vector.data() ),
+    mSize( vector.size() )
+///
+/// Constructor for a view of all the elements in a vector. This is implicit so that vectors
+/// may be passed wherever a read-only view is expected.
+///
+/// @param vector
+///  The vector to be viewed.
+///
+{
+
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_ARRAY_VIEW_H
@@ -9,14 +9,16 @@
 #define CUPCAKE_AUDIO_BUFFER_H
 
 // In module includes
-// None.
+#include "Arena.h"
 
 // Thirdparty includes
 // None.
 
 // Std Lib includes
 #include <vector>
+#include <memory>
 #include <algorithm>
+#include <cstring>
 #include <assert.h>
 
 namespace cupcake
@@ -29,10 +31,11 @@ class AudioBuffer
 public:
 
 	AudioBuffer();
-	AudioBuffer( size_t size );
+	AudioBuffer( size_t size, std::shared_ptr< Arena > arena=nullptr );
 	~AudioBuffer();
 
 	void PushSamples( const std::vector< T >& samples );
+	void PushSamples( const T* samples, size_t num_samples );
 	void PopFront( size_t numElements );
 
 	const size_t NumSamples() const;
@@ -46,7 +49,7 @@ private:
 	//
 	// Data
 	//
-	std::vector< T > mData;
+	ArenaVector< T > mData;
 
 	//
 	// Configuration
@@ -79,8 +82,8 @@ AudioBuffer<T>::AudioBuffer() :
 }
 
 template< typename T >
-AudioBuffer<T>::AudioBuffer( size_t size ) :
-	mData( 2*(size+1) ),
+AudioBuffer<T>::AudioBuffer( size_t size, std::shared_ptr< Arena > arena ) :
+	mData( 2*(size+1), T(), ArenaAllocator< T >( std::move( arena ) ) ),
 	mBufferLength( size+1 ),
 	mReadHead( 0 ),
 	mWriteHead( 0 )
@@ -90,6 +93,9 @@ AudioBuffer<T>::AudioBuffer( size_t size ) :
 /// @param size
 ///  The maximum number of elements allowable in the buffer.
 ///
+/// @param arena
+///  An optional arena to allocate the buffer from. If null, the buffer is allocated from the heap.
+///
 {
     
 }
@@ -108,30 +114,46 @@ void AudioBuffer<T>::PushSamples( const std::vector< T >& samples )
 ///
 /// Copy samples into the AudioBuffer's memory. It is on the user of the class
 /// to ensure the buffer doesn't overflow.
+///
+/// @param samples
+///  A vector of samples to be added to the AudioBuffer.
+///
+{
+    PushSamples( samples.data(), samples.size() );
+}
+
+template< typename T >
+void AudioBuffer<T>::PushSamples( const T* samples, size_t num_samples )
+///
+/// Copy samples into the AudioBuffer's memory. It is on the user of the class
+/// to ensure the buffer doesn't overflow.
 /// This copies the samples twice so that when reading from the buffer
 /// overlaps the end of the circular buffer, we can still get a contiguous
 /// block of memory with as many of the buffer samples as we like, without
 /// having to rearrange the memory.
 ///
 /// @param samples
-///  A vector of samples to be added to the AudioBuffer.
+///  A pointer to the first of the samples to be added to the AudioBuffer.
+///
+/// @param num_samples
+///  The number of samples to be added to the AudioBuffer.
 ///
 {
 
-    assert( samples.size() <= SpaceRemaining() ); // Buffer overflow if this condition is false.
+    assert( num_samples <= SpaceRemaining() ); // Buffer overflow if this condition is false.
 
     size_t samples_until_end = mBufferLength - mWriteHead;
 
-	memcpy( mData.data() + mWriteHead, samples.data(), std::min( samples.size(), samples_until_end )*sizeof( T ) );
-	memcpy( mData.data() + mWriteHead + mBufferLength, samples.data(), std::min( samples.size(), samples_until_end )*sizeof( T ) );
+	memcpy( mData.data() + mWriteHead, samples, std::min( num_samples, samples_until_end )*sizeof( T ) );
+	memcpy( mData.data() + mWriteHead + mBufferLength, samples, std::min( num_samples, samples_until_end )*sizeof( T ) );
 
-	if( samples.size() > samples_until_end )
+	if( num_samples > samples_until_end )
 	{
-		memcpy( mData.data(), samples.data() + samples_until_end, ( samples.size() - samples_until_end )*sizeof( T ) );
-		memcpy( mData.data() + mBufferLength, samples.data() + samples_until_end, ( samples.size() - samples_until_end )*sizeof( T ) );
+		memcpy( mData.data(), samples + samples_until_end, ( num_samples - samples_until_end )*sizeof( T ) );
+		memcpy( mData.data() + mBufferLength, samples + samples_until_end, ( num_samples - samples_until_end )*sizeof( T ) );
 	}
 
-	mWriteHead = ( mWriteHead + samples.size() ) % mBufferLength;
+	mWriteHead = ( mWriteHead + num_samples ) % mBufferLength;
 
 }
 
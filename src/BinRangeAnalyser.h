@@ -0,0 +1,440 @@
+//
+// Created: 10/18/26 by agent
+//
+// Fast wavelet analysis of contiguous samples, limited to a range of frequency bins.
+//
+
+#ifndef CUPCAKE_BIN_RANGE_ANALYSER_H
+#define CUPCAKE_BIN_RANGE_ANALYSER_H
+
+// In module includes
+#include "STFTFrameAnalyser.h"
+#include "FastCQT.h"
+#include "Arena.h"
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+namespace cupcake
+{
+
+enum BinRangeMethod : int
+{
+    BIN_RANGE_AUTOMATIC,        // Whichever of the below is expected to be cheaper.
+    BIN_RANGE_FFT,              // A full FFT, of which only the range is kept.
+    BIN_RANGE_PRUNED_DFT        // A DFT of only the bins in the range.
+};
+
+struct BinRangeFrames
+///
+/// The output frames of one call to BinRangeAnalyser.
+///
+{
+    size_t first_bin = 0;
+    size_t num_bins = 0;
+    size_t num_frames = 0;
+    std::vector< std::complex< float > > values;    // num_frames x num_bins, from first_bin up.
+};
+
+template< size_t FFT_SIZE >
+class BinRangeAnalyser
+///
+/// Computes the bins [min_bin, max_bin] of the frames of FastWavelet::PushSamples, and only those
+/// bins, for models that only use part of the spectrum.
+///
+/// The IIR sweeps of FastCQT run across the whole spectrum, so a sweep limited to the range starts
+/// from the wrong state at each edge. That error decays by the magnitude of the filter coefficient
+/// of each bin it passes, so the sweeps are run over the range widened by guard bins, as given by
+/// FastCQT::GetSweepRange, until it is below tolerance times the spectrum at the edges. Low bins are
+/// smoothed lightly and need few guard bins, while high bins need many. A tolerance of zero widens
+/// the sweep to the whole spectrum, and so gives exactly the bins of PushSamples.
+///
+/// The swept bins may be computed in one of two ways. With BIN_RANGE_FFT, each frame is windowed and
+/// transformed in full, as by STFTAnalysis, and the swept bins are kept. With BIN_RANGE_PRUNED_DFT,
+/// only the swept bins are computed, by a product with a precomputed kernel of the window times the
+/// DFT, which costs window length times swept bins per frame. This is only cheaper than an FFT for
+/// a handful of swept bins, more than which are usually needed as guard bins alone at the default
+/// tolerance, so BIN_RANGE_AUTOMATIC only chooses it for narrow ranges at loose tolerances.
+/// Either way, the sweeps, the working memory and the output scale with the range of bins.
+///
+/// Frames are processed in blocks of FRAMES_PER_BLOCK, a multiple of the frames swept at once by the
+/// widest kernel, so that with the whole spectrum swept, each frame is filtered exactly as by
+/// FastCQT::ApplyInPlace on a whole buffer.
+///
+/// Thread safety: An instance holds working buffers, so it must not be used by more than one thread
+/// at a time. The FastCQT given at construction must outlive it.
+///
+{
+
+public:
+
+    static const size_t mFrameSize = veclib::get_output_FFT_size( FFT_SIZE );
+
+    typedef typename STFTFrameAnalyser< FFT_SIZE >::Frame Frame;
+
+    BinRangeAnalyser( const std::vector< float >& window,
+                      const FastCQT< FFT_SIZE >& cqt,
+                      size_t min_bin,
+                      size_t max_bin,
+                      float tolerance=DEFAULT_TOLERANCE,
+                      BinRangeMethod method=BIN_RANGE_AUTOMATIC,
+                      std::shared_ptr< Arena > arena=nullptr );
+    ~BinRangeAnalyser();
+
+    BinRangeFrames& Process( const float* samples, size_t num_frames, size_t increment );
+
+    const size_t GetFirstBin() const;
+    const size_t GetNumBins() const;
+    const size_t GetFirstSweepBin() const;
+    const size_t GetNumSweepBins() const;
+    const BinRangeMethod GetMethod() const;
+
+    //
+    // Constants
+    //
+    static constexpr float DEFAULT_TOLERANCE = 1e-4f;
+    static const size_t FRAMES_PER_BLOCK = 16;
+
+private:
+
+    //
+    // Configuration
+    //
+    const FastCQT< FFT_SIZE >& mCQT;
+    const size_t mWinLen;
+    const size_t mFirstBin;
+    const size_t mNumBins;
+    size_t mFirstSweepBin;
+    size_t mNumSweepBins;
+    BinRangeMethod mMethod;
+
+    //
+    // Data
+    //
+    std::vector< std::complex< float > > mKernel;       // Pruned DFT only, mWinLen x mNumSweepBins.
+    std::vector< Frame > mFrames;                       // FFT only, a block of whole frames.
+    std::vector< std::complex< float > > mBlock;        // A block of frames, FRAMES_PER_BLOCK x mNumSweepBins.
+    BinRangeFrames mOutput;
+
+    //
+    // Mechanics
+    //
+    std::unique_ptr< STFTFrameAnalyser< FFT_SIZE > > mAnalyser;
+
+    //
+    // Helpers
+    //
+    void ComputeKernel( STFTFrameAnalyser< FFT_SIZE >& analyser );
+    void AnalyseBlockFFT( const float* samples, size_t num_frames, size_t increment );
+    void AnalyseBlockPrunedDFT( const float* samples, size_t num_frames, size_t increment );
+
+};
+
+template< size_t FFT_SIZE >
+const size_t BinRangeAnalyser< FFT_SIZE >::mFrameSize;
+
+template< size_t FFT_SIZE >
+constexpr float BinRangeAnalyser< FFT_SIZE >::DEFAULT_TOLERANCE;
+
+template< size_t FFT_SIZE >
+const size_t BinRangeAnalyser< FFT_SIZE >::FRAMES_PER_BLOCK;
+
+template< size_t FFT_SIZE >
+BinRangeAnalyser< FFT_SIZE >::BinRangeAnalyser( const std::vector< float >& window,
+                                                const FastCQT< FFT_SIZE >& cqt,
+                                                size_t min_bin,
+                                                size_t max_bin,
+                                                float tolerance,
+                                                BinRangeMethod method,
+                                                std::shared_ptr< Arena > arena ) :
+    mCQT( cqt ),
+    mWinLen( window.size() ),
+    mFirstBin( min_bin ),
+    mNumBins( max_bin + 1 - min_bin ),
+    mFirstSweepBin( 0 ),
+    mNumSweepBins( 0 ),
+    mMethod( method )
+///
+/// Constructor. Chooses the bins to sweep and, for the pruned DFT, computes its kernel.
+///
+/// @param window
+///  The analysis window, which must be no longer than FFT_SIZE.
+///
+/// @param cqt
+///  The fast CQT whose filter coefficients are applied, made for the same window length.
+///
+/// @param min_bin
+///  The first bin to be output.
+///
+/// @param max_bin
+///  The last bin to be output, from min_bin up to and including the Nyquist bin.
+///
+/// @param tolerance
+///  The largest error in the output bins, from limiting the sweeps, relative to the magnitude of the
+///  spectrum at the edges of the sweep. From zero, for exactly the bins of the whole spectrum, to
+///  less than one.
+///
+/// @param method
+///  How the swept bins are computed from the samples.
+///
+/// @param arena
+///  An optional arena for the working memory of the FFT.
+///
+{
+    if( window.empty() || window.size() > FFT_SIZE )
+    {
+        throw std::invalid_argument( "The window must be no longer than the FFT" );
+    }
+    if( min_bin > max_bin || max_bin >= mFrameSize )
+    {
+        throw std::invalid_argument( "The range of bins must be within the spectrum, with its first bin no higher than its last" );
+    }
+    if( !( tolerance >= 0.0f && tolerance < 1.0f ) )
+    {
+        throw std::invalid_argument( "The tolerance must be from zero to less than one" );
+    }
+
+    const std::pair< size_t, size_t > sweep_range = mCQT.GetSweepRange( min_bin, max_bin, tolerance );
+    mFirstSweepBin = sweep_range.first;
+    mNumSweepBins = sweep_range.second + 1 - sweep_range.first;
+
+    // Real multiply-adds of the pruned DFT against an estimate of the flops of a real FFT.
+    if( mMethod == BIN_RANGE_AUTOMATIC )
+    {
+        const double dft_cost = 4.0*mWinLen*mNumSweepBins;
+        const double fft_cost = 2.5*FFT_SIZE*std::log2( static_cast< double >( FFT_SIZE ) );
+        mMethod = dft_cost < fft_cost ? BIN_RANGE_PRUNED_DFT : BIN_RANGE_FFT;
+    }
+
+    std::unique_ptr< STFTFrameAnalyser< FFT_SIZE > > analyser( new STFTFrameAnalyser< FFT_SIZE >( window, std::move( arena ) ) );
+    mFrames.resize( FRAMES_PER_BLOCK );
+    if( mMethod == BIN_RANGE_PRUNED_DFT )
+    {
+        ComputeKernel( *analyser );
+        mFrames.clear();
+        mFrames.shrink_to_fit();
+    }
+    else
+    {
+        mAnalyser = std::move( analyser );
+    }
+
+    mBlock.resize( FRAMES_PER_BLOCK*mNumSweepBins );
+    mOutput.first_bin = mFirstBin;
+    mOutput.num_bins = mNumBins;
+}
+
+template< size_t FFT_SIZE >
+BinRangeAnalyser< FFT_SIZE >::~BinRangeAnalyser() = default;
+
+template< size_t FFT_SIZE >
+BinRangeFrames& BinRangeAnalyser< FFT_SIZE >::Process( const float* samples, size_t num_frames, size_t increment )
+///
+/// Analyse a number of successive frames.
+///
+/// @param samples
+///  A pointer to the first sample of the first frame. There must be at least
+///  ( num_frames - 1 )*increment + window length samples available from here.
+///
+/// @param num_frames
+///  The number of frames to analyse.
+///
+/// @param increment
+///  The number of samples between the start of successive frames.
+///
+/// @return
+///  The bins of the range of each frame, valid until the next call.
+///
+{
+    mOutput.num_frames = num_frames;
+    mOutput.values.resize( num_frames*mNumBins );
+
+    const size_t offset = mFirstBin - mFirstSweepBin;
+    for( size_t first=0; first<num_frames; first+=FRAMES_PER_BLOCK )
+    {
+        const size_t block_frames = std::min( FRAMES_PER_BLOCK, num_frames - first );
+        const float* block_samples = samples + first*increment;
+        if( mMethod == BIN_RANGE_PRUNED_DFT )
+        {
+            AnalyseBlockPrunedDFT( block_samples, block_frames, increment );
+        }
+        else
+        {
+            AnalyseBlockFFT( block_samples, block_frames, increment );
+        }
+
+        mCQT.ApplyInPlace( mBlock.data(), block_frames, mFirstSweepBin, mNumSweepBins );
+
+        for( size_t frame=0; frame<block_frames; ++frame )
+        {
+            const std::complex< float >* swept = mBlock.data() + frame*mNumSweepBins + offset;
+            std::copy( swept, swept + mNumBins, mOutput.values.data() + ( first + frame )*mNumBins );
+        }
+    }
+
+    return mOutput;
+}
+
+template< size_t FFT_SIZE >
+const size_t BinRangeAnalyser< FFT_SIZE >::GetFirstBin() const
+///
+/// Get the bin of the first value of each output frame.
+///
+/// @return
+///  The first bin of the range.
+///
+{
+    return mFirstBin;
+}
+
+template< size_t FFT_SIZE >
+const size_t BinRangeAnalyser< FFT_SIZE >::GetNumBins() const
+///
+/// Get the size of the output frames.
+///
+/// @return
+///  The number of bins in the range.
+///
+{
+    return mNumBins;
+}
+
+template< size_t FFT_SIZE >
+const size_t BinRangeAnalyser< FFT_SIZE >::GetFirstSweepBin() const
+///
+/// Get the first bin computed and swept, including guard bins.
+///
+/// @return
+///  The first swept bin.
+///
+{
+    return mFirstSweepBin;
+}
+
+template< size_t FFT_SIZE >
+const size_t BinRangeAnalyser< FFT_SIZE >::GetNumSweepBins() const
+///
+/// Get the number of bins computed and swept for each frame, including guard bins.
+///
+/// @return
+///  The number of swept bins.
+///
+{
+    return mNumSweepBins;
+}
+
+template< size_t FFT_SIZE >
+const BinRangeMethod BinRangeAnalyser< FFT_SIZE >::GetMethod() const
+///
+/// Get how the swept bins are computed, as chosen at construction.
+///
+/// @return
+///  Either BIN_RANGE_FFT or BIN_RANGE_PRUNED_DFT.
+///
+{
+    return mMethod;
+}
+
+template< size_t FFT_SIZE >
+void BinRangeAnalyser< FFT_SIZE >::ComputeKernel( STFTFrameAnalyser< FFT_SIZE >& analyser )
+///
+/// Computes the kernel of the pruned DFT, the swept bins of the windowed FFT of a unit impulse at
+/// each sample of the window. Taking these from the FFT itself gives the same window, scale and sign
+/// conventions as the FFT path.
+///
+/// @param analyser
+///  Windows and transforms frames with the analysis window.
+///
+{
+    // Frame f of an impulse at mWinLen - 1, with an increment of one sample, has it at sample
+    // mWinLen - 1 - f.
+    std::vector< float > impulse( 2*mWinLen - 1, 0.0f );
+    impulse[mWinLen-1] = 1.0f;
+
+    mKernel.resize( mWinLen*mNumSweepBins );
+    for( size_t first=0; first<mWinLen; first+=FRAMES_PER_BLOCK )
+    {
+        const size_t block_frames = std::min( FRAMES_PER_BLOCK, mWinLen - first );
+        analyser.AnalyseFrames( impulse.data() + first, block_frames, 1, mFrames.data() );
+        for( size_t frame=0; frame<block_frames; ++frame )
+        {
+            const size_t sample = mWinLen - 1 - ( first + frame );
+            const std::complex< float >* bins = mFrames[frame].data() + mFirstSweepBin;
+            std::copy( bins, bins + mNumSweepBins, mKernel.data() + sample*mNumSweepBins );
+        }
+    }
+}
+
+template< size_t FFT_SIZE >
+void BinRangeAnalyser< FFT_SIZE >::AnalyseBlockFFT( const float* samples, size_t num_frames, size_t increment )
+///
+/// Windows and transforms a block of frames in full, keeping the swept bins in the block.
+///
+/// @param samples
+///  A pointer to the first sample of the first frame.
+///
+/// @param num_frames
+///  The number of frames, at most FRAMES_PER_BLOCK.
+///
+/// @param increment
+///  The number of samples between the start of successive frames.
+///
+{
+    mAnalyser->AnalyseFrames( samples, num_frames, increment, mFrames.data() );
+    for( size_t frame=0; frame<num_frames; ++frame )
+    {
+        const std::complex< float >* bins = mFrames[frame].data() + mFirstSweepBin;
+        std::copy( bins, bins + mNumSweepBins, mBlock.data() + frame*mNumSweepBins );
+    }
+}
+
+template< size_t FFT_SIZE >
+void BinRangeAnalyser< FFT_SIZE >::AnalyseBlockPrunedDFT( const float* samples, size_t num_frames, size_t increment )
+///
+/// Computes the swept bins of a block of frames directly, as the sum over the window of each sample
+/// times the kernel of its position. Each row of the kernel is applied to the whole block while it
+/// is in cache, and the multiply-adds within a row are over contiguous bins, so they vectorise.
+///
+/// @param samples
+///  A pointer to the first sample of the first frame.
+///
+/// @param num_frames
+///  The number of frames, at most FRAMES_PER_BLOCK.
+///
+/// @param increment
+///  The number of samples between the start of successive frames.
+///
+{
+    // Complex values are read as interleaved real and imaginary parts, each scaled by a real sample.
+    const size_t row_size = 2*mNumSweepBins;
+    float* block = reinterpret_cast< float* >( mBlock.data() );
+    const float* kernel = reinterpret_cast< const float* >( mKernel.data() );
+    std::fill( block, block + num_frames*row_size, 0.0f );
+
+    for( size_t sample=0; sample<mWinLen; ++sample )
+    {
+        const float* kernel_row = kernel + sample*row_size;
+        for( size_t frame=0; frame<num_frames; ++frame )
+        {
+            const float value = samples[frame*increment + sample];
+            float* output = block + frame*row_size;
+            for( size_t index=0; index<row_size; ++index )
+            {
+                output[index] += value*kernel_row[index];
+            }
+        }
+    }
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_BIN_RANGE_ANALYSER_H
@@ -0,0 +1,363 @@
+//
+// Created: 10/18/26 by agent
+//
+// A constant-Q transform of STFT frames by a precomputed sparse spectral kernel.
+//
+
+#ifndef CUPCAKE_EXACT_CQT_H
+#define CUPCAKE_EXACT_CQT_H
+
+// In module includes
+#include "STFTFrameAnalyser.h"
+#include "Kernels.h"
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cmath>
+
+namespace cupcake
+{
+
+struct ExactCQTFrames
+///
+/// The constant-Q output frames of one call to ExactCQT.
+///
+{
+    size_t num_frames = 0;
+    size_t num_bins = 0;
+    std::vector< std::complex< float > > values;    // num_frames x num_bins, from low to high frequency.
+};
+
+template< size_t FFT_SIZE >
+class ExactCQT
+///
+/// A constant-Q transform computed from STFT frames with a sparse spectral kernel, after Brown and
+/// Puckette, "An efficient algorithm for the calculation of a constant Q transform", 1992.
+///
+/// Bin k has centre frequency min_frequency*2^( k/bins_per_octave ) and a Hamming windowed complex
+/// exponential of N_k = ceil( Q*sample_rate/f_k ) samples as its temporal kernel, centred in the
+/// analysis window, where Q = 1/( 2^( 1/bins_per_octave ) - 1 ). The product of each temporal kernel
+/// with an STFT frame is computed in the frequency domain, where the kernels are concentrated in a
+/// few bins around their centre frequency. The spectral kernels are computed once, with the analysis
+/// window divided out so that the STFT of this library may be used as is, and every value below
+/// threshold times the peak of its kernel is dropped. The rest are held as a sparse (CSR) matrix.
+///
+/// Unlike FastCQT, whose IIR smoothing across frequency approximates a constant-Q window on the FFT
+/// bins, this gives the classic constant-Q transform, at geometrically spaced frequencies, at the
+/// cost of a sparse matrix product per frame. With a threshold of zero and an analysis window that is
+/// no shorter than any temporal kernel, the output only differs from the time-domain transform by the
+/// sidelobes of the temporal kernels beyond DC and the Nyquist frequency, which are small as the main
+/// lobe of every kernel is kept below the Nyquist frequency.
+///
+/// Frames are processed in blocks of FRAMES_PER_BLOCK, transposed so that the block's values of each
+/// FFT bin are contiguous. Each kernel value is then multiplied with the whole block with SIMD
+/// (get_kernels().sparse_cmul), and the block stays in cache while every kernel row is applied.
+///
+/// Thread safety: An instance holds a working buffer, so it must not be used by more than one thread
+/// at a time.
+///
+{
+
+public:
+
+    static const size_t mFrameSize = veclib::get_output_FFT_size( FFT_SIZE );
+
+    typedef typename STFTFrameAnalyser< FFT_SIZE >::Frame Frame;
+
+    ExactCQT( const std::vector< float >& window,
+              float sample_rate,
+              float min_frequency,
+              size_t bins_per_octave,
+              size_t num_bins=0,
+              float threshold=DEFAULT_THRESHOLD );
+    ~ExactCQT();
+
+    ExactCQTFrames& Process( const Frame* frames, size_t num_frames );
+
+    const std::vector< float >& GetBinFrequencies() const;
+    const size_t GetNumBins() const;
+    const size_t GetNumNonZeros() const;
+
+    //
+    // Constants
+    //
+    static constexpr float DEFAULT_THRESHOLD = 0.0054f;
+    static const size_t FRAMES_PER_BLOCK = 16;
+
+private:
+
+    //
+    // Configuration
+    //
+    std::vector< float > mFrequencies;
+
+    //
+    // Data
+    //
+    std::vector< std::complex< float > > mValues;       // The non-zero kernel values, row by row.
+    std::vector< uint32_t > mColumns;                   // The FFT bin of each value, less mFirstColumn.
+    std::vector< uint32_t > mRowStarts;                 // The first value of each row, and the end of the last.
+    size_t mFirstColumn;
+    size_t mNumColumns;
+    std::vector< std::complex< float > > mBlock;        // A block of frames, mNumColumns x FRAMES_PER_BLOCK.
+    ExactCQTFrames mOutput;
+
+};
+
+template< size_t FFT_SIZE >
+const size_t ExactCQT< FFT_SIZE >::mFrameSize;
+
+template< size_t FFT_SIZE >
+constexpr float ExactCQT< FFT_SIZE >::DEFAULT_THRESHOLD;
+
+template< size_t FFT_SIZE >
+const size_t ExactCQT< FFT_SIZE >::FRAMES_PER_BLOCK;
+
+template< size_t FFT_SIZE >
+ExactCQT< FFT_SIZE >::ExactCQT( const std::vector< float >& window,
+                                float sample_rate,
+                                float min_frequency,
+                                size_t bins_per_octave,
+                                size_t num_bins,
+                                float threshold ) :
+    mFirstColumn( 0 ),
+    mNumColumns( 0 )
+///
+/// Constructor. Computes the sparse spectral kernel.
+///
+/// @param window
+///  The analysis window of the STFT frames to be transformed, which sets the longest temporal kernel.
+///
+/// @param sample_rate
+///  The sample rate of the audio, in Hz.
+///
+/// @param min_frequency
+///  The centre frequency of the first bin, in Hz. Its temporal kernel must fit within the window.
+///
+/// @param bins_per_octave
+///  The number of bins in each octave, which sets Q.
+///
+/// @param num_bins
+///  The number of bins. If zero, every bin whose bandwidth is below the Nyquist frequency is computed.
+///
+/// @param threshold
+///  Kernel values smaller than this fraction of the peak of their kernel are dropped. Zero keeps
+///  the whole kernel.
+///
+{
+    if( window.empty() || window.size() > FFT_SIZE )
+    {
+        throw std::invalid_argument( "The window must be no longer than the FFT" );
+    }
+    if( sample_rate <= 0.0f || min_frequency <= 0.0f || min_frequency >= sample_rate/2 || bins_per_octave == 0 )
+    {
+        throw std::invalid_argument( "The lowest frequency must be between zero and the Nyquist frequency, with at least one bin per octave" );
+    }
+    if( threshold < 0.0f || threshold >= 1.0f )
+    {
+        throw std::invalid_argument( "The kernel threshold must be from zero to less than one" );
+    }
+
+    const double Q = 1.0/( std::pow( 2.0, 1.0/bins_per_octave ) - 1.0 );
+    const size_t win_len = window.size();
+    if( static_cast< size_t >( std::ceil( Q*sample_rate/min_frequency ) ) > win_len )
+    {
+        throw std::invalid_argument( "The window is too short for the temporal kernel of the lowest frequency" );
+    }
+    for( size_t bin=0; num_bins==0 || bin<num_bins; ++bin )
+    {
+        // The main lobe of each temporal kernel, 2*f/Q either side of f, must be below the Nyquist frequency.
+        const double frequency = min_frequency*std::pow( 2.0, static_cast< double >( bin )/bins_per_octave );
+        if( frequency*( 1.0 + 2.0/Q ) >= sample_rate/2.0 )
+        {
+            if( num_bins != 0 )
+            {
+                throw std::invalid_argument( "The bandwidth of every bin must be below the Nyquist frequency" );
+            }
+            break;
+        }
+        mFrequencies.push_back( static_cast< float >( frequency ) );
+    }
+
+    // The FFT's scale, as the DC value of a unit impulse.
+    STFTFrameAnalyser< FFT_SIZE > analyser( std::vector< float >( FFT_SIZE, 1.0f ) );
+    std::vector< float > real( FFT_SIZE, 0.0f );
+    std::vector< float > imag( FFT_SIZE, 0.0f );
+    Frame real_spectrum;
+    Frame imag_spectrum;
+    real[0] = 1.0f;
+    analyser.AnalyseFrames( real.data(), 1, FFT_SIZE, &real_spectrum );
+    const double scale = real_spectrum[0].real();
+
+    // Window values too small to divide out are left out of the kernels.
+    const float peak = *std::max_element( window.begin(), window.end() );
+    const float min_window = 0.01f*peak;
+
+    std::vector< std::vector< std::complex< float > > > rows( mFrequencies.size() );
+    size_t last_column = 0;
+    mFirstColumn = mFrameSize;
+    for( size_t bin=0; bin<mFrequencies.size(); ++bin )
+    {
+        // Temporal kernel t[n], centred on the window, over the window.
+        const size_t length = std::min( win_len, static_cast< size_t >( std::ceil( Q*sample_rate/mFrequencies[bin] ) ) );
+        const size_t start = ( win_len - length )/2;
+        const double centre = win_len/2.0;
+        std::fill( real.begin(), real.end(), 0.0f );
+        std::fill( imag.begin(), imag.end(), 0.0f );
+        for( size_t n=0; n<length; ++n )
+        {
+            const size_t sample = start + n;
+            if( window[sample] < min_window )
+            {
+                continue;
+            }
+            const double hamming = 0.54 - 0.46*std::cos( 2.0*M_PI*n/std::max< size_t >( length - 1, 1 ) );
+            const double phase = -2.0*M_PI*mFrequencies[bin]*( sample - centre )/sample_rate;
+            const double value = hamming/length/window[sample];
+            real[sample] = static_cast< float >( value*std::cos( phase ) );
+            imag[sample] = static_cast< float >( value*std::sin( phase ) );
+        }
+
+        // sum_n x[n]t[n] = 1/N sum_j X[j]T[-j], where T[-j] = conj( R[j] ) + i*conj( I[j] ) for the
+        // spectra R and I of the real and imaginary parts of t. The kernel is concentrated at negative
+        // frequencies, so only the positive frequencies of X, i.e., the STFT frame, are needed.
+        analyser.AnalyseFrames( real.data(), 1, FFT_SIZE, &real_spectrum );
+        analyser.AnalyseFrames( imag.data(), 1, FFT_SIZE, &imag_spectrum );
+        std::vector< std::complex< float > >& row = rows[bin];
+        row.resize( mFrameSize );
+        float row_peak = 0.0f;
+        for( size_t column=0; column<mFrameSize; ++column )
+        {
+            const std::complex< double > value = ( std::conj( std::complex< double >( real_spectrum[column] ) ) +
+                                                   std::complex< double >( 0.0, 1.0 )*std::conj( std::complex< double >( imag_spectrum[column] ) ) )/( FFT_SIZE*scale*scale );
+            row[column] = std::complex< float >( value );
+            row_peak = std::max( row_peak, std::abs( row[column] ) );
+        }
+        for( size_t column=0; column<mFrameSize; ++column )
+        {
+            if( std::abs( row[column] ) < threshold*row_peak )
+            {
+                row[column] = std::complex< float >();
+            }
+            else
+            {
+                mFirstColumn = std::min( mFirstColumn, column );
+                last_column = std::max( last_column, column );
+            }
+        }
+    }
+    mNumColumns = mFrequencies.empty() ? 0 : last_column + 1 - mFirstColumn;
+
+    // Compress to CSR, keeping every value of a zero threshold.
+    mRowStarts.push_back( 0 );
+    for( const auto& row : rows )
+    {
+        for( size_t column=mFirstColumn; column<mFirstColumn+mNumColumns; ++column )
+        {
+            if( threshold == 0.0f || row[column] != std::complex< float >() )
+            {
+                mValues.push_back( row[column] );
+                mColumns.push_back( static_cast< uint32_t >( column - mFirstColumn ) );
+            }
+        }
+        mRowStarts.push_back( static_cast< uint32_t >( mValues.size() ) );
+    }
+
+    mBlock.resize( mNumColumns*FRAMES_PER_BLOCK );
+    mOutput.num_bins = mFrequencies.size();
+}
+
+template< size_t FFT_SIZE >
+ExactCQT< FFT_SIZE >::~ExactCQT() = default;
+
+template< size_t FFT_SIZE >
+ExactCQTFrames& ExactCQT< FFT_SIZE >::Process( const Frame* frames, size_t num_frames )
+///
+/// Transform STFT frames.
+///
+/// @param frames
+///  The STFT frames, analysed with the window given at construction.
+///
+/// @param num_frames
+///  The number of frames.
+///
+/// @return
+///  The constant-Q frames, valid until the next call.
+///
+{
+    const size_t num_bins = mFrequencies.size();
+    mOutput.num_frames = num_frames;
+    mOutput.values.resize( num_frames*num_bins );
+
+    for( size_t first=0; first<num_frames; first+=FRAMES_PER_BLOCK )
+    {
+        const size_t block_frames = std::min( FRAMES_PER_BLOCK, num_frames - first );
+        for( size_t frame=0; frame<block_frames; ++frame )
+        {
+            const std::complex< float >* input = frames[first+frame].data() + mFirstColumn;
+            for( size_t column=0; column<mNumColumns; ++column )
+            {
+                mBlock[column*FRAMES_PER_BLOCK + frame] = input[column];
+            }
+        }
+
+        get_kernels().sparse_cmul( mValues.data(),
+                                   mColumns.data(),
+                                   mRowStarts.data(),
+                                   num_bins,
+                                   mBlock.data(),
+                                   FRAMES_PER_BLOCK,
+                                   block_frames,
+                                   mOutput.values.data() + first*num_bins,
+                                   num_bins );
+    }
+
+    return mOutput;
+}
+
+template< size_t FFT_SIZE >
+const std::vector< float >& ExactCQT< FFT_SIZE >::GetBinFrequencies() const
+///
+/// Get the centre frequency of each bin.
+///
+/// @return
+///  GetNumBins() frequencies in Hz, in increasing order.
+///
+{
+    return mFrequencies;
+}
+
+template< size_t FFT_SIZE >
+const size_t ExactCQT< FFT_SIZE >::GetNumBins() const
+///
+/// Get the size of the output frames.
+///
+/// @return
+///  The number of constant-Q bins.
+///
+{
+    return mFrequencies.size();
+}
+
+template< size_t FFT_SIZE >
+const size_t ExactCQT< FFT_SIZE >::GetNumNonZeros() const
+///
+/// Get the number of values kept in the sparse kernel, i.e., the complex multiplies per frame.
+///
+/// @return
+///  The number of kernel values.
+///
+{
+    return mValues.size();
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_EXACT_CQT_H
@@ -9,13 +9,18 @@
 #define CUPCAKE_FAST_CQT_H
 
 // In module includes
-// None.
+#include "ProcessingStats.h"
+#include "Kernels.h"
+#include "Arena.h"
 
 // Thirdparty includes
 #include "sig_gen.h"
 
 // Std Lib includes
+#include <memory>
+#include <utility>
 #include <math.h>
+#include <assert.h>
 
 namespace cupcake
 {
@@ -28,12 +33,20 @@ class FastCQT
     
 public:
     
-    FastCQT( size_t window_size );
+    FastCQT( size_t window_size, std::shared_ptr< Arena > arena=nullptr );
     ~FastCQT();
     
     void ApplyInPlace( std::vector< std::array< std::complex< float >, IO_SIZE > >& signal );
+    void ApplyInPlace( std::array< std::complex< float >, IO_SIZE >* frames, size_t num_frames ) const;
+    void ApplyInPlaceRecorded( std::array< std::complex< float >, IO_SIZE >* frames, size_t num_frames );
+    void ApplyInPlace( std::complex< float >* frames, size_t num_frames, size_t first_bin, size_t num_bins ) const;
+    std::pair< size_t, size_t > GetSweepRange( size_t min_bin, size_t max_bin, float tolerance ) const;
     
     const std::vector< std::complex< float > >& GetFilterCoefficients() const;
+    std::vector< float > GetEffectiveWindowLengths() const;
+    
+    const ProcessingStats& GetStats() const;
+    void ResetStats();
     
 private:
     
@@ -41,8 +54,14 @@ private:
     // Configuration
     //
     std::vector< std::complex< float > > mFilterCoefficients;
+    ArenaVector< std::complex< float > > mOneMinusCoefficients;
     size_t mWinSize;
     
+    //
+    // Statistics
+    //
+    ProcessingStats mStats;
+    
     //
     // Helpers
     //
@@ -51,12 +70,20 @@ private:
 };
 
 template< size_t FFT_SIZE >
-FastCQT<FFT_SIZE>::FastCQT( size_t window_size ) :
+FastCQT<FFT_SIZE>::FastCQT( size_t window_size, std::shared_ptr< Arena > arena ) :
     mFilterCoefficients( IO_SIZE, 0.0 ),
+    mOneMinusCoefficients( IO_SIZE, 0.0, ArenaAllocator< std::complex< float > >( std::move( arena ) ) ),
     mWinSize( window_size )
 ///
 /// Constructor.
 ///
+/// @param window_size
+///  The length of the STFT window the CQT is applied to.
+///
+/// @param arena
+///  An optional arena to allocate the coefficients used by the sweeps from. If null, they are
+///  allocated from the heap.
+///
 {
     CalculateFilterCoefficients();
 }
@@ -80,30 +107,138 @@ void FastCQT< FFT_SIZE >::ApplyInPlace( std::vector< std::array< std::complex< f
 /// @todo [matt.mccallum 10.02.17] I might be able to optimize the convolutions here further
 ///                                with the IPP or other vector/linalg library.
 {
-    for( auto& sig_frame : signal )
+    ApplyInPlaceRecorded( signal.data(), signal.size() );
+}
+
+template< size_t FFT_SIZE >
+void FastCQT< FFT_SIZE >::ApplyInPlaceRecorded( std::array< std::complex< float >, IO_SIZE >* frames, size_t num_frames )
+///
+/// Applies the fast CQT operation to a block of STFT frames in memory owned by the caller, recording
+/// statistics as the vector overload does. Unlike the const overload, this may not be shared between
+/// threads.
+///
+/// @param frames
+///  A pointer to the first of the complex valued STFT frames to be filtered in place.
+///
+/// @param num_frames
+///  The number of frames to be filtered.
+///
+{
     {
-        // convolve forwards
-        std::complex<float>* fc = mFilterCoefficients.data();
-        std::complex<float>* last_sig_element = sig_frame.data(); // @note [matt.mccallum 10.01.17] It doesn't matter where we start because the first filtering coefficient is 0 (no history).
-        for( auto& sig_element : sig_frame )
-        {
-            sig_element = (*fc)*(*last_sig_element) + ( 1.0f - (*fc) )*sig_element;
-            last_sig_element = &sig_element;
-            ++fc;
-        }
-        
-        // convolve backwards
-        --fc;
-        last_sig_element = sig_frame.data() + sig_frame.size() - 1;
-        for( auto sig_element=sig_frame.end()-2; sig_element>sig_frame.begin(); --sig_element )
-        {
-            (*sig_element) = (*fc)*(*last_sig_element) + ( 1.0f - (*fc) )*(*sig_element);
-            last_sig_element = &(*sig_element);
-            --fc;
-        }
-        
-        sig_frame[sig_frame.size()-1] = {0,0}; // Remove the Nyquist component - this is dependent on the way the output of the FFT operation is formatted.
+        StatsTimer timer( mStats.cqt_cycles );
+        ApplyInPlace( frames, num_frames );
+    }
+    
+    stats_add( mStats.calls, 1 );
+    stats_add( mStats.frames, num_frames );
+    stats_add( mStats.bytes_moved, 2*num_frames*sizeof( frames[0] ) ); // Each frame is read and written once.
+}
+
+template< size_t FFT_SIZE >
+void FastCQT< FFT_SIZE >::ApplyInPlace( std::array< std::complex< float >, IO_SIZE >* frames, size_t num_frames ) const
+///
+/// Applies the fast CQT operation to a block of STFT frames in memory owned by the caller.
+/// This only reads the filter coefficients, so a single FastCQT may be shared by several
+/// threads, each filtering its own frames. For the same reason no statistics are recorded here.
+///
+/// @param frames
+///  A pointer to the first of the complex valued STFT frames to be filtered in place.
+///
+/// @param num_frames
+///  The number of frames to be filtered.
+///
+{
+    // The sweeps are run by the kernels selected for this CPU, which filter 2, 4 or 8 frames at once
+    // where the instruction set allows. The sweep is a recurrence across bins, so a single frame (as
+    // pushed by most real-time callers) and any frames left over from a full register are filtered
+    // by the scalar sweep. Pushing blocks of frames is what makes use of the vector units.
+    get_kernels().cqt_sweep( reinterpret_cast< std::complex< float >* >( frames ),
+                             num_frames,
+                             IO_SIZE,
+                             mFilterCoefficients.data(),
+                             mOneMinusCoefficients.data() );
+}
+    
+template< size_t FFT_SIZE >
+void FastCQT< FFT_SIZE >::ApplyInPlace( std::complex< float >* frames, size_t num_frames, size_t first_bin, size_t num_bins ) const
+///
+/// Applies the fast CQT operation to frames holding only a contiguous range of bins. The sweeps
+/// start and end at the edges of the range, so the bins near each edge differ from those of a full
+/// sweep, unless the edge is that of the spectrum. GetSweepRange gives a range wide enough that the
+/// bins of interest do not. As with a full sweep, the last bin of the range is set to zero.
+///
+/// @param frames
+///  A pointer to the first of the frames, each num_bins contiguous values.
+///
+/// @param num_frames
+///  The number of frames to be filtered.
+///
+/// @param first_bin
+///  The bin of the first value in each frame.
+///
+/// @param num_bins
+///  The number of bins in each frame, such that first_bin + num_bins is no more than the full
+///  number of bins.
+///
+{
+    assert( first_bin + num_bins <= IO_SIZE );
+    
+    get_kernels().cqt_sweep( frames,
+                             num_frames,
+                             num_bins,
+                             mFilterCoefficients.data() + first_bin,
+                             mOneMinusCoefficients.data() + first_bin );
+}
+
+template< size_t FFT_SIZE >
+std::pair< size_t, size_t > FastCQT< FFT_SIZE >::GetSweepRange( size_t min_bin, size_t max_bin, float tolerance ) const
+///
+/// Get the range of bins to sweep so that the bins [min_bin, max_bin] come out as in a full sweep,
+/// to within a tolerance. Starting a sweep at a bin rather than at the edge of the spectrum is an
+/// error in its state, which decays by the magnitude of the coefficient of each bin it passes, so
+/// the range is widened on each side until that error has decayed below the tolerance, or the edge
+/// of the spectrum is reached. Low bins are only lightly smoothed, so need few extra bins, while
+/// high bins need many.
+///
+/// @param min_bin
+///  The first bin of interest.
+///
+/// @param max_bin
+///  The last bin of interest, which must be no less than min_bin.
+///
+/// @param tolerance
+///  The largest error in the bins of interest, relative to the magnitude of the spectrum at the
+///  edges of the range. Zero always gives the whole spectrum, so the bins are exactly those of a
+///  full sweep.
+///
+/// @return
+///  The first and last bin to be swept.
+///
+{
+    assert( min_bin <= max_bin && max_bin < IO_SIZE );
+    
+    // The error below could underflow to zero before reaching an edge, so zero is not left to the loops.
+    if( tolerance == 0.0f )
+    {
+        return std::make_pair( size_t( 0 ), IO_SIZE - 1 );
+    }
+    
+    // The forward sweep carries its error up through the coefficient of each bin.
+    size_t first_bin = min_bin;
+    for( float error=1.0f; first_bin>0 && error>tolerance; --first_bin )
+    {
+        error *= std::abs( mFilterCoefficients[first_bin] );
     }
+    
+    // The backward sweep carries its error down through the coefficient of the bin above.
+    size_t last_bin = max_bin;
+    for( float error=1.0f; last_bin+1<IO_SIZE && error>tolerance; )
+    {
+        ++last_bin;
+        error *= std::abs( mFilterCoefficients[last_bin] );
+    }
+    
+    return std::make_pair( first_bin, last_bin );
 }
     
 template< size_t FFT_SIZE >
@@ -135,6 +270,13 @@ void FastCQT< FFT_SIZE >::CalculateFilterCoefficients()
         {
             return ( value - min )/range*time_shift;
         });
+    
+    // The complement of each coefficient, weighting the input of each filtering step.
+    std::transform( mFilterCoefficients.begin(), mFilterCoefficients.end(), mOneMinusCoefficients.begin(),
+        []( const std::complex<float>& coeff )->std::complex<float>
+        {
+            return 1.0f - coeff;
+        });
 }
     
 template< size_t FFT_SIZE >
@@ -151,6 +293,51 @@ const std::vector< std::complex< float > >& FastCQT< FFT_SIZE >::GetFilterCoeffi
 {
     return mFilterCoefficients;
 }
+
+template< size_t FFT_SIZE >
+std::vector< float > FastCQT< FFT_SIZE >::GetEffectiveWindowLengths() const
+///
+/// Get the length of the time window that each bin effectively has after filtering. Filtering
+/// forwards and backwards across frequency with a coefficient of magnitude a convolves the spectrum
+/// with a two-sided exponential a^|n|, which is ( 1 + a )/( 1 - a ) bins wide. This narrows the
+/// STFT window in time by the same factor.
+///
+/// @return
+///  The effective window length of each bin, in samples. This is the STFT window length for bins
+///  that are not smoothed, and zero for any bin whose coefficient has unit magnitude.
+///
+{
+    std::vector< float > lengths( IO_SIZE );
+    std::transform( mFilterCoefficients.begin(), mFilterCoefficients.end(), lengths.begin(),
+        [this]( const std::complex<float>& coeff )->float
+        {
+            const float magnitude = std::abs( coeff );
+            return magnitude < 1.0f ? mWinSize*( 1.0f - magnitude )/( 1.0f + magnitude ) : 0.0f;
+        });
+    return lengths;
+}
+
+template< size_t FFT_SIZE >
+const ProcessingStats& FastCQT< FFT_SIZE >::GetStats() const
+///
+/// Get the statistics recorded by the vector overload of ApplyInPlace and by ApplyInPlaceRecorded.
+/// These are only recorded when compiled with CUPCAKE_ENABLE_STATS, and otherwise are all zero.
+///
+/// @return
+///  The time spent in the IIR sweeps, and the number of frames and bytes filtered.
+///
+{
+    return mStats;
+}
+
+template< size_t FFT_SIZE >
+void FastCQT< FFT_SIZE >::ResetStats()
+///
+/// Sets all recorded statistics back to zero.
+///
+{
+    mStats = ProcessingStats();
+}
     
 } // namespace cupcake
 
@@ -8,19 +8,36 @@
 #include "FastWavelet.h"
 #include "STFTAnalysis.h"
 #include "FastCQT.h"
+#include "STFTFrameAnalyser.h"
+#include "SpectralFeatures.h"
+#include "OnsetDetector.h"
+#include "MultiResolutionFastWavelet.h"
+#include "ExactCQT.h"
+#include "FrameDecimator.h"
+#include "BinRangeAnalyser.h"
+#include "FrameStore.h"
+#include "ThreadPool.h"
+#include "WorkStealingPool.h"
 
 // Thirdparty includes
 // None.
 
 // Std Lib includes
-// None.
+#include <algorithm>
+#include <stdexcept>
+#include <assert.h>
 
 using namespace cupcake;
 
-FastWavelet::FastWavelet( float overlap, const std::vector<float>& window ) :
-    mSTFT( new STFTAnalysis<FastWavelet::FAST_WAVELET_FFT_SIZE>( overlap, window ) ),
-    mCQT( new FastCQT<FastWavelet::FAST_WAVELET_FFT_SIZE>( window.size() ) ),
-    mOutputBuffer( FastWavelet::FAST_WAVELET_FFT_SIZE, 0.0 )
+template< size_t FFT_SIZE >
+const size_t FastWavelet< FFT_SIZE >::PARALLEL_CHUNK_SAMPLES = STFTAnalysis<FFT_SIZE>::INPUT_BUFFER_SIZE - FFT_SIZE;
+
+template< size_t FFT_SIZE >
+FastWavelet< FFT_SIZE >::FastWavelet( float overlap, const std::vector<float>& window, std::shared_ptr<Arena> arena ) :
+    mOverlap( overlap ),
+    mSTFT( new STFTAnalysis<FFT_SIZE>( overlap, window, arena ) ),
+    mCQT( new FastCQT<FFT_SIZE>( window.size(), arena ) ),
+    mArena( arena )
 ///
 /// Constructor.
 ///
@@ -31,14 +48,21 @@ FastWavelet::FastWavelet( float overlap, const std::vector<float>& window ) :
 ///
 /// @param window
 ///  The windowing function of the STFT operation. This vector also implies the windowing
-///  length.
+///  length, which must be no longer than FFT_SIZE.
+///
+/// @param arena
+///  An optional arena to lay out the input buffer and working memory in, including that of the
+///  batch analysers. Many instances may share one arena. If null, everything is allocated from
+///  the heap.
 ///
 {
 }
 
-FastWavelet::~FastWavelet() = default;
+template< size_t FFT_SIZE >
+FastWavelet< FFT_SIZE >::~FastWavelet() = default;
 
-std::vector< std::array< std::complex< float >, FastWavelet::mOutputSize > >& FastWavelet::PushSamples( const std::vector<float>& audio )
+template< size_t FFT_SIZE >
+typename FastWavelet< FFT_SIZE >::FrameBuffer& FastWavelet< FFT_SIZE >::PushSamples( const std::vector<float>& audio )
 ///
 /// Push samples to be analysed. This performs the STFT on the signal and successively
 /// applies a CQT transform on the resulting STFT. Signal samples are buffered for further
@@ -53,8 +77,28 @@ std::vector< std::array< std::complex< float >, FastWavelet::mOutputSize > >& Fa
 ///  A contiguous 2D complex valued vector of samples at the output of the fast CQT. 
 ///
 {
+    return PushSamples( ArrayView< const float >( audio ) );
+}
+
+template< size_t FFT_SIZE >
+typename FastWavelet< FFT_SIZE >::FrameBuffer& FastWavelet< FFT_SIZE >::PushSamples( ArrayView< const float > audio )
+///
+/// Push samples to be analysed, reading them in place from memory owned by the caller.
+/// This is otherwise identical to the vector overload.
+///
+/// @param audio
+///  A view of the audio samples to be processed. The samples only need to remain valid for the
+///  duration of this call.
+///
+/// @return
+///  A contiguous 2D complex valued vector of samples at the output of the fast CQT. 
+///
+{
+    StatsTimer timer( mStats.total_cycles );
+    stats_add( mStats.calls, 1 );
+    
     // Circular buffer, window, and STFT.
-    auto& stft_output = mSTFT->PushSamples( audio );
+    auto& stft_output = mSTFT->PushSamples( audio.data(), audio.size() );
  
     // Transform the STFT to have narrower windowing length at higher frequencies.
     mCQT->ApplyInPlace( stft_output );
@@ -63,24 +107,808 @@ std::vector< std::array< std::complex< float >, FastWavelet::mOutputSize > >& Fa
     return stft_output;
 }
 
-std::vector< float > FastWavelet::GetWindow()
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::PushSamplesInto( ArrayView< const float > audio, Frame* output )
+///
+/// Push samples to be analysed, as for PushSamples, writing the frames straight into memory owned
+/// by the caller rather than this object's output buffer. This is how the Python binding hands
+/// each call's frames to an array of exactly the right size without copying them.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @param output
+///  Room for GetNumPushFrames( audio.size() ) frames.
+///
+/// @return
+///  The number of frames written to output.
+///
+{
+    StatsTimer timer( mStats.total_cycles );
+    stats_add( mStats.calls, 1 );
+    
+    const size_t num_frames = mSTFT->PushSamplesInto( audio.data(), audio.size(), output );
+    mCQT->ApplyInPlaceRecorded( output, num_frames );
+    return num_frames;
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::ConfigureParallel( size_t num_threads )
+///
+/// Sets up the pool of threads used by PushSamplesParallel. This is only needed to choose the
+/// number of threads, as PushSamplesParallel otherwise creates a pool of one thread per core on its
+/// first call.
+///
+/// @param num_threads
+///  The number of worker threads, or zero for one per core.
+///
+{
+    typedef STFTFrameAnalyser<FFT_SIZE> analyser_type;
+    
+    mParallelPool.reset( new WorkStealingPool( num_threads ) );
+    mParallelAnalysers.clear();
+    for( size_t worker=0; worker<mParallelPool->GetNumThreads(); ++worker )
+    {
+        mParallelAnalysers.emplace_back( new analyser_type( mSTFT->GetWindow(), mArena ) );
+    }
+}
+
+template< size_t FFT_SIZE >
+typename FastWavelet< FFT_SIZE >::FrameBuffer& FastWavelet< FFT_SIZE >::PushSamplesParallel( ArrayView< const float > audio )
+///
+/// Push samples to be analysed, as for PushSamples, with the frames they complete spread over a
+/// pool of threads. This is intended for offline use, where a whole file is pushed in one call.
+///
+/// The samples are buffered exactly as by PushSamples, and the two may be mixed on one stream.
+/// The frames are then split into small tasks on a work-stealing pool, each of which windows,
+/// transforms and filters its own frames in place in the output, so the output is identical to
+/// that of PushSamples. Tasks start at a multiple of the widest CQT sweep, so that each frame is
+/// filtered by the same kernel as on the serial path.
+///
+/// The frames are computed straight into an output buffer sized for exactly this call's frames, so
+/// a longer earlier call's capacity is not kept. See PushSamplesParallelInto.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @return
+///  A contiguous 2D complex valued vector of samples at the output of the fast CQT.
+///
+{
+    const size_t num_frames = GetNumPushFrames( audio.size() );
+    if( mParallelOutput.capacity() > num_frames )
+    {
+        FrameBuffer().swap( mParallelOutput );
+    }
+    mParallelOutput.resize( num_frames );
+    
+    PushSamplesParallelInto( audio, mParallelOutput.data() );
+    return mParallelOutput;
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::PushSamplesParallelInto( ArrayView< const float > audio, Frame* output )
+///
+/// Push samples to be analysed in parallel, as for PushSamplesParallel, writing the frames straight
+/// into memory owned by the caller, as for PushSamplesInto.
+///
+/// Long inputs are pushed through the STFT input buffer a chunk at a time, with every chunk's frames
+/// computed in parallel into the next part of output. The time spent windowing, in FFTs and in the
+/// CQT by the threads is not included in GetStats.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @param output
+///  Room for GetNumPushFrames( audio.size() ) frames.
+///
+/// @return
+///  The number of frames written to output.
+///
+{
+    StatsTimer timer( mStats.total_cycles );
+    stats_add( mStats.calls, 1 );
+    
+    if( !mParallelPool )
+    {
+        ConfigureParallel( 0 );
+    }
+    
+    const size_t chunk_samples = PARALLEL_CHUNK_SAMPLES;
+    size_t frames_written = 0;
+    for( size_t first=0; first<audio.size(); first+=chunk_samples )
+    {
+        Frame* const chunk_output = output + frames_written;
+        frames_written += mSTFT->PushSamplesDirect( audio.data() + first, std::min( chunk_samples, audio.size() - first ), [this, chunk_output]( const float* input, size_t num_frames )
+        {
+            AnalyseParallel( input, num_frames, chunk_output );
+        });
+    }
+    return frames_written;
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::ConfigureFeatures( float sample_rate, size_t num_bands, float min_frequency, float tuning )
+///
+/// Sets up the reduction of output frames to features by PushSamplesFeatures. Calling this again
+/// replaces the previous configuration, and the flux of the next frame is measured against silence.
+///
+/// @param sample_rate
+///  The sample rate of the audio, in Hz.
+///
+/// @param num_bands
+///  The number of band energies per frame, in bands spaced logarithmically up to the Nyquist frequency.
+///
+/// @param min_frequency
+///  The lowest frequency, in Hz, included in the chroma and band energies.
+///
+/// @param tuning
+///  The frequency of A4, in Hz.
+///
+{
+    if( num_bands == 0 || min_frequency <= 0.0f || min_frequency >= sample_rate/2 )
+    {
+        throw std::invalid_argument( "There must be at least one band, and the lowest frequency must be between zero and the Nyquist frequency" );
+    }
+    mFeatures.reset( new SpectralFeatures<FFT_SIZE>( sample_rate, num_bands, min_frequency, tuning ) );
+}
+
+template< size_t FFT_SIZE >
+SpectralFeatureFrames& FastWavelet< FFT_SIZE >::PushSamplesFeatures( ArrayView< const float > audio )
+///
+/// Push samples to be analysed, as for PushSamples, and return the features of the output frames
+/// rather than the frames themselves. ConfigureFeatures must be called first.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @return
+///  The chroma, band energies, centroid and flux of every frame produced by these samples.
+///
+{
+    if( !mFeatures )
+    {
+        throw std::logic_error( "ConfigureFeatures must be called before PushSamplesFeatures" );
+    }
+    
+    auto& frames = PushSamples( audio );
+    return mFeatures->Process( frames.data(), frames.size() );
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::ConfigureOnsets( float sample_rate, float delta, size_t wait, size_t pre_max, size_t post_max, size_t pre_avg, size_t post_avg )
+///
+/// Sets up onset detection by PushSamplesOnsets, with peak picking parameters as for OnsetDetector.
+/// Calling this again starts onset detection afresh, counting frames from the next frame output.
+///
+/// @param sample_rate
+///  The sample rate of the audio, in Hz, used to give the time of each onset.
+///
+/// @param delta
+///  How far novelty must exceed its local mean to be an onset.
+///
+/// @param wait
+///  The number of frames after an onset in which no further onset is reported.
+///
+/// @param pre_max
+///  The number of frames before a peak it must be the largest of.
+///
+/// @param post_max
+///  The number of frames after a peak it must be the largest of.
+///
+/// @param pre_avg
+///  The number of frames before a peak in its local mean.
+///
+/// @param post_avg
+///  The number of frames after a peak in its local mean.
+///
+{
+    if( sample_rate <= 0.0f )
+    {
+        throw std::invalid_argument( "The sample rate must be positive" );
+    }
+    const double frame_period = mSTFT->GetIncrement()/static_cast< double >( sample_rate );
+    mOnsets.reset( new OnsetDetector<FFT_SIZE>( frame_period, delta, wait, pre_max, post_max, pre_avg, post_avg ) );
+}
+
+template< size_t FFT_SIZE >
+OnsetFrames& FastWavelet< FFT_SIZE >::PushSamplesOnsets( ArrayView< const float > audio )
+///
+/// Push samples to be analysed, as for PushSamples, and return the novelty of the output frames
+/// and any onsets that can now be decided, rather than the frames themselves. Onsets are reported
+/// OnsetDetector::GetLatencyFrames() frames after they occur. ConfigureOnsets must be called first.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @return
+///  The novelty of every frame produced by these samples, and the onsets decided.
+///
+{
+    if( !mOnsets )
+    {
+        throw std::logic_error( "ConfigureOnsets must be called before PushSamplesOnsets" );
+    }
+    
+    auto& frames = PushSamples( audio );
+    return mOnsets->Process( frames.data(), frames.size() );
+}
+
+template< size_t FFT_SIZE >
+OnsetFrames& FastWavelet< FFT_SIZE >::FlushOnsets()
+///
+/// Decides the last few frames, which are still waiting on later frames, as though the audio has
+/// ended. ConfigureOnsets must be called first.
+///
+/// @return
+///  Any onsets in the last frames.
+///
+{
+    if( !mOnsets )
+    {
+        throw std::logic_error( "ConfigureOnsets must be called before FlushOnsets" );
+    }
+    
+    return mOnsets->Flush();
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::ConfigureOctaves( size_t num_octaves )
+///
+/// Sets up the multi-resolution analysis of PushSamplesOctaves, in which each octave below the top
+/// octave is analysed at half the sample rate of the one above, with the window and overlap of
+/// this object. See MultiResolutionFastWavelet. Calling this again starts a new stream.
+///
+/// @param num_octaves
+///  The number of octaves analysed at successively halved sample rates, including the top octave.
+///
+{
+    mOctaves.reset( new MultiResolutionFastWavelet<FFT_SIZE>( num_octaves, mOverlap, mSTFT->GetWindow(), mArena ) );
+}
+
+template< size_t FFT_SIZE >
+MultiResolutionFrames& FastWavelet< FFT_SIZE >::PushSamplesOctaves( ArrayView< const float > audio )
+///
+/// Push samples to be analysed at multiple resolutions, returning one frame of every octave stitched
+/// together for each hop. This is a separate stream from that of PushSamples, which it neither
+/// reads nor modifies. ConfigureOctaves must be called first.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @return
+///  The stitched frames produced by these samples, from low to high frequency.
+///
+{
+    if( !mOctaves )
+    {
+        throw std::logic_error( "ConfigureOctaves must be called before PushSamplesOctaves" );
+    }
+    
+    return mOctaves->PushSamples( audio.data(), audio.size() );
+}
+
+template< size_t FFT_SIZE >
+std::vector< float > FastWavelet< FFT_SIZE >::GetOctaveFrequencies( float sample_rate )
+///
+/// Get the centre frequency of each bin of the frames returned by PushSamplesOctaves.
+/// ConfigureOctaves must be called first.
+///
+/// @param sample_rate
+///  The sample rate of the audio, in Hz.
+///
+/// @return
+///  The frequency of each bin in Hz, in increasing order.
+///
+{
+    if( !mOctaves )
+    {
+        throw std::logic_error( "ConfigureOctaves must be called before GetOctaveFrequencies" );
+    }
+    
+    return mOctaves->GetBinFrequencies( sample_rate );
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::GetOctaveLatency() const
+///
+/// Get the delay of the frames returned by PushSamplesOctaves, i.e., that of the lowest octave.
+/// See MultiResolutionFastWavelet::GetAlgorithmicLatency. ConfigureOctaves must be called first.
+///
+/// @return
+///  The algorithmic latency in samples.
+///
+{
+    if( !mOctaves )
+    {
+        throw std::logic_error( "ConfigureOctaves must be called before GetOctaveLatency" );
+    }
+    
+    return mOctaves->GetAlgorithmicLatency();
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::GetOctaveBufferedSamples() const
+///
+/// Get the number of samples pushed to PushSamplesOctaves that are still buffered, awaiting future
+/// frames. ConfigureOctaves must be called first.
+///
+/// @return
+///  The number of buffered samples.
+///
+{
+    if( !mOctaves )
+    {
+        throw std::logic_error( "ConfigureOctaves must be called before GetOctaveBufferedSamples" );
+    }
+    
+    return mOctaves->GetBufferedSamples();
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::ConfigureExact( float sample_rate, float min_frequency, size_t bins_per_octave, size_t num_bins, float threshold )
+///
+/// Sets up the exact constant-Q transform of PushSamplesExact, computed from the STFT frames of this
+/// object with a sparse spectral kernel, rather than by FastCQT's approximation. See ExactCQT.
+/// Calling this again replaces the previous configuration.
+///
+/// @param sample_rate
+///  The sample rate of the audio, in Hz.
+///
+/// @param min_frequency
+///  The centre frequency of the first bin, in Hz.
+///
+/// @param bins_per_octave
+///  The number of bins in each octave.
+///
+/// @param num_bins
+///  The number of bins, or zero for every bin below the Nyquist frequency.
+///
+/// @param threshold
+///  Kernel values smaller than this fraction of the peak of their kernel are dropped.
+///
+{
+    mExact.reset( new ExactCQT<FFT_SIZE>( mSTFT->GetWindow(), sample_rate, min_frequency, bins_per_octave, num_bins, threshold ) );
+}
+
+template< size_t FFT_SIZE >
+ExactCQTFrames& FastWavelet< FFT_SIZE >::PushSamplesExact( ArrayView< const float > audio )
+///
+/// Push samples to be analysed, returning the exact constant-Q transform of each STFT frame rather
+/// than the output of FastCQT. This shares the STFT, and so the stream, of PushSamples, so calls to
+/// the two may be interleaved to switch between them frame for frame. ConfigureExact must be
+/// called first.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @return
+///  The constant-Q frames produced by these samples.
+///
+{
+    if( !mExact )
+    {
+        throw std::logic_error( "ConfigureExact must be called before PushSamplesExact" );
+    }
+    
+    StatsTimer timer( mStats.total_cycles );
+    stats_add( mStats.calls, 1 );
+    
+    auto& stft_output = mSTFT->PushSamples( audio.data(), audio.size() );
+    return mExact->Process( stft_output.data(), stft_output.size() );
+}
+
+template< size_t FFT_SIZE >
+std::vector< float > FastWavelet< FFT_SIZE >::GetExactFrequencies()
+///
+/// Get the centre frequency of each bin of the frames returned by PushSamplesExact.
+/// ConfigureExact must be called first.
+///
+/// @return
+///  The frequency of each bin in Hz, in increasing order.
+///
+{
+    if( !mExact )
+    {
+        throw std::logic_error( "ConfigureExact must be called before GetExactFrequencies" );
+    }
+    
+    return mExact->GetBinFrequencies();
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::ConfigureDecimation( size_t min_hops_per_window )
+///
+/// Sets up the multi-rate output of PushSamplesDecimated, in which each band of bins keeps fewer
+/// frames the longer its effective window in the fast CQT. See FrameDecimator. Calling this again
+/// replaces the previous configuration, and the next frame output is kept by every band.
+///
+/// @param min_hops_per_window
+///  The number of frames each bin keeps within its effective window.
+///
+{
+    mDecimator.reset( new FrameDecimator<FFT_SIZE>( mCQT->GetEffectiveWindowLengths(), mSTFT->GetIncrement(), min_hops_per_window ) );
+}
+
+template< size_t FFT_SIZE >
+DecimatedFrames& FastWavelet< FFT_SIZE >::PushSamplesDecimated( ArrayView< const float > audio )
+///
+/// Push samples to be analysed, as for PushSamples, and return the output frames with each band
+/// decimated in time. ConfigureDecimation must be called first.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @return
+///  The frames kept from each band, from low to high frequency.
+///
+{
+    if( !mDecimator )
+    {
+        throw std::logic_error( "ConfigureDecimation must be called before PushSamplesDecimated" );
+    }
+    
+    auto& frames = PushSamples( audio );
+    return mDecimator->Process( frames.data(), frames.size() );
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::ConfigureBinRange( size_t min_bin, size_t max_bin, float tolerance, BinRangeMethod method )
+///
+/// Sets up PushSamplesBinRange, which computes only the bins [min_bin, max_bin] of each output
+/// frame. See BinRangeAnalyser. Calling this again replaces the previous configuration.
+///
+/// @param min_bin
+///  The first bin to be output.
+///
+/// @param max_bin
+///  The last bin to be output, which must be no lower than min_bin and no higher than the Nyquist bin.
+///
+/// @param tolerance
+///  The largest error in the output bins from limiting the CQT sweeps to the range, relative to the
+///  spectrum at the edges of the sweep. Zero gives exactly the bins of PushSamples.
+///
+/// @param method
+///  Whether the bins are computed by an FFT, by a DFT of only the bins needed, or by whichever is
+///  expected to be cheaper.
+///
+{
+    mBinRange.reset( new BinRangeAnalyser<FFT_SIZE>( mSTFT->GetWindow(), *mCQT, min_bin, max_bin, tolerance, method, mArena ) );
+}
+
+template< size_t FFT_SIZE >
+BinRangeFrames& FastWavelet< FFT_SIZE >::PushSamplesBinRange( ArrayView< const float > audio )
+///
+/// Push samples to be analysed, as for PushSamples, and return only the bins of the range given to
+/// ConfigureBinRange. The samples are buffered by the STFT of PushSamples, and the two may be mixed
+/// on one stream, but the frames are analysed by the range's own analyser, so only the bins it needs
+/// are filtered and stored. ConfigureBinRange must be called first.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @return
+///  The bins of the range of each frame produced by these samples, valid until the next call.
+///
+{
+    if( !mBinRange )
+    {
+        throw std::logic_error( "ConfigureBinRange must be called before PushSamplesBinRange" );
+    }
+    
+    StatsTimer timer( mStats.total_cycles );
+    stats_add( mStats.calls, 1 );
+    
+    const size_t increment = mSTFT->GetIncrement();
+    BinRangeFrames* output = nullptr;
+    mSTFT->PushSamplesDirect( audio.data(), audio.size(), [&]( const float* input, size_t num_frames )
+    {
+        output = &mBinRange->Process( input, num_frames, increment );
+    });
+    return *output;
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::PushSamplesToStore( ArrayView< const float > audio, FrameStoreWriter& store )
+///
+/// Push samples to be analysed, as for PushSamples, and append the output frames to the clip open
+/// in a frame store rather than returning them.
+///
+/// @param audio
+///  A view of the audio samples to be processed.
+///
+/// @param store
+///  A frame store with a clip open, written with this FFT size, hop and window. Otherwise this
+///  throws std::invalid_argument, before any samples are pushed.
+///
+/// @return
+///  The number of frames written.
+///
+{
+    if( store.GetFFTSize() != FFT_SIZE || store.GetNumBins() != mOutputSize )
+    {
+        throw std::invalid_argument( "Frame store was created for a different FFT size" );
+    }
+    if( store.GetHop() != GetIncrement() )
+    {
+        throw std::invalid_argument( "Frame store was created for a different hop" );
+    }
+    const std::vector< float >& window = GetWindow();
+    if( store.GetWindowLength() != window.size() || store.GetWindowHash() != hash_window( window ) )
+    {
+        throw std::invalid_argument( "Frame store was created for a different window" );
+    }
+    
+    auto& frames = PushSamples( audio );
+    store.WriteFrames( reinterpret_cast< const std::complex< float >* >( frames.data() ), frames.size() );
+    return frames.size();
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::GetNumFrames( size_t num_samples ) const
+///
+/// Computes the number of output frames a clip of samples produces when it is streamed through a
+/// freshly constructed FastWavelet, i.e., the number of complete STFT frames in the clip.
+///
+/// @param num_samples
+///  The number of samples in the clip.
+///
+/// @return
+///  The number of output frames.
+///
+{
+    return STFTFrameAnalyser<FFT_SIZE>::GetNumFrames( num_samples, mSTFT->GetWinLen(), mSTFT->GetIncrement() );
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::GetNumPushFrames( size_t num_samples ) const
+///
+/// Computes the number of output frames the next push of samples produces, given the samples
+/// already buffered, e.g. to size the output of PushSamplesInto.
+///
+/// @param num_samples
+///  The number of samples to be pushed.
+///
+/// @return
+///  The number of output frames.
+///
+{
+    return STFTFrameAnalyser<FFT_SIZE>::GetNumFrames( mSTFT->GetBufferedSamples() + num_samples, mSTFT->GetWinLen(), mSTFT->GetIncrement() );
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::GetIncrement() const
+///
+/// Get the number of samples between the starts of successive output frames.
+///
+/// @return
+///  The STFT increment in samples.
+///
+{
+    return mSTFT->GetIncrement();
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::GetAlgorithmicLatency() const
+///
+/// Get the delay from the first sample of a frame being pushed to the frame being output by
+/// PushSamples. This is that of the STFT, as the fast CQT filters each frame on its own.
+///
+/// This also holds for every other method that shares the STFT of PushSamples, i.e., all but
+/// PushSamplesOctaves, whose delay is given by GetOctaveLatency. In particular, PushSamplesDecimated
+/// outputs each frame it keeps along with the full rate frame it is taken from, so decimation
+/// lengthens the hop of a band but not its latency.
+///
+/// @return
+///  The algorithmic latency in samples.
+///
+{
+    return mSTFT->GetAlgorithmicLatency();
+}
+
+template< size_t FFT_SIZE >
+size_t FastWavelet< FFT_SIZE >::GetBufferedSamples() const
+///
+/// Get the number of samples pushed that are still buffered, awaiting future frames, by every method
+/// that shares the STFT of PushSamples. PushSamplesOctaves buffers its samples separately, as given
+/// by GetOctaveBufferedSamples.
+///
+/// @return
+///  The number of buffered samples.
+///
+{
+    return mSTFT->GetBufferedSamples();
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::TransformBatch( const float* clips,
+                                              size_t num_clips,
+                                              size_t clip_stride,
+                                              const size_t* clip_lengths,
+                                              std::complex< float >* output,
+                                              size_t num_output_frames )
+///
+/// Transforms many independent clips in one call, spreading the work over a pool of threads.
+/// Each clip is transformed as though it were pushed in full through a freshly constructed
+/// FastWavelet, so this neither reads nor modifies the streaming state used by PushSamples.
+/// The window, STFT parameters and CQT coefficients of this object are shared by all clips.
+/// The thread pool and per-thread FFT state are created on the first call and reused after that.
+///
+/// @param clips
+///  A pointer to the first sample of the first clip. Clip n starts at clips + n*clip_stride.
+///
+/// @param num_clips
+///  The number of clips to transform.
+///
+/// @param clip_stride
+///  The number of samples between the start of successive clips. This is also the maximum
+///  length of each clip.
+///
+/// @param clip_lengths
+///  The number of valid samples in each clip, each no more than clip_stride. This may be null, in
+///  which case every clip is clip_stride samples long.
+///
+/// @param output
+///  A pointer to memory for num_clips*num_output_frames*mOutputSize complex values. Frame f of
+///  clip n starts at output + ( n*num_output_frames + f )*mOutputSize. Frames beyond the end of a
+///  clip are set to zero, and frames beyond num_output_frames are not computed.
+///
+/// @param num_output_frames
+///  The number of frames of output per clip, usually GetNumFrames( clip_stride ).
+///
+{
+    typedef STFTFrameAnalyser<FFT_SIZE> analyser_type;
+    typedef typename analyser_type::Frame frame_type;
+    
+    if( !mBatchPool )
+    {
+        mBatchPool.reset( new ThreadPool() );
+        for( size_t worker=0; worker<mBatchPool->GetNumThreads(); ++worker )
+        {
+            mBatchAnalysers.emplace_back( new analyser_type( mSTFT->GetWindow(), mArena ) );
+        }
+    }
+    
+    // Split each clip into blocks of frames, so that a few long clips still occupy every thread.
+    const size_t increment = mSTFT->GetIncrement();
+    const size_t win_len = mSTFT->GetWinLen();
+    const size_t frames_per_task = BATCH_FRAMES_PER_TASK;
+    const size_t blocks_per_clip = ( num_output_frames + frames_per_task - 1 )/frames_per_task;
+    frame_type* output_frames = reinterpret_cast< frame_type* >( output );
+    
+    mBatchPool->ParallelFor( num_clips*blocks_per_clip, [&]( size_t task, size_t worker )
+    {
+        const size_t clip = task/blocks_per_clip;
+        const size_t first_frame = ( task%blocks_per_clip )*frames_per_task;
+        const size_t num_frames = std::min( frames_per_task, num_output_frames - first_frame );
+        
+        const size_t clip_length = clip_lengths ? std::min( clip_lengths[clip], clip_stride ) : clip_stride;
+        const size_t clip_frames = analyser_type::GetNumFrames( clip_length, win_len, increment );
+        const size_t num_valid = first_frame < clip_frames ? std::min( num_frames, clip_frames - first_frame ) : 0;
+        
+        frame_type* block = output_frames + clip*num_output_frames + first_frame;
+        
+        // Window, STFT and CQT of the frames that lie within the clip.
+        mBatchAnalysers[worker]->AnalyseFrames( clips + clip*clip_stride + first_frame*increment, num_valid, increment, block );
+        mCQT->ApplyInPlace( block, num_valid );
+        
+        // Pad the remainder of the block.
+        std::fill( block + num_valid, block + num_frames, frame_type() );
+    });
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::AnalyseParallel( const float* input, size_t num_frames, Frame* output )
+///
+/// Computes frames from buffered samples on the parallel pool, as the frames of a chunk pushed by
+/// PushSamplesParallel.
+///
+/// @param input
+///  The samples of the first frame, followed by those of the rest, one STFT increment apart.
+///
+/// @param num_frames
+///  The number of frames.
+///
+/// @param output
+///  Where to write the frames.
+///
+{
+    const size_t increment = mSTFT->GetIncrement();
+    const size_t frames_per_task = PARALLEL_FRAMES_PER_TASK;
+    const size_t num_tasks = ( num_frames + frames_per_task - 1 )/frames_per_task;
+    
+    mParallelPool->SubmitRange( num_tasks, [this, input, output, increment, frames_per_task, num_frames]( size_t task, size_t worker )
+    {
+        // Window, STFT and CQT of this task's frames.
+        const size_t first_frame = task*frames_per_task;
+        const size_t task_frames = std::min( frames_per_task, num_frames - first_frame );
+        mParallelAnalysers[worker]->AnalyseFrames( input + first_frame*increment, task_frames, increment, output + first_frame );
+        mCQT->ApplyInPlace( output + first_frame, task_frames );
+    });
+    mParallelPool->Wait();
+}
+
+template< size_t FFT_SIZE >
+const std::vector< float >& FastWavelet< FFT_SIZE >::GetWindow()
 ///
 /// Returns the windowing function used for STFT analysis in the time domain.
 ///
 /// @return
-///  The window as a vector of float values.
+///  The window as a vector of float values, valid for the lifetime of this object.
 ///
 {
     return mSTFT->GetWindow();
 }
 
-std::vector< std::complex< float > > FastWavelet::GetCQTCoeffs()
+template< size_t FFT_SIZE >
+const std::vector< std::complex< float > >& FastWavelet< FFT_SIZE >::GetCQTCoeffs()
 ///
 /// Returns the coefficients used for filtering each sample of the STFT.
 ///
 /// @return
-///  The CQT coefficients.
+///  The CQT coefficients, valid for the lifetime of this object.
 ///
 {
     return mCQT->GetFilterCoefficients();
-}
\ No newline at end of file
+}
+
+template< size_t FFT_SIZE >
+ProcessingStats FastWavelet< FFT_SIZE >::GetStats()
+///
+/// Get the statistics recorded by PushSamples, broken down by stage. These are only recorded when
+/// compiled with CUPCAKE_ENABLE_STATS, and otherwise are all zero. TransformBatch is not included.
+///
+/// @return
+///  The number of calls and total time spent in PushSamples, the time spent buffering input,
+///  windowing, in FFTs and in the CQT, the number of frames produced, the bytes moved by all
+///  stages and the number of samples waiting in the input buffer.
+///
+{
+    const ProcessingStats stft_stats = mSTFT->GetStats();
+    const ProcessingStats& cqt_stats = mCQT->GetStats();
+    
+    ProcessingStats stats = mStats;
+    stats.buffer_cycles = stft_stats.buffer_cycles;
+    stats.window_cycles = stft_stats.window_cycles;
+    stats.fft_cycles = stft_stats.fft_cycles;
+    stats.cqt_cycles = cqt_stats.cqt_cycles;
+    stats.frames = stft_stats.frames;
+    stats.bytes_moved = stft_stats.bytes_moved + cqt_stats.bytes_moved;
+    stats.buffer_occupancy = stft_stats.buffer_occupancy;
+    stats.max_buffer_occupancy = stft_stats.max_buffer_occupancy;
+    return stats;
+}
+
+template< size_t FFT_SIZE >
+void FastWavelet< FFT_SIZE >::ResetStats()
+///
+/// Sets all recorded statistics back to zero.
+///
+{
+    mStats = ProcessingStats();
+    mSTFT->ResetStats();
+    mCQT->ResetStats();
+}
+
+template< size_t FFT_SIZE >
+std::mutex& FastWavelet< FFT_SIZE >::GetMutex()
+///
+/// Returns a mutex for serializing the use of this instance by multiple threads. FastWavelet does
+/// not lock this itself, it is up to the threads sharing an instance to hold it while calling
+/// PushSamples and while consuming the output that is returned.
+///
+/// @return
+///  The mutex associated with this instance.
+///
+{
+    return mMutex;
+}
+
+// Explicit instantiations - these must match FastWaveletFFTSizes.
+template class cupcake::FastWavelet< 256 >;
+template class cupcake::FastWavelet< 512 >;
+template class cupcake::FastWavelet< 1024 >;
+template class cupcake::FastWavelet< 2048 >;
+template class cupcake::FastWavelet< 4096 >;
+template class cupcake::FastWavelet< 8192 >;
+template class cupcake::FastWavelet< 16384 >;
@@ -4,66 +4,189 @@
 // Class for computing a fast wavelet transform.
 //
 
-// @todo [matt.mccallum 10.02.17] There could be some improvement here by implementing a sort
-//                                of chain-of-command design pattern using templates so that
-//                                the process of taking inputs and passing them on to the next
-//                                block is all accounted for.
-//                                For example, have a templated signal processing block with
-//                                arbitrary inputs and outputs. This class doesn't care what
-//                                the signal processing blocks are, it just needs to take some
-//                                input or previous output and pass it on to the next block.
+// @note Custom chains of per-frame processing blocks can be composed at compile time with
+//       ProcessingChain (see ProcessingChain.h), where FastWaveletChain performs the same per-frame
+//       processing as this class. This class keeps its own stages for the input buffering,
+//       statistics and the multi-frame CQT sweeps that it shares with TransformBatch.
 
 #ifndef CUPCAKE_FAST_WAVELET_H
 #define CUPCAKE_FAST_WAVELET_H
 
 // In module includes.
-// None.
+#include "ArrayView.h"
+#include "ProcessingStats.h"
+#include "Arena.h"
 
 // Third party includes.
 #include "FFT.h"
 
 // Std lib includes.
 #include <vector>
+#include <array>
+#include <complex>
 #include <memory>
+#include <mutex>
+#include <utility>
 
 namespace cupcake
 {
     
 template< size_t FFT_SIZE > class STFTAnalysis;
 template< size_t FFT_SIZE > class FastCQT;
+template< size_t FFT_SIZE > class STFTFrameAnalyser;
+template< size_t FFT_SIZE > class SpectralFeatures;
+struct SpectralFeatureFrames;
+template< size_t FFT_SIZE > class OnsetDetector;
+struct OnsetFrames;
+template< size_t FFT_SIZE > class MultiResolutionFastWavelet;
+struct MultiResolutionFrames;
+template< size_t FFT_SIZE > class ExactCQT;
+struct ExactCQTFrames;
+template< size_t FFT_SIZE > class FrameDecimator;
+struct DecimatedFrames;
+template< size_t FFT_SIZE > class BinRangeAnalyser;
+struct BinRangeFrames;
+enum BinRangeMethod : int;
+class FrameStoreWriter;
+class ThreadPool;
+class WorkStealingPool;
 
+// The FFT sizes for which FastWavelet is compiled. Each has its own fully specialised STFT and CQT,
+// so that runtime users (e.g. the Python binding) can choose an FFT size without any loss of speed.
+typedef std::index_sequence< 256, 512, 1024, 2048, 4096, 8192, 16384 > FastWaveletFFTSizes;
+
+template< size_t FFT_SIZE = 4096 >
 class FastWavelet
 ///
 /// Fast wavelet analyser.
 ///
+/// This is only instantiated for the FFT sizes in FastWaveletFFTSizes.
+///
+/// Thread safety: An instance holds streaming state and an output buffer, so it must not be used
+/// by more than one thread at a time. Independent instances share no mutable state and may be
+/// driven concurrently from different threads. Callers that do share an instance between threads
+/// should hold GetMutex() while calling PushSamples and while consuming its output. The Python
+/// binding does this for every call.
+///
 {
-    static const size_t FAST_WAVELET_FFT_SIZE = 4096;
 
 public:
-    FastWavelet( float overlap, const std::vector<float>& window );
+    FastWavelet( float overlap, const std::vector<float>& window, std::shared_ptr<Arena> arena=nullptr );
 	~FastWavelet();
     
-    static const size_t mOutputSize = veclib::get_output_FFT_size( FAST_WAVELET_FFT_SIZE );
+    static const size_t mOutputSize = veclib::get_output_FFT_size( FFT_SIZE );
+    
+    typedef std::array< std::complex< float >, mOutputSize > Frame;
+    typedef std::vector< Frame > FrameBuffer;
+    
+    FrameBuffer& PushSamples( const std::vector<float>& audio );
+    FrameBuffer& PushSamples( ArrayView< const float > audio );
+    size_t PushSamplesInto( ArrayView< const float > audio, Frame* output );
+    
+    void ConfigureParallel( size_t num_threads );
+    FrameBuffer& PushSamplesParallel( ArrayView< const float > audio );
+    size_t PushSamplesParallelInto( ArrayView< const float > audio, Frame* output );
+    
+    void ConfigureFeatures( float sample_rate, size_t num_bands, float min_frequency, float tuning );
+    SpectralFeatureFrames& PushSamplesFeatures( ArrayView< const float > audio );
+    
+    void ConfigureOnsets( float sample_rate, float delta, size_t wait, size_t pre_max, size_t post_max, size_t pre_avg, size_t post_avg );
+    OnsetFrames& PushSamplesOnsets( ArrayView< const float > audio );
+    OnsetFrames& FlushOnsets();
     
-    std::vector< std::array< std::complex< float >, mOutputSize > >& PushSamples( const std::vector<float>& audio );
+    void ConfigureOctaves( size_t num_octaves );
+    MultiResolutionFrames& PushSamplesOctaves( ArrayView< const float > audio );
+    std::vector< float > GetOctaveFrequencies( float sample_rate );
+    size_t GetOctaveLatency() const;
+    size_t GetOctaveBufferedSamples() const;
     
-    std::vector< float > GetWindow();
-    std::vector< std::complex< float > > GetCQTCoeffs();
+    void ConfigureExact( float sample_rate, float min_frequency, size_t bins_per_octave, size_t num_bins, float threshold );
+    ExactCQTFrames& PushSamplesExact( ArrayView< const float > audio );
+    std::vector< float > GetExactFrequencies();
+    
+    void ConfigureDecimation( size_t min_hops_per_window );
+    DecimatedFrames& PushSamplesDecimated( ArrayView< const float > audio );
+    
+    void ConfigureBinRange( size_t min_bin, size_t max_bin, float tolerance, BinRangeMethod method );
+    BinRangeFrames& PushSamplesBinRange( ArrayView< const float > audio );
+    
+    size_t PushSamplesToStore( ArrayView< const float > audio, FrameStoreWriter& store );
+    
+    size_t GetNumFrames( size_t num_samples ) const;
+    size_t GetNumPushFrames( size_t num_samples ) const;
+    size_t GetIncrement() const;
+    size_t GetAlgorithmicLatency() const;
+    size_t GetBufferedSamples() const;
+    void TransformBatch( const float* clips,
+                         size_t num_clips,
+                         size_t clip_stride,
+                         const size_t* clip_lengths,
+                         std::complex< float >* output,
+                         size_t num_output_frames );
+    
+    const std::vector< float >& GetWindow();
+    const std::vector< std::complex< float > >& GetCQTCoeffs();
+    
+    ProcessingStats GetStats();
+    void ResetStats();
+    
+    std::mutex& GetMutex();
 
 private:
     
+    //
+    // Configuration
+    //
+    const float mOverlap;
+    
     //
     // Mechanics
     //
-    std::unique_ptr<STFTAnalysis<FAST_WAVELET_FFT_SIZE>> mSTFT;
-    std::unique_ptr<FastCQT<FAST_WAVELET_FFT_SIZE>> mCQT;
+    std::unique_ptr<STFTAnalysis<FFT_SIZE>> mSTFT;
+    std::unique_ptr<FastCQT<FFT_SIZE>> mCQT;
+    std::unique_ptr<ThreadPool> mBatchPool;
+    std::vector<std::unique_ptr<STFTFrameAnalyser<FFT_SIZE>>> mBatchAnalysers;
+    std::unique_ptr<WorkStealingPool> mParallelPool;
+    std::vector<std::unique_ptr<STFTFrameAnalyser<FFT_SIZE>>> mParallelAnalysers;
+    std::unique_ptr<SpectralFeatures<FFT_SIZE>> mFeatures;
+    std::unique_ptr<OnsetDetector<FFT_SIZE>> mOnsets;
+    std::unique_ptr<MultiResolutionFastWavelet<FFT_SIZE>> mOctaves;
+    std::unique_ptr<ExactCQT<FFT_SIZE>> mExact;
+    std::unique_ptr<FrameDecimator<FFT_SIZE>> mDecimator;
+    std::unique_ptr<BinRangeAnalyser<FFT_SIZE>> mBinRange;
+    std::shared_ptr<Arena> mArena;
     
     //
     // Data
     //
-    std::vector<float> mOutputBuffer;
+    FrameBuffer mParallelOutput;
+    
+    //
+    // Thread safety
+    //
+    std::mutex mMutex;
+    
+    //
+    // Statistics
+    //
+    ProcessingStats mStats;
+    
+    //
+    // Constants
+    //
+    static const size_t BATCH_FRAMES_PER_TASK = 32;
+    static const size_t PARALLEL_FRAMES_PER_TASK = 8;         // A multiple of the frames in the widest CQT sweep.
+    static const size_t PARALLEL_CHUNK_SAMPLES;               // The STFT input buffer, less the longest window.
+    
+    //
+    // Helpers
+    //
+    void AnalyseParallel( const float* input, size_t num_frames, Frame* output );
 };
 
+template< size_t FFT_SIZE >
+const size_t FastWavelet< FFT_SIZE >::mOutputSize;
+
 } // namespace cupcake
 
 #endif // CUPCAKE_FAST_WAVELET_H
\ No newline at end of file
@@ -6,7 +6,11 @@
 
 // In module includes.
 #include "FastWavelet.h"
+#include "FastWaveletRegistry.h"
 #include "PybindArgumentConversion.h"
+#include "FrameStore.h"
+#include "FrameStoreBinding.h"
+#include "TransformCache.h"
 
 // Third party includes.
 #include "pybind11/pybind11.h"
@@ -21,11 +25,81 @@ using namespace cupcake;
 PYBIND11_PLUGIN(FastWavelet) {
     py::module m("FastWavelet", "C++ implementation of the fast wavelet transform");
     
-    py::class_<cupcake::FastWavelet>(m, "FastWavelet")
-        .def( "__init__", &py_wrapped_ctor< FastWavelet, float, const std::vector<float>& > )
-        .def( "PushSamples", py_wrapped_func( &FastWavelet::PushSamples ) )
-        .def( "GetWindow", py_wrapped_func( &FastWavelet::GetWindow ) )
-        .def( "GetCQTCoeffs", py_wrapped_func( &FastWavelet::GetCQTCoeffs ) );
+    py::class_<PyFastWavelet>(m, "FastWavelet")
+        .def( "__init__", &py_wrapped_ctor< PyFastWavelet, float, const std::vector<float>&, size_t >,
+              py::arg( "overlap" ), py::arg( "window" ), py::arg( "fft_size" ) = 4096 )
+        .def( "PushSamples", &PyFastWavelet::PushSamples )
+        .def( "ConfigureParallel", &PyFastWavelet::ConfigureParallel, py::arg( "num_threads" ) = 0 )
+        .def( "PushSamplesParallel", &PyFastWavelet::PushSamplesParallel )
+        .def( "ConfigureFeatures", &PyFastWavelet::ConfigureFeatures,
+              py::arg( "sample_rate" ), py::arg( "num_bands" ) = 8, py::arg( "min_frequency" ) = 27.5f, py::arg( "tuning" ) = 440.0f )
+        .def( "PushSamplesFeatures", &PyFastWavelet::PushSamplesFeatures )
+        .def( "ConfigureOnsets", &PyFastWavelet::ConfigureOnsets,
+              py::arg( "sample_rate" ), py::arg( "delta" ) = 0.05f, py::arg( "wait" ) = 3, py::arg( "pre_max" ) = 3,
+              py::arg( "post_max" ) = 1, py::arg( "pre_avg" ) = 10, py::arg( "post_avg" ) = 1 )
+        .def( "PushSamplesOnsets", &PyFastWavelet::PushSamplesOnsets )
+        .def( "FlushOnsets", &PyFastWavelet::FlushOnsets )
+        .def( "ConfigureOctaves", &PyFastWavelet::ConfigureOctaves, py::arg( "num_octaves" ) )
+        .def( "PushSamplesOctaves", &PyFastWavelet::PushSamplesOctaves )
+        .def( "GetOctaveFrequencies", &PyFastWavelet::GetOctaveFrequencies, py::arg( "sample_rate" ) )
+        .def( "GetOctaveLatency", &PyFastWavelet::GetOctaveLatency )
+        .def( "GetOctaveBufferedSamples", &PyFastWavelet::GetOctaveBufferedSamples )
+        .def( "ConfigureExact", &PyFastWavelet::ConfigureExact,
+              py::arg( "sample_rate" ), py::arg( "min_frequency" ), py::arg( "bins_per_octave" ) = 12, py::arg( "num_bins" ) = 0,
+              py::arg( "threshold" ) = 0.0054f )
+        .def( "PushSamplesExact", &PyFastWavelet::PushSamplesExact )
+        .def( "GetExactFrequencies", &PyFastWavelet::GetExactFrequencies )
+        .def( "ConfigureDecimation", &PyFastWavelet::ConfigureDecimation, py::arg( "min_hops_per_window" ) = 4 )
+        .def( "PushSamplesDecimated", &PyFastWavelet::PushSamplesDecimated )
+        .def( "ConfigureBinRange", &PyFastWavelet::ConfigureBinRange,
+              py::arg( "min_bin" ), py::arg( "max_bin" ), py::arg( "tolerance" ) = 1e-4f, py::arg( "method" ) = "auto" )
+        .def( "PushSamplesBinRange", &PyFastWavelet::PushSamplesBinRange )
+        .def( "PushSamplesToStore", &PyFastWavelet::PushSamplesToStore, py::arg( "audio" ), py::arg( "store" ) )
+        .def( "TransformCached", &PyFastWavelet::TransformCached, py::arg( "audio" ), py::arg( "cache" ) )
+        .def( "GetWindow", &PyFastWavelet::GetWindow )
+        .def( "GetCQTCoeffs", &PyFastWavelet::GetCQTCoeffs )
+        .def( "GetFFTSize", &PyFastWavelet::GetFFTSize )
+        .def( "GetAlgorithmicLatency", &PyFastWavelet::GetAlgorithmicLatency )
+        .def( "GetBufferedSamples", &PyFastWavelet::GetBufferedSamples )
+        .def( "GetStats", &PyFastWavelet::GetStats )
+        .def( "ResetStats", &PyFastWavelet::ResetStats )
+        .def( "TransformBatch", &PyFastWavelet::TransformBatch, py::arg( "clips" ), py::arg( "lengths" ) = py::none() );
+    
+    py::class_<FrameStoreWriter>(m, "FrameStoreWriter")
+        .def( "__init__", &py_wrapped_ctor< FrameStoreWriter, const std::string&, size_t, size_t, const std::vector<float>& >,
+              py::arg( "path" ), py::arg( "fft_size" ), py::arg( "hop" ), py::arg( "window" ) )
+        .def( "BeginClip", &FrameStoreWriter::BeginClip )
+        .def( "WriteFrames", &frame_store_write_frames )
+        .def( "EndClip", &FrameStoreWriter::EndClip )
+        .def( "Flush", &FrameStoreWriter::Flush )
+        .def( "GetFFTSize", &FrameStoreWriter::GetFFTSize )
+        .def( "GetHop", &FrameStoreWriter::GetHop )
+        .def( "GetNumBins", &FrameStoreWriter::GetNumBins )
+        .def( "GetWindowLength", &FrameStoreWriter::GetWindowLength )
+        .def( "GetWindowHash", &FrameStoreWriter::GetWindowHash )
+        .def( "GetNumClips", &FrameStoreWriter::GetNumClips )
+        .def( "IsClipOpen", &FrameStoreWriter::IsClipOpen );
+    
+    py::class_<FrameStoreReader, std::shared_ptr<FrameStoreReader>>(m, "FrameStoreReader")
+        .def( "__init__", &py_wrapped_ctor< FrameStoreReader, const std::string& >, py::arg( "path" ) )
+        .def( "GetNumClips", &FrameStoreReader::GetNumClips )
+        .def( "GetClipName", &FrameStoreReader::GetClipName )
+        .def( "GetNumFrames", &FrameStoreReader::GetNumFrames )
+        .def( "GetFrames", &frame_store_get_frames, py::arg( "clip" ), py::arg( "start" ) = 0, py::arg( "stop" ) = py::none() )
+        .def( "FindClip", &FrameStoreReader::FindClip )
+        .def( "GetFFTSize", &FrameStoreReader::GetFFTSize )
+        .def( "GetHop", &FrameStoreReader::GetHop )
+        .def( "GetNumBins", &FrameStoreReader::GetNumBins )
+        .def( "GetWindowLength", &FrameStoreReader::GetWindowLength )
+        .def( "GetWindowHash", &FrameStoreReader::GetWindowHash );
+    
+    py::class_<TransformCache>(m, "TransformCache")
+        .def( "__init__", &py_wrapped_ctor< TransformCache, const std::string&, uint64_t >, py::arg( "directory" ), py::arg( "max_bytes" ) )
+        .def( "Evict", &TransformCache::Evict )
+        .def( "GetMaxBytes", &TransformCache::GetMaxBytes )
+        .def( "GetNumHits", &TransformCache::GetNumHits )
+        .def( "GetNumMisses", &TransformCache::GetNumMisses )
+        .def( "GetSizeBytes", &TransformCache::GetSizeBytes );
 
     return m.ptr();
 };
\ No newline at end of file
@@ -0,0 +1,524 @@
+//
+// Created: 10/18/26 by agent
+//
+// Runtime selection between the compiled FFT sizes of FastWavelet for the python binding.
+//
+
+#ifndef CUPCAKE_FAST_WAVELET_REGISTRY_H
+#define CUPCAKE_FAST_WAVELET_REGISTRY_H
+
+// In module includes.
+#include "FastWavelet.h"
+#include "PybindArgumentConversion.h"
+#include "FrameStore.h"
+#include "FrameStoreBinding.h"
+#include "TransformCache.h"
+
+// Third party includes.
+#include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
+
+// Std lib includes.
+#include <vector>
+#include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include <utility>
+
+namespace py = pybind11;
+
+namespace cupcake
+{
+
+typedef py::array_t<float, py::array::c_style | py::array::forcecast> py_float_array;
+
+template< size_t FFT_SIZE >
+py::array_t<std::complex<float>> transform_batch( FastWavelet<FFT_SIZE>* self, py_float_array& clips, py::object& lengths )
+///
+/// Python entry point for FastWavelet::TransformBatch. The output array is allocated up front, while
+/// holding the GIL, and is then filled in place with the GIL released and the instance locked.
+///
+/// @param self
+///  The object whose window and coefficients are used for all clips.
+///
+/// @param clips
+///  A 2D array with one clip per row.
+///
+/// @param lengths
+///  None, or a 1D integer array with the number of valid samples in each row of clips.
+///
+/// @return
+///  A 3D complex array indexed by clip, frame and frequency bin.
+///
+{
+    if (clips.ndim() != 2)
+        throw std::runtime_error("Number of dimensions must be two");
+
+    const size_t num_clips = static_cast<size_t>( clips.shape( 0 ) );
+    const size_t clip_stride = static_cast<size_t>( clips.shape( 1 ) );
+
+    // Lengths are read as signed integers, so that negative lengths are rejected rather than wrapping around.
+    std::vector<size_t> clip_lengths;
+    if( !lengths.is_none() )
+    {
+        auto signed_lengths = lengths.cast<py::array_t<int64_t, py::array::c_style | py::array::forcecast>>();
+        if (signed_lengths.ndim() != 1 || static_cast<size_t>( signed_lengths.shape( 0 ) ) != num_clips)
+            throw std::runtime_error("There must be one length per clip");
+        
+        const int64_t* signed_data = signed_lengths.data();
+        clip_lengths.reserve( num_clips );
+        for( size_t clip=0; clip<num_clips; ++clip )
+        {
+            if( signed_data[clip] < 0 )
+                throw std::invalid_argument("Clip lengths must not be negative");
+            clip_lengths.push_back( static_cast<size_t>( signed_data[clip] ) );
+        }
+    }
+
+    const size_t num_frames = self->GetNumFrames( clip_stride );
+    std::vector<size_t> shape = { num_clips, num_frames, FastWavelet<FFT_SIZE>::mOutputSize };
+    py::array_t<std::complex<float>> ret( shape );
+
+    const float* clips_data = clips.data();
+    const size_t* lengths_data = lengths.is_none() ? nullptr : clip_lengths.data();
+    std::complex<float>* output = ret.mutable_data();
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( self->GetMutex() );
+        self->TransformBatch( clips_data, num_clips, clip_stride, lengths_data, output, num_frames );
+    }
+
+    return ret;
+}
+
+inline BinRangeMethod parse_bin_range_method( const std::string& method )
+///
+/// Converts the name of a way of computing a range of bins, as given in python, to a BinRangeMethod.
+///
+/// @param method
+///  One of "auto", "fft" or "dft".
+///
+/// @return
+///  The method.
+///
+{
+    if( method == "auto" )
+        return BIN_RANGE_AUTOMATIC;
+    if( method == "fft" )
+        return BIN_RANGE_FFT;
+    if( method == "dft" )
+        return BIN_RANGE_PRUNED_DFT;
+    throw std::invalid_argument( "The method must be one of 'auto', 'fft' or 'dft'" );
+}
+
+
+//
+// Type erasure
+//
+
+class AnyFastWavelet
+///
+/// The python facing interface of a FastWavelet of any FFT size. Arguments and return values are
+/// python types, as the shape of the output frames depends on the FFT size.
+///
+{
+public:
+    virtual ~AnyFastWavelet() = default;
+
+    virtual py::array_t<std::complex<float>> PushSamples( py_float_array& audio ) = 0;
+    virtual void ConfigureParallel( size_t num_threads ) = 0;
+    virtual py::array_t<std::complex<float>> PushSamplesParallel( py_float_array& audio ) = 0;
+    virtual py::array_t<std::complex<float>> TransformBatch( py_float_array& clips, py::object& lengths ) = 0;
+    virtual void ConfigureFeatures( float sample_rate, size_t num_bands, float min_frequency, float tuning ) = 0;
+    virtual py::dict PushSamplesFeatures( py_float_array& audio ) = 0;
+    virtual void ConfigureOnsets( float sample_rate, float delta, size_t wait, size_t pre_max, size_t post_max, size_t pre_avg, size_t post_avg ) = 0;
+    virtual py::dict PushSamplesOnsets( py_float_array& audio ) = 0;
+    virtual py::dict FlushOnsets() = 0;
+    virtual void ConfigureOctaves( size_t num_octaves ) = 0;
+    virtual py::array_t<std::complex<float>> PushSamplesOctaves( py_float_array& audio ) = 0;
+    virtual py::array_t<float> GetOctaveFrequencies( float sample_rate ) = 0;
+    virtual size_t GetOctaveLatency() = 0;
+    virtual size_t GetOctaveBufferedSamples() = 0;
+    virtual void ConfigureExact( float sample_rate, float min_frequency, size_t bins_per_octave, size_t num_bins, float threshold ) = 0;
+    virtual py::array_t<std::complex<float>> PushSamplesExact( py_float_array& audio ) = 0;
+    virtual py::array_t<float> GetExactFrequencies() = 0;
+    virtual void ConfigureDecimation( size_t min_hops_per_window ) = 0;
+    virtual py::list PushSamplesDecimated( py_float_array& audio ) = 0;
+    virtual void ConfigureBinRange( size_t min_bin, size_t max_bin, float tolerance, BinRangeMethod method ) = 0;
+    virtual py::array_t<std::complex<float>> PushSamplesBinRange( py_float_array& audio ) = 0;
+    virtual size_t PushSamplesToStore( py_float_array& audio, FrameStoreWriter& store ) = 0;
+    virtual py::array_t<std::complex<float>> TransformCached( py_float_array& audio, TransformCache& cache ) = 0;
+    virtual size_t GetAlgorithmicLatency() = 0;
+    virtual size_t GetBufferedSamples() = 0;
+    virtual py::array_t<float> GetWindow() = 0;
+    virtual py::array_t<std::complex<float>> GetCQTCoeffs() = 0;
+    virtual py::dict GetStats() = 0;
+    virtual void ResetStats() = 0;
+};
+
+template< size_t FFT_SIZE >
+class AnyFastWaveletImpl : public AnyFastWavelet
+///
+/// Implements the python facing interface for a single FFT size. Each method goes through the same
+/// wrapping as a directly bound method, so the GIL is released and the instance locked in the same way.
+///
+{
+public:
+    AnyFastWaveletImpl( float overlap, const std::vector<float>& window ) :
+        mInstance( overlap, window )
+    ///
+    /// Constructor.
+    ///
+    /// @param overlap
+    ///  The overlap of successive STFT windows as a fraction of windowing length.
+    ///
+    /// @param window
+    ///  The windowing function of the STFT operation.
+    ///
+    {
+    }
+
+    py::array_t<std::complex<float>> PushSamples( py_float_array& audio ) override
+    {
+        return PushSamplesToArray( audio, &FastWavelet<FFT_SIZE>::PushSamplesInto );
+    }
+
+    void ConfigureParallel( size_t num_threads ) override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        mInstance.ConfigureParallel( num_threads );
+    }
+
+    py::array_t<std::complex<float>> PushSamplesParallel( py_float_array& audio ) override
+    {
+        return PushSamplesToArray( audio, &FastWavelet<FFT_SIZE>::PushSamplesParallelInto );
+    }
+
+    py::array_t<std::complex<float>> TransformBatch( py_float_array& clips, py::object& lengths ) override
+    {
+        return transform_batch( &mInstance, clips, lengths );
+    }
+
+    void ConfigureFeatures( float sample_rate, size_t num_bands, float min_frequency, float tuning ) override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        mInstance.ConfigureFeatures( sample_rate, num_bands, min_frequency, tuning );
+    }
+
+    py::dict PushSamplesFeatures( py_float_array& audio ) override
+    {
+        return py_wrapped_func< ArrayView<const float> >( &FastWavelet<FFT_SIZE>::PushSamplesFeatures )( &mInstance, audio );
+    }
+
+    void ConfigureOnsets( float sample_rate, float delta, size_t wait, size_t pre_max, size_t post_max, size_t pre_avg, size_t post_avg ) override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        mInstance.ConfigureOnsets( sample_rate, delta, wait, pre_max, post_max, pre_avg, post_avg );
+    }
+
+    py::dict PushSamplesOnsets( py_float_array& audio ) override
+    {
+        return py_wrapped_func< ArrayView<const float> >( &FastWavelet<FFT_SIZE>::PushSamplesOnsets )( &mInstance, audio );
+    }
+
+    py::dict FlushOnsets() override
+    {
+        return py_wrapped_func( &FastWavelet<FFT_SIZE>::FlushOnsets )( &mInstance );
+    }
+
+    void ConfigureOctaves( size_t num_octaves ) override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        mInstance.ConfigureOctaves( num_octaves );
+    }
+
+    py::array_t<std::complex<float>> PushSamplesOctaves( py_float_array& audio ) override
+    {
+        return py_wrapped_func< ArrayView<const float> >( &FastWavelet<FFT_SIZE>::PushSamplesOctaves )( &mInstance, audio );
+    }
+
+    py::array_t<float> GetOctaveFrequencies( float sample_rate ) override
+    {
+        return py_wrapped_func( &FastWavelet<FFT_SIZE>::GetOctaveFrequencies )( &mInstance, sample_rate );
+    }
+
+    size_t GetOctaveLatency() override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        return mInstance.GetOctaveLatency();
+    }
+
+    size_t GetOctaveBufferedSamples() override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        return mInstance.GetOctaveBufferedSamples();
+    }
+
+    void ConfigureExact( float sample_rate, float min_frequency, size_t bins_per_octave, size_t num_bins, float threshold ) override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        mInstance.ConfigureExact( sample_rate, min_frequency, bins_per_octave, num_bins, threshold );
+    }
+
+    py::array_t<std::complex<float>> PushSamplesExact( py_float_array& audio ) override
+    {
+        return py_wrapped_func< ArrayView<const float> >( &FastWavelet<FFT_SIZE>::PushSamplesExact )( &mInstance, audio );
+    }
+
+    py::array_t<float> GetExactFrequencies() override
+    {
+        return py_wrapped_func( &FastWavelet<FFT_SIZE>::GetExactFrequencies )( &mInstance );
+    }
+
+    void ConfigureDecimation( size_t min_hops_per_window ) override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        mInstance.ConfigureDecimation( min_hops_per_window );
+    }
+
+    py::list PushSamplesDecimated( py_float_array& audio ) override
+    {
+        return py_wrapped_func< ArrayView<const float> >( &FastWavelet<FFT_SIZE>::PushSamplesDecimated )( &mInstance, audio );
+    }
+
+    void ConfigureBinRange( size_t min_bin, size_t max_bin, float tolerance, BinRangeMethod method ) override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        mInstance.ConfigureBinRange( min_bin, max_bin, tolerance, method );
+    }
+
+    py::array_t<std::complex<float>> PushSamplesBinRange( py_float_array& audio ) override
+    {
+        return py_wrapped_func< ArrayView<const float> >( &FastWavelet<FFT_SIZE>::PushSamplesBinRange )( &mInstance, audio );
+    }
+
+    size_t PushSamplesToStore( py_float_array& audio, FrameStoreWriter& store ) override
+    {
+        ArrayView<const float> samples = convert_arg<ArrayView<const float>>( std::move( audio ) );
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        return mInstance.PushSamplesToStore( samples, store );
+    }
+
+    py::array_t<std::complex<float>> TransformCached( py_float_array& audio, TransformCache& cache ) override
+    {
+        ArrayView<const float> samples = convert_arg<ArrayView<const float>>( std::move( audio ) );
+        std::shared_ptr<FrameStoreReader> reader;
+        {
+            py::gil_scoped_release release;
+            reader = cache.Transform( mInstance, samples );
+        }
+        return frame_store_get_frames( py::cast( reader ), 0, 0, py::none() );
+    }
+
+    size_t GetAlgorithmicLatency() override
+    {
+        return mInstance.GetAlgorithmicLatency();
+    }
+
+    size_t GetBufferedSamples() override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        return mInstance.GetBufferedSamples();
+    }
+
+    py::array_t<float> GetWindow() override
+    {
+        return py_wrapped_func( &FastWavelet<FFT_SIZE>::GetWindow )( &mInstance );
+    }
+
+    py::array_t<std::complex<float>> GetCQTCoeffs() override
+    {
+        return py_wrapped_func( &FastWavelet<FFT_SIZE>::GetCQTCoeffs )( &mInstance );
+    }
+
+    py::dict GetStats() override
+    {
+        return py_wrapped_func( &FastWavelet<FFT_SIZE>::GetStats )( &mInstance );
+    }
+
+    void ResetStats() override
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+        mInstance.ResetStats();
+    }
+
+private:
+
+    //
+    // Mechanics
+    //
+    FastWavelet<FFT_SIZE> mInstance;
+
+    //
+    // Helpers
+    //
+    typedef size_t (FastWavelet<FFT_SIZE>::*push_into_type)( ArrayView<const float>, typename FastWavelet<FFT_SIZE>::Frame* );
+
+    py::array_t<std::complex<float>> PushSamplesToArray( py_float_array& audio, push_into_type push )
+    ///
+    /// Pushes samples with PushSamplesInto or PushSamplesParallelInto, analysing them straight into
+    /// a vector of exactly this call's frames, which the returned array then owns. So the frames are
+    /// never copied, and no output buffer is kept or re-reserved between calls.
+    ///
+    /// @param audio
+    ///  The samples to be pushed.
+    ///
+    /// @param push
+    ///  The method that analyses the samples into the vector.
+    ///
+    /// @return
+    ///  A 2D complex array indexed by frame and frequency bin.
+    ///
+    {
+        ArrayView<const float> samples = convert_arg<ArrayView<const float>>( std::move( audio ) );
+        std::unique_ptr<typename FastWavelet<FFT_SIZE>::FrameBuffer> frames;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock( mInstance.GetMutex() );
+            frames.reset( new typename FastWavelet<FFT_SIZE>::FrameBuffer( mInstance.GetNumPushFrames( samples.size() ) ) );
+            (mInstance.*push)( samples, frames->data() );
+        }
+        return owning_frames( frames );
+    }
+};
+
+
+//
+// Registry
+//
+
+template< size_t FFT_SIZE >
+std::unique_ptr<AnyFastWavelet> make_any_fast_wavelet( float overlap, const std::vector<float>& window )
+///
+/// Factory for a single FFT size, as stored in the registry.
+///
+{
+    return std::unique_ptr<AnyFastWavelet>( new AnyFastWaveletImpl<FFT_SIZE>( overlap, window ) );
+}
+
+template< size_t... FFT_SIZES >
+std::unique_ptr<AnyFastWavelet> make_any_fast_wavelet( size_t fft_size, float overlap, const std::vector<float>& window, std::index_sequence<FFT_SIZES...> )
+///
+/// Looks up the specialization of FastWavelet for an FFT size and constructs it.
+///
+/// @param fft_size
+///  The FFT size, which must be one of FFT_SIZES and no smaller than the window.
+///
+/// @param overlap
+///  The overlap of successive STFT windows as a fraction of windowing length.
+///
+/// @param window
+///  The windowing function of the STFT operation.
+///
+/// @return
+///  The newly constructed FastWavelet.
+///
+{
+    typedef std::unique_ptr<AnyFastWavelet> (*factory_type)( float, const std::vector<float>& );
+    static const std::map<size_t, factory_type> registry = { { FFT_SIZES, &make_any_fast_wavelet<FFT_SIZES> }... };
+
+    auto factory = registry.find( fft_size );
+    if( factory == registry.end() )
+    {
+        std::string sizes;
+        for( auto& entry : registry )
+        {
+            sizes += ( sizes.empty() ? "" : ", " ) + std::to_string( entry.first );
+        }
+        throw std::invalid_argument( "FFT size must be one of: " + sizes );
+    }
+    if( window.size() > fft_size )
+    {
+        throw std::invalid_argument( "Window must be no longer than the FFT size" );
+    }
+
+    return factory->second( overlap, window );
+}
+
+class PyFastWavelet
+///
+/// The object bound as the python FastWavelet class. It holds a FastWavelet of the FFT size chosen
+/// at construction, so each FFT size keeps its own fully specialized processing.
+///
+{
+public:
+    PyFastWavelet( float overlap, const std::vector<float>& window, size_t fft_size ) :
+        mFFTSize( fft_size ),
+        mImpl( make_any_fast_wavelet( fft_size, overlap, window, FastWaveletFFTSizes() ) )
+    ///
+    /// Constructor.
+    ///
+    /// @param overlap
+    ///  The overlap of successive STFT windows as a fraction of windowing length.
+    ///
+    /// @param window
+    ///  The windowing function of the STFT operation.
+    ///
+    /// @param fft_size
+    ///  The FFT size, which must be one of FastWaveletFFTSizes.
+    ///
+    {
+    }
+
+    py::array_t<std::complex<float>> PushSamples( py_float_array audio ) { return mImpl->PushSamples( audio ); };
+    void ConfigureParallel( size_t num_threads ) { mImpl->ConfigureParallel( num_threads ); };
+    py::array_t<std::complex<float>> PushSamplesParallel( py_float_array audio ) { return mImpl->PushSamplesParallel( audio ); };
+    py::array_t<std::complex<float>> TransformBatch( py_float_array clips, py::object lengths ) { return mImpl->TransformBatch( clips, lengths ); };
+    void ConfigureFeatures( float sample_rate, size_t num_bands, float min_frequency, float tuning ) { mImpl->ConfigureFeatures( sample_rate, num_bands, min_frequency, tuning ); };
+    py::dict PushSamplesFeatures( py_float_array audio ) { return mImpl->PushSamplesFeatures( audio ); };
+    void ConfigureOnsets( float sample_rate, float delta, size_t wait, size_t pre_max, size_t post_max, size_t pre_avg, size_t post_avg ) { mImpl->ConfigureOnsets( sample_rate, delta, wait, pre_max, post_max, pre_avg, post_avg ); };
+    py::dict PushSamplesOnsets( py_float_array audio ) { return mImpl->PushSamplesOnsets( audio ); };
+    py::dict FlushOnsets() { return mImpl->FlushOnsets(); };
+    void ConfigureOctaves( size_t num_octaves ) { mImpl->ConfigureOctaves( num_octaves ); };
+    py::array_t<std::complex<float>> PushSamplesOctaves( py_float_array audio ) { return mImpl->PushSamplesOctaves( audio ); };
+    py::array_t<float> GetOctaveFrequencies( float sample_rate ) { return mImpl->GetOctaveFrequencies( sample_rate ); };
+    size_t GetOctaveLatency() { return mImpl->GetOctaveLatency(); };
+    size_t GetOctaveBufferedSamples() { return mImpl->GetOctaveBufferedSamples(); };
+    void ConfigureExact( float sample_rate, float min_frequency, size_t bins_per_octave, size_t num_bins, float threshold ) { mImpl->ConfigureExact( sample_rate, min_frequency, bins_per_octave, num_bins, threshold ); };
+    py::array_t<std::complex<float>> PushSamplesExact( py_float_array audio ) { return mImpl->PushSamplesExact( audio ); };
+    py::array_t<float> GetExactFrequencies() { return mImpl->GetExactFrequencies(); };
+    void ConfigureDecimation( size_t min_hops_per_window ) { mImpl->ConfigureDecimation( min_hops_per_window ); };
+    py::list PushSamplesDecimated( py_float_array audio ) { return mImpl->PushSamplesDecimated( audio ); };
+    void ConfigureBinRange( size_t min_bin, size_t max_bin, float tolerance, const std::string& method ) { mImpl->ConfigureBinRange( min_bin, max_bin, tolerance, parse_bin_range_method( method ) ); };
+    py::array_t<std::complex<float>> PushSamplesBinRange( py_float_array audio ) { return mImpl->PushSamplesBinRange( audio ); };
+    size_t PushSamplesToStore( py_float_array audio, FrameStoreWriter& store ) { return mImpl->PushSamplesToStore( audio, store ); };
+    py::array_t<std::complex<float>> TransformCached( py_float_array audio, TransformCache& cache ) { return mImpl->TransformCached( audio, cache ); };
+    size_t GetAlgorithmicLatency() { return mImpl->GetAlgorithmicLatency(); };
+    size_t GetBufferedSamples() { return mImpl->GetBufferedSamples(); };
+    py::array_t<float> GetWindow() { return mImpl->GetWindow(); };
+    py::array_t<std::complex<float>> GetCQTCoeffs() { return mImpl->GetCQTCoeffs(); };
+    py::dict GetStats() { return mImpl->GetStats(); };
+    void ResetStats() { mImpl->ResetStats(); };
+    size_t GetFFTSize() const { return mFFTSize; };
+
+private:
+
+    //
+    // Configuration
+    //
+    const size_t mFFTSize;
+
+    //
+    // Mechanics
+    //
+    std::unique_ptr<AnyFastWavelet> mImpl;
+};
+
+} // namespace cupcake
+
+#endif // CUPCAKE_FAST_WAVELET_REGISTRY_H
@@ -0,0 +1,223 @@
+//
+// Created: 10/18/26 by agent
+//
+// Decimation in time of each band of fast CQT frames, according to its effective window length.
+//
+
+#ifndef CUPCAKE_FRAME_DECIMATOR_H
+#define CUPCAKE_FRAME_DECIMATOR_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <array>
+#include <complex>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+namespace cupcake
+{
+
+struct DecimatedBand
+///
+/// The frames of one band, i.e., a run of bins sharing a decimation factor, from one call to
+/// FrameDecimator.
+///
+{
+    size_t first_bin = 0;
+    size_t num_bins = 0;
+    size_t decimation = 1;                          // Full rate frames per frame of this band.
+    uint64_t first_frame = 0;                       // The index of the first frame below, in frames of this band.
+    size_t num_frames = 0;
+    std::vector< std::complex< float > > values;    // num_frames x num_bins.
+};
+
+struct DecimatedFrames
+///
+/// The multi-rate output of one call to FrameDecimator, with one entry per band from low to high
+/// frequency.
+///
+{
+    std::vector< DecimatedBand > bands;
+};
+
+template< size_t FFT_SIZE >
+class FrameDecimator
+///
+/// Keeps fewer frames of the bins whose effective window is long.
+///
+/// A bin whose effective window is L samples long (see FastCQT::GetEffectiveWindowLengths) varies
+/// over time about as quickly as an STFT with an L sample window, and so needs min_hops_per_window
+/// frames per L samples rather than one per hop. Each bin keeps one frame in every D, where D is the
+/// largest power of two giving a hop of no more than L/min_hops_per_window samples. Adjacent bins
+/// with the same D are grouped into a band, and frame j of a band with decimation D is frame j*D of
+/// the full rate stream. As frames are subsampled without filtering, min_hops_per_window should be
+/// enough for the window, e.g., 4 for the 4 bin wide main lobe of a Hann or Hamming window.
+///
+/// The frames to keep are counted from the start of the stream, so the output of a stream does not
+/// depend on how it is divided into calls to Process.
+///
+{
+
+public:
+
+    static const size_t mFrameSize = veclib::get_output_FFT_size( FFT_SIZE );
+
+    typedef std::array< std::complex< float >, mFrameSize > Frame;
+
+    FrameDecimator( const std::vector< float >& window_lengths, size_t increment, size_t min_hops_per_window=DEFAULT_MIN_HOPS_PER_WINDOW );
+    ~FrameDecimator();
+
+    DecimatedFrames& Process( const Frame* frames, size_t num_frames );
+    void Reset();
+
+    const std::vector< size_t >& GetDecimation() const;
+    const size_t GetNumBands() const;
+
+    //
+    // Constants
+    //
+    static const size_t DEFAULT_MIN_HOPS_PER_WINDOW = 4;
+
+private:
+
+    //
+    // Configuration
+    //
+    std::vector< size_t > mDecimation;      // The decimation factor of each bin.
+
+    //
+    // Data
+    //
+    uint64_t mNumFrames;                    // Full rate frames processed so far.
+    DecimatedFrames mOutput;
+
+};
+
+template< size_t FFT_SIZE >
+const size_t FrameDecimator< FFT_SIZE >::mFrameSize;
+
+template< size_t FFT_SIZE >
+const size_t FrameDecimator< FFT_SIZE >::DEFAULT_MIN_HOPS_PER_WINDOW;
+
+template< size_t FFT_SIZE >
+FrameDecimator< FFT_SIZE >::FrameDecimator( const std::vector< float >& window_lengths, size_t increment, size_t min_hops_per_window ) :
+    mDecimation( mFrameSize, 1 ),
+    mNumFrames( 0 )
+///
+/// Constructor. Chooses the decimation of each bin and groups the bins into bands.
+///
+/// @param window_lengths
+///  The effective window length of each bin in samples, as given by FastCQT::GetEffectiveWindowLengths.
+///
+/// @param increment
+///  The number of samples between successive full rate frames.
+///
+/// @param min_hops_per_window
+///  The number of frames to keep within each effective window.
+///
+{
+    if( window_lengths.size() != mFrameSize )
+    {
+        throw std::invalid_argument( "There must be one window length for each bin" );
+    }
+    if( increment == 0 || min_hops_per_window == 0 )
+    {
+        throw std::invalid_argument( "The increment and the hops per window must be non-zero" );
+    }
+
+    for( size_t bin=0; bin<mFrameSize; ++bin )
+    {
+        while( 2*mDecimation[bin]*increment*min_hops_per_window <= window_lengths[bin] )
+        {
+            mDecimation[bin] *= 2;
+        }
+        if( bin == 0 || mDecimation[bin] != mDecimation[bin-1] )
+        {
+            mOutput.bands.emplace_back();
+            mOutput.bands.back().first_bin = bin;
+            mOutput.bands.back().decimation = mDecimation[bin];
+        }
+        ++mOutput.bands.back().num_bins;
+    }
+}
+
+template< size_t FFT_SIZE >
+FrameDecimator< FFT_SIZE >::~FrameDecimator() = default;
+
+template< size_t FFT_SIZE >
+DecimatedFrames& FrameDecimator< FFT_SIZE >::Process( const Frame* frames, size_t num_frames )
+///
+/// Decimate the next frames of the stream.
+///
+/// @param frames
+///  The full rate frames.
+///
+/// @param num_frames
+///  The number of frames.
+///
+/// @return
+///  The frames kept from each band, valid until the next call.
+///
+{
+    for( DecimatedBand& band : mOutput.bands )
+    {
+        // The first frame at or after mNumFrames that is a multiple of the decimation.
+        const uint64_t next = ( mNumFrames + band.decimation - 1 )/band.decimation;
+        const uint64_t end = ( mNumFrames + num_frames + band.decimation - 1 )/band.decimation;
+        band.first_frame = next;
+        band.num_frames = static_cast< size_t >( end - next );
+        band.values.resize( band.num_frames*band.num_bins );
+        for( size_t frame=0; frame<band.num_frames; ++frame )
+        {
+            const auto& input = frames[( next + frame )*band.decimation - mNumFrames];
+            std::copy( input.begin() + band.first_bin, input.begin() + band.first_bin + band.num_bins, band.values.begin() + frame*band.num_bins );
+        }
+    }
+    mNumFrames += num_frames;
+
+    return mOutput;
+}
+
+template< size_t FFT_SIZE >
+void FrameDecimator< FFT_SIZE >::Reset()
+///
+/// Starts a new stream, so that the next frame processed is kept by every band.
+///
+{
+    mNumFrames = 0;
+}
+
+template< size_t FFT_SIZE >
+const std::vector< size_t >& FrameDecimator< FFT_SIZE >::GetDecimation() const
+///
+/// Get the decimation of each bin.
+///
+/// @return
+///  The number of full rate frames per frame kept, for each bin.
+///
+{
+    return mDecimation;
+}
+
+template< size_t FFT_SIZE >
+const size_t FrameDecimator< FFT_SIZE >::GetNumBands() const
+///
+/// Get the number of runs of bins that share a decimation.
+///
+/// @return
+///  The number of bands in each output.
+///
+{
+    return mOutput.bands.size();
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_FRAME_DECIMATOR_H
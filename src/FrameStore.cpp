@@ -0,0 +1,664 @@
+//
+// Created: 10/18/26 by agent
+//
+// An append-only, memory-mappable file of transform frames, grouped into clips.
+//
+
+// In module includes
+#include "FrameStore.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <stdexcept>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+using namespace cupcake;
+
+namespace
+{
+
+uint64_t align_offset( uint64_t offset )
+{
+    return ( offset + FRAME_STORE_ALIGNMENT - 1 )/FRAME_STORE_ALIGNMENT*FRAME_STORE_ALIGNMENT;
+}
+
+std::runtime_error file_error( const std::string& what, const std::string& path )
+{
+    return std::runtime_error( what + " '" + path + "': " + std::strerror( errno ) );
+}
+
+void check_header( const FrameStoreHeader& header, const std::string& path )
+///
+/// Throws if a header is not that of a frame store this code can read.
+///
+{
+    if( std::memcmp( header.magic, FRAME_STORE_MAGIC, sizeof( FRAME_STORE_MAGIC ) ) != 0 )
+    {
+        throw std::runtime_error( "Not a frame store: '" + path + "'" );
+    }
+    if( header.version != FRAME_STORE_VERSION || header.layout != FRAME_STORE_LAYOUT_COMPLEX64 )
+    {
+        throw std::runtime_error( "Unsupported frame store version or layout: '" + path + "'" );
+    }
+}
+
+template< typename read_type, typename clip_type >
+uint64_t scan_clips( uint64_t file_size, const FrameStoreHeader& header, const std::string& path, read_type read, clip_type on_clip )
+///
+/// Walks the clips of a frame store, stopping at the first unfinished clip.
+///
+/// @param file_size
+///  The size of the file.
+///
+/// @param header
+///  The header of the file, already checked.
+///
+/// @param path
+///  The path of the file, for errors.
+///
+/// @param read
+///  Reads bytes from the file: read( destination, num_bytes, offset ).
+///
+/// @param on_clip
+///  Called with the name, offset of the frames and number of frames of each finished clip.
+///
+/// @return
+///  The offset just past the last finished clip.
+///
+{
+    const uint64_t frame_bytes = header.num_bins*sizeof( std::complex< float > );
+    if( frame_bytes == 0 )
+    {
+        throw std::runtime_error( "Corrupt frame store: '" + path + "'" );
+    }
+
+    uint64_t offset = FRAME_STORE_HEADER_SIZE;
+    while( offset + sizeof( FrameStoreClipHeader ) <= file_size )
+    {
+        FrameStoreClipHeader clip;
+        read( &clip, sizeof( clip ), offset );
+        if( clip.magic != FRAME_STORE_CLIP_MAGIC )
+        {
+            throw std::runtime_error( "Corrupt frame store: '" + path + "'" );
+        }
+        if( clip.num_frames == FRAME_STORE_OPEN_CLIP )
+        {
+            break;
+        }
+
+        // The frame count is compared by division, so that a corrupt count cannot overflow past the check.
+        const uint64_t frames_offset = align_offset( offset + sizeof( clip ) + clip.name_length );
+        if( frames_offset > file_size || clip.num_frames > ( file_size - frames_offset )/frame_bytes )
+        {
+            throw std::runtime_error( "Truncated frame store: '" + path + "'" );
+        }
+        const uint64_t end = align_offset( frames_offset + clip.num_frames*frame_bytes );
+
+        std::string name( clip.name_length, '\0' );
+        read( &name[0], clip.name_length, offset + sizeof( clip ) );
+        on_clip( name, frames_offset, clip.num_frames );
+        offset = end;
+    }
+    return offset;
+}
+
+} // namespace
+
+uint64_t cupcake::hash_window( const std::vector< float >& window )
+///
+/// Hashes the samples of a window, so that frames computed with different windows can be told
+/// apart without storing the window itself. This is 64 bit FNV-1a over the bytes of the samples.
+///
+/// @param window
+///  The analysis window.
+///
+/// @return
+///  The hash of the window.
+///
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    const unsigned char* bytes = reinterpret_cast< const unsigned char* >( window.data() );
+    for( size_t byte=0; byte<window.size()*sizeof( float ); ++byte )
+    {
+        hash = ( hash ^ bytes[byte] )*0x100000001b3ull;
+    }
+    return hash;
+}
+
+
+//
+// Writer
+//
+
+FrameStoreWriter::FrameStoreWriter( const std::string& path, size_t fft_size, size_t hop, const std::vector< float >& window ) :
+    mFrameBytes( ( fft_size/2 + 1 )*sizeof( std::complex< float > ) ),
+    mFile( -1 ),
+    mEnd( FRAME_STORE_HEADER_SIZE ),
+    mClipStart( 0 ),
+    mFramesStart( 0 ),
+    mClipFrames( 0 ),
+    mNumClips( 0 ),
+    mClipOpen( false )
+///
+/// Constructor. Opens a frame store for appending, creating it if it does not exist.
+///
+/// @param path
+///  The path of the file.
+///
+/// @param fft_size
+///  The FFT size of the frames.
+///
+/// @param hop
+///  The number of samples between successive frames.
+///
+/// @param window
+///  The analysis window. An existing store must have been written with the same FFT size, hop
+///  and window, otherwise this throws std::runtime_error, as it does for any error opening the file.
+///
+{
+    std::memset( &mHeader, 0, sizeof( mHeader ) );
+    std::memcpy( mHeader.magic, FRAME_STORE_MAGIC, sizeof( FRAME_STORE_MAGIC ) );
+    mHeader.version = FRAME_STORE_VERSION;
+    mHeader.layout = FRAME_STORE_LAYOUT_COMPLEX64;
+    mHeader.fft_size = fft_size;
+    mHeader.hop = hop;
+    mHeader.num_bins = fft_size/2 + 1;
+    mHeader.window_length = window.size();
+    mHeader.window_hash = hash_window( window );
+
+    mFile = open( path.c_str(), O_RDWR | O_CREAT, 0644 );
+    if( mFile < 0 )
+    {
+        throw file_error( "Could not open frame store", path );
+    }
+
+    try
+    {
+        // The lock is taken before anything is read, as opening drops any unfinished clip, which
+        // would otherwise truncate a clip another writer is still writing.
+        if( flock( mFile, LOCK_EX | LOCK_NB ) != 0 )
+        {
+            throw errno == EWOULDBLOCK ? std::runtime_error( "Frame store is already open for writing: '" + path + "'" )
+                                       : file_error( "Could not lock frame store", path );
+        }
+
+        struct stat info;
+        if( fstat( mFile, &info ) != 0 )
+        {
+            throw file_error( "Could not read frame store", path );
+        }
+        const uint64_t file_size = static_cast< uint64_t >( info.st_size );
+
+        if( file_size == 0 )
+        {
+            std::vector< char > header( FRAME_STORE_HEADER_SIZE, 0 );
+            std::memcpy( header.data(), &mHeader, sizeof( mHeader ) );
+            WriteAt( header.data(), header.size(), 0 );
+        }
+        else
+        {
+            FrameStoreHeader existing;
+            if( file_size < FRAME_STORE_HEADER_SIZE || pread( mFile, &existing, sizeof( existing ), 0 ) != sizeof( existing ) )
+            {
+                throw std::runtime_error( "Not a frame store: '" + path + "'" );
+            }
+            check_header( existing, path );
+            if( existing.fft_size != mHeader.fft_size || existing.hop != mHeader.hop ||
+                existing.window_length != mHeader.window_length || existing.window_hash != mHeader.window_hash )
+            {
+                throw std::runtime_error( "Frame store was written with a different transform: '" + path + "'" );
+            }
+
+            auto read = [this, &path]( void* data, size_t num_bytes, uint64_t offset )
+            {
+                if( pread( mFile, data, num_bytes, static_cast< off_t >( offset ) ) != static_cast< ssize_t >( num_bytes ) )
+                {
+                    throw file_error( "Could not read frame store", path );
+                }
+            };
+            mEnd = scan_clips( file_size, mHeader, path, read, [this]( const std::string&, uint64_t, uint64_t ){ ++mNumClips; } );
+
+            // Drop any unfinished clip, along with the padding after the last clip.
+            if( ftruncate( mFile, static_cast< off_t >( mEnd ) ) != 0 )
+            {
+                throw file_error( "Could not truncate frame store", path );
+            }
+        }
+    }
+    catch( ... )
+    {
+        close( mFile );
+        throw;
+    }
+}
+
+FrameStoreWriter::~FrameStoreWriter()
+///
+/// Destructor. Finishes any open clip and closes the file.
+///
+{
+    if( mClipOpen )
+    {
+        try
+        {
+            EndClip();
+        }
+        catch( ... )
+        {
+            // The clip is left unfinished, so readers ignore it.
+        }
+    }
+    close( mFile );
+}
+
+size_t FrameStoreWriter::BeginClip( const std::string& name )
+///
+/// Starts a new clip at the end of the store. Frames written until EndClip belong to this clip.
+///
+/// @param name
+///  The name of the clip, used to find it when reading.
+///
+/// @return
+///  The index of the clip.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    if( mClipOpen )
+    {
+        throw std::logic_error( "A clip is already open" );
+    }
+
+    FrameStoreClipHeader clip;
+    clip.magic = FRAME_STORE_CLIP_MAGIC;
+    clip.name_length = static_cast< uint32_t >( name.size() );
+    clip.num_frames = FRAME_STORE_OPEN_CLIP;
+
+    mClipStart = mEnd;
+    mFramesStart = align_offset( mClipStart + sizeof( clip ) + name.size() );
+
+    std::vector< char > header( mFramesStart - mClipStart, 0 );
+    std::memcpy( header.data(), &clip, sizeof( clip ) );
+    std::memcpy( header.data() + sizeof( clip ), name.data(), name.size() );
+    WriteAt( header.data(), header.size(), mClipStart );
+
+    mClipFrames = 0;
+    mClipOpen = true;
+    return mNumClips;
+}
+
+void FrameStoreWriter::WriteFrames( const std::complex< float >* frames, size_t num_frames )
+///
+/// Appends frames to the open clip.
+///
+/// @param frames
+///  num_frames x GetNumBins() complex values, frame after frame.
+///
+/// @param num_frames
+///  The number of frames.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    if( !mClipOpen )
+    {
+        throw std::logic_error( "No clip is open" );
+    }
+
+    WriteAt( frames, num_frames*mFrameBytes, mFramesStart + mClipFrames*mFrameBytes );
+    mClipFrames += num_frames;
+}
+
+void FrameStoreWriter::EndClip()
+///
+/// Finishes the open clip, making it visible to readers opened from now on. The clip's frames are
+/// flushed to the disk first, though the clip only survives a power loss once Flush is called.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    if( !mClipOpen )
+    {
+        throw std::logic_error( "No clip is open" );
+    }
+
+    // Pad the clip so that the next one is aligned, then fill in its frame count. The frames reach
+    // the disk before the count is written, so that after a power loss the count never describes
+    // frames that were lost.
+    const uint64_t frames_end = mFramesStart + mClipFrames*mFrameBytes;
+    const uint64_t end = align_offset( frames_end );
+    if( end > frames_end )
+    {
+        const char padding[FRAME_STORE_ALIGNMENT] = {};
+        WriteAt( padding, end - frames_end, frames_end );
+    }
+    Sync();
+    WriteAt( &mClipFrames, sizeof( mClipFrames ), mClipStart + offsetof( FrameStoreClipHeader, num_frames ) );
+
+    mEnd = end;
+    mClipOpen = false;
+    ++mNumClips;
+}
+
+void FrameStoreWriter::Flush()
+///
+/// Waits for everything written so far to reach the disk.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    Sync();
+}
+
+const size_t FrameStoreWriter::GetFFTSize() const
+///
+/// @return
+///  The FFT size of the stored frames.
+///
+{
+    return mHeader.fft_size;
+}
+
+const size_t FrameStoreWriter::GetHop() const
+///
+/// @return
+///  The number of samples between successive frames.
+///
+{
+    return mHeader.hop;
+}
+
+const size_t FrameStoreWriter::GetWindowLength() const
+///
+/// @return
+///  The length of the analysis window.
+///
+{
+    return mHeader.window_length;
+}
+
+const uint64_t FrameStoreWriter::GetWindowHash() const
+///
+/// @return
+///  The hash of the analysis window, as given by hash_window.
+///
+{
+    return mHeader.window_hash;
+}
+
+const size_t FrameStoreWriter::GetNumBins() const
+///
+/// Get the number of complex values in each frame.
+///
+/// @return
+///  The number of frequency bins.
+///
+{
+    return mHeader.num_bins;
+}
+
+const size_t FrameStoreWriter::GetNumClips() const
+///
+/// Get the number of finished clips in the store.
+///
+/// @return
+///  The number of clips.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mNumClips;
+}
+
+const bool FrameStoreWriter::IsClipOpen() const
+///
+/// Get whether a clip has been begun and not yet ended.
+///
+/// @return
+///  Whether a clip is open.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mClipOpen;
+}
+
+void FrameStoreWriter::WriteAt( const void* data, size_t num_bytes, uint64_t offset )
+///
+/// Writes bytes to the file, retrying until all are written.
+///
+/// @param data
+///  The bytes to write.
+///
+/// @param num_bytes
+///  The number of bytes.
+///
+/// @param offset
+///  Where in the file to write them.
+///
+{
+    const char* bytes = static_cast< const char* >( data );
+    while( num_bytes > 0 )
+    {
+        const ssize_t written = pwrite( mFile, bytes, num_bytes, static_cast< off_t >( offset ) );
+        if( written < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            throw std::runtime_error( std::string( "Could not write frame store: " ) + std::strerror( errno ) );
+        }
+        bytes += written;
+        num_bytes -= static_cast< size_t >( written );
+        offset += static_cast< uint64_t >( written );
+    }
+}
+
+void FrameStoreWriter::Sync()
+///
+/// Waits for everything written so far to reach the disk. The caller holds mMutex.
+///
+{
+    if( fdatasync( mFile ) != 0 )
+    {
+        throw std::runtime_error( std::string( "Could not flush frame store: " ) + std::strerror( errno ) );
+    }
+}
+
+
+//
+// Reader
+//
+
+FrameStoreReader::FrameStoreReader( const std::string& path ) :
+    mData( nullptr ),
+    mSize( 0 )
+///
+/// Constructor. Maps a frame store and finds its clips.
+///
+/// @param path
+///  The path of the file. This throws std::runtime_error if it cannot be opened or is not a frame store.
+///
+{
+    const int file = open( path.c_str(), O_RDONLY );
+    if( file < 0 )
+    {
+        throw file_error( "Could not open frame store", path );
+    }
+
+    struct stat info;
+    if( fstat( file, &info ) != 0 )
+    {
+        close( file );
+        throw file_error( "Could not read frame store", path );
+    }
+    mSize = static_cast< size_t >( info.st_size );
+    if( mSize < FRAME_STORE_HEADER_SIZE )
+    {
+        close( file );
+        throw std::runtime_error( "Not a frame store: '" + path + "'" );
+    }
+
+    void* data = mmap( nullptr, mSize, PROT_READ, MAP_SHARED, file, 0 );
+    close( file );
+    if( data == MAP_FAILED )
+    {
+        throw file_error( "Could not map frame store", path );
+    }
+    mData = static_cast< const char* >( data );
+
+    try
+    {
+        std::memcpy( &mHeader, mData, sizeof( mHeader ) );
+        check_header( mHeader, path );
+
+        auto read = [this]( void* destination, size_t num_bytes, uint64_t offset ){ std::memcpy( destination, mData + offset, num_bytes ); };
+        scan_clips( mSize, mHeader, path, read, [this]( const std::string& name, uint64_t frames_offset, uint64_t num_frames )
+        {
+            mClipsByName[name] = mClips.size();
+            mClips.push_back( { name, frames_offset, num_frames } );
+        });
+    }
+    catch( ... )
+    {
+        munmap( const_cast< char* >( mData ), mSize );
+        throw;
+    }
+}
+
+FrameStoreReader::~FrameStoreReader()
+///
+/// Destructor. Unmaps the store, invalidating all frames returned.
+///
+{
+    munmap( const_cast< char* >( mData ), mSize );
+}
+
+const size_t FrameStoreReader::GetNumClips() const
+///
+/// Get the number of clips in the store.
+///
+/// @return
+///  The number of clips.
+///
+{
+    return mClips.size();
+}
+
+const std::string& FrameStoreReader::GetClipName( size_t clip ) const
+///
+/// Get the name a clip was written with.
+///
+/// @param clip
+///  The index of the clip.
+///
+/// @return
+///  The name of the clip.
+///
+{
+    return mClips.at( clip ).name;
+}
+
+const size_t FrameStoreReader::GetNumFrames( size_t clip ) const
+///
+/// Get the number of frames in a clip.
+///
+/// @param clip
+///  The index of the clip.
+///
+/// @return
+///  The number of frames.
+///
+{
+    return mClips.at( clip ).num_frames;
+}
+
+const std::complex< float >* FrameStoreReader::GetFrames( size_t clip, size_t first_frame ) const
+///
+/// Get the frames of a clip, directly from the mapping.
+///
+/// @param clip
+///  The index of the clip.
+///
+/// @param first_frame
+///  The first frame wanted, which may be at most the number of frames in the clip.
+///
+/// @return
+///  A pointer to the frames from first_frame onwards, GetNumBins() complex values per frame.
+///
+{
+    const Clip& info = mClips.at( clip );
+    if( first_frame > info.num_frames )
+    {
+        throw std::out_of_range( "Frame is beyond the end of the clip" );
+    }
+    return reinterpret_cast< const std::complex< float >* >( mData + info.frames_offset ) + first_frame*mHeader.num_bins;
+}
+
+size_t FrameStoreReader::FindClip( const std::string& name ) const
+///
+/// Finds a clip by name.
+///
+/// @param name
+///  The name of the clip. If several clips have this name, the last written is found.
+///
+/// @return
+///  The index of the clip. Throws std::out_of_range if there is no such clip.
+///
+{
+    auto clip = mClipsByName.find( name );
+    if( clip == mClipsByName.end() )
+    {
+        throw std::out_of_range( "No clip named '" + name + "'" );
+    }
+    return clip->second;
+}
+
+const size_t FrameStoreReader::GetFFTSize() const
+///
+/// @return
+///  The FFT size of the stored frames.
+///
+{
+    return mHeader.fft_size;
+}
+
+const size_t FrameStoreReader::GetHop() const
+///
+/// @return
+///  The number of samples between successive frames.
+///
+{
+    return mHeader.hop;
+}
+
+const size_t FrameStoreReader::GetNumBins() const
+///
+/// @return
+///  The number of complex values in each frame.
+///
+{
+    return mHeader.num_bins;
+}
+
+const size_t FrameStoreReader::GetWindowLength() const
+///
+/// @return
+///  The length of the analysis window.
+///
+{
+    return mHeader.window_length;
+}
+
+const uint64_t FrameStoreReader::GetWindowHash() const
+///
+/// @return
+///  The hash of the analysis window, as given by hash_window.
+///
+{
+    return mHeader.window_hash;
+}
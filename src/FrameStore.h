@@ -0,0 +1,211 @@
+//
+// Created: 10/18/26 by agent
+//
+// An append-only, memory-mappable file of transform frames, grouped into clips.
+//
+
+#ifndef CUPCAKE_FRAME_STORE_H
+#define CUPCAKE_FRAME_STORE_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+
+namespace cupcake
+{
+
+//
+// File format
+//
+// A frame store is a FrameStoreHeader, padded to FRAME_STORE_HEADER_SIZE bytes, followed by any
+// number of clips. Each clip is a FrameStoreClipHeader, the clip's name, and then the clip's frames
+// as num_frames x num_bins complex floats, starting and ending on a FRAME_STORE_ALIGNMENT boundary.
+// Clips are only ever appended, and a clip's frame count is filled in once all its frames are
+// written, so a clip that was never finished (e.g. the writer crashed) is ignored by readers and
+// overwritten by the next writer. The frames are flushed to the disk before the frame count is
+// written, so this also holds after a power loss. All values are in the byte order of the machine
+// that wrote them.
+//
+
+const char FRAME_STORE_MAGIC[8] = { 'C', 'U', 'P', 'C', 'F', 'R', 'M', 'S' };
+const uint32_t FRAME_STORE_VERSION = 1;
+const uint32_t FRAME_STORE_CLIP_MAGIC = 0x50494c43;                 // "CLIP"
+const uint64_t FRAME_STORE_OPEN_CLIP = ~static_cast< uint64_t >( 0 );  // The frame count of an unfinished clip.
+const size_t FRAME_STORE_HEADER_SIZE = 4096;
+const size_t FRAME_STORE_ALIGNMENT = 64;
+
+enum FrameStoreLayout : uint32_t
+{
+    FRAME_STORE_LAYOUT_COMPLEX64 = 0            // Frames of interleaved 32 bit real and imaginary parts, frame after frame.
+};
+
+struct FrameStoreHeader
+///
+/// The description of the transform at the start of every frame store.
+///
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t layout;
+    uint64_t fft_size;
+    uint64_t hop;
+    uint64_t num_bins;
+    uint64_t window_length;
+    uint64_t window_hash;
+};
+
+struct FrameStoreClipHeader
+///
+/// The start of each clip.
+///
+{
+    uint32_t magic;
+    uint32_t name_length;
+    uint64_t num_frames;
+};
+
+uint64_t hash_window( const std::vector< float >& window );
+
+class FrameStoreWriter
+///
+/// Appends clips of frames to a frame store, creating it if it does not exist.
+///
+/// Frames are written straight to the file as they are given, so a clip of any length may be
+/// streamed in without being held in memory. Only one writer may have a store open at a time,
+/// which is enforced with an exclusive flock, though any number of readers may map it while it is
+/// being written. Finishing a clip waits for its frames to reach the disk.
+///
+/// Thread safety: A writer may be shared between threads. BeginClip, WriteFrames, EndClip and Flush
+/// each hold an internal mutex for the whole call, so calls from different threads never interleave
+/// their writes, though the frames of one clip are still stored in the order the calls are made.
+/// Callers that stream a clip from several threads must order those calls themselves.
+///
+{
+
+public:
+
+    FrameStoreWriter( const std::string& path, size_t fft_size, size_t hop, const std::vector< float >& window );
+    ~FrameStoreWriter();
+
+    FrameStoreWriter( const FrameStoreWriter& ) = delete;
+    FrameStoreWriter& operator=( const FrameStoreWriter& ) = delete;
+
+    size_t BeginClip( const std::string& name );
+    void WriteFrames( const std::complex< float >* frames, size_t num_frames );
+    void EndClip();
+    void Flush();
+
+    const size_t GetFFTSize() const;
+    const size_t GetHop() const;
+    const size_t GetNumBins() const;
+    const size_t GetWindowLength() const;
+    const uint64_t GetWindowHash() const;
+    const size_t GetNumClips() const;
+    const bool IsClipOpen() const;
+
+private:
+
+    //
+    // Configuration
+    //
+    FrameStoreHeader mHeader;
+    const size_t mFrameBytes;
+
+    //
+    // Mechanics
+    //
+    int mFile;
+
+    //
+    // Thread safety
+    //
+    mutable std::mutex mMutex;
+
+    //
+    // Data
+    //
+    uint64_t mEnd;              // The end of the last finished clip.
+    uint64_t mClipStart;        // The start of the open clip's header.
+    uint64_t mFramesStart;      // The start of the open clip's frames.
+    uint64_t mClipFrames;       // The number of frames written to the open clip.
+    size_t mNumClips;
+    bool mClipOpen;
+
+    //
+    // Helpers
+    //
+    void WriteAt( const void* data, size_t num_bytes, uint64_t offset );
+    void Sync();
+
+};
+
+class FrameStoreReader
+///
+/// Maps a frame store into memory, giving direct access to the frames of every clip.
+///
+/// Only the clips finished when the store was opened are visible. Clips are found by index, in
+/// the order they were written, or by name, where a later clip hides an earlier clip of the same
+/// name. The frames returned point into the mapping, so remain valid as long as the reader.
+///
+{
+
+public:
+
+    FrameStoreReader( const std::string& path );
+    ~FrameStoreReader();
+
+    FrameStoreReader( const FrameStoreReader& ) = delete;
+    FrameStoreReader& operator=( const FrameStoreReader& ) = delete;
+
+    const size_t GetNumClips() const;
+    const std::string& GetClipName( size_t clip ) const;
+    const size_t GetNumFrames( size_t clip ) const;
+    const std::complex< float >* GetFrames( size_t clip, size_t first_frame=0 ) const;
+    size_t FindClip( const std::string& name ) const;
+
+    const size_t GetFFTSize() const;
+    const size_t GetHop() const;
+    const size_t GetNumBins() const;
+    const size_t GetWindowLength() const;
+    const uint64_t GetWindowHash() const;
+
+private:
+
+    struct Clip
+    ///
+    /// Where a clip lies in the mapping.
+    ///
+    {
+        std::string name;
+        uint64_t frames_offset;
+        uint64_t num_frames;
+    };
+
+    //
+    // Mechanics
+    //
+    const char* mData;
+    size_t mSize;
+
+    //
+    // Data
+    //
+    FrameStoreHeader mHeader;
+    std::vector< Clip > mClips;
+    std::unordered_map< std::string, size_t > mClipsByName;
+
+};
+
+} // namespace cupcake
+
+#endif // CUPCAKE_FRAME_STORE_H
@@ -0,0 +1,85 @@
+//
+// Created: 10/18/26 by agent
+//
+// Python entry points for reading and writing frame stores.
+//
+
+#ifndef CUPCAKE_FRAME_STORE_BINDING_H
+#define CUPCAKE_FRAME_STORE_BINDING_H
+
+// In module includes.
+#include "FrameStore.h"
+
+// Third party includes.
+#include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
+
+// Std lib includes.
+#include <vector>
+#include <complex>
+#include <stdexcept>
+
+namespace py = pybind11;
+
+namespace cupcake
+{
+
+typedef py::array_t<std::complex<float>, py::array::c_style | py::array::forcecast> py_complex_array;
+
+inline void frame_store_write_frames( FrameStoreWriter* self, py_complex_array& frames )
+///
+/// Python entry point for FrameStoreWriter::WriteFrames. The frames are written with the GIL released,
+/// so calls from other Python threads on the same writer wait on the writer's own mutex.
+///
+/// @param self
+///  The writer, with a clip open.
+///
+/// @param frames
+///  A 2D complex array with one frame per row.
+///
+{
+    if (frames.ndim() != 2 || static_cast<size_t>( frames.shape( 1 ) ) != self->GetNumBins())
+        throw std::runtime_error("Frames must be a 2D array with one column per frequency bin");
+
+    const std::complex<float>* data = frames.data();
+    const size_t num_frames = static_cast<size_t>( frames.shape( 0 ) );
+    py::gil_scoped_release release;
+    self->WriteFrames( data, num_frames );
+}
+
+inline py::array_t<std::complex<float>> frame_store_get_frames( py::object self, size_t clip, size_t start, py::object stop )
+///
+/// Python entry point for FrameStoreReader::GetFrames. The returned array is a view straight into
+/// the mapped file, which keeps the reader alive for as long as the array exists.
+///
+/// @param self
+///  The python reader object.
+///
+/// @param clip
+///  The index of the clip.
+///
+/// @param start
+///  The first frame wanted.
+///
+/// @param stop
+///  One past the last frame wanted, or None for the end of the clip.
+///
+/// @return
+///  A read-only 2D complex array indexed by frame and frequency bin.
+///
+{
+    const FrameStoreReader* reader = self.cast<FrameStoreReader*>();
+    const size_t num_frames = reader->GetNumFrames( clip );
+    const size_t end = stop.is_none() ? num_frames : stop.cast<size_t>();
+    if (start > end || end > num_frames)
+        throw std::out_of_range("Frame range is outside the clip");
+
+    const size_t num_bins = reader->GetNumBins();
+    std::vector<size_t> shape = { end - start, num_bins };
+    std::vector<size_t> strides = { num_bins*sizeof( std::complex<float> ), sizeof( std::complex<float> ) };
+    return py::array_t<std::complex<float>>( shape, strides, reader->GetFrames( clip, start ), self );
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_FRAME_STORE_BINDING_H
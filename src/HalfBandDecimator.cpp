@@ -0,0 +1,132 @@
+//
+// Created: 10/18/26 by agent
+//
+// A streaming polyphase half-band FIR decimator, halving the sample rate of a signal.
+//
+
+// In module includes
+#include "HalfBandDecimator.h"
+#include "Kernels.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+using namespace cupcake;
+
+const size_t HalfBandDecimator::DEFAULT_NUM_TAPS;
+
+HalfBandDecimator::HalfBandDecimator( size_t num_taps ) :
+    mTaps( num_taps ),
+    mNextIsEven( true )
+///
+/// Constructor. Designs the filter and starts the stream.
+///
+/// @param num_taps
+///  The number of non-zero taps on each side of the centre tap. More taps give a sharper cut off.
+///
+{
+    if( num_taps == 0 )
+    {
+        throw std::invalid_argument( "A half-band filter needs at least one tap each side" );
+    }
+
+    // Blackman windowed sinc, with the window reaching zero one sample beyond the outermost taps.
+    const double half_length = 2.0*num_taps;
+    double sum = 0.0;
+    for( size_t tap=0; tap<num_taps; ++tap )
+    {
+        const double offset = 2.0*( num_taps - 1 - tap ) + 1.0;
+        const double sinc = std::sin( M_PI*offset/2.0 )/( M_PI*offset );
+        const double window = 0.42 + 0.5*std::cos( M_PI*offset/half_length ) + 0.08*std::cos( 2.0*M_PI*offset/half_length );
+        mTaps[tap] = static_cast< float >( sinc*window );
+        sum += sinc*window;
+    }
+
+    // Unity gain at DC, i.e., the taps each side sum to a quarter.
+    for( float& tap : mTaps )
+    {
+        tap = static_cast< float >( tap*0.25/sum );
+    }
+
+    Reset();
+}
+
+HalfBandDecimator::~HalfBandDecimator() = default;
+
+size_t HalfBandDecimator::Process( const float* samples, size_t num_samples, std::vector< float >& output )
+///
+/// Push samples to be decimated, and append every output that can now be computed.
+///
+/// @param samples
+///  The samples to be decimated.
+///
+/// @param num_samples
+///  The number of samples.
+///
+/// @param output
+///  The vector to append the outputs to.
+///
+/// @return
+///  The number of outputs appended.
+///
+{
+    for( size_t sample=0; sample<num_samples; ++sample )
+    {
+        ( mNextIsEven ? mCentre : mSide ).push_back( samples[sample] );
+        mNextIsEven = !mNextIsEven;
+    }
+
+    // Each output needs 2*num_taps odd samples around its even sample.
+    const size_t span = 2*mTaps.size() - 1;
+    const size_t num_side = mSide.size() > span ? mSide.size() - span : 0;
+    const size_t num_outputs = std::min( mCentre.size(), num_side );
+    if( num_outputs == 0 )
+    {
+        return 0;
+    }
+
+    const size_t first = output.size();
+    output.resize( first + num_outputs );
+    get_kernels().half_band( mCentre.data(), mSide.data(), mTaps.data(), mTaps.size(), output.data() + first, num_outputs );
+
+    mCentre.erase( mCentre.begin(), mCentre.begin() + num_outputs );
+    mSide.erase( mSide.begin(), mSide.begin() + num_outputs );
+    return num_outputs;
+}
+
+void HalfBandDecimator::Reset()
+///
+/// Starts a new stream, as though no samples had been pushed.
+///
+{
+    mCentre.clear();
+    mSide.assign( mTaps.size(), 0.0f );
+    mNextIsEven = true;
+}
+
+const std::vector< float >& HalfBandDecimator::GetTaps() const
+///
+/// Get the non-zero taps of the filter either side of its centre tap of 0.5.
+///
+/// @return
+///  The taps at odd offsets from the centre, from the outermost, at offset 2*num_taps - 1, inwards.
+///
+{
+    return mTaps;
+}
+
+const size_t HalfBandDecimator::GetLatency() const
+///
+/// Get the number of input samples beyond 2m that must be pushed before output m is computed.
+///
+/// @return
+///  The latency in input samples.
+///
+{
+    return 2*mTaps.size() - 1;
+}
@@ -0,0 +1,76 @@
+//
+// Created: 10/18/26 by agent
+//
+// A streaming polyphase half-band FIR decimator, halving the sample rate of a signal.
+//
+
+#ifndef CUPCAKE_HALF_BAND_DECIMATOR_H
+#define CUPCAKE_HALF_BAND_DECIMATOR_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <cstddef>
+
+namespace cupcake
+{
+
+class HalfBandDecimator
+///
+/// Low pass filters a stream of samples to a quarter of its sample rate and keeps every second
+/// sample.
+///
+/// The filter is a windowed sinc half-band filter of 4*num_taps - 1 taps. Every second tap of a
+/// half-band filter is zero, besides the centre tap of 0.5, so the input is split into its even
+/// and odd samples, and each output only costs num_taps multiplies of pairs of odd samples (the
+/// filter is symmetric) and one of an even sample. These are computed by the half_band kernel, for
+/// many outputs at once.
+///
+/// Output m is the filtered signal at input sample 2m, i.e., the filter adds no phase shift, but
+/// can only be computed once input sample 2m + GetLatency() has been pushed. Samples before the
+/// start of the stream are taken to be zero.
+///
+{
+
+public:
+
+    HalfBandDecimator( size_t num_taps=DEFAULT_NUM_TAPS );
+    ~HalfBandDecimator();
+
+    size_t Process( const float* samples, size_t num_samples, std::vector< float >& output );
+    void Reset();
+
+    const std::vector< float >& GetTaps() const;
+    const size_t GetLatency() const;
+
+    //
+    // Constants
+    //
+    // Flat to within 0.01 dB up to an eighth of the input sample rate, and below -70 dB from three
+    // eighths of it. Decimated signals are only used in this passband by MultiResolutionFastWavelet.
+    static const size_t DEFAULT_NUM_TAPS = 8;
+
+private:
+
+    //
+    // Configuration
+    //
+    std::vector< float > mTaps;         // The taps at odd offsets from the centre, outermost first.
+
+    //
+    // Data
+    //
+    std::vector< float > mCentre;       // Even samples not yet output.
+    std::vector< float > mSide;         // Odd samples, from num_taps before the first even sample in mCentre.
+    bool mNextIsEven;
+
+};
+
+} // namespace cupcake
+
+#endif // CUPCAKE_HALF_BAND_DECIMATOR_H
@@ -0,0 +1,894 @@
+//
+// Created: 10/18/26 by agent
+//
+// Hot inner loops, compiled for several instruction sets and selected at runtime.
+//
+// Each variant is compiled with a function level target attribute, so this file may be built with
+// the baseline flags of the rest of the project and still contain AVX2 and AVX-512 code. Nothing
+// outside of get_kernels() chooses between the variants, and only variants the CPU (and OS) support
+// are ever chosen.
+//
+
+// In module includes
+#include "Kernels.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define CUPCAKE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace cupcake;
+
+namespace
+{
+
+//
+// Generic variants
+//
+
+void cqt_sweep_generic( std::complex< float >* frames,
+                        size_t num_frames,
+                        size_t frame_size,
+                        const std::complex< float >* coeffs,
+                        const std::complex< float >* one_minus_coeffs )
+///
+/// Filters each frame forwards and then backwards across frequency with a single pole IIR filter,
+/// one frame at a time.
+///
+{
+    if( frame_size < 2 )
+    {
+        return;
+    }
+
+    for( size_t frame_idx=0; frame_idx<num_frames; ++frame_idx )
+    {
+        std::complex< float >* frame = frames + frame_idx*frame_size;
+
+        // Forwards - the first coefficient has no history, so starting from the first bin itself is fine.
+        std::complex< float > last = frame[0];
+        for( size_t bin=0; bin<frame_size; ++bin )
+        {
+            frame[bin] = coeffs[bin]*last + one_minus_coeffs[bin]*frame[bin];
+            last = frame[bin];
+        }
+
+        // Backwards
+        last = frame[frame_size-1];
+        for( size_t bin=frame_size-2; bin>0; --bin )
+        {
+            frame[bin] = coeffs[bin+1]*last + one_minus_coeffs[bin+1]*frame[bin];
+            last = frame[bin];
+        }
+
+        // Remove the Nyquist component.
+        frame[frame_size-1] = { 0, 0 };
+    }
+}
+
+void mult_generic( const float* a, const float* b, float* out, size_t num_samples )
+{
+    for( size_t i=0; i<num_samples; ++i )
+    {
+        out[i] = a[i]*b[i];
+    }
+}
+
+void add_in_place_generic( const float* in, float* in_out, size_t num_samples )
+{
+    for( size_t i=0; i<num_samples; ++i )
+    {
+        in_out[i] += in[i];
+    }
+}
+
+void mult_const_in_place_generic( float* in_out, float multiplier, size_t num_samples )
+{
+    for( size_t i=0; i<num_samples; ++i )
+    {
+        in_out[i] *= multiplier;
+    }
+}
+
+void half_band_generic( const float* centre, const float* side, const float* taps, size_t num_taps, float* out, size_t num_outputs )
+{
+    const size_t last = 2*num_taps - 1;
+    for( size_t n=0; n<num_outputs; ++n )
+    {
+        float sum = 0.5f*centre[n];
+        for( size_t k=0; k<num_taps; ++k )
+        {
+            sum += taps[k]*( side[n+k] + side[n+last-k] );
+        }
+        out[n] = sum;
+    }
+}
+
+void sparse_cmul_generic( const std::complex< float >* values,
+                          const uint32_t* columns,
+                          const uint32_t* row_starts,
+                          size_t num_rows,
+                          const std::complex< float >* frames,
+                          size_t frame_stride,
+                          size_t num_frames,
+                          std::complex< float >* out,
+                          size_t out_stride )
+{
+    for( size_t frame=0; frame<num_frames; ++frame )
+    {
+        for( size_t row=0; row<num_rows; ++row )
+        {
+            std::complex< float > sum = { 0, 0 };
+            for( uint32_t i=row_starts[row]; i<row_starts[row+1]; ++i )
+            {
+                sum += values[i]*frames[columns[i]*frame_stride + frame];
+            }
+            out[frame*out_stride + row] = sum;
+        }
+    }
+}
+
+void spectral_frame_generic( const std::complex< float >* bins,
+                             const float* frequencies,
+                             float* previous_magnitude,
+                             float* power,
+                             size_t num_bins,
+                             float* sums )
+{
+    float total_power = 0.0f;
+    float weighted_power = 0.0f;
+    float flux = 0.0f;
+    for( size_t bin=0; bin<num_bins; ++bin )
+    {
+        const float bin_power = bins[bin].real()*bins[bin].real() + bins[bin].imag()*bins[bin].imag();
+        const float magnitude = std::sqrt( bin_power );
+        flux += std::max( magnitude - previous_magnitude[bin], 0.0f );
+        total_power += bin_power;
+        weighted_power += bin_power*frequencies[bin];
+        power[bin] = bin_power;
+        previous_magnitude[bin] = magnitude;
+    }
+    sums[0] = total_power;
+    sums[1] = weighted_power;
+    sums[2] = flux;
+}
+
+float sum_generic( const float* in, size_t num_samples )
+{
+    float sum = 0.0f;
+    for( size_t i=0; i<num_samples; ++i )
+    {
+        sum += in[i];
+    }
+    return sum;
+}
+
+const KernelTable GENERIC_KERNELS = { "generic", &cqt_sweep_generic, &mult_generic, &add_in_place_generic, &mult_const_in_place_generic, &half_band_generic, &sparse_cmul_generic, &spectral_frame_generic, &sum_generic };
+
+#if CUPCAKE_KERNELS_X86
+
+//
+// SIMD sweeps
+//
+// The sweep is a recurrence across bins, so it cannot be vectorised within a frame without changing
+// its rounding. Instead several frames are filtered at once, with each register holding the same bin
+// of 2 (SSE2), 4 (AVX2) or 8 (AVX-512) frames as interleaved real and imaginary parts. The complex
+// products are computed in the same order as std::complex, as re*v + im*swap(v)*(-1, 1).
+// Frames that do not fill a register are passed on to the next narrower variant.
+//
+
+__attribute__(( target( "sse2" ) ))
+inline __m128 load_pair( const std::complex< float >* p0, const std::complex< float >* p1 )
+{
+    return _mm_loadh_pi( _mm_loadl_pi( _mm_setzero_ps(), reinterpret_cast< const __m64* >( p0 ) ), reinterpret_cast< const __m64* >( p1 ) );
+}
+
+__attribute__(( target( "sse2" ) ))
+inline void store_pair( std::complex< float >* p0, std::complex< float >* p1, __m128 v )
+{
+    _mm_storel_pi( reinterpret_cast< __m64* >( p0 ), v );
+    _mm_storeh_pi( reinterpret_cast< __m64* >( p1 ), v );
+}
+
+__attribute__(( target( "sse2" ) ))
+inline __m128 cmul_sse2( std::complex< float > c, __m128 v, __m128 sign )
+{
+    const __m128 swapped = _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+    return _mm_add_ps( _mm_mul_ps( _mm_set1_ps( c.real() ), v ), _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( c.imag() ), swapped ), sign ) );
+}
+
+__attribute__(( target( "sse2" ) ))
+void cqt_sweep_sse2( std::complex< float >* frames,
+                     size_t num_frames,
+                     size_t frame_size,
+                     const std::complex< float >* coeffs,
+                     const std::complex< float >* one_minus_coeffs )
+{
+    const size_t LANES = 2;
+    if( frame_size < 2 )
+    {
+        return;
+    }
+
+    const __m128 sign = _mm_setr_ps( -1.0f, 1.0f, -1.0f, 1.0f );
+    size_t frame_idx = 0;
+    for( ; frame_idx+LANES<=num_frames; frame_idx+=LANES )
+    {
+        std::complex< float >* f0 = frames + frame_idx*frame_size;
+        std::complex< float >* f1 = f0 + frame_size;
+
+        __m128 last = load_pair( f0, f1 );
+        for( size_t bin=0; bin<frame_size; ++bin )
+        {
+            last = _mm_add_ps( cmul_sse2( coeffs[bin], last, sign ), cmul_sse2( one_minus_coeffs[bin], load_pair( f0 + bin, f1 + bin ), sign ) );
+            store_pair( f0 + bin, f1 + bin, last );
+        }
+
+        last = load_pair( f0 + frame_size - 1, f1 + frame_size - 1 );
+        for( size_t bin=frame_size-2; bin>0; --bin )
+        {
+            last = _mm_add_ps( cmul_sse2( coeffs[bin+1], last, sign ), cmul_sse2( one_minus_coeffs[bin+1], load_pair( f0 + bin, f1 + bin ), sign ) );
+            store_pair( f0 + bin, f1 + bin, last );
+        }
+
+        store_pair( f0 + frame_size - 1, f1 + frame_size - 1, _mm_setzero_ps() );
+    }
+
+    cqt_sweep_generic( frames + frame_idx*frame_size, num_frames - frame_idx, frame_size, coeffs, one_minus_coeffs );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline __m256 load_quad( std::complex< float >* p, size_t stride )
+{
+    return _mm256_insertf128_ps( _mm256_castps128_ps256( load_pair( p, p + stride ) ), load_pair( p + 2*stride, p + 3*stride ), 1 );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline void store_quad( std::complex< float >* p, size_t stride, __m256 v )
+{
+    store_pair( p, p + stride, _mm256_castps256_ps128( v ) );
+    store_pair( p + 2*stride, p + 3*stride, _mm256_extractf128_ps( v, 1 ) );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline __m256 cmul_avx2( std::complex< float > c, __m256 v, __m256 sign )
+{
+    const __m256 swapped = _mm256_permute_ps( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+    return _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( c.real() ), v ), _mm256_mul_ps( _mm256_mul_ps( _mm256_set1_ps( c.imag() ), swapped ), sign ) );
+}
+
+__attribute__(( target( "avx2" ) ))
+void cqt_sweep_avx2( std::complex< float >* frames,
+                     size_t num_frames,
+                     size_t frame_size,
+                     const std::complex< float >* coeffs,
+                     const std::complex< float >* one_minus_coeffs )
+{
+    const size_t LANES = 4;
+    if( frame_size < 2 )
+    {
+        return;
+    }
+
+    const __m256 sign = _mm256_setr_ps( -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f );
+    size_t frame_idx = 0;
+    for( ; frame_idx+LANES<=num_frames; frame_idx+=LANES )
+    {
+        std::complex< float >* f0 = frames + frame_idx*frame_size;
+
+        __m256 last = load_quad( f0, frame_size );
+        for( size_t bin=0; bin<frame_size; ++bin )
+        {
+            last = _mm256_add_ps( cmul_avx2( coeffs[bin], last, sign ), cmul_avx2( one_minus_coeffs[bin], load_quad( f0 + bin, frame_size ), sign ) );
+            store_quad( f0 + bin, frame_size, last );
+        }
+
+        last = load_quad( f0 + frame_size - 1, frame_size );
+        for( size_t bin=frame_size-2; bin>0; --bin )
+        {
+            last = _mm256_add_ps( cmul_avx2( coeffs[bin+1], last, sign ), cmul_avx2( one_minus_coeffs[bin+1], load_quad( f0 + bin, frame_size ), sign ) );
+            store_quad( f0 + bin, frame_size, last );
+        }
+
+        store_quad( f0 + frame_size - 1, frame_size, _mm256_setzero_ps() );
+    }
+
+    cqt_sweep_sse2( frames + frame_idx*frame_size, num_frames - frame_idx, frame_size, coeffs, one_minus_coeffs );
+}
+
+// The masked forms of the permute and gather are used as the unmasked forms start from an undefined
+// register, which some compilers warn about.
+__attribute__(( target( "avx512f" ) ))
+inline __m512 gather_frames( __m512i index, const double* p )
+{
+    return _mm512_castpd_ps( _mm512_mask_i64gather_pd( _mm512_setzero_pd(), 0xFF, index, p, 8 ) );
+}
+
+__attribute__(( target( "avx512f" ) ))
+inline __m512 cmul_avx512( std::complex< float > c, __m512 v, __m512 sign )
+{
+    const __m512 swapped = _mm512_maskz_permute_ps( 0xFFFF, v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+    return _mm512_add_ps( _mm512_mul_ps( _mm512_set1_ps( c.real() ), v ), _mm512_mul_ps( _mm512_mul_ps( _mm512_set1_ps( c.imag() ), swapped ), sign ) );
+}
+
+__attribute__(( target( "avx512f" ) ))
+void cqt_sweep_avx512( std::complex< float >* frames,
+                       size_t num_frames,
+                       size_t frame_size,
+                       const std::complex< float >* coeffs,
+                       const std::complex< float >* one_minus_coeffs )
+{
+    const size_t LANES = 8;
+    if( frame_size < 2 )
+    {
+        return;
+    }
+
+    // Each complex value is gathered and scattered as a single 64 bit element.
+    const long long stride = static_cast< long long >( frame_size );
+    const __m512i index = _mm512_set_epi64( 7*stride, 6*stride, 5*stride, 4*stride, 3*stride, 2*stride, stride, 0 );
+    const __m512 sign = _mm512_setr_ps( -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f );
+    size_t frame_idx = 0;
+    for( ; frame_idx+LANES<=num_frames; frame_idx+=LANES )
+    {
+        double* f0 = reinterpret_cast< double* >( frames + frame_idx*frame_size );
+
+        __m512 last = gather_frames( index, f0 );
+        for( size_t bin=0; bin<frame_size; ++bin )
+        {
+            const __m512 input = gather_frames( index, f0 + bin );
+            last = _mm512_add_ps( cmul_avx512( coeffs[bin], last, sign ), cmul_avx512( one_minus_coeffs[bin], input, sign ) );
+            _mm512_i64scatter_pd( f0 + bin, index, _mm512_castps_pd( last ), 8 );
+        }
+
+        last = gather_frames( index, f0 + frame_size - 1 );
+        for( size_t bin=frame_size-2; bin>0; --bin )
+        {
+            const __m512 input = gather_frames( index, f0 + bin );
+            last = _mm512_add_ps( cmul_avx512( coeffs[bin+1], last, sign ), cmul_avx512( one_minus_coeffs[bin+1], input, sign ) );
+            _mm512_i64scatter_pd( f0 + bin, index, _mm512_castps_pd( last ), 8 );
+        }
+
+        _mm512_i64scatter_pd( f0 + frame_size - 1, index, _mm512_setzero_pd(), 8 );
+    }
+
+    cqt_sweep_avx2( frames + frame_idx*frame_size, num_frames - frame_idx, frame_size, coeffs, one_minus_coeffs );
+}
+
+//
+// SIMD element-wise kernels
+//
+
+__attribute__(( target( "sse2" ) ))
+void mult_sse2( const float* a, const float* b, float* out, size_t num_samples )
+{
+    size_t i = 0;
+    for( ; i+4<=num_samples; i+=4 )
+    {
+        _mm_storeu_ps( out + i, _mm_mul_ps( _mm_loadu_ps( a + i ), _mm_loadu_ps( b + i ) ) );
+    }
+    mult_generic( a + i, b + i, out + i, num_samples - i );
+}
+
+__attribute__(( target( "sse2" ) ))
+void add_in_place_sse2( const float* in, float* in_out, size_t num_samples )
+{
+    size_t i = 0;
+    for( ; i+4<=num_samples; i+=4 )
+    {
+        _mm_storeu_ps( in_out + i, _mm_add_ps( _mm_loadu_ps( in_out + i ), _mm_loadu_ps( in + i ) ) );
+    }
+    add_in_place_generic( in + i, in_out + i, num_samples - i );
+}
+
+__attribute__(( target( "sse2" ) ))
+void mult_const_in_place_sse2( float* in_out, float multiplier, size_t num_samples )
+{
+    const __m128 mult = _mm_set1_ps( multiplier );
+    size_t i = 0;
+    for( ; i+4<=num_samples; i+=4 )
+    {
+        _mm_storeu_ps( in_out + i, _mm_mul_ps( _mm_loadu_ps( in_out + i ), mult ) );
+    }
+    mult_const_in_place_generic( in_out + i, multiplier, num_samples - i );
+}
+
+__attribute__(( target( "avx2" ) ))
+void mult_avx2( const float* a, const float* b, float* out, size_t num_samples )
+{
+    size_t i = 0;
+    for( ; i+8<=num_samples; i+=8 )
+    {
+        _mm256_storeu_ps( out + i, _mm256_mul_ps( _mm256_loadu_ps( a + i ), _mm256_loadu_ps( b + i ) ) );
+    }
+    mult_generic( a + i, b + i, out + i, num_samples - i );
+}
+
+__attribute__(( target( "avx2" ) ))
+void add_in_place_avx2( const float* in, float* in_out, size_t num_samples )
+{
+    size_t i = 0;
+    for( ; i+8<=num_samples; i+=8 )
+    {
+        _mm256_storeu_ps( in_out + i, _mm256_add_ps( _mm256_loadu_ps( in_out + i ), _mm256_loadu_ps( in + i ) ) );
+    }
+    add_in_place_generic( in + i, in_out + i, num_samples - i );
+}
+
+__attribute__(( target( "avx2" ) ))
+void mult_const_in_place_avx2( float* in_out, float multiplier, size_t num_samples )
+{
+    const __m256 mult = _mm256_set1_ps( multiplier );
+    size_t i = 0;
+    for( ; i+8<=num_samples; i+=8 )
+    {
+        _mm256_storeu_ps( in_out + i, _mm256_mul_ps( _mm256_loadu_ps( in_out + i ), mult ) );
+    }
+    mult_const_in_place_generic( in_out + i, multiplier, num_samples - i );
+}
+
+__attribute__(( target( "avx512f" ) ))
+void mult_avx512( const float* a, const float* b, float* out, size_t num_samples )
+{
+    size_t i = 0;
+    for( ; i+16<=num_samples; i+=16 )
+    {
+        _mm512_storeu_ps( out + i, _mm512_mul_ps( _mm512_loadu_ps( a + i ), _mm512_loadu_ps( b + i ) ) );
+    }
+    mult_generic( a + i, b + i, out + i, num_samples - i );
+}
+
+__attribute__(( target( "avx512f" ) ))
+void add_in_place_avx512( const float* in, float* in_out, size_t num_samples )
+{
+    size_t i = 0;
+    for( ; i+16<=num_samples; i+=16 )
+    {
+        _mm512_storeu_ps( in_out + i, _mm512_add_ps( _mm512_loadu_ps( in_out + i ), _mm512_loadu_ps( in + i ) ) );
+    }
+    add_in_place_generic( in + i, in_out + i, num_samples - i );
+}
+
+__attribute__(( target( "avx512f" ) ))
+void mult_const_in_place_avx512( float* in_out, float multiplier, size_t num_samples )
+{
+    const __m512 mult = _mm512_set1_ps( multiplier );
+    size_t i = 0;
+    for( ; i+16<=num_samples; i+=16 )
+    {
+        _mm512_storeu_ps( in_out + i, _mm512_mul_ps( _mm512_loadu_ps( in_out + i ), mult ) );
+    }
+    mult_const_in_place_generic( in_out + i, multiplier, num_samples - i );
+}
+
+//
+// SIMD half-band filters
+//
+// Each register holds consecutive outputs, so that every tap is a pair of unaligned loads from the
+// side samples, summed, scaled and accumulated in the same order as the generic variant.
+//
+
+__attribute__(( target( "sse2" ) ))
+void half_band_sse2( const float* centre, const float* side, const float* taps, size_t num_taps, float* out, size_t num_outputs )
+{
+    const size_t last = 2*num_taps - 1;
+    const __m128 half = _mm_set1_ps( 0.5f );
+    size_t n = 0;
+    for( ; n+4<=num_outputs; n+=4 )
+    {
+        __m128 sum = _mm_mul_ps( half, _mm_loadu_ps( centre + n ) );
+        for( size_t k=0; k<num_taps; ++k )
+        {
+            const __m128 pair = _mm_add_ps( _mm_loadu_ps( side + n + k ), _mm_loadu_ps( side + n + last - k ) );
+            sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( taps[k] ), pair ) );
+        }
+        _mm_storeu_ps( out + n, sum );
+    }
+    half_band_generic( centre + n, side + n, taps, num_taps, out + n, num_outputs - n );
+}
+
+__attribute__(( target( "avx2" ) ))
+void half_band_avx2( const float* centre, const float* side, const float* taps, size_t num_taps, float* out, size_t num_outputs )
+{
+    const size_t last = 2*num_taps - 1;
+    const __m256 half = _mm256_set1_ps( 0.5f );
+    size_t n = 0;
+    for( ; n+8<=num_outputs; n+=8 )
+    {
+        __m256 sum = _mm256_mul_ps( half, _mm256_loadu_ps( centre + n ) );
+        for( size_t k=0; k<num_taps; ++k )
+        {
+            const __m256 pair = _mm256_add_ps( _mm256_loadu_ps( side + n + k ), _mm256_loadu_ps( side + n + last - k ) );
+            sum = _mm256_add_ps( sum, _mm256_mul_ps( _mm256_set1_ps( taps[k] ), pair ) );
+        }
+        _mm256_storeu_ps( out + n, sum );
+    }
+    half_band_sse2( centre + n, side + n, taps, num_taps, out + n, num_outputs - n );
+}
+
+__attribute__(( target( "avx512f" ) ))
+void half_band_avx512( const float* centre, const float* side, const float* taps, size_t num_taps, float* out, size_t num_outputs )
+{
+    const size_t last = 2*num_taps - 1;
+    const __m512 half = _mm512_set1_ps( 0.5f );
+    size_t n = 0;
+    for( ; n+16<=num_outputs; n+=16 )
+    {
+        __m512 sum = _mm512_mul_ps( half, _mm512_loadu_ps( centre + n ) );
+        for( size_t k=0; k<num_taps; ++k )
+        {
+            const __m512 pair = _mm512_add_ps( _mm512_loadu_ps( side + n + k ), _mm512_loadu_ps( side + n + last - k ) );
+            sum = _mm512_add_ps( sum, _mm512_mul_ps( _mm512_set1_ps( taps[k] ), pair ) );
+        }
+        _mm512_storeu_ps( out + n, sum );
+    }
+    half_band_avx2( centre + n, side + n, taps, num_taps, out + n, num_outputs - n );
+}
+
+//
+// SIMD sparse products
+//
+// As for the sweeps, each register holds the same bin of 2 (SSE2), 4 (AVX2) or 8 (AVX-512) frames,
+// which are contiguous as the frames are stored bin by bin. Each kernel value is broadcast and
+// multiplied with a whole register, and the sums are scattered to their frames once per row.
+//
+
+__attribute__(( target( "sse2" ) ))
+void sparse_cmul_sse2( const std::complex< float >* values,
+                       const uint32_t* columns,
+                       const uint32_t* row_starts,
+                       size_t num_rows,
+                       const std::complex< float >* frames,
+                       size_t frame_stride,
+                       size_t num_frames,
+                       std::complex< float >* out,
+                       size_t out_stride )
+{
+    const size_t LANES = 2;
+    const __m128 sign = _mm_setr_ps( -1.0f, 1.0f, -1.0f, 1.0f );
+    size_t frame = 0;
+    for( ; frame+LANES<=num_frames; frame+=LANES )
+    {
+        for( size_t row=0; row<num_rows; ++row )
+        {
+            __m128 sum = _mm_setzero_ps();
+            for( uint32_t i=row_starts[row]; i<row_starts[row+1]; ++i )
+            {
+                const __m128 input = _mm_loadu_ps( reinterpret_cast< const float* >( frames + columns[i]*frame_stride + frame ) );
+                sum = _mm_add_ps( sum, cmul_sse2( values[i], input, sign ) );
+            }
+            std::complex< float >* first = out + frame*out_stride + row;
+            store_pair( first, first + out_stride, sum );
+        }
+    }
+
+    sparse_cmul_generic( values, columns, row_starts, num_rows, frames + frame, frame_stride, num_frames - frame, out + frame*out_stride, out_stride );
+}
+
+__attribute__(( target( "avx2" ) ))
+void sparse_cmul_avx2( const std::complex< float >* values,
+                       const uint32_t* columns,
+                       const uint32_t* row_starts,
+                       size_t num_rows,
+                       const std::complex< float >* frames,
+                       size_t frame_stride,
+                       size_t num_frames,
+                       std::complex< float >* out,
+                       size_t out_stride )
+{
+    const size_t LANES = 4;
+    const __m256 sign = _mm256_setr_ps( -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f );
+    size_t frame = 0;
+    for( ; frame+LANES<=num_frames; frame+=LANES )
+    {
+        for( size_t row=0; row<num_rows; ++row )
+        {
+            __m256 sum = _mm256_setzero_ps();
+            for( uint32_t i=row_starts[row]; i<row_starts[row+1]; ++i )
+            {
+                const __m256 input = _mm256_loadu_ps( reinterpret_cast< const float* >( frames + columns[i]*frame_stride + frame ) );
+                sum = _mm256_add_ps( sum, cmul_avx2( values[i], input, sign ) );
+            }
+            store_quad( out + frame*out_stride + row, out_stride, sum );
+        }
+    }
+
+    sparse_cmul_sse2( values, columns, row_starts, num_rows, frames + frame, frame_stride, num_frames - frame, out + frame*out_stride, out_stride );
+}
+
+__attribute__(( target( "avx512f" ) ))
+void sparse_cmul_avx512( const std::complex< float >* values,
+                         const uint32_t* columns,
+                         const uint32_t* row_starts,
+                         size_t num_rows,
+                         const std::complex< float >* frames,
+                         size_t frame_stride,
+                         size_t num_frames,
+                         std::complex< float >* out,
+                         size_t out_stride )
+{
+    const size_t LANES = 8;
+    const long long stride = static_cast< long long >( out_stride );
+    const __m512i index = _mm512_set_epi64( 7*stride, 6*stride, 5*stride, 4*stride, 3*stride, 2*stride, stride, 0 );
+    const __m512 sign = _mm512_setr_ps( -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f );
+    size_t frame = 0;
+    for( ; frame+LANES<=num_frames; frame+=LANES )
+    {
+        for( size_t row=0; row<num_rows; ++row )
+        {
+            __m512 sum = _mm512_setzero_ps();
+            for( uint32_t i=row_starts[row]; i<row_starts[row+1]; ++i )
+            {
+                const __m512 input = _mm512_loadu_ps( reinterpret_cast< const float* >( frames + columns[i]*frame_stride + frame ) );
+                sum = _mm512_add_ps( sum, cmul_avx512( values[i], input, sign ) );
+            }
+            _mm512_i64scatter_pd( reinterpret_cast< double* >( out + frame*out_stride + row ), index, _mm512_castps_pd( sum ), 8 );
+        }
+    }
+
+    sparse_cmul_avx2( values, columns, row_starts, num_rows, frames + frame, frame_stride, num_frames - frame, out + frame*out_stride, out_stride );
+}
+
+//
+// SIMD spectral reductions
+//
+// Each register holds consecutive bins, with the real and imaginary parts of the complex bins
+// separated by shuffles, so that powers and magnitudes are computed exactly as in the generic
+// variant. The sums are accumulated per lane and added across lanes at the end. Bins that do not
+// fill a register are passed on to the next narrower variant.
+//
+
+__attribute__(( target( "sse2" ) ))
+inline float horizontal_sum_sse2( __m128 v )
+{
+    const __m128 pairs = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+    return _mm_cvtss_f32( _mm_add_ss( pairs, _mm_shuffle_ps( pairs, pairs, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline float horizontal_sum_avx2( __m256 v )
+{
+    return horizontal_sum_sse2( _mm_add_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) ) );
+}
+
+__attribute__(( target( "sse2" ) ))
+void spectral_frame_sse2( const std::complex< float >* bins,
+                          const float* frequencies,
+                          float* previous_magnitude,
+                          float* power,
+                          size_t num_bins,
+                          float* sums )
+{
+    const float* values = reinterpret_cast< const float* >( bins );
+    const __m128 zero = _mm_setzero_ps();
+    __m128 total_power = zero;
+    __m128 weighted_power = zero;
+    __m128 flux = zero;
+    size_t bin = 0;
+    for( ; bin+4<=num_bins; bin+=4 )
+    {
+        const __m128 low = _mm_loadu_ps( values + 2*bin );
+        const __m128 high = _mm_loadu_ps( values + 2*bin + 4 );
+        const __m128 re = _mm_shuffle_ps( low, high, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+        const __m128 im = _mm_shuffle_ps( low, high, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+        const __m128 bin_power = _mm_add_ps( _mm_mul_ps( re, re ), _mm_mul_ps( im, im ) );
+        const __m128 magnitude = _mm_sqrt_ps( bin_power );
+        flux = _mm_add_ps( flux, _mm_max_ps( _mm_sub_ps( magnitude, _mm_loadu_ps( previous_magnitude + bin ) ), zero ) );
+        total_power = _mm_add_ps( total_power, bin_power );
+        weighted_power = _mm_add_ps( weighted_power, _mm_mul_ps( bin_power, _mm_loadu_ps( frequencies + bin ) ) );
+        _mm_storeu_ps( power + bin, bin_power );
+        _mm_storeu_ps( previous_magnitude + bin, magnitude );
+    }
+
+    float remainder[3];
+    spectral_frame_generic( bins + bin, frequencies + bin, previous_magnitude + bin, power + bin, num_bins - bin, remainder );
+    sums[0] = horizontal_sum_sse2( total_power ) + remainder[0];
+    sums[1] = horizontal_sum_sse2( weighted_power ) + remainder[1];
+    sums[2] = horizontal_sum_sse2( flux ) + remainder[2];
+}
+
+__attribute__(( target( "avx2" ) ))
+inline __m256 interleave_quads( __m256 v )
+{
+    // (0, 1, 4, 5 | 2, 3, 6, 7) -> (0, 1, 2, 3 | 4, 5, 6, 7), moving pairs of floats.
+    return _mm256_castpd_ps( _mm256_permute4x64_pd( _mm256_castps_pd( v ), _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+}
+
+__attribute__(( target( "avx2" ) ))
+void spectral_frame_avx2( const std::complex< float >* bins,
+                          const float* frequencies,
+                          float* previous_magnitude,
+                          float* power,
+                          size_t num_bins,
+                          float* sums )
+{
+    const float* values = reinterpret_cast< const float* >( bins );
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 total_power = zero;
+    __m256 weighted_power = zero;
+    __m256 flux = zero;
+    size_t bin = 0;
+    for( ; bin+8<=num_bins; bin+=8 )
+    {
+        const __m256 low = _mm256_loadu_ps( values + 2*bin );
+        const __m256 high = _mm256_loadu_ps( values + 2*bin + 8 );
+        const __m256 re = interleave_quads( _mm256_shuffle_ps( low, high, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+        const __m256 im = interleave_quads( _mm256_shuffle_ps( low, high, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+        const __m256 bin_power = _mm256_add_ps( _mm256_mul_ps( re, re ), _mm256_mul_ps( im, im ) );
+        const __m256 magnitude = _mm256_sqrt_ps( bin_power );
+        flux = _mm256_add_ps( flux, _mm256_max_ps( _mm256_sub_ps( magnitude, _mm256_loadu_ps( previous_magnitude + bin ) ), zero ) );
+        total_power = _mm256_add_ps( total_power, bin_power );
+        weighted_power = _mm256_add_ps( weighted_power, _mm256_mul_ps( bin_power, _mm256_loadu_ps( frequencies + bin ) ) );
+        _mm256_storeu_ps( power + bin, bin_power );
+        _mm256_storeu_ps( previous_magnitude + bin, magnitude );
+    }
+
+    float remainder[3];
+    spectral_frame_sse2( bins + bin, frequencies + bin, previous_magnitude + bin, power + bin, num_bins - bin, remainder );
+    sums[0] = horizontal_sum_avx2( total_power ) + remainder[0];
+    sums[1] = horizontal_sum_avx2( weighted_power ) + remainder[1];
+    sums[2] = horizontal_sum_avx2( flux ) + remainder[2];
+}
+
+// As for the sweeps, masked forms are used where the unmasked forms start from an undefined register.
+__attribute__(( target( "avx512f" ) ))
+inline float horizontal_sum_avx512( __m512 v )
+{
+    const __m256 low = _mm256_castpd_ps( _mm512_mask_extractf64x4_pd( _mm256_setzero_pd(), 0xF, _mm512_castps_pd( v ), 0 ) );
+    const __m256 high = _mm256_castpd_ps( _mm512_mask_extractf64x4_pd( _mm256_setzero_pd(), 0xF, _mm512_castps_pd( v ), 1 ) );
+    return horizontal_sum_avx2( _mm256_add_ps( low, high ) );
+}
+
+__attribute__(( target( "avx512f" ) ))
+void spectral_frame_avx512( const std::complex< float >* bins,
+                            const float* frequencies,
+                            float* previous_magnitude,
+                            float* power,
+                            size_t num_bins,
+                            float* sums )
+{
+    const float* values = reinterpret_cast< const float* >( bins );
+    const __m512i even = _mm512_setr_epi32( 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30 );
+    const __m512i odd = _mm512_setr_epi32( 1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31 );
+    const __m512 zero = _mm512_setzero_ps();
+    __m512 total_power = zero;
+    __m512 weighted_power = zero;
+    __m512 flux = zero;
+    size_t bin = 0;
+    for( ; bin+16<=num_bins; bin+=16 )
+    {
+        const __m512 low = _mm512_loadu_ps( values + 2*bin );
+        const __m512 high = _mm512_loadu_ps( values + 2*bin + 16 );
+        const __m512 re = _mm512_permutex2var_ps( low, even, high );
+        const __m512 im = _mm512_permutex2var_ps( low, odd, high );
+        const __m512 bin_power = _mm512_add_ps( _mm512_mul_ps( re, re ), _mm512_mul_ps( im, im ) );
+        const __m512 magnitude = _mm512_maskz_sqrt_ps( 0xFFFF, bin_power );
+        flux = _mm512_add_ps( flux, _mm512_maskz_max_ps( 0xFFFF, _mm512_sub_ps( magnitude, _mm512_loadu_ps( previous_magnitude + bin ) ), zero ) );
+        total_power = _mm512_add_ps( total_power, bin_power );
+        weighted_power = _mm512_add_ps( weighted_power, _mm512_mul_ps( bin_power, _mm512_loadu_ps( frequencies + bin ) ) );
+        _mm512_storeu_ps( power + bin, bin_power );
+        _mm512_storeu_ps( previous_magnitude + bin, magnitude );
+    }
+
+    float remainder[3];
+    spectral_frame_avx2( bins + bin, frequencies + bin, previous_magnitude + bin, power + bin, num_bins - bin, remainder );
+    sums[0] = horizontal_sum_avx512( total_power ) + remainder[0];
+    sums[1] = horizontal_sum_avx512( weighted_power ) + remainder[1];
+    sums[2] = horizontal_sum_avx512( flux ) + remainder[2];
+}
+
+__attribute__(( target( "sse2" ) ))
+float sum_sse2( const float* in, size_t num_samples )
+{
+    __m128 sum = _mm_setzero_ps();
+    size_t i = 0;
+    for( ; i+4<=num_samples; i+=4 )
+    {
+        sum = _mm_add_ps( sum, _mm_loadu_ps( in + i ) );
+    }
+    return horizontal_sum_sse2( sum ) + sum_generic( in + i, num_samples - i );
+}
+
+__attribute__(( target( "avx2" ) ))
+float sum_avx2( const float* in, size_t num_samples )
+{
+    __m256 sum = _mm256_setzero_ps();
+    size_t i = 0;
+    for( ; i+8<=num_samples; i+=8 )
+    {
+        sum = _mm256_add_ps( sum, _mm256_loadu_ps( in + i ) );
+    }
+    return horizontal_sum_avx2( sum ) + sum_sse2( in + i, num_samples - i );
+}
+
+__attribute__(( target( "avx512f" ) ))
+float sum_avx512( const float* in, size_t num_samples )
+{
+    __m512 sum = _mm512_setzero_ps();
+    size_t i = 0;
+    for( ; i+16<=num_samples; i+=16 )
+    {
+        sum = _mm512_add_ps( sum, _mm512_loadu_ps( in + i ) );
+    }
+    return horizontal_sum_avx512( sum ) + sum_avx2( in + i, num_samples - i );
+}
+
+const KernelTable SSE2_KERNELS = { "sse2", &cqt_sweep_sse2, &mult_sse2, &add_in_place_sse2, &mult_const_in_place_sse2, &half_band_sse2, &sparse_cmul_sse2, &spectral_frame_sse2, &sum_sse2 };
+const KernelTable AVX2_KERNELS = { "avx2", &cqt_sweep_avx2, &mult_avx2, &add_in_place_avx2, &mult_const_in_place_avx2, &half_band_avx2, &sparse_cmul_avx2, &spectral_frame_avx2, &sum_avx2 };
+const KernelTable AVX512_KERNELS = { "avx512", &cqt_sweep_avx512, &mult_avx512, &add_in_place_avx512, &mult_const_in_place_avx512, &half_band_avx512, &sparse_cmul_avx512, &spectral_frame_avx512, &sum_avx512 };
+
+#endif // CUPCAKE_KERNELS_X86
+
+const KernelTable& select_kernels()
+///
+/// Chooses the kernels used by this process: the most capable variant the CPU supports, unless
+/// the environment variable CUPCAKE_KERNELS names another supported variant (e.g. "generic"),
+/// which is useful for comparing variants on a single machine.
+///
+{
+    std::vector< const KernelTable* > supported = get_supported_kernels();
+
+    const char* requested = std::getenv( "CUPCAKE_KERNELS" );
+    if( requested )
+    {
+        for( auto table : supported )
+        {
+            if( std::strcmp( table->name, requested ) == 0 )
+            {
+                return *table;
+            }
+        }
+    }
+
+    return *supported.back();
+}
+
+} // namespace
+
+const KernelTable& cupcake::get_kernels()
+///
+/// Get the kernels used for all processing. These are chosen once, on first use.
+///
+/// @return
+///  The selected kernel table.
+///
+{
+    static const KernelTable& kernels = select_kernels();
+    return kernels;
+}
+
+std::vector< const KernelTable* > cupcake::get_supported_kernels()
+///
+/// Get all of the kernel variants that may run on this CPU.
+///
+/// @return
+///  The supported kernel tables, ordered from least to most capable. The generic variant is
+///  always first.
+///
+{
+    std::vector< const KernelTable* > supported( 1, &GENERIC_KERNELS );
+#if CUPCAKE_KERNELS_X86
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "sse2" ) )
+    {
+        supported.push_back( &SSE2_KERNELS );
+    }
+    if( __builtin_cpu_supports( "avx2" ) )
+    {
+        supported.push_back( &AVX2_KERNELS );
+    }
+    if( __builtin_cpu_supports( "avx512f" ) )
+    {
+        supported.push_back( &AVX512_KERNELS );
+    }
+#endif
+    return supported;
+}
@@ -0,0 +1,140 @@
+//
+// Created: 10/18/26 by agent
+//
+// Hot inner loops, compiled for several instruction sets and selected at runtime.
+//
+
+#ifndef CUPCAKE_KERNELS_H
+#define CUPCAKE_KERNELS_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+#include "vector_functions.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+namespace cupcake
+{
+
+struct KernelTable
+///
+/// A set of implementations of the hot loops for one instruction set. All variants give the same
+/// results as the generic variant, to within rounding of the IIR sweeps.
+///
+{
+    const char* name;
+
+    // Applies the fast CQT filtering to num_frames contiguous frames of frame_size complex bins, in
+    // place. See FastCQT::ApplyInPlace for the definition of the filtering. The SIMD variants only
+    // vectorise across frames, so a single frame is always filtered by the scalar generic sweep.
+    void (*cqt_sweep)( std::complex< float >* frames,
+                       size_t num_frames,
+                       size_t frame_size,
+                       const std::complex< float >* coeffs,
+                       const std::complex< float >* one_minus_coeffs );
+
+    // out[i] = a[i]*b[i], e.g. windowing.
+    void (*mult)( const float* a, const float* b, float* out, size_t num_samples );
+
+    // in_out[i] += in[i], e.g. overlap-add.
+    void (*add_in_place)( const float* in, float* in_out, size_t num_samples );
+
+    // in_out[i] *= multiplier, e.g. normalisation.
+    void (*mult_const_in_place)( float* in_out, float multiplier, size_t num_samples );
+
+    // out[n] = 0.5*centre[n] + sum_k taps[k]*( side[n+k] + side[n+2*num_taps-1-k] ), for k < num_taps.
+    // This is the polyphase form of a half-band FIR decimator, where centre holds the even input
+    // samples and side the odd ones. See HalfBandDecimator.
+    void (*half_band)( const float* centre,
+                       const float* side,
+                       const float* taps,
+                       size_t num_taps,
+                       float* out,
+                       size_t num_outputs );
+
+    // out[f*out_stride + row] = sum_i values[i]*frames[columns[i]*frame_stride + f], for i from
+    // row_starts[row] to row_starts[row+1], every row < num_rows and every frame f < num_frames.
+    // i.e., a sparse (CSR) matrix times a block of frames stored bin by bin. See ExactCQT.
+    void (*sparse_cmul)( const std::complex< float >* values,
+                         const uint32_t* columns,
+                         const uint32_t* row_starts,
+                         size_t num_rows,
+                         const std::complex< float >* frames,
+                         size_t frame_stride,
+                         size_t num_frames,
+                         std::complex< float >* out,
+                         size_t out_stride );
+
+    // In one pass over num_bins complex bins: power[i] = |bins[i]|^2, and previous_magnitude[i] is
+    // replaced by |bins[i]|, while sums = { sum power[i], sum power[i]*frequencies[i],
+    // sum max( |bins[i]| - previous_magnitude[i], 0 ) } are accumulated. The powers and magnitudes
+    // agree between variants to within rounding (the compiler may fuse the multiply-adds into FMA
+    // where the instruction set has it, e.g. AVX-512), and the sums are accumulated in a different
+    // order in each.
+    // See SpectralFeatures.
+    void (*spectral_frame)( const std::complex< float >* bins,
+                            const float* frequencies,
+                            float* previous_magnitude,
+                            float* power,
+                            size_t num_bins,
+                            float* sums );
+
+    // Returns the sum of in[i]. As above, the order of summation differs between variants.
+    float (*sum)( const float* in, size_t num_samples );
+};
+
+const KernelTable& get_kernels();
+std::vector< const KernelTable* > get_supported_kernels();
+
+namespace kernels
+{
+
+//
+// Drop in replacements for the veclib functions on the processing path. float data goes through the
+// selected kernels, other types fall back to veclib.
+//
+
+inline void vec_mult( const float* a, const float* b, float* out, size_t num_samples )
+{
+    get_kernels().mult( a, b, out, num_samples );
+}
+
+template< typename T >
+inline void vec_mult( const T* a, const T* b, T* out, size_t num_samples )
+{
+    veclib::vec_mult( a, b, out, num_samples );
+}
+
+inline void vec_add_in_place( const float* in, float* in_out, size_t num_samples )
+{
+    get_kernels().add_in_place( in, in_out, num_samples );
+}
+
+template< typename T >
+inline void vec_add_in_place( const T* in, T* in_out, size_t num_samples )
+{
+    veclib::vec_add_in_place( in, in_out, num_samples );
+}
+
+inline void vec_mult_const_in_place( float* in_out, float multiplier, size_t num_samples )
+{
+    get_kernels().mult_const_in_place( in_out, multiplier, num_samples );
+}
+
+template< typename T >
+inline void vec_mult_const_in_place( T* in_out, T multiplier, size_t num_samples )
+{
+    veclib::vec_mult_const_in_place( in_out, multiplier, num_samples );
+}
+
+} // namespace kernels
+
+} // namespace cupcake
+
+#endif // CUPCAKE_KERNELS_H
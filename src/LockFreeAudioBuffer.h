@@ -0,0 +1,271 @@
+//
+// Created: 10/18/26 by agent
+//
+// Single-producer/single-consumer lock-free FIFO buffer for audio. One thread may push samples
+// while another thread reads and pops them, without either thread taking a lock.
+//
+
+#ifndef CUPCAKE_LOCK_FREE_AUDIO_BUFFER_H
+#define CUPCAKE_LOCK_FREE_AUDIO_BUFFER_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <assert.h>
+
+namespace cupcake
+{
+
+template< typename T >
+class LockFreeAudioBuffer
+///
+/// A circular buffer with the same double-copy layout as AudioBuffer, so that the consumer can
+/// always read the buffered samples as one contiguous block of memory.
+/// PushSamples may only be called from a single producer thread, and Data, PopFront and Read
+/// may only be called from a single consumer thread. Each side only ever writes its own head,
+/// so both sides are wait-free.
+///
+{
+
+public:
+
+    LockFreeAudioBuffer();
+    LockFreeAudioBuffer( size_t size );
+    ~LockFreeAudioBuffer();
+
+    // Producer side.
+    bool PushSamples( const std::vector< T >& samples );
+    bool PushSamples( const T* samples, size_t num_samples );
+    const size_t SpaceRemaining() const;
+
+    // Consumer side.
+    void PopFront( size_t numElements );
+    const size_t NumSamples() const;
+    const T* Data();
+
+    const size_t Size() const;
+
+private:
+
+    //
+    // Data
+    //
+    std::vector< T > mData;
+
+    //
+    // Configuration
+    //
+    const size_t mBufferLength;
+
+    //
+    // Mechanics
+    //
+    // The heads are padded out to their own cache lines so that the producer and consumer
+    // do not invalidate each other's cache line every time they move their own head.
+    //
+    static const size_t CACHE_LINE_SIZE = 64;
+    char mConfigurationPadding[CACHE_LINE_SIZE];
+    std::atomic< size_t > mReadHead;
+    char mReadHeadPadding[CACHE_LINE_SIZE - sizeof( std::atomic< size_t > )];
+    std::atomic< size_t > mWriteHead;
+    char mWriteHeadPadding[CACHE_LINE_SIZE - sizeof( std::atomic< size_t > )];
+
+    //
+    // Constants
+    //
+    static const size_t DEFAULT_BUFFER_SIZE = 44100*10;
+
+    //
+    // Helpers
+    //
+    size_t NumSamples( size_t read_head, size_t write_head ) const;
+};
+
+template< typename T >
+LockFreeAudioBuffer<T>::LockFreeAudioBuffer() :
+    mData( 2*(DEFAULT_BUFFER_SIZE+1) ),
+    mBufferLength( DEFAULT_BUFFER_SIZE+1 ),
+    mReadHead( 0 ),
+    mWriteHead( 0 )
+///
+/// Default Constructor.
+///
+{
+
+}
+
+template< typename T >
+LockFreeAudioBuffer<T>::LockFreeAudioBuffer( size_t size ) :
+    mData( 2*(size+1) ),
+    mBufferLength( size+1 ),
+    mReadHead( 0 ),
+    mWriteHead( 0 )
+///
+/// Constructor.
+///
+/// @param size
+///  The maximum number of elements allowable in the buffer.
+///
+{
+
+}
+
+template< typename T >
+LockFreeAudioBuffer<T>::~LockFreeAudioBuffer()
+///
+/// Destructor.
+///
+{
+
+}
+
+template< typename T >
+bool LockFreeAudioBuffer<T>::PushSamples( const std::vector< T >& samples )
+///
+/// Copy samples into the buffer. Producer thread only.
+///
+/// @param samples
+///  A vector of samples to be added to the buffer.
+///
+/// @return
+///  True if the samples were added, false if there was not enough space for all of them,
+///  in which case none of them are added.
+///
+{
+    return PushSamples( samples.data(), samples.size() );
+}
+
+template< typename T >
+bool LockFreeAudioBuffer<T>::PushSamples( const T* samples, size_t num_samples )
+///
+/// Copy samples into the buffer. Producer thread only.
+/// As with AudioBuffer, the samples are written twice so that the consumer can read across the
+/// end of the circular buffer contiguously. The samples only become visible to the consumer once
+/// they have been completely written.
+///
+/// @param samples
+///  A pointer to the first of the samples to be added to the buffer.
+///
+/// @param num_samples
+///  The number of samples to be added to the buffer.
+///
+/// @return
+///  True if the samples were added, false if there was not enough space for all of them,
+///  in which case none of them are added.
+///
+{
+    size_t write_head = mWriteHead.load( std::memory_order_relaxed );
+    size_t read_head = mReadHead.load( std::memory_order_acquire );
+
+    if( num_samples > ( mBufferLength - 1 - NumSamples( read_head, write_head ) ) )
+    {
+        return false;
+    }
+
+    size_t samples_until_end = mBufferLength - write_head;
+
+    memcpy( mData.data() + write_head, samples, std::min( num_samples, samples_until_end )*sizeof( T ) );
+    memcpy( mData.data() + write_head + mBufferLength, samples, std::min( num_samples, samples_until_end )*sizeof( T ) );
+
+    if( num_samples > samples_until_end )
+    {
+        memcpy( mData.data(), samples + samples_until_end, ( num_samples - samples_until_end )*sizeof( T ) );
+        memcpy( mData.data() + mBufferLength, samples + samples_until_end, ( num_samples - samples_until_end )*sizeof( T ) );
+    }
+
+    mWriteHead.store( ( write_head + num_samples ) % mBufferLength, std::memory_order_release );
+
+    return true;
+}
+
+template< typename T >
+void LockFreeAudioBuffer<T>::PopFront( size_t numElements )
+///
+/// Clear a number of (the oldest) samples from the beginning of the buffer. Consumer thread only.
+/// Unlike AudioBuffer, the heads are never reset to the start of the buffer, as the write head
+/// belongs to the producer.
+///
+/// @param numElements
+///  The number of values to erase from the start of the buffer. This is limited to the number of
+///  samples currently in the buffer.
+///
+{
+    size_t read_head = mReadHead.load( std::memory_order_relaxed );
+    size_t write_head = mWriteHead.load( std::memory_order_acquire );
+
+    numElements = std::min( numElements, NumSamples( read_head, write_head ) );
+
+    mReadHead.store( ( read_head + numElements ) % mBufferLength, std::memory_order_release );
+}
+
+template< typename T >
+const size_t LockFreeAudioBuffer<T>::NumSamples() const
+///
+/// Returns the number of samples in the buffer. When called from the consumer thread this is the
+/// number of samples that may safely be read via Data(). The producer may add more at any time.
+///
+/// @return
+///  The number of samples in the buffer.
+///
+{
+    return NumSamples( mReadHead.load( std::memory_order_acquire ), mWriteHead.load( std::memory_order_acquire ) );
+}
+
+template< typename T >
+const size_t LockFreeAudioBuffer<T>::SpaceRemaining() const
+///
+/// Returns the number of samples beyond which a push will be rejected. When called from the
+/// producer thread this is a lower bound, as the consumer may free more space at any time.
+///
+/// @return
+///  The number of samples that can be added before the buffer is full.
+///
+{
+    return mBufferLength - 1 - NumSamples();
+}
+
+template< typename T >
+const size_t LockFreeAudioBuffer<T>::Size() const
+///
+/// Returns the maximum number of elements in total that can be written to an empty buffer.
+///
+/// @return
+///  The number of elements in the buffer.
+///
+{
+    return mBufferLength - 1;
+}
+
+template< typename T >
+const T* LockFreeAudioBuffer<T>::Data()
+///
+/// Getter function returning a pointer to the first element of the contiguous data in the
+/// buffer. Consumer thread only. At least NumSamples() elements may be read from this pointer.
+///
+/// @return
+///  A pointer to the first element in the buffer.
+///
+{
+    return mData.data() + mReadHead.load( std::memory_order_relaxed );
+}
+
+template< typename T >
+size_t LockFreeAudioBuffer<T>::NumSamples( size_t read_head, size_t write_head ) const
+///
+/// Computes the number of samples between a snapshot of the two heads.
+///
+{
+    return write_head >= read_head ? write_head - read_head : write_head + mBufferLength - read_head;
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_LOCK_FREE_AUDIO_BUFFER_H
@@ -0,0 +1,317 @@
+//
+// Created: 10/18/26 by agent
+//
+// Single-producer/single-consumer lock-free overlap-add buffer. One thread may overlap-add
+// frames while another thread reads and pops the completed samples, without either thread
+// taking a lock.
+//
+
+#ifndef CUPCAKE_LOCK_FREE_OVERLAP_ADD_BUFFER_H
+#define CUPCAKE_LOCK_FREE_OVERLAP_ADD_BUFFER_H
+
+// In module includes
+#include "Kernels.h"
+
+// Thirdparty includes
+#include "vector_functions.h"
+
+// Std Lib includes
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <assert.h>
+
+namespace cupcake
+{
+
+template< typename T >
+class LockFreeOverlapAddBuffer
+///
+/// An overlap-add buffer with the same semantics as OverlapAddBuffer, where the samples before
+/// the write position are complete and may be consumed by another thread.
+/// PushSamples and IncrementWritePosition may only be called from a single producer thread, and
+/// Read and PopFront may only be called from a single consumer thread.
+/// The producer only ever adds into the region at and beyond the write position, and the consumer
+/// only reads and zeros the region before it, so neither side has to wait for the other.
+///
+{
+public:
+
+    LockFreeOverlapAddBuffer();
+    LockFreeOverlapAddBuffer( size_t size );
+    ~LockFreeOverlapAddBuffer();
+
+    // Producer side.
+    bool PushSamples( const std::vector< T >& samples );
+    bool PushSamples( const T* samples, size_t num_samples );
+    void IncrementWritePosition( size_t increment );
+    const size_t SpaceRemaining() const;
+
+    // Consumer side.
+    void PopFront( size_t numElements );
+    void Read( std::vector< T >& output );
+    void Read( T* output, size_t num_samples );
+    const size_t NumSamples() const;
+
+    const size_t Size() const;
+
+private:
+
+    //
+    // Data
+    //
+    std::vector< T > mData;
+
+    //
+    // Configuration
+    //
+    const size_t mBufferLength;
+
+    //
+    // Mechanics
+    //
+    // The heads are padded out to their own cache lines so that the producer and consumer
+    // do not invalidate each other's cache line every time they move their own head.
+    //
+    static const size_t CACHE_LINE_SIZE = 64;
+    char mConfigurationPadding[CACHE_LINE_SIZE];
+    std::atomic< size_t > mReadHead;
+    char mReadHeadPadding[CACHE_LINE_SIZE - sizeof( std::atomic< size_t > )];
+    std::atomic< size_t > mWriteHead;
+    char mWriteHeadPadding[CACHE_LINE_SIZE - sizeof( std::atomic< size_t > )];
+
+    //
+    // Constants
+    //
+    static const size_t DEFAULT_BUFFER_SIZE = 44100*10;
+
+    //
+    // Helpers
+    //
+    size_t NumSamples( size_t read_head, size_t write_head ) const;
+};
+
+template< typename T >
+LockFreeOverlapAddBuffer< T >::LockFreeOverlapAddBuffer() :
+    mData( DEFAULT_BUFFER_SIZE+1 ),
+    mBufferLength( DEFAULT_BUFFER_SIZE+1 ),
+    mReadHead( 0 ),
+    mWriteHead( 0 )
+///
+/// Default Constructor.
+///
+{
+
+}
+
+template< typename T >
+LockFreeOverlapAddBuffer< T >::LockFreeOverlapAddBuffer( size_t size ) :
+    mData( size+1 ),
+    mBufferLength( size+1 ),
+    mReadHead( 0 ),
+    mWriteHead( 0 )
+///
+/// Constructor.
+///
+/// @param size
+///  The maximum number of elements allowable in the buffer.
+///
+{
+
+}
+
+template< typename T >
+LockFreeOverlapAddBuffer< T >::~LockFreeOverlapAddBuffer()
+///
+/// Destructor.
+///
+{
+
+}
+
+template< typename T >
+bool LockFreeOverlapAddBuffer< T >::PushSamples( const std::vector< T >& samples )
+///
+/// Adds samples to the buffer at the current write position. Producer thread only.
+///
+/// @param samples
+///  A vector of samples to be added to the buffer.
+///
+/// @return
+///  True if the samples were added, false if the consumer has not yet freed enough space for
+///  them, in which case nothing is added.
+///
+{
+    return PushSamples( samples.data(), samples.size() );
+}
+
+template< typename T >
+bool LockFreeOverlapAddBuffer< T >::PushSamples( const T* samples, size_t num_samples )
+///
+/// Adds samples to the buffer by adding their values to any content that is already written
+/// ahead of the current write position, as in OverlapAddBuffer. This does not increment the write
+/// position, so none of these samples are visible to the consumer until IncrementWritePosition is
+/// called. Producer thread only.
+///
+/// @param samples
+///  A pointer to the first of the samples to be added to the buffer.
+///
+/// @param num_samples
+///  The number of samples to be added to the buffer.
+///
+/// @return
+///  True if the samples were added, false if the consumer has not yet freed enough space for
+///  them, in which case nothing is added.
+///
+{
+    size_t write_head = mWriteHead.load( std::memory_order_relaxed );
+    size_t read_head = mReadHead.load( std::memory_order_acquire );
+
+    if( num_samples > ( mBufferLength - 1 - NumSamples( read_head, write_head ) ) )
+    {
+        return false;
+    }
+
+    size_t samples_until_end = mBufferLength - write_head;
+
+    kernels::vec_add_in_place( samples, mData.data() + write_head, std::min( num_samples, samples_until_end ) );
+
+    if( num_samples > samples_until_end )
+    {
+        kernels::vec_add_in_place( samples + samples_until_end, mData.data(), num_samples - samples_until_end );
+    }
+
+    return true;
+}
+
+template< typename T >
+void LockFreeOverlapAddBuffer< T >::IncrementWritePosition( size_t increment )
+///
+/// Increments the position of the write head, publishing the samples before it to the consumer.
+/// Producer thread only.
+///
+/// @param increment
+///  The number of samples by which to increment the write position.
+///
+{
+    size_t write_head = mWriteHead.load( std::memory_order_relaxed );
+
+    assert( increment <= ( mBufferLength - 1 - NumSamples( mReadHead.load( std::memory_order_acquire ), write_head ) ) ); // Buffer overflow.
+
+    mWriteHead.store( ( write_head + increment ) % mBufferLength, std::memory_order_release );
+}
+
+template< typename T >
+void LockFreeOverlapAddBuffer< T >::PopFront( size_t numElements )
+///
+/// Removes a number of the oldest samples from the buffer, zeroing them for future adds before
+/// handing the space back to the producer. Consumer thread only.
+///
+/// @param numElements
+///  The number of oldest elements to be removed from the buffer. This is limited to the number of
+///  complete samples currently in the buffer.
+///
+{
+    size_t read_head = mReadHead.load( std::memory_order_relaxed );
+    size_t write_head = mWriteHead.load( std::memory_order_acquire );
+
+    numElements = std::min( numElements, NumSamples( read_head, write_head ) );
+
+    veclib::vec_zero( mData.data() + read_head, std::min( mBufferLength - read_head, numElements ) );
+    if( numElements > ( mBufferLength - read_head ) )
+    {
+        veclib::vec_zero( mData.data(), numElements - ( mBufferLength - read_head ) );
+    }
+
+    mReadHead.store( ( read_head + numElements ) % mBufferLength, std::memory_order_release );
+}
+
+template< typename T >
+void LockFreeOverlapAddBuffer< T >::Read( std::vector< T >& output )
+///
+/// Copy the output.size() oldest complete samples into the provided output vector without removing
+/// them from the buffer. Consumer thread only.
+///
+/// @param output
+///  A vector of length according to the number of desired samples to be read.
+///
+{
+    Read( output.data(), output.size() );
+}
+
+template< typename T >
+void LockFreeOverlapAddBuffer< T >::Read( T* output, size_t num_samples )
+///
+/// Copy a number of the oldest complete samples into the provided output without removing them
+/// from the buffer. Consumer thread only.
+///
+/// @param output
+///  A pointer to memory for at least num_samples samples.
+///
+/// @param num_samples
+///  The number of samples to copy. This must be no more than NumSamples().
+///
+{
+    size_t read_head = mReadHead.load( std::memory_order_relaxed );
+
+    assert( num_samples <= NumSamples( read_head, mWriteHead.load( std::memory_order_acquire ) ) );
+
+    veclib::vec_copy( mData.data() + read_head, output, std::min( mBufferLength - read_head, num_samples ) );
+
+    if( num_samples > ( mBufferLength - read_head ) )
+    {
+        veclib::vec_copy( mData.data(), output + ( mBufferLength - read_head ), num_samples - ( mBufferLength - read_head ) );
+    }
+}
+
+template< typename T >
+const size_t LockFreeOverlapAddBuffer< T >::NumSamples() const
+///
+/// Returns the number of complete samples in the buffer. When called from the consumer thread
+/// this is the number of samples that may safely be read. The producer may complete more at any
+/// time.
+///
+/// @return
+///  The number of complete samples in the buffer.
+///
+{
+    return NumSamples( mReadHead.load( std::memory_order_acquire ), mWriteHead.load( std::memory_order_acquire ) );
+}
+
+template< typename T >
+const size_t LockFreeOverlapAddBuffer< T >::SpaceRemaining() const
+///
+/// Returns the number of samples beyond which a push will be rejected. When called from the
+/// producer thread this is a lower bound, as the consumer may free more space at any time.
+///
+/// @return
+///  The number of samples that can be added before the buffer is full.
+///
+{
+    return mBufferLength - 1 - NumSamples();
+}
+
+template< typename T >
+const size_t LockFreeOverlapAddBuffer< T >::Size() const
+///
+/// Returns the total number of allowable samples in the buffer.
+///
+/// @return
+///  The total number of samples that can fit in the buffer.
+///
+{
+    return mBufferLength - 1;
+}
+
+template< typename T >
+size_t LockFreeOverlapAddBuffer< T >::NumSamples( size_t read_head, size_t write_head ) const
+///
+/// Computes the number of complete samples between a snapshot of the two heads.
+///
+{
+    return write_head >= read_head ? write_head - read_head : write_head + mBufferLength - read_head;
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_LOCK_FREE_OVERLAP_ADD_BUFFER_H
@@ -0,0 +1,405 @@
+//
+// Created: 10/18/26 by agent
+//
+// Fast wavelet analysis with the sample rate halved for each lower octave.
+//
+
+#ifndef CUPCAKE_MULTI_RESOLUTION_FAST_WAVELET_H
+#define CUPCAKE_MULTI_RESOLUTION_FAST_WAVELET_H
+
+// In module includes
+#include "STFTAnalysis.h"
+#include "FastCQT.h"
+#include "HalfBandDecimator.h"
+#include "Arena.h"
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+namespace cupcake
+{
+
+struct MultiResolutionFrames
+///
+/// The stitched output frames of one call to MultiResolutionFastWavelet.
+///
+{
+    size_t num_frames = 0;
+    size_t num_bins = 0;
+    std::vector< std::complex< float > > values;    // num_frames x num_bins, from low to high frequency.
+};
+
+template< size_t FFT_SIZE >
+class MultiResolutionFastWavelet
+///
+/// Fast wavelet analyser with an octave-decimated filter bank below its top octave.
+///
+/// Octave 0 is a FastWavelet STFT and CQT at the full sample rate. Each octave below it decimates
+/// the octave above with a HalfBandDecimator, and runs its own STFT and CQT with the same FFT size,
+/// window and overlap at half the sample rate. Each lower octave therefore has half the bin spacing
+/// of the one above, a window twice as long in time and a hop twice as long, i.e., a constant-Q
+/// trade-off between time and frequency resolution from octave to octave.
+///
+/// Each octave below the top contributes bins [FFT_SIZE/8, FFT_SIZE/4) of its own transform, the
+/// lowest octave also contributes all bins below those, and the top octave contributes its bins from
+/// FFT_SIZE/8 to Nyquist. These are stitched into one frame per top octave frame, ordered from low
+/// to high frequency, with GetNumBins() = FFT_SIZE/2 + 1 + ( num_octaves - 1 )*FFT_SIZE/8 bins, whose
+/// centre frequencies are given by GetBinFrequencies. Decimated octaves only use their lower half,
+/// well within the decimator's passband, so no bin is affected by its transition band or aliasing.
+///
+/// The lowest octave has the bin spacing of a FastWavelet with an FFT 2^( num_octaves - 1 ) times
+/// longer. A single FFT that long would be computed every hop, whereas here each octave computes
+/// half as many FFT_SIZE transforms as the one above, i.e., fewer than two per hop in total, and the
+/// higher octaves keep the time resolution of the short window.
+///
+/// Lower octaves produce frames less often, and later, than the top octave, as their windows are
+/// longer and each decimator adds a few samples of latency. Each output frame holds the most
+/// recent frame of every lower octave that can be computed from the samples up to the end of the
+/// top octave frame, or zeros before the first one. So the output is causal, and independent of
+/// how the stream is divided into calls to PushSamples. GetAlgorithmicLatency gives the delay of
+/// the lowest octave, which is the longest.
+///
+/// Thread safety: As for FastWavelet, an instance holds streaming state and must not be used by
+/// more than one thread at a time.
+///
+{
+
+public:
+
+    static const size_t mFrameSize = veclib::get_output_FFT_size( FFT_SIZE );
+
+    MultiResolutionFastWavelet( size_t num_octaves, float overlap, const std::vector< float >& window, std::shared_ptr< Arena > arena=nullptr );
+    ~MultiResolutionFastWavelet();
+
+    MultiResolutionFrames& PushSamples( const float* samples, size_t num_samples );
+    std::vector< float > GetBinFrequencies( float sample_rate ) const;
+
+    const size_t GetNumOctaves() const;
+    const size_t GetNumBins() const;
+    const size_t GetIncrement() const;
+    const size_t GetAlgorithmicLatency() const;
+    const size_t GetBufferedSamples() const;
+
+    //
+    // Constants
+    //
+    static const size_t MAX_OCTAVES = 16;
+
+private:
+
+    struct Octave
+    ///
+    /// The transform of one octave, and its frames waiting to be stitched into the output.
+    ///
+    {
+        std::unique_ptr< STFTAnalysis< FFT_SIZE > > stft;
+        std::unique_ptr< FastCQT< FFT_SIZE > > cqt;
+        HalfBandDecimator decimator;                        // From the octave above. Unused by the top octave.
+        std::vector< float > samples;                       // The decimated samples of the current call.
+        size_t first_bin = 0;                               // The first bin of this octave's frames in the output.
+        size_t num_bins = 0;
+        size_t output_offset = 0;                           // Where those bins are in each output frame.
+        std::vector< std::complex< float > > pending;       // The output bins of frames not yet stitched, below the top octave.
+        uint64_t next_frame = 0;                            // The index of the first frame in pending.
+        size_t num_used = 0;                                // Pending frames stitched by the current call.
+        std::vector< std::complex< float > > held;          // The output bins of the last frame stitched.
+    };
+
+    //
+    // Configuration
+    //
+    const size_t mIncrement;
+    const size_t mWinLen;
+    size_t mNumBins;
+
+    //
+    // Mechanics
+    //
+    std::vector< Octave > mOctaves;
+
+    //
+    // Data
+    //
+    uint64_t mNumFrames;                // Top octave frames output so far.
+    uint64_t mNumSamples;               // Samples pushed so far.
+    MultiResolutionFrames mOutput;
+
+    //
+    // Helpers
+    //
+    uint64_t GetLastSample( size_t octave, uint64_t frame ) const;
+
+};
+
+template< size_t FFT_SIZE >
+const size_t MultiResolutionFastWavelet< FFT_SIZE >::mFrameSize;
+
+template< size_t FFT_SIZE >
+const size_t MultiResolutionFastWavelet< FFT_SIZE >::MAX_OCTAVES;
+
+template< size_t FFT_SIZE >
+MultiResolutionFastWavelet< FFT_SIZE >::MultiResolutionFastWavelet( size_t num_octaves, float overlap, const std::vector< float >& window, std::shared_ptr< Arena > arena ) :
+    mIncrement( static_cast< size_t >( ( 1-overlap )*window.size() ) ),
+    mWinLen( window.size() ),
+    mNumBins( 0 ),
+    mNumFrames( 0 ),
+    mNumSamples( 0 )
+///
+/// Constructor.
+///
+/// @param num_octaves
+///  The number of octaves analysed at successively halved sample rates, from 1 to MAX_OCTAVES. A
+///  single octave is the same analysis as FastWavelet.
+///
+/// @param overlap
+///  The overlap of successive STFT windows as a fraction of windowing length, in every octave.
+///
+/// @param window
+///  The windowing function of the STFT in every octave, in samples of that octave.
+///
+/// @param arena
+///  An optional arena to lay out the input buffers and working memory of every octave in.
+///
+{
+    if( num_octaves == 0 || num_octaves > MAX_OCTAVES )
+    {
+        throw std::invalid_argument( "The number of octaves must be from 1 to 16" );
+    }
+    mOctaves.resize( num_octaves );
+
+    // Lay out the bins from the lowest octave up.
+    for( size_t octave=num_octaves; octave-->0; )
+    {
+        Octave& stage = mOctaves[octave];
+        stage.stft.reset( new STFTAnalysis< FFT_SIZE >( overlap, window, arena ) );
+        stage.cqt.reset( new FastCQT< FFT_SIZE >( window.size(), arena ) );
+        stage.first_bin = octave == num_octaves - 1 ? 0 : FFT_SIZE/8;
+        stage.num_bins = ( octave == 0 ? mFrameSize : FFT_SIZE/4 ) - stage.first_bin;
+        stage.output_offset = mNumBins;
+        stage.held.assign( stage.num_bins, std::complex< float >() );
+        mNumBins += stage.num_bins;
+    }
+}
+
+template< size_t FFT_SIZE >
+MultiResolutionFastWavelet< FFT_SIZE >::~MultiResolutionFastWavelet() = default;
+
+template< size_t FFT_SIZE >
+MultiResolutionFrames& MultiResolutionFastWavelet< FFT_SIZE >::PushSamples( const float* samples, size_t num_samples )
+///
+/// Push samples to be analysed. Each octave decimates and transforms the samples, and one stitched
+/// frame is returned for each frame of the top octave that can now be produced.
+///
+/// @param samples
+///  The samples to be analysed, at the full sample rate.
+///
+/// @param num_samples
+///  The number of samples.
+///
+/// @return
+///  The stitched frames.
+///
+{
+    // Run every octave on its share of the samples. Lower octaves keep their frames until they are
+    // stitched, whereas the top octave's frames are stitched straight from its STFT output.
+    const float* level = samples;
+    size_t level_size = num_samples;
+    typename STFTAnalysis< FFT_SIZE >::FrameBuffer* top_frames = nullptr;
+    for( size_t octave=0; octave<mOctaves.size(); ++octave )
+    {
+        Octave& stage = mOctaves[octave];
+        if( octave > 0 )
+        {
+            stage.samples.clear();
+            stage.decimator.Process( level, level_size, stage.samples );
+            level = stage.samples.data();
+            level_size = stage.samples.size();
+        }
+
+        auto& frames = stage.stft->PushSamples( level, level_size );
+        stage.cqt->ApplyInPlace( frames );
+        if( octave == 0 )
+        {
+            top_frames = &frames;
+            continue;
+        }
+        for( const auto& frame : frames )
+        {
+            stage.pending.insert( stage.pending.end(), frame.begin() + stage.first_bin, frame.begin() + stage.first_bin + stage.num_bins );
+        }
+        stage.num_used = 0;
+    }
+
+    // Stitch each top octave frame with the latest frame of each lower octave that was complete by then.
+    const Octave& top = mOctaves[0];
+    mOutput.num_frames = top_frames->size();
+    mOutput.num_bins = mNumBins;
+    mOutput.values.resize( mOutput.num_frames*mNumBins );
+    for( size_t frame=0; frame<mOutput.num_frames; ++frame )
+    {
+        const uint64_t last_sample = GetLastSample( 0, mNumFrames + frame );
+        std::complex< float >* output = mOutput.values.data() + frame*mNumBins;
+        for( size_t octave=1; octave<mOctaves.size(); ++octave )
+        {
+            Octave& stage = mOctaves[octave];
+            const size_t num_pending = stage.pending.size()/stage.num_bins;
+            while( stage.num_used < num_pending && GetLastSample( octave, stage.next_frame + stage.num_used ) <= last_sample )
+            {
+                ++stage.num_used;
+            }
+            const std::complex< float >* held = stage.num_used > 0 ? stage.pending.data() + ( stage.num_used - 1 )*stage.num_bins : stage.held.data();
+            std::copy( held, held + stage.num_bins, output + stage.output_offset );
+        }
+        const auto& current = ( *top_frames )[frame];
+        std::copy( current.begin() + top.first_bin, current.begin() + top.first_bin + top.num_bins, output + top.output_offset );
+    }
+
+    // Keep the last frame stitched from each octave, and any that are still to come.
+    for( size_t octave=1; octave<mOctaves.size(); ++octave )
+    {
+        Octave& stage = mOctaves[octave];
+        if( stage.num_used > 0 )
+        {
+            auto last_used = stage.pending.begin() + stage.num_used*stage.num_bins;
+            std::copy( last_used - stage.num_bins, last_used, stage.held.begin() );
+            stage.pending.erase( stage.pending.begin(), last_used );
+            stage.next_frame += stage.num_used;
+        }
+    }
+    mNumFrames += mOutput.num_frames;
+    mNumSamples += num_samples;
+
+    return mOutput;
+}
+
+template< size_t FFT_SIZE >
+std::vector< float > MultiResolutionFastWavelet< FFT_SIZE >::GetBinFrequencies( float sample_rate ) const
+///
+/// Get the centre frequency of each bin of the stitched frames.
+///
+/// @param sample_rate
+///  The sample rate of the input, in Hz.
+///
+/// @return
+///  GetNumBins() frequencies in Hz, in increasing order.
+///
+{
+    std::vector< float > frequencies;
+    frequencies.reserve( mNumBins );
+    for( size_t octave=mOctaves.size(); octave-->0; )
+    {
+        const Octave& stage = mOctaves[octave];
+        const double bin_width = sample_rate/static_cast< double >( FFT_SIZE << octave );
+        for( size_t bin=stage.first_bin; bin<stage.first_bin+stage.num_bins; ++bin )
+        {
+            frequencies.push_back( static_cast< float >( bin*bin_width ) );
+        }
+    }
+    return frequencies;
+}
+
+template< size_t FFT_SIZE >
+const size_t MultiResolutionFastWavelet< FFT_SIZE >::GetNumOctaves() const
+///
+/// Get the number of octaves analysed.
+///
+/// @return
+///  The number of octaves, including the top octave.
+///
+{
+    return mOctaves.size();
+}
+
+template< size_t FFT_SIZE >
+const size_t MultiResolutionFastWavelet< FFT_SIZE >::GetNumBins() const
+///
+/// Get the size of the stitched frames.
+///
+/// @return
+///  The number of bins in each output frame.
+///
+{
+    return mNumBins;
+}
+
+template< size_t FFT_SIZE >
+const size_t MultiResolutionFastWavelet< FFT_SIZE >::GetIncrement() const
+///
+/// Get the number of samples between the starts of successive output frames, i.e., the hop of the
+/// top octave. The hop of each lower octave is twice that of the octave above, in input samples.
+///
+/// @return
+///  The top octave STFT increment in samples.
+///
+{
+    return mIncrement;
+}
+
+template< size_t FFT_SIZE >
+const size_t MultiResolutionFastWavelet< FFT_SIZE >::GetAlgorithmicLatency() const
+///
+/// Get the delay from the first input sample of a frame of the lowest octave being pushed to that
+/// frame being computed. This is the window length less one, scaled to the lowest octave's sample
+/// rate, plus the latency of each decimator above it. As for FastWavelet, the frame is then output
+/// with the next top octave frame, and pushing in chunks adds up to a chunk more.
+///
+/// @return
+///  The algorithmic latency in samples of the input. With a single octave, this is that of the STFT.
+///
+{
+    return static_cast< size_t >( GetLastSample( mOctaves.size() - 1, 0 ) );
+}
+
+template< size_t FFT_SIZE >
+const size_t MultiResolutionFastWavelet< FFT_SIZE >::GetBufferedSamples() const
+///
+/// Get the number of samples pushed since the start of the earliest frame, in any octave, that has
+/// not yet been computed. These are the samples still held, in some form, for future frames. This
+/// is never more than GetAlgorithmicLatency().
+///
+/// @return
+///  The number of buffered samples, in samples of the input.
+///
+{
+    uint64_t first_needed = mNumFrames*mIncrement;
+    for( size_t octave=1; octave<mOctaves.size(); ++octave )
+    {
+        const Octave& stage = mOctaves[octave];
+        const uint64_t num_computed = stage.next_frame + stage.pending.size()/stage.num_bins;
+        first_needed = std::min( first_needed, ( num_computed*mIncrement ) << octave );
+    }
+    return static_cast< size_t >( mNumSamples - std::min( mNumSamples, first_needed ) );
+}
+
+template< size_t FFT_SIZE >
+uint64_t MultiResolutionFastWavelet< FFT_SIZE >::GetLastSample( size_t octave, uint64_t frame ) const
+///
+/// Finds the input sample whose arrival completes a frame of an octave.
+///
+/// @param octave
+///  The octave, counted down from the top octave.
+///
+/// @param frame
+///  The index of the frame in that octave, counted from the start of the stream.
+///
+/// @return
+///  The index of the input sample, at the full sample rate.
+///
+{
+    // Sample m of an octave needs sample 2m + latency of the octave above.
+    const uint64_t latency = mOctaves[0].decimator.GetLatency();
+    const uint64_t last = frame*mIncrement + mWinLen - 1;
+    return ( last << octave ) + latency*( ( uint64_t( 1 ) << octave ) - 1 );
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_MULTI_RESOLUTION_FAST_WAVELET_H
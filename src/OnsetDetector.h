@@ -0,0 +1,346 @@
+//
+// Created: 10/18/26 by agent
+//
+// Streaming spectral flux novelty and onset peak picking on fast CQT output.
+//
+
+#ifndef CUPCAKE_ONSET_DETECTOR_H
+#define CUPCAKE_ONSET_DETECTOR_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <array>
+#include <complex>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <assert.h>
+
+namespace cupcake
+{
+
+struct OnsetFrames
+///
+/// The output of one call to OnsetDetector: the novelty of every new frame, and the onsets that
+/// could be decided with the frames seen so far.
+///
+{
+    std::vector< float > novelty;           // The novelty of each frame passed to this call.
+    std::vector< uint64_t > onset_frames;   // The index of each onset decided during this call, counted from the first frame.
+    std::vector< double > onset_times;      // The start time of each of those frames, in seconds.
+};
+
+template< size_t FFT_SIZE >
+class OnsetDetector
+///
+/// Detects onsets in a stream of frames, one frame at a time.
+///
+/// The novelty of each frame is its spectral flux: the mean over bins of the increase in log
+/// compressed magnitude from the previous frame. Onsets are the peaks in novelty that are the
+/// largest within [pre_max, post_max] frames of themselves, that exceed the mean novelty within
+/// [pre_avg, post_avg] frames by at least delta, and that follow the previous onset by more than
+/// wait frames.
+///
+/// Only the previous frame's magnitudes and a short history of novelty are kept. Deciding whether
+/// a frame is an onset needs max( post_max, post_avg ) frames after it, so onsets are reported
+/// with a latency of exactly that many frames, and otherwise as soon as the frames are pushed.
+///
+{
+
+public:
+
+    static const size_t mInputSize = veclib::get_output_FFT_size( FFT_SIZE );
+
+    typedef std::array< std::complex< float >, mInputSize > Frame;
+
+    OnsetDetector( double frame_period,
+                   float delta=0.05f,
+                   size_t wait=3,
+                   size_t pre_max=3,
+                   size_t post_max=1,
+                   size_t pre_avg=10,
+                   size_t post_avg=1,
+                   float compression=1.0f );
+    ~OnsetDetector();
+
+    OnsetFrames& Process( const Frame* frames, size_t num_frames );
+    OnsetFrames& Flush();
+    void Reset();
+
+    const size_t GetLatencyFrames() const;
+    const uint64_t GetNumFrames() const;
+
+private:
+
+    //
+    // Configuration
+    //
+    const double mFramePeriod;
+    const float mDelta;
+    const size_t mWait;
+    const size_t mPreMax;
+    const size_t mPostMax;
+    const size_t mPreAvg;
+    const size_t mPostAvg;
+    const float mCompression;
+    const size_t mLatency;
+
+    //
+    // Data
+    //
+    std::vector< float > mPreviousMagnitude;
+    std::vector< float > mNoveltyHistory;       // A circular buffer of the most recent novelty values, indexed by frame.
+    uint64_t mNumFrames;                        // Frames seen since construction or reset.
+    uint64_t mNextDecision;                     // The first frame not yet decided.
+    uint64_t mLastOnset;
+    bool mHasOnset;
+    OnsetFrames mOutput;
+
+    //
+    // Helpers
+    //
+    float ComputeNovelty( const Frame& frame );
+    void Decide( uint64_t frame );
+
+};
+
+template< size_t FFT_SIZE >
+const size_t OnsetDetector< FFT_SIZE >::mInputSize;
+
+template< size_t FFT_SIZE >
+OnsetDetector< FFT_SIZE >::OnsetDetector( double frame_period,
+                                          float delta,
+                                          size_t wait,
+                                          size_t pre_max,
+                                          size_t post_max,
+                                          size_t pre_avg,
+                                          size_t post_avg,
+                                          float compression ) :
+    mFramePeriod( frame_period ),
+    mDelta( delta ),
+    mWait( wait ),
+    mPreMax( pre_max ),
+    mPostMax( post_max ),
+    mPreAvg( pre_avg ),
+    mPostAvg( post_avg ),
+    mCompression( compression ),
+    mLatency( std::max( post_max, post_avg ) ),
+    mPreviousMagnitude( mInputSize, 0.0f ),
+    mNoveltyHistory( std::max( pre_max, pre_avg ) + std::max( post_max, post_avg ) + 1, 0.0f ),
+    mNumFrames( 0 ),
+    mNextDecision( 0 ),
+    mLastOnset( 0 ),
+    mHasOnset( false )
+///
+/// Constructor.
+///
+/// @param frame_period
+///  The time between successive frames in seconds, i.e., the STFT increment over the sample rate.
+///
+/// @param delta
+///  How far novelty must exceed its local mean to be an onset.
+///
+/// @param wait
+///  The number of frames after an onset in which no further onset is reported.
+///
+/// @param pre_max
+///  The number of frames before a peak it must be the largest of.
+///
+/// @param post_max
+///  The number of frames after a peak it must be the largest of.
+///
+/// @param pre_avg
+///  The number of frames before a peak in its local mean.
+///
+/// @param post_avg
+///  The number of frames after a peak in its local mean.
+///
+/// @param compression
+///  Magnitudes are compressed with log( 1 + compression*magnitude ) before differencing.
+///  Zero differences the magnitudes themselves.
+///
+{
+}
+
+template< size_t FFT_SIZE >
+OnsetDetector< FFT_SIZE >::~OnsetDetector() = default;
+
+template< size_t FFT_SIZE >
+OnsetFrames& OnsetDetector< FFT_SIZE >::Process( const Frame* frames, size_t num_frames )
+///
+/// Computes the novelty of a block of frames, following on from the last frame processed, and
+/// decides every frame that is now followed by enough frames.
+///
+/// @param frames
+///  The frames, e.g. the output of FastWavelet::PushSamples.
+///
+/// @param num_frames
+///  The number of frames.
+///
+/// @return
+///  The novelty of these frames and the onsets decided. This is overwritten by the next call.
+///
+{
+    mOutput.novelty.resize( num_frames );
+    mOutput.onset_frames.clear();
+    mOutput.onset_times.clear();
+
+    for( size_t frame=0; frame<num_frames; ++frame )
+    {
+        const float novelty = ComputeNovelty( frames[frame] );
+        mOutput.novelty[frame] = novelty;
+        mNoveltyHistory[mNumFrames%mNoveltyHistory.size()] = novelty;
+        ++mNumFrames;
+
+        while( mNextDecision + mLatency < mNumFrames )
+        {
+            Decide( mNextDecision++ );
+        }
+    }
+
+    return mOutput;
+}
+
+template< size_t FFT_SIZE >
+OnsetFrames& OnsetDetector< FFT_SIZE >::Flush()
+///
+/// Decides the frames still waiting on later frames, as though the stream ended after the last
+/// frame processed. Call this at the end of a stream.
+///
+/// @return
+///  The onsets decided, with no novelty values. This is overwritten by the next call.
+///
+{
+    mOutput.novelty.clear();
+    mOutput.onset_frames.clear();
+    mOutput.onset_times.clear();
+
+    while( mNextDecision < mNumFrames )
+    {
+        Decide( mNextDecision++ );
+    }
+
+    return mOutput;
+}
+
+template< size_t FFT_SIZE >
+void OnsetDetector< FFT_SIZE >::Reset()
+///
+/// Starts a new stream. Frames are counted from zero again, and the first frame's flux is
+/// measured against silence.
+///
+{
+    std::fill( mPreviousMagnitude.begin(), mPreviousMagnitude.end(), 0.0f );
+    mNumFrames = 0;
+    mNextDecision = 0;
+    mLastOnset = 0;
+    mHasOnset = false;
+}
+
+template< size_t FFT_SIZE >
+const size_t OnsetDetector< FFT_SIZE >::GetLatencyFrames() const
+///
+/// Get the number of frames after a frame that are needed to decide whether it is an onset.
+///
+/// @return
+///  The latency of onset reports in frames.
+///
+{
+    return mLatency;
+}
+
+template< size_t FFT_SIZE >
+const uint64_t OnsetDetector< FFT_SIZE >::GetNumFrames() const
+///
+/// Get the number of frames processed since construction or the last reset.
+///
+/// @return
+///  The number of frames.
+///
+{
+    return mNumFrames;
+}
+
+template< size_t FFT_SIZE >
+float OnsetDetector< FFT_SIZE >::ComputeNovelty( const Frame& frame )
+///
+/// Computes the spectral flux of a frame against the previous frame, and keeps its magnitudes.
+///
+/// @param frame
+///  The new frame.
+///
+/// @return
+///  The novelty of the frame.
+///
+{
+    const float* bins = reinterpret_cast< const float* >( frame.data() );
+    float flux = 0.0f;
+    for( size_t bin=0; bin<mInputSize; ++bin )
+    {
+        float magnitude = std::sqrt( bins[2*bin]*bins[2*bin] + bins[2*bin+1]*bins[2*bin+1] );
+        magnitude = mCompression > 0.0f ? std::log1p( mCompression*magnitude ) : magnitude;
+        flux += std::max( magnitude - mPreviousMagnitude[bin], 0.0f );
+        mPreviousMagnitude[bin] = magnitude;
+    }
+    return flux/mInputSize;
+}
+
+template< size_t FFT_SIZE >
+void OnsetDetector< FFT_SIZE >::Decide( uint64_t frame )
+///
+/// Decides whether a frame is an onset, using the frames on either side of it that have been
+/// seen, and adds it to the output if so.
+///
+/// @param frame
+///  The frame to decide. All frames up to mNumFrames - 1 are in the novelty history.
+///
+{
+    const size_t history = mNoveltyHistory.size();
+    const float novelty = mNoveltyHistory[frame%history];
+    const uint64_t last_frame = mNumFrames - 1;
+
+    // It must be the largest value in its neighbourhood.
+    const uint64_t max_begin = frame - std::min< uint64_t >( frame, mPreMax );
+    const uint64_t max_end = std::min< uint64_t >( last_frame, frame + mPostMax );
+    for( uint64_t other=max_begin; other<=max_end; ++other )
+    {
+        if( mNoveltyHistory[other%history] > novelty )
+        {
+            return;
+        }
+    }
+
+    // It must stand out from the mean of its neighbourhood.
+    const uint64_t avg_begin = frame - std::min< uint64_t >( frame, mPreAvg );
+    const uint64_t avg_end = std::min< uint64_t >( last_frame, frame + mPostAvg );
+    float sum = 0.0f;
+    for( uint64_t other=avg_begin; other<=avg_end; ++other )
+    {
+        sum += mNoveltyHistory[other%history];
+    }
+    if( novelty < sum/( avg_end - avg_begin + 1 ) + mDelta )
+    {
+        return;
+    }
+
+    // And it must not follow too closely on the previous onset.
+    if( mHasOnset && frame - mLastOnset <= mWait )
+    {
+        return;
+    }
+
+    mHasOnset = true;
+    mLastOnset = frame;
+    mOutput.onset_frames.push_back( frame );
+    mOutput.onset_times.push_back( frame*mFramePeriod );
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_ONSET_DETECTOR_H
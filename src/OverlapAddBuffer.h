@@ -9,7 +9,7 @@
 #define CUPCAKE_OVERLAP_ADD_BUFFER_H
 
 // In module includes
-// None.
+#include "Kernels.h"
 
 // Thirdparty includes
 #include "vector_functions.h"
@@ -32,6 +32,7 @@ public:
     ~OverlapAddBuffer();
     
     void PushSamples( const std::vector< T >& samples );
+    void PushSamples( const T* samples, size_t num_samples );
     void IncrementWritePosition( size_t increment);
     void PopFront( size_t numElements );
     void Read( std::vector< T >& output );
@@ -113,17 +114,33 @@ void OverlapAddBuffer< T >::PushSamples( const std::vector< T >& samples )
 /// @param samples
 ///  A vector of samples to be added to the buffer.
 ///
+{
+    PushSamples( samples.data(), samples.size() );
+}
+
+template< typename T >
+void OverlapAddBuffer< T >::PushSamples( const T* samples, size_t num_samples )
+///
+/// Adds samples to the buffer at the current write position, as for the vector overload, reading
+/// them from memory owned by the caller.
+///
+/// @param samples
+///  A pointer to the first of the samples to be added to the buffer.
+///
+/// @param num_samples
+///  The number of samples to be added.
+///
 {
     
-    assert( samples.size() <= SpaceRemaining() ); // Buffer overflow if this condition is false.
+    assert( num_samples <= SpaceRemaining() ); // Buffer overflow if this condition is false.
     
     size_t samples_until_end = mBufferLength - mWriteHead;
     
-    veclib::vec_add_in_place( samples.data(), mData.data() + mWriteHead, std::min( samples.size(), samples_until_end ) );
+    kernels::vec_add_in_place( samples, mData.data() + mWriteHead, std::min( num_samples, samples_until_end ) );
     
-    if( samples.size() > samples_until_end )
+    if( num_samples > samples_until_end )
     {
-        veclib::vec_add_in_place( samples.data() + samples_until_end, mData.data(), samples.size() - samples_until_end );
+        kernels::vec_add_in_place( samples + samples_until_end, mData.data(), num_samples - samples_until_end );
     }
     
 }
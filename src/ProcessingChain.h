@@ -0,0 +1,508 @@
+//
+// Created: 10/18/26 by agent
+//
+// Compile time composition of per-frame signal processing stages.
+//
+
+#ifndef CUPCAKE_PROCESSING_CHAIN_H
+#define CUPCAKE_PROCESSING_CHAIN_H
+
+// In module includes
+#include "STFTSynthesis.h"
+#include "FastCQT.h"
+#include "Kernels.h"
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <array>
+#include <complex>
+#include <tuple>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <assert.h>
+
+namespace cupcake
+{
+
+//
+// Stages
+//
+// A stage processes one frame at a time. It declares the type of frame it takes as Input and the
+// type it produces as Output, and provides:
+//
+//     void Process( const Input& input, Output& output );
+//
+// A stage whose Input and Output are the same type works in place: the chain passes it the same
+// frame as both input and output, so it must allow the two to alias.
+//
+
+struct FFTConfigDeleter
+///
+/// Releases an FFT configuration owned by a std::unique_ptr, so that stages holding one may be moved.
+///
+{
+    void operator()( veclib::FFTConfig* config ) const
+    {
+        veclib::destroy_FFT( *config );
+        delete config;
+    }
+};
+
+typedef std::unique_ptr< veclib::FFTConfig, FFTConfigDeleter > FFTConfigPtr;
+
+inline FFTConfigPtr make_FFT_config( size_t fft_size )
+///
+/// Creates an FFT configuration for a given transform size.
+///
+{
+    FFTConfigPtr config( new veclib::FFTConfig() );
+    veclib::make_FFT( fft_size, *config );
+    return config;
+}
+
+template< size_t FFT_SIZE >
+class WindowStage
+///
+/// Reads a frame of samples in place and multiplies it by the analysis window, zero padding it to
+/// the FFT size.
+///
+{
+public:
+    typedef const float* Input;
+    typedef std::array< float, FFT_SIZE > Output;
+
+    WindowStage( const std::vector< float >& window );
+
+    void Process( const Input& input, Output& output ) const;
+    const std::vector< float >& GetWindow() const { return mWindow; };
+
+private:
+
+    //
+    // Configuration
+    //
+    std::vector< float > mWindow;
+};
+
+template< size_t FFT_SIZE >
+class FFTStage
+///
+/// Transforms a zero padded time domain frame to its positive frequency spectrum.
+///
+{
+public:
+    typedef std::array< float, FFT_SIZE > Input;
+    typedef std::array< std::complex< float >, veclib::get_output_FFT_size( FFT_SIZE ) > Output;
+
+    FFTStage();
+
+    void Process( const Input& input, Output& output );
+
+private:
+
+    //
+    // Mechanics
+    //
+    FFTConfigPtr mFFTConfig;
+};
+
+template< size_t FFT_SIZE >
+class FastCQTStage
+///
+/// Applies the fast CQT filtering across frequency to a spectrum, in place.
+///
+{
+public:
+    typedef std::array< std::complex< float >, veclib::get_output_FFT_size( FFT_SIZE ) > Input;
+    typedef Input Output;
+
+    FastCQTStage( size_t window_size );
+
+    void Process( const Input& input, Output& output ) const;
+    const FastCQT< FFT_SIZE >& GetCQT() const { return *mCQT; };
+
+private:
+
+    //
+    // Mechanics
+    //
+    std::unique_ptr< FastCQT< FFT_SIZE > > mCQT;
+};
+
+template< size_t SIZE >
+class MagnitudeStage
+///
+/// Takes the magnitude of each complex bin.
+///
+{
+public:
+    typedef std::array< std::complex< float >, SIZE > Input;
+    typedef std::array< float, SIZE > Output;
+
+    void Process( const Input& input, Output& output ) const;
+};
+
+template< size_t SIZE, size_t FACTOR >
+class PoolingStage
+///
+/// Averages each group of FACTOR adjacent bins into one. A final, partial group is averaged over
+/// the bins it contains.
+///
+{
+public:
+    static_assert( FACTOR > 0, "The pooling factor must be positive" );
+
+    typedef std::array< float, SIZE > Input;
+    typedef std::array< float, ( SIZE + FACTOR - 1 )/FACTOR > Output;
+
+    void Process( const Input& input, Output& output ) const;
+};
+
+template< size_t FFT_SIZE >
+class SynthesisStage
+///
+/// Transforms a spectrum back to the time domain, truncated to the window length and normalised
+/// as in STFTSynthesis. The remainder of the output frame is zero. Successive output frames
+/// overlap-added at the synthesis increment reconstruct the signal.
+///
+{
+public:
+    typedef std::array< std::complex< float >, veclib::get_output_FFT_size( FFT_SIZE ) > Input;
+    typedef std::array< float, FFT_SIZE > Output;
+
+    SynthesisStage( size_t sample_increment, const std::vector< float >& window );
+
+    void Process( const Input& input, Output& output );
+    const size_t GetWinLen() const { return mWinLen; };
+
+private:
+
+    //
+    // Configuration
+    //
+    const size_t mWinLen;
+    const float mNormalisationMult;
+
+    //
+    // Mechanics
+    //
+    FFTConfigPtr mFFTConfig;
+};
+
+
+//
+// Chain
+//
+
+template< typename... Stages >
+class ProcessingChain
+///
+/// A fixed sequence of stages, chosen at compile time, that is run over each frame in turn.
+///
+/// All stages are run on one frame before the next frame is started, so the intermediate results
+/// are a single frame per stage, which stay in cache, rather than blocks of frames. The calls
+/// between stages are resolved at compile time, so they may be inlined into a single loop. Stages
+/// that work in place share the previous stage's frame, and the final stage writes directly to the
+/// caller's output.
+///
+/// An instance may only be used by one thread at a time.
+///
+{
+    static const size_t NUM_STAGES = sizeof...( Stages );
+    static_assert( NUM_STAGES > 0, "A chain needs at least one stage" );
+
+    typedef std::tuple< Stages... > StageTuple;
+    template< size_t I > using StageType = typename std::tuple_element< I, StageTuple >::type;
+
+public:
+
+    typedef typename StageType< 0 >::Input Input;
+    typedef typename StageType< NUM_STAGES - 1 >::Output Output;
+
+    explicit ProcessingChain( Stages... stages );
+
+    void ProcessFrame( const Input& input, Output& output );
+    void ProcessFrames( const float* samples, size_t num_frames, size_t increment, Output* output );
+
+    template< size_t I > StageType< I >& GetStage() { return std::get< I >( mStages ); };
+    template< size_t I > const StageType< I >& GetStage() const { return std::get< I >( mStages ); };
+
+private:
+
+    //
+    // Helpers
+    //
+    typedef std::integral_constant< int, 0 > LastStage;
+    typedef std::integral_constant< int, 1 > InPlaceStage;
+    typedef std::integral_constant< int, 2 > OutOfPlaceStage;
+
+    template< size_t I > using StageKind = std::integral_constant< int, I + 1 == NUM_STAGES ? 0 : std::is_same< typename StageType< I >::Input, typename StageType< I >::Output >::value ? 1 : 2 >;
+
+    template< size_t I, typename Current > void RunStage( Current& current, Output& output, LastStage );
+    template< size_t I, typename Current > void RunStage( Current& current, Output& output, InPlaceStage );
+    template< size_t I, typename Current > void RunStage( Current& current, Output& output, OutOfPlaceStage );
+
+    //
+    // Mechanics
+    //
+    StageTuple mStages;
+
+    //
+    // Data
+    //
+    std::unique_ptr< std::tuple< typename Stages::Output... > > mScratch;   // One frame per stage, only used by stages that are neither last nor in place.
+};
+
+template< typename... Stages >
+ProcessingChain< Stages... > make_processing_chain( Stages... stages )
+///
+/// Creates a chain from its stages, deducing the type of the chain.
+///
+{
+    return ProcessingChain< Stages... >( std::move( stages )... );
+}
+
+// The per-frame processing of FastWavelet: window, FFT and fast CQT.
+template< size_t FFT_SIZE >
+using FastWaveletChain = ProcessingChain< WindowStage< FFT_SIZE >, FFTStage< FFT_SIZE >, FastCQTStage< FFT_SIZE > >;
+
+
+//
+// Stage implementations
+//
+
+template< size_t FFT_SIZE >
+WindowStage< FFT_SIZE >::WindowStage( const std::vector< float >& window ) :
+    mWindow( window )
+///
+/// Constructor.
+///
+/// @param window
+///  The windowing function, which also sets the frame length. This must be no longer than FFT_SIZE.
+///
+{
+    assert( mWindow.size() <= FFT_SIZE );
+}
+
+template< size_t FFT_SIZE >
+void WindowStage< FFT_SIZE >::Process( const Input& input, Output& output ) const
+///
+/// Windows one frame.
+///
+/// @param input
+///  A pointer to the first sample of the frame, which must have at least as many samples as the window.
+///
+/// @param output
+///  The windowed frame, zero padded to FFT_SIZE.
+///
+{
+    kernels::vec_mult( input, mWindow.data(), output.data(), mWindow.size() );
+    std::fill( output.begin() + mWindow.size(), output.end(), 0.0f );
+}
+
+template< size_t FFT_SIZE >
+FFTStage< FFT_SIZE >::FFTStage() :
+    mFFTConfig( make_FFT_config( FFT_SIZE ) )
+///
+/// Constructor.
+///
+{
+}
+
+template< size_t FFT_SIZE >
+void FFTStage< FFT_SIZE >::Process( const Input& input, Output& output )
+///
+/// Transforms one frame.
+///
+{
+    veclib::FFT_not_in_place( input.data(), output.data(), *mFFTConfig );
+}
+
+template< size_t FFT_SIZE >
+FastCQTStage< FFT_SIZE >::FastCQTStage( size_t window_size ) :
+    mCQT( new FastCQT< FFT_SIZE >( window_size ) )
+///
+/// Constructor.
+///
+/// @param window_size
+///  The length of the analysis window, which sets the CQT filter coefficients.
+///
+{
+}
+
+template< size_t FFT_SIZE >
+void FastCQTStage< FFT_SIZE >::Process( const Input& input, Output& output ) const
+///
+/// Filters one spectrum. The input and output may be the same frame.
+///
+{
+    if( &input != &output )
+    {
+        output = input;
+    }
+    mCQT->ApplyInPlace( &output, 1 );
+}
+
+template< size_t SIZE >
+void MagnitudeStage< SIZE >::Process( const Input& input, Output& output ) const
+///
+/// Takes the magnitude of one spectrum.
+///
+{
+    std::transform( input.begin(), input.end(), output.begin(), []( const std::complex< float >& bin ){ return std::abs( bin ); } );
+}
+
+template< size_t SIZE, size_t FACTOR >
+void PoolingStage< SIZE, FACTOR >::Process( const Input& input, Output& output ) const
+///
+/// Pools one frame of values.
+///
+{
+    for( size_t group=0; group<output.size(); ++group )
+    {
+        const size_t first = group*FACTOR;
+        const size_t last = std::min( first + FACTOR, SIZE );
+        float sum = 0.0f;
+        for( size_t bin=first; bin<last; ++bin )
+        {
+            sum += input[bin];
+        }
+        output[group] = sum/static_cast< float >( last - first );
+    }
+}
+
+template< size_t FFT_SIZE >
+SynthesisStage< FFT_SIZE >::SynthesisStage( size_t sample_increment, const std::vector< float >& window ) :
+    mWinLen( window.size() ),
+    mNormalisationMult( STFTSynthesis< FFT_SIZE >::ComputeNormalizationMultiplier( sample_increment, window ) ),
+    mFFTConfig( make_FFT_config( FFT_SIZE ) )
+///
+/// Constructor.
+///
+/// @param sample_increment
+///  The number of samples between successive frames when they are overlap-added.
+///
+/// @param window
+///  The window used in the analysis of the frames.
+///
+{
+    assert( mWinLen <= FFT_SIZE );
+}
+
+template< size_t FFT_SIZE >
+void SynthesisStage< FFT_SIZE >::Process( const Input& input, Output& output )
+///
+/// Synthesises one frame.
+///
+{
+    veclib::IFFT_not_in_place( input.data(), output.data(), *mFFTConfig );
+    kernels::vec_mult_const_in_place( output.data(), mNormalisationMult, mWinLen );
+    std::fill( output.begin() + mWinLen, output.end(), 0.0f );
+}
+
+
+//
+// Chain implementation
+//
+
+template< typename... Stages >
+ProcessingChain< Stages... >::ProcessingChain( Stages... stages ) :
+    mStages( std::move( stages )... ),
+    mScratch( new std::tuple< typename Stages::Output... >() )
+///
+/// Constructor.
+///
+/// @param stages
+///  The stages, in the order they are applied. The output of each must be the input of the next.
+///
+{
+}
+
+template< typename... Stages >
+void ProcessingChain< Stages... >::ProcessFrame( const Input& input, Output& output )
+///
+/// Runs every stage over one frame.
+///
+/// @param input
+///  The input of the first stage.
+///
+/// @param output
+///  Written with the output of the last stage.
+///
+{
+    RunStage< 0 >( input, output, StageKind< 0 >() );
+}
+
+template< typename... Stages >
+void ProcessingChain< Stages... >::ProcessFrames( const float* samples, size_t num_frames, size_t increment, Output* output )
+///
+/// Runs every stage over a number of successive frames of contiguous samples. This is only
+/// available for chains that start with a WindowStage (or another stage taking a pointer to samples).
+///
+/// @param samples
+///  A pointer to the first sample of the first frame. Frame n starts at samples + n*increment.
+///
+/// @param num_frames
+///  The number of frames to process.
+///
+/// @param increment
+///  The number of samples between the start of successive frames.
+///
+/// @param output
+///  A pointer to memory for num_frames outputs.
+///
+{
+    static_assert( std::is_same< Input, const float* >::value, "Only chains taking pointers to samples can process frames of samples" );
+
+    for( size_t frame=0; frame<num_frames; ++frame )
+    {
+        ProcessFrame( samples + frame*increment, output[frame] );
+    }
+}
+
+template< typename... Stages >
+template< size_t I, typename Current >
+void ProcessingChain< Stages... >::RunStage( Current& current, Output& output, LastStage )
+///
+/// Runs the last stage, writing to the caller's output.
+///
+{
+    std::get< I >( mStages ).Process( current, output );
+}
+
+template< typename... Stages >
+template< size_t I, typename Current >
+void ProcessingChain< Stages... >::RunStage( Current& current, Output& output, InPlaceStage )
+///
+/// Runs an in place stage on the current frame, then the rest of the chain.
+///
+{
+    static_assert( std::is_same< typename StageType< I >::Output, typename StageType< I + 1 >::Input >::value, "Each stage must take the output of the previous stage" );
+    static_assert( !std::is_const< Current >::value, "The first stage cannot work in place" );
+
+    std::get< I >( mStages ).Process( current, current );
+    RunStage< I + 1 >( current, output, StageKind< I + 1 >() );
+}
+
+template< typename... Stages >
+template< size_t I, typename Current >
+void ProcessingChain< Stages... >::RunStage( Current& current, Output& output, OutOfPlaceStage )
+///
+/// Runs a stage into its own frame, then the rest of the chain on that frame.
+///
+{
+    static_assert( std::is_same< typename StageType< I >::Output, typename StageType< I + 1 >::Input >::value, "Each stage must take the output of the previous stage" );
+
+    auto& next = std::get< I >( *mScratch );
+    std::get< I >( mStages ).Process( current, next );
+    RunStage< I + 1 >( next, output, StageKind< I + 1 >() );
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_PROCESSING_CHAIN_H
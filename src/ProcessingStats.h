@@ -0,0 +1,137 @@
+//
+// Created: 10/18/26 by agent
+//
+// Low overhead timing and counters for the processing stages.
+//
+// Instrumentation is compiled in only when CUPCAKE_ENABLE_STATS is defined to 1, otherwise the timers
+// and counters below compile to nothing and all statistics read as zero.
+//
+
+#ifndef CUPCAKE_PROCESSING_STATS_H
+#define CUPCAKE_PROCESSING_STATS_H
+
+#ifndef CUPCAKE_ENABLE_STATS
+#define CUPCAKE_ENABLE_STATS 0
+#endif
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#endif
+
+namespace cupcake
+{
+
+struct ProcessingStats
+///
+/// Totals accumulated since construction or the last reset. Times are in units of
+/// read_cycle_counter(), i.e., CPU timestamp counter cycles where available and otherwise
+/// nanoseconds (see stats_counter_unit()).
+///
+{
+    uint64_t calls = 0;                     // Number of calls into the instrumented object.
+    uint64_t total_cycles = 0;              // Time spent in those calls, in total.
+    uint64_t buffer_cycles = 0;             // Time spent copying samples into and out of buffers.
+    uint64_t window_cycles = 0;             // Time spent applying the analysis window.
+    uint64_t fft_cycles = 0;                // Time spent in FFTs.
+    uint64_t cqt_cycles = 0;                // Time spent in the fast CQT IIR sweeps.
+    uint64_t frames = 0;                    // Number of output frames produced.
+    uint64_t bytes_moved = 0;               // Bytes copied into buffers, or read and written by a stage.
+    uint64_t buffer_occupancy = 0;          // Samples left in the input buffer after the last call.
+    uint64_t max_buffer_occupancy = 0;      // The most samples ever left in the input buffer after a call.
+};
+
+inline uint64_t read_cycle_counter()
+///
+/// Reads a fast, monotonic counter for timing short sections of code.
+///
+/// @return
+///  The CPU timestamp counter on x86, otherwise a steady clock in nanoseconds.
+///
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    return __rdtsc();
+#else
+    return static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+#endif
+}
+
+inline const char* stats_counter_unit()
+///
+/// @return
+///  The unit of the times recorded in ProcessingStats.
+///
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+inline void stats_add( uint64_t& counter, uint64_t value )
+///
+/// Adds to a statistics counter, if statistics are enabled.
+///
+{
+#if CUPCAKE_ENABLE_STATS
+    counter += value;
+#endif
+}
+
+inline void stats_set_occupancy( ProcessingStats& stats, uint64_t occupancy )
+///
+/// Records the buffer occupancy at the end of a call, if statistics are enabled.
+///
+{
+#if CUPCAKE_ENABLE_STATS
+    stats.buffer_occupancy = occupancy;
+    stats.max_buffer_occupancy = std::max( stats.max_buffer_occupancy, occupancy );
+#endif
+}
+
+class StatsTimer
+///
+/// Adds the time between its construction and destruction to a statistics counter, if statistics
+/// are enabled. Otherwise this is an empty object.
+///
+{
+public:
+
+#if CUPCAKE_ENABLE_STATS
+    StatsTimer( uint64_t& accumulator ) :
+        mAccumulator( accumulator ),
+        mStart( read_cycle_counter() )
+    {
+    }
+
+    ~StatsTimer()
+    {
+        mAccumulator += read_cycle_counter() - mStart;
+    }
+
+private:
+
+    //
+    // Data
+    //
+    uint64_t& mAccumulator;
+    const uint64_t mStart;
+#else
+    StatsTimer( uint64_t& ) {}
+#endif
+
+};
+
+} // namespace cupcake
+
+#endif // CUPCAKE_PROCESSING_STATS_H
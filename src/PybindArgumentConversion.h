@@ -7,8 +7,18 @@
 // @todo [matt.mccallum 10.02.17] This wrapping of C++ argument types should probably be
 //                                sitting in its own codebase as an extension to pybind11.
 
+#ifndef CUPCAKE_PYBIND_ARGUMENT_CONVERSION_H
+#define CUPCAKE_PYBIND_ARGUMENT_CONVERSION_H
+
 // In module includes.
-// None.
+#include "ArrayView.h"
+#include "ProcessingStats.h"
+#include "SpectralFeatures.h"
+#include "OnsetDetector.h"
+#include "MultiResolutionFastWavelet.h"
+#include "ExactCQT.h"
+#include "FrameDecimator.h"
+#include "BinRangeAnalyser.h"
 
 // Third party includes.
 #include "pybind11/pybind11.h"
@@ -16,7 +26,10 @@
 #include "pybind11/complex.h"
 
 // Std lib includes.
-// None.
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
 
 namespace py = pybind11;
 
@@ -35,6 +48,10 @@ struct python_argument_type{ typedef T type; };
 // Map std::vector<float> to py::array_t<float>, and its references.
 template<>
 struct python_argument_type<const std::vector<float>&>{ typedef py::array_t<float, 16> type; };
+// Map ArrayView<const float> to a C-contiguous float32 array. pybind11 passes arrays that already
+// have this layout straight through, and makes a single fused cast+copy of any other array.
+template<>
+struct python_argument_type<ArrayView<const float>>{ typedef py::array_t<float, py::array::c_style | py::array::forcecast> type; };
 
 
     
@@ -90,6 +107,27 @@ const std::vector<float> convert_arg<const std::vector<float>&>( typename python
     
 }
     
+
+// The python array to read-only view case.
+template<>
+ArrayView<const float> convert_arg<ArrayView<const float>>( typename python_argument_type<ArrayView<const float>>::type&& x )
+///
+/// Creates a view of the contents of a python array without copying them. The array argument
+/// holds a reference to the python array for the duration of the wrapped call, so the view remains
+/// valid until the C++ function returns. At the moment this is only implemented for 1D arrays.
+///
+/// @param x
+///  A 1D, C-contiguous, float32 python array.
+///
+/// @return
+///  A view of the contents of the python array.
+///
+{
+    if (x.ndim() != 1)
+        throw std::runtime_error("Number of dimensions must be one");
+    
+    return ArrayView<const float>( x.data(), static_cast<size_t>( x.shape( 0 ) ) );
+}
     
 
 //
@@ -117,11 +155,69 @@ arg convert_return( arg& x )
     return x; // @todo [matt.mccallum 10.01.17] This might copy the vector back to the output, not so great...
 }
     
+// Python ownership of C++ objects.
+template< typename owned_type >
+py::capsule owning_capsule( std::unique_ptr<owned_type>& x )
+///
+/// Hands a heap allocated C++ object over to a python capsule, which deletes the object once
+/// python releases its last reference to the capsule. Used as the base object of numpy arrays
+/// that refer directly to the memory of C++ vectors, so no copy of the vector is required.
+///
+/// @param x
+///  The object to be owned by the capsule. This is released from the unique_ptr once the capsule
+///  has been successfully created.
+///
+/// @return
+///  A capsule that owns the object.
+///
+{
+    py::capsule ret( x.get(), []( void* p ){ delete reinterpret_cast<owned_type*>( p ); } );
+    x.release();
+    return ret;
+}
+
+// Python ownership of the contents of C++ vectors.
+template< typename T >
+std::unique_ptr<std::vector<T>> take_contents( std::vector<T>& x )
+///
+/// Takes the contents of a vector (usually an output buffer of a C++ object) for a python array,
+/// leaving x empty.
+/// If x's contents fill at least half of its capacity, its memory is moved out and x is left without
+/// any, so the object that owns x allocates exactly what its next output needs. Otherwise the contents
+/// are copied into an exactly-sized vector, so that a python array holding a few frames does not keep
+/// a larger reservation alive. Outputs that are sized for each call are therefore always moved.
+///
+/// @param x
+///  The vector whose contents are to be taken.
+///
+/// @return
+///  A heap allocated vector holding the contents of x.
+///
+{
+    // Contents are moved rather than copied once they occupy at least this fraction of the capacity.
+    static const size_t MOVE_FRACTION_DENOMINATOR = 2;
+
+    std::unique_ptr<std::vector<T>> owned;
+    if( x.size() >= x.capacity()/MOVE_FRACTION_DENOMINATOR )
+    {
+        owned.reset( new std::vector<T>( std::move( x ) ) );
+        x = std::vector<T>();
+    }
+    else
+    {
+        owned.reset( new std::vector<T>( x.begin(), x.end() ) );
+        x.clear();
+    }
+    return owned;
+}
+
 // The std::vector to py::array conversion.
 py::array_t<float> convert_return( std::vector<float>& x )
 ///
 /// Converts a vector (likely returned from a C++ function) to a python array, that may be used
-/// back in python.
+/// back in python. The contents of the vector are taken with take_contents, so they are only
+/// copied when they are small relative to the vector's capacity. As with all the vector conversions
+/// below, this leaves x empty.
 ///
 /// @param x
 ///  A C++ vector to be converted to an array python can understand.
@@ -130,18 +226,40 @@ py::array_t<float> convert_return( std::vector<float>& x )
 ///  An array python can understand.
 ///
 {
-    py::array_t<float> ret( x.size(), x.data() );
+    std::unique_ptr<std::vector<float>> owned( take_contents( x ) );
+    const float* data = owned->data();
+    size_t size = owned->size();
+    
+    py::array_t<float> ret( size, data, owning_capsule( owned ) );
     return ret; // This will not copy the object on return as specified in return value optimization as specified in the C++ standard - 12.8 (32)
 }
+
+// The const std::vector to py::array conversion.
+py::array_t<float> convert_return( const std::vector<float>& x )
+///
+/// Converts a vector that is still owned by a C++ object (e.g. FastWavelet::GetWindow) to a python
+/// array. Such a vector cannot be moved from, so the python array holds a copy.
+///
+/// @param x
+///  A C++ vector to be copied into an array python can understand.
+///
+/// @return
+///  An array python can understand.
+///
+{
+    return py::array_t<float>( x.size(), x.data() ); // Without a base object, pybind11 copies the data.
+}
     
-// The std::vector<std::array<std::complex<float>,N>> to py::array conversion.
+// Python ownership of a block of frames.
 template< size_t ARRAY_SIZE >
-py::array_t<std::complex<float>> convert_return( std::vector<std::array<std::complex<float>, ARRAY_SIZE>>& x )
+py::array_t<std::complex<float>> owning_frames( std::unique_ptr<std::vector<std::array<std::complex<float>, ARRAY_SIZE>>>& owned )
 ///
-/// Converts a two dimensional complex valued C++ data block into a two dimensional Python array.
+/// Hands a heap allocated block of frames over to a two dimensional (frames x bins) python array,
+/// without copying them. This is used directly for frames that were analysed straight into a
+/// vector of exactly the right size, e.g. by FastWavelet::PushSamplesInto.
 ///
-/// @param x
-///  The two dimensional C++ array to be converted into a python array.
+/// @param owned
+///  The frames, released from the unique_ptr once the array owns them.
 ///
 /// @return
 ///  The resulting python C++ object that is interpretable by pybind11 and hence Python.
@@ -149,22 +267,46 @@ py::array_t<std::complex<float>> convert_return( std::vector<std::array<std::com
 {
     std::vector<size_t> shape(2, 0);
     std::vector<size_t> strides(2, 0);
-    shape[0] = x.size();
-    shape[1] = x[0].size();
-    strides[0] = (x[0].size())*sizeof( std::complex<float> );
+    shape[0] = owned->size();
+    shape[1] = ARRAY_SIZE;
+    strides[0] = ARRAY_SIZE*sizeof( std::complex<float> );
     strides[1] = 1*sizeof( std::complex<float> );
+    const std::complex<float>* data = reinterpret_cast<const std::complex<float>*>( owned->data() );
     
     py::array_t<std::complex<float>> ret( shape,
                                          strides,
-                                         x[0].data() );
+                                         data,
+                                         owning_capsule( owned ) );
 
     return ret; // This will not copy the object on return as specified in return value optimization as specified in the C++ standard - 12.8 (32)
 }
     
+// The std::vector<std::array<std::complex<float>,N>> to py::array conversion.
+template< size_t ARRAY_SIZE >
+py::array_t<std::complex<float>> convert_return( std::vector<std::array<std::complex<float>, ARRAY_SIZE>>& x )
+///
+/// Converts a two dimensional complex valued C++ data block into a two dimensional Python array.
+/// The frames are taken with take_contents. FastWavelet::PushSamples and PushSamplesParallel do not
+/// come through here, as their frames are analysed straight into an array with owning_frames.
+///
+/// @param x
+///  The two dimensional C++ array to be converted into a python array.
+///
+/// @return
+///  The resulting python C++ object that is interpretable by pybind11 and hence Python.
+///
+{
+    typedef std::vector<std::array<std::complex<float>, ARRAY_SIZE>> frames_type;
+    
+    std::unique_ptr<frames_type> owned( take_contents( x ) );
+    return owning_frames( owned );
+}
+    
 // The std::vector<std::complex<float>> to py:array conversion
 py::array_t<std::complex<float>> convert_return( std::vector<std::complex<float>>& x )
 ///
-/// Converts a single dimensional complex valued C++ data block into a single dimensional Python array.
+/// Converts a single dimensional complex valued C++ data block into a single dimensional Python array,
+/// taking the contents of the vector with take_contents.
 ///
 /// @param x
 ///  The single dimensional C++ array to be converted.
@@ -173,11 +315,252 @@ py::array_t<std::complex<float>> convert_return( std::vector<std::complex<float>
 ///  The resulting python C++ object that is interpretable by pybind11 and hence Python.
 ///
 {
-    py::array_t<std::complex<float>> ret( x.size(), x.data() );
+    std::unique_ptr<std::vector<std::complex<float>>> owned( take_contents( x ) );
+    const std::complex<float>* data = owned->data();
+    size_t size = owned->size();
+    
+    py::array_t<std::complex<float>> ret( size, data, owning_capsule( owned ) );
+    return ret;
+}
+
+// The const std::vector<std::complex<float>> to py:array conversion
+py::array_t<std::complex<float>> convert_return( const std::vector<std::complex<float>>& x )
+///
+/// Converts a single dimensional complex valued vector that is still owned by a C++ object (e.g.
+/// FastWavelet::GetCQTCoeffs) to a python array holding a copy.
+///
+/// @param x
+///  The single dimensional C++ array to be copied.
+///
+/// @return
+///  The resulting python C++ object that is interpretable by pybind11 and hence Python.
+///
+{
+    return py::array_t<std::complex<float>>( x.size(), x.data() ); // Without a base object, pybind11 copies the data.
+}
+    
+// Python ownership of C++ vectors of any shape.
+template< typename T >
+py::array_t<T> owning_array( std::vector<T>& x, std::vector<size_t> shape )
+///
+/// Hands the contents of a vector to a C-contiguous python array owned by python, leaving x empty.
+/// The contents are taken with take_contents.
+///
+/// @param x
+///  The vector, holding the product of shape elements.
+///
+/// @param shape
+///  The shape of the array.
+///
+/// @return
+///  The python array.
+///
+{
+    std::unique_ptr<std::vector<T>> owned( take_contents( x ) );
+    std::vector<size_t> strides( shape.size(), sizeof( T ) );
+    for( size_t dim=shape.size(); dim>1; --dim )
+    {
+        strides[dim-2] = strides[dim-1]*shape[dim-1];
+    }
+    const T* data = owned->data();
+    return py::array_t<T>( shape, strides, data, owning_capsule( owned ) );
+}
+    
+// The SpectralFeatureFrames to python dictionary conversion.
+py::dict convert_return( SpectralFeatureFrames& x )
+///
+/// Converts the features of a block of frames into a python dictionary of arrays, keyed by
+/// "chroma" (frames x 12), "bands" (frames x bands), "centroid" and "flux" (frames). As with the
+/// vector conversions, each feature's memory is taken with take_contents, leaving x empty.
+///
+/// @param x
+///  The features to be converted.
+///
+/// @return
+///  A dictionary of the features.
+///
+{
+    py::dict ret;
+    ret["chroma"] = owning_array( x.chroma, { x.num_frames, SpectralFeatureFrames::NUM_CHROMA } );
+    ret["bands"] = owning_array( x.bands, { x.num_frames, x.num_bands } );
+    ret["centroid"] = owning_array( x.centroid, { x.num_frames } );
+    ret["flux"] = owning_array( x.flux, { x.num_frames } );
+    return ret;
+}
+    
+// The OnsetFrames to python dictionary conversion.
+py::dict convert_return( OnsetFrames& x )
+///
+/// Converts the output of onset detection into a python dictionary of 1D arrays, keyed by
+/// "novelty", "onset_frames" and "onset_times". The arrays take over the memory of x.
+///
+/// @param x
+///  The novelty and onsets to be converted.
+///
+/// @return
+///  A dictionary of the novelty and onsets.
+///
+{
+    py::dict ret;
+    ret["novelty"] = owning_array( x.novelty, { x.novelty.size() } );
+    ret["onset_frames"] = owning_array( x.onset_frames, { x.onset_frames.size() } );
+    ret["onset_times"] = owning_array( x.onset_times, { x.onset_times.size() } );
+    return ret;
+}
+    
+// The MultiResolutionFrames to py::array conversion.
+py::array_t<std::complex<float>> convert_return( MultiResolutionFrames& x )
+///
+/// Converts stitched multi-resolution frames into a two dimensional (frames x bins) complex python
+/// array, which takes over the memory of x.
+///
+/// @param x
+///  The frames to be converted.
+///
+/// @return
+///  The python array.
+///
+{
+    return owning_array( x.values, { x.num_frames, x.num_bins } );
+}
+    
+// The ExactCQTFrames to py::array conversion.
+py::array_t<std::complex<float>> convert_return( ExactCQTFrames& x )
+///
+/// Converts constant-Q frames into a two dimensional (frames x bins) complex python array, which
+/// takes over the memory of x.
+///
+/// @param x
+///  The frames to be converted.
+///
+/// @return
+///  The python array.
+///
+{
+    return owning_array( x.values, { x.num_frames, x.num_bins } );
+}
+    
+// The BinRangeFrames to py::array conversion.
+py::array_t<std::complex<float>> convert_return( BinRangeFrames& x )
+///
+/// Converts the bins of a range of frames into a two dimensional (frames x bins) complex python
+/// array, which takes over the memory of x.
+///
+/// @param x
+///  The frames to be converted.
+///
+/// @return
+///  The python array.
+///
+{
+    return owning_array( x.values, { x.num_frames, x.num_bins } );
+}
+    
+// The DecimatedFrames to python list conversion.
+py::list convert_return( DecimatedFrames& x )
+///
+/// Converts multi-rate frames into a python list with a dictionary for each band, from low to
+/// high frequency, keyed by "first_bin", "decimation", "first_frame" and "frames", a two dimensional
+/// (frames x bins) complex array which takes over the memory of that band in x.
+///
+/// @param x
+///  The frames to be converted.
+///
+/// @return
+///  A list of the bands.
+///
+{
+    py::list ret;
+    for( DecimatedBand& band : x.bands )
+    {
+        py::dict entry;
+        entry["first_bin"] = band.first_bin;
+        entry["decimation"] = band.decimation;
+        entry["first_frame"] = band.first_frame;
+        entry["frames"] = owning_array( band.values, { band.num_frames, band.num_bins } );
+        ret.append( entry );
+    }
+    return ret;
+}
+    
+// The ProcessingStats to python dictionary conversion.
+py::dict convert_return( ProcessingStats& x )
+///
+/// Converts processing statistics into a python dictionary, keyed by the names of the fields
+/// of ProcessingStats. The unit of all times is given under the key "counter_unit".
+///
+/// @param x
+///  The statistics to be converted.
+///
+/// @return
+///  A dictionary of the statistics.
+///
+{
+    py::dict ret;
+    ret["calls"] = x.calls;
+    ret["total_cycles"] = x.total_cycles;
+    ret["buffer_cycles"] = x.buffer_cycles;
+    ret["window_cycles"] = x.window_cycles;
+    ret["fft_cycles"] = x.fft_cycles;
+    ret["cqt_cycles"] = x.cqt_cycles;
+    ret["frames"] = x.frames;
+    ret["bytes_moved"] = x.bytes_moved;
+    ret["buffer_occupancy"] = x.buffer_occupancy;
+    ret["max_buffer_occupancy"] = x.max_buffer_occupancy;
+    ret["counter_unit"] = stats_counter_unit();
+    ret["enabled"] = static_cast<bool>( CUPCAKE_ENABLE_STATS );
     return ret;
 }
     
 
+//
+// Thread safety
+//
+    
+// The default...
+template< typename obj >
+std::unique_lock<std::mutex> lock_instance( obj* o, long )
+///
+/// Objects that provide no mutex are not locked by the wrapped functions.
+///
+/// @param o
+///  The object a wrapped method is about to be called on.
+///
+/// @return
+///  A lock that does not own any mutex.
+///
+{
+    return std::unique_lock<std::mutex>();
+}
+    
+// Objects providing GetMutex()...
+template< typename obj >
+auto lock_instance( obj* o, int ) -> decltype( std::unique_lock<std::mutex>( o->GetMutex() ) )
+///
+/// Locks the mutex of an object that provides one via GetMutex(), so that python threads sharing
+/// a single instance have their calls on that instance serialized.
+///
+/// @param o
+///  The object a wrapped method is about to be called on.
+///
+/// @return
+///  A lock owning the object's mutex.
+///
+{
+    return std::unique_lock<std::mutex>( o->GetMutex() );
+}
+    
+template< typename F, typename tuple_type, size_t... I >
+decltype(auto) apply_tuple( F&& f, tuple_type& t, std::index_sequence<I...> )
+///
+/// Calls a function with the elements of a tuple as its arguments.
+///
+{
+    return f( std::get<I>( t )... );
+}
+    
+    
+    
 //
 // Function converters
 //
@@ -193,6 +576,8 @@ void py_wrapped_ctor( obj& instance, typename python_argument_type<args>::type..
 /// It also must choose between the many possible constructors of a class
 /// and so the `args` to the constructor should usually be provided explicitly
 /// in the template.
+/// The arguments are converted while holding the GIL, and the object is then
+/// constructed (which may allocate large buffers) with the GIL released.
 ///
 /// @param instance
 ///  The soon-to-be memory location of the new object.
@@ -201,7 +586,10 @@ void py_wrapped_ctor( obj& instance, typename python_argument_type<args>::type..
 ///  The arguments passed into the new object upon construction.
 ///
 {
-    new (&instance) obj( convert_arg<args>( std::forward<typename python_argument_type<args>::type>( a ) )... );
+    auto converted = std::make_tuple( convert_arg<args>( std::forward<typename python_argument_type<args>::type>( a ) )... );
+    
+    py::gil_scoped_release release;
+    apply_tuple( [&instance]( auto&... c ){ new (&instance) obj( c... ); }, converted, std::index_sequence_for<args...>() );
 }
 
 template< typename... args, typename obj, typename ret >
@@ -209,6 +597,10 @@ auto py_wrapped_func( ret (obj::*f)( args... ) )
 ///
 /// A factory function for creating function pointers that wrap up class methods and automatically
 /// convert all function arguments to/from python types, before and after calling the C++ function.
+/// The C++ function itself is called with the GIL released, so other python threads may run (and
+/// drive other objects) while it computes. Objects providing GetMutex() are locked from before the
+/// call until its result has been converted, so python threads sharing an instance are serialized.
+/// The GIL is always released before waiting on the lock, so this cannot deadlock with the GIL.
 ///
 /// @param f
 ///  The function pointer to be wrapped up.
@@ -219,7 +611,20 @@ auto py_wrapped_func( ret (obj::*f)( args... ) )
 {
     return [f]( obj* o, typename python_argument_type<args>::type&... a )
     {
-        auto x = (o->*f)( convert_arg<args>( std::forward<typename python_argument_type<args>::type>( a ) )... );
+        // Conversion of arguments may touch python objects, so is done holding the GIL.
+        auto converted = std::make_tuple( convert_arg<args>( std::forward<typename python_argument_type<args>::type>( a ) )... );
+        
+        std::unique_lock<std::mutex> lock;
+        auto call = [&]() -> decltype(auto)
+        {
+            py::gil_scoped_release release;
+            lock = lock_instance( o, 0 );
+            return apply_tuple( [o, f]( auto&... c ) -> decltype(auto) { return (o->*f)( c... ); }, converted, std::index_sequence_for<args...>() );
+        };
+        
+        // @note Methods returning a reference to an output buffer bind to x here rather than being copied,
+        //       and the conversion then hands the buffer's contents over to python.
+        decltype(auto) x = call();
         auto y = convert_return( x );
         return y;
     };
@@ -227,3 +632,4 @@ auto py_wrapped_func( ret (obj::*f)( args... ) )
     
 } // namespace cupcake
 
+#endif // CUPCAKE_PYBIND_ARGUMENT_CONVERSION_H
@@ -0,0 +1,335 @@
+//
+// Created: 10/18/26 by agent
+//
+// Bounded single-producer/single-consumer lock-free queue, for handing blocks between threads.
+//
+
+#ifndef CUPCAKE_SPSC_QUEUE_H
+#define CUPCAKE_SPSC_QUEUE_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <stdexcept>
+
+namespace cupcake
+{
+
+template< typename T >
+class SPSCQueue
+///
+/// A ring of a fixed number of slots, with items moved in by one producer thread and moved out by
+/// one consumer thread. As in LockFreeAudioBuffer, each side only ever writes its own head, so
+/// TryPush and TryPop are wait-free.
+///
+/// Push waits while the queue is full, so a fast producer is held back to the pace of its consumer,
+/// and Pop waits while it is empty. Both spin briefly, then yield, then block on a condition
+/// variable, so a thread waiting on a slow or idle neighbour does not use any CPU. The other side
+/// only takes the lock to wake a thread that is blocked, so while neither is blocked pushing and
+/// popping stay lock-free. The producer calls Close after its last item, so that Pop returns false
+/// once the consumer has taken everything.
+///
+{
+
+public:
+
+    SPSCQueue( size_t capacity );
+    ~SPSCQueue();
+
+    // Producer side.
+    bool TryPush( T& item );
+    void Push( T& item );
+    void Close();
+
+    // Consumer side.
+    bool TryPop( T& item );
+    bool Pop( T& item );
+
+    const size_t Size() const;
+    const size_t Capacity() const;
+
+private:
+
+    //
+    // Data
+    //
+    std::vector< T > mSlots;
+
+    //
+    // Mechanics
+    //
+    // The heads are padded out to their own cache lines, as in LockFreeAudioBuffer.
+    //
+    static const size_t CACHE_LINE_SIZE = 64;
+    char mConfigurationPadding[CACHE_LINE_SIZE];
+    std::atomic< size_t > mReadHead;
+    char mReadHeadPadding[CACHE_LINE_SIZE - sizeof( std::atomic< size_t > )];
+    std::atomic< size_t > mWriteHead;
+    std::atomic< bool > mClosed;
+
+    //
+    // Thread safety
+    //
+    std::atomic< size_t > mNumBlocked;      // Threads blocked, or about to block, on mWakeCondition.
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+
+    //
+    // Constants
+    //
+    static const size_t SPIN_LIMIT = 64;
+    static const size_t YIELD_LIMIT = 1024;
+
+    //
+    // Helpers
+    //
+    bool IsFull() const;
+    bool IsEmpty() const;
+    template< typename Ready >
+    void Wait( size_t attempt, const Ready& ready );
+    void Wake();
+
+};
+
+template< typename T >
+const size_t SPSCQueue< T >::CACHE_LINE_SIZE;
+
+template< typename T >
+const size_t SPSCQueue< T >::SPIN_LIMIT;
+
+template< typename T >
+const size_t SPSCQueue< T >::YIELD_LIMIT;
+
+template< typename T >
+SPSCQueue< T >::SPSCQueue( size_t capacity ) :
+    mSlots( capacity + 1 ),
+    mReadHead( 0 ),
+    mWriteHead( 0 ),
+    mClosed( false ),
+    mNumBlocked( 0 )
+///
+/// Constructor.
+///
+/// @param capacity
+///  The maximum number of items in the queue, which must be at least one.
+///
+{
+    if( capacity == 0 )
+    {
+        throw std::invalid_argument( "A queue must hold at least one item" );
+    }
+}
+
+template< typename T >
+SPSCQueue< T >::~SPSCQueue()
+///
+/// Destructor.
+///
+{
+}
+
+template< typename T >
+bool SPSCQueue< T >::TryPush( T& item )
+///
+/// Move an item into the queue, if there is space. Producer thread only.
+///
+/// @param item
+///  The item, which is moved from if it is added.
+///
+/// @return
+///  True if the item was added, false if the queue was full.
+///
+{
+    const size_t write_head = mWriteHead.load( std::memory_order_relaxed );
+    const size_t next = write_head + 1 == mSlots.size() ? 0 : write_head + 1;
+    if( next == mReadHead.load( std::memory_order_acquire ) )
+    {
+        return false;
+    }
+    mSlots[write_head] = std::move( item );
+    mWriteHead.store( next, std::memory_order_release );
+    Wake();
+    return true;
+}
+
+template< typename T >
+void SPSCQueue< T >::Push( T& item )
+///
+/// Move an item into the queue, waiting for space if it is full. Producer thread only.
+///
+/// @param item
+///  The item, which is moved from.
+///
+{
+    for( size_t attempt=0; !TryPush( item ); ++attempt )
+    {
+        Wait( attempt, [this](){ return !IsFull(); } );
+    }
+}
+
+template< typename T >
+void SPSCQueue< T >::Close()
+///
+/// Mark the end of the items. Producer thread only, after its last push.
+///
+{
+    mClosed.store( true, std::memory_order_release );
+    Wake();
+}
+
+template< typename T >
+bool SPSCQueue< T >::TryPop( T& item )
+///
+/// Move the oldest item out of the queue, if there is one. Consumer thread only.
+///
+/// @param item
+///  Where to move the item to.
+///
+/// @return
+///  True if an item was taken, false if the queue was empty.
+///
+{
+    const size_t read_head = mReadHead.load( std::memory_order_relaxed );
+    if( read_head == mWriteHead.load( std::memory_order_acquire ) )
+    {
+        return false;
+    }
+    item = std::move( mSlots[read_head] );
+    mReadHead.store( read_head + 1 == mSlots.size() ? 0 : read_head + 1, std::memory_order_release );
+    Wake();
+    return true;
+}
+
+template< typename T >
+bool SPSCQueue< T >::Pop( T& item )
+///
+/// Move the oldest item out of the queue, waiting for one if it is empty. Consumer thread only.
+///
+/// @param item
+///  Where to move the item to.
+///
+/// @return
+///  True if an item was taken, false if the queue is empty and closed.
+///
+{
+    for( size_t attempt=0; !TryPop( item ); ++attempt )
+    {
+        // The producer closes after its last push, so check for any last item after seeing it closed.
+        if( mClosed.load( std::memory_order_acquire ) )
+        {
+            return TryPop( item );
+        }
+        Wait( attempt, [this](){ return !IsEmpty() || mClosed.load( std::memory_order_acquire ); } );
+    }
+    return true;
+}
+
+template< typename T >
+const size_t SPSCQueue< T >::Size() const
+///
+/// Get the number of items in the queue. This is only a snapshot while the other side is active.
+///
+/// @return
+///  The number of items.
+///
+{
+    const size_t read_head = mReadHead.load( std::memory_order_acquire );
+    const size_t write_head = mWriteHead.load( std::memory_order_acquire );
+    return write_head >= read_head ? write_head - read_head : write_head + mSlots.size() - read_head;
+}
+
+template< typename T >
+const size_t SPSCQueue< T >::Capacity() const
+///
+/// Get the maximum number of items in the queue.
+///
+/// @return
+///  The capacity given at construction.
+///
+{
+    return mSlots.size() - 1;
+}
+
+template< typename T >
+bool SPSCQueue< T >::IsFull() const
+///
+/// @return
+///  Whether there is no space to push an item.
+///
+{
+    const size_t write_head = mWriteHead.load( std::memory_order_acquire );
+    const size_t next = write_head + 1 == mSlots.size() ? 0 : write_head + 1;
+    return next == mReadHead.load( std::memory_order_acquire );
+}
+
+template< typename T >
+bool SPSCQueue< T >::IsEmpty() const
+///
+/// @return
+///  Whether there is no item to pop.
+///
+{
+    return mReadHead.load( std::memory_order_acquire ) == mWriteHead.load( std::memory_order_acquire );
+}
+
+template< typename T >
+template< typename Ready >
+void SPSCQueue< T >::Wait( size_t attempt, const Ready& ready )
+///
+/// Backs off between attempts to push or pop.
+///
+/// @param attempt
+///  The number of attempts that have failed so far.
+///
+/// @param ready
+///  Whether the next attempt may succeed. Once spinning and yielding have not helped, the thread
+///  blocks until this is true.
+///
+{
+    if( attempt < SPIN_LIMIT )
+    {
+        return;
+    }
+    if( attempt < YIELD_LIMIT )
+    {
+        std::this_thread::yield();
+        return;
+    }
+
+    // The count is raised before ready is checked, and Wake reads it after changing the queue, with a
+    // full fence on both sides, so either ready sees the change or Wake sees this thread and, as the
+    // lock is held until the thread is waiting, wakes it.
+    std::unique_lock< std::mutex > lock( mWakeMutex );
+    mNumBlocked.fetch_add( 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    mWakeCondition.wait( lock, ready );
+    mNumBlocked.fetch_sub( 1, std::memory_order_relaxed );
+}
+
+template< typename T >
+void SPSCQueue< T >::Wake()
+///
+/// Wakes the other side if it is blocked in Wait, after a push, pop or close.
+///
+{
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if( mNumBlocked.load( std::memory_order_relaxed ) > 0 )
+    {
+        std::lock_guard< std::mutex > lock( mWakeMutex );
+        mWakeCondition.notify_all();
+    }
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_SPSC_QUEUE_H
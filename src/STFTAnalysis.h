@@ -10,6 +10,10 @@
 
 // In module includes
 #include "AudioBuffer.h"
+#include "LockFreeAudioBuffer.h"
+#include "STFTFrameAnalyser.h"
+#include "ProcessingStats.h"
+#include "Arena.h"
 
 // Thirdparty includes
 #include "FFT.h"
@@ -19,6 +23,8 @@
 #include <vector>
 #include <complex>
 #include <array>
+#include <memory>
+#include <type_traits>
 #include <assert.h>
 
 namespace cupcake
@@ -30,21 +36,38 @@ class STFTAnalysis
     
 public:
 
-	STFTAnalysis( float overlap, const std::vector< float >& window );
+	STFTAnalysis( float overlap, const std::vector< float >& window, std::shared_ptr< Arena > arena=nullptr );
 	~STFTAnalysis();
     
     static constexpr size_t GetOutputSize() { return veclib::get_output_FFT_size( FFTSize ); };
+    
+    static const size_t INPUT_BUFFER_SIZE = 44100*30;   // The most samples that may be buffered at once.
+    
+    typedef std::array< std::complex< float >, GetOutputSize() > Frame;
+    typedef std::vector< Frame > FrameBuffer;
 
     // @todo [matt.mccallum 10.02.17] Having a contiguous output memory block like this is nice for vectorised
     //                                operations, although, it would preferably be runtime configurable.
     //                                I should spend some time creating a vector allocator so that 2D vectors
     //                                like this can have dynamically allocated memory, allowing runtime configuration
     //                                of the STFT size.
-	std::vector< std::array< std::complex< float >, GetOutputSize() > >& PushSamples( const std::vector< float >& samples );
+	FrameBuffer& PushSamples( const std::vector< float >& samples );
+	FrameBuffer& PushSamples( const float* samples, size_t num_samples );
+    template< typename Analyse >
+    FrameBuffer& PushSamples( const float* samples, size_t num_samples, const Analyse& analyse );
+    template< typename Analyse >
+    size_t PushSamplesDirect( const float* samples, size_t num_samples, const Analyse& analyse );
+    size_t PushSamplesInto( const float* samples, size_t num_samples, Frame* output );
+    FrameBuffer& PullSamples( LockFreeAudioBuffer< float >& input );
     
     const size_t GetIncrement() const;
     const std::vector< float >& GetWindow() const;
     const size_t GetWinLen() const;
+    const size_t GetAlgorithmicLatency() const;
+    const size_t GetBufferedSamples() const;
+    
+    ProcessingStats GetStats() const;
+    void ResetStats();
 
 private:
 
@@ -53,38 +76,44 @@ private:
 	//
     const float mOverlap;
 	const size_t mIncrement;
-	const std::vector< float > mWindow;
 	const size_t mWinLen;
 
 	//
 	// Data
 	//
 	AudioBuffer< float > mInputBuffer;
-	std::vector< std::array< std::complex< float >, GetOutputSize() > > mOutputBuffer;
-    std::vector< float > mWorkingBuffer;
+	FrameBuffer mOutputBuffer;
     
     //
     // Mechanics
     //
-    veclib::FFTConfig mFFTConfig;
+    STFTFrameAnalyser< FFTSize > mFrameAnalyser;
 
-	//
-	// Constants
-	//
-	static const size_t INPUT_BUFFER_SIZE = 44100*30;
+    //
+    // Statistics
+    //
+    ProcessingStats mStats;
+
+    //
+    // Helpers
+    //
+    template< typename Buffer >
+    FrameBuffer& ProcessBuffer( Buffer& input );
+    template< typename Buffer, typename Analyse >
+    FrameBuffer& ProcessBuffer( Buffer& input, const Analyse& analyse );
+    template< typename Buffer, typename Analyse >
+    size_t ConsumeBuffer( Buffer& input, const Analyse& analyse );
 
 };
 
 template< size_t FFTSize >
-STFTAnalysis< FFTSize >::STFTAnalysis( float overlap, const std::vector< float >& window ) :
+STFTAnalysis< FFTSize >::STFTAnalysis( float overlap, const std::vector< float >& window, std::shared_ptr< Arena > arena ) :
 	mOverlap( overlap ),
 	mIncrement( static_cast< size_t >( ( 1-overlap )*window.size() ) ),
-	mWindow( window ),
 	mWinLen( window.size() ),
-	mInputBuffer( INPUT_BUFFER_SIZE ),
-	mOutputBuffer( ( INPUT_BUFFER_SIZE-mWinLen )/mIncrement + 1, std::array< std::complex< float >, GetOutputSize() >() ),
-    mWorkingBuffer( FFTSize, 0.0 ),
-    mFFTConfig()
+	mInputBuffer( INPUT_BUFFER_SIZE, arena ),
+	mOutputBuffer( ( INPUT_BUFFER_SIZE-mWinLen )/mIncrement + 1, Frame() ),
+    mFrameAnalyser( window, arena )
 ///
 /// Constructor.
 ///
@@ -97,8 +126,13 @@ STFTAnalysis< FFTSize >::STFTAnalysis( float overlap, const std::vector< float >
 ///  A vector of float values describing the windowing function (and hence windowing
 ///  length) for the STFT operation.
 ///
+/// @param arena
+///  An optional arena to allocate the input buffer and working memory from. If null, they are
+///  allocated from the heap. The output frames are always on the heap, as they are returned as a
+///  FrameBuffer.
+///
 {
-    veclib::make_FFT( FFTSize, mFFTConfig );
+    static_assert( std::is_same< Frame, typename STFTFrameAnalyser< FFTSize >::Frame >::value, "Frame types must match" );
 }
 
 template< size_t FFTSize >
@@ -107,11 +141,11 @@ STFTAnalysis< FFTSize >::~STFTAnalysis()
 /// Destructor.
 ///
 {
-    destroy_FFT( mFFTConfig );
+
 }
 
 template< size_t FFTSize >
-std::vector< std::array< std::complex< float >, STFTAnalysis< FFTSize >::GetOutputSize() > >& STFTAnalysis< FFTSize >::PushSamples( const std::vector< float >& samples )
+typename STFTAnalysis< FFTSize >::FrameBuffer& STFTAnalysis< FFTSize >::PushSamples( const std::vector< float >& samples )
 ///
 /// Adds samples to previous left over samples at input buffer
 /// and performs all the FFT operations it has enough samples
@@ -125,43 +159,254 @@ std::vector< std::array< std::complex< float >, STFTAnalysis< FFTSize >::GetOutp
 /// @return
 ///  Reference to a vector containing all output STFT frames
 ///
+{
+    return PushSamples( samples.data(), samples.size() );
+}
+
+template< size_t FFTSize >
+typename STFTAnalysis< FFTSize >::FrameBuffer& STFTAnalysis< FFTSize >::PushSamples( const float* samples, size_t num_samples )
+///
+/// Adds samples to previous left over samples at input buffer
+/// and performs all the FFT operations it has enough samples
+/// for. The samples are read in place, so they may live in any
+/// contiguous memory (e.g. a numpy array).
+///
+/// @param samples
+///  A pointer to the first of the single-channel samples to be added to the
+///  input buffer and transformed.
+///
+/// @param num_samples
+///  The number of samples to be added.
+///
+/// @return
+///  Reference to a vector containing all output STFT frames
+///
 {
 
-	assert( samples.size() < mInputBuffer.SpaceRemaining() ); // Too many samples to fit into input buffer.
+	assert( num_samples < mInputBuffer.SpaceRemaining() ); // Too many samples to fit into input buffer.
 	
 	// Add samples to input
-	mInputBuffer.PushSamples( samples );
+	{
+		StatsTimer timer( mStats.buffer_cycles );
+		mInputBuffer.PushSamples( samples, num_samples );
+	}
+	stats_add( mStats.bytes_moved, num_samples*sizeof( float ) );
 
-	// Prepare output buffer
-	size_t numFramesAvailable = mInputBuffer.NumSamples() > mWinLen ? ( mInputBuffer.NumSamples() - mWinLen )/mIncrement + 1 : 0;
-	mOutputBuffer.resize( numFramesAvailable ); // @todo [mcmccallum 05/01/17] This will zero initialise all elements, we should try avoid this.
+	return ProcessBuffer( mInputBuffer );
+
+}
 
-	// Perform the FFTs
-	size_t output_frame_idx = 0;
-	size_t input_pointer = 0;
-	while( ( input_pointer + mWinLen ) < mInputBuffer.NumSamples() )
+template< size_t FFTSize >
+template< typename Analyse >
+typename STFTAnalysis< FFTSize >::FrameBuffer& STFTAnalysis< FFTSize >::PushSamples( const float* samples, size_t num_samples, const Analyse& analyse )
+///
+/// Adds samples to the input buffer as for the overload above, but has the caller compute the
+/// frames, e.g. on several threads, rather than this object's frame analyser. The buffering, and
+/// so the frames produced, are exactly those of the other overloads.
+///
+/// @param samples
+///  A pointer to the first of the single-channel samples to be added to the input buffer.
+///
+/// @param num_samples
+///  The number of samples to be added.
+///
+/// @param analyse
+///  Called once, as analyse( input, num_frames, output ), to window and transform num_frames
+///  successive frames of the buffered samples, starting at input, into output. The frames start
+///  GetIncrement() samples apart.
+///
+/// @return
+///  Reference to a vector containing all output STFT frames
+///
+{
+
+	assert( num_samples < mInputBuffer.SpaceRemaining() ); // Too many samples to fit into input buffer.
+	
+	// Add samples to input
 	{
-        
-        // Multiply by window
-        veclib::vec_mult( samples.data() + input_pointer, mWindow.data(), mWorkingBuffer.data(), mWinLen );
-
-		// Perform FFT
-        std::array< std::complex< float >, GetOutputSize() >& output_vector = mOutputBuffer[output_frame_idx];
-        veclib::FFT_not_in_place( mWorkingBuffer.data(), output_vector.data(), mFFTConfig );
-        
-		// Increment indices for next frame
-		output_frame_idx++;
-		input_pointer += mIncrement;
+		StatsTimer timer( mStats.buffer_cycles );
+		mInputBuffer.PushSamples( samples, num_samples );
+	}
+	stats_add( mStats.bytes_moved, num_samples*sizeof( float ) );
+
+	return ProcessBuffer( mInputBuffer, analyse );
+
+}
+
+template< size_t FFTSize >
+template< typename Analyse >
+size_t STFTAnalysis< FFTSize >::PushSamplesDirect( const float* samples, size_t num_samples, const Analyse& analyse )
+///
+/// Adds samples to the input buffer as for the overloads above, and hands the samples of the frames
+/// they complete straight to the caller, without touching this object's output buffer. This is for
+/// callers that write their own output, e.g. of only a few bins, so a full width frame buffer is
+/// neither resized nor zeroed for them.
+///
+/// @param samples
+///  A pointer to the first of the single-channel samples to be added to the input buffer.
+///
+/// @param num_samples
+///  The number of samples to be added.
+///
+/// @param analyse
+///  Called once, as analyse( input, num_frames ), with num_frames successive frames of the buffered
+///  samples starting at input. The frames start GetIncrement() samples apart.
+///
+/// @return
+///  The number of frames handed to analyse.
+///
+{
 
+	assert( num_samples < mInputBuffer.SpaceRemaining() ); // Too many samples to fit into input buffer.
+	
+	// Add samples to input
+	{
+		StatsTimer timer( mStats.buffer_cycles );
+		mInputBuffer.PushSamples( samples, num_samples );
 	}
+	stats_add( mStats.bytes_moved, num_samples*sizeof( float ) );
+
+	return ConsumeBuffer( mInputBuffer, analyse );
+
+}
 
-	// Clear obsolete samples from the input
+template< size_t FFTSize >
+size_t STFTAnalysis< FFTSize >::PushSamplesInto( const float* samples, size_t num_samples, Frame* output )
+///
+/// Adds samples to the input buffer as for PushSamples, and transforms the frames they complete
+/// with this object's frame analyser straight into memory owned by the caller, e.g. an array that
+/// is handed to python without a copy. This object's output buffer is not touched.
+///
+/// @param samples
+///  A pointer to the first of the single-channel samples to be added to the input buffer.
+///
+/// @param num_samples
+///  The number of samples to be added.
+///
+/// @param output
+///  Room for the frames produced, i.e. STFTFrameAnalyser::GetNumFrames( GetBufferedSamples() +
+///  num_samples, GetWinLen(), GetIncrement() ) frames.
+///
+/// @return
+///  The number of frames written to output.
+///
+{
+    const size_t num_frames = PushSamplesDirect( samples, num_samples, [this, output]( const float* input, size_t num_frames )
+    {
+        mFrameAnalyser.AnalyseFrames( input, num_frames, mIncrement, output );
+    });
+    stats_add( mStats.bytes_moved, num_frames*sizeof( Frame ) );
+    return num_frames;
+}
+
+template< size_t FFTSize >
+typename STFTAnalysis< FFTSize >::FrameBuffer& STFTAnalysis< FFTSize >::PullSamples( LockFreeAudioBuffer< float >& input )
+///
+/// Performs all the FFT operations there are enough samples for in a lock-free buffer that
+/// is being filled by another thread (e.g. an audio callback), and clears the samples that
+/// are no longer needed from that buffer. This must be called from the buffer's consumer thread.
+/// Samples that are not yet enough for a complete frame are left in the lock-free buffer
+/// for the next call.
+///
+/// @param input
+///  A lock-free buffer of single-channel samples to be transformed.
+///
+/// @return
+///  Reference to a vector containing all output STFT frames
+///
+{
+    return ProcessBuffer( input );
+}
+
+template< size_t FFTSize >
+template< typename Buffer >
+typename STFTAnalysis< FFTSize >::FrameBuffer& STFTAnalysis< FFTSize >::ProcessBuffer( Buffer& input )
+///
+/// Performs all the FFT operations there are enough samples for in the provided buffer with this
+/// object's frame analyser.
+///
+/// @param input
+///  The buffer of samples to be transformed.
+///
+/// @return
+///  Reference to a vector containing all output STFT frames
+///
+{
+    return ProcessBuffer( input, [this]( const float* samples, size_t num_frames, Frame* output )
+    {
+        mFrameAnalyser.AnalyseFrames( samples, num_frames, mIncrement, output );
+    });
+}
+
+template< size_t FFTSize >
+template< typename Buffer, typename Analyse >
+typename STFTAnalysis< FFTSize >::FrameBuffer& STFTAnalysis< FFTSize >::ProcessBuffer( Buffer& input, const Analyse& analyse )
+///
+/// Performs all the FFT operations there are enough samples for in the provided buffer,
+/// and clears the samples that will not be part of any future frame.
+///
+/// @param input
+///  The buffer of samples to be transformed. This may be any buffer providing contiguous
+///  access to its samples via Data(), NumSamples() and PopFront().
+///
+/// @param analyse
+///  Windows and transforms the frames, as analyse( input, num_frames, output ).
+///
+/// @return
+///  Reference to a vector containing all output STFT frames
+///
+{
+
+	const size_t num_frames = ConsumeBuffer( input, [&]( const float* samples, size_t numFramesAvailable )
+	{
+		// Prepare output buffer
+		// This is within the capacity reserved on construction for a full input buffer, so it does not allocate.
+		// The Python binding analyses into arrays of its own with PushSamplesInto, so never takes this buffer.
+		mOutputBuffer.resize( numFramesAvailable ); // @todo [mcmccallum 05/01/17] This will zero initialise all elements, we should try avoid this.
+
+		// Perform the FFTs
+		analyse( samples, numFramesAvailable, mOutputBuffer.data() );
+	});
+	stats_add( mStats.bytes_moved, num_frames*sizeof( Frame ) );
+
+	return mOutputBuffer;
+
+}
+
+template< size_t FFTSize >
+template< typename Buffer, typename Analyse >
+size_t STFTAnalysis< FFTSize >::ConsumeBuffer( Buffer& input, const Analyse& analyse )
+///
+/// Hands the samples of every frame there are enough samples for in the provided buffer to analyse,
+/// and clears the samples that will not be part of any future frame.
+///
+/// @param input
+///  The buffer of samples, as for ProcessBuffer.
+///
+/// @param analyse
+///  Called as analyse( input, num_frames ) with the samples of the frames.
+///
+/// @return
+///  The number of frames handed to analyse.
+///
+{
+
+	size_t num_samples = input.NumSamples();
+	size_t numFramesAvailable = STFTFrameAnalyser< FFTSize >::GetNumFrames( num_samples, mWinLen, mIncrement );
+
+	analyse( input.Data(), numFramesAvailable );
+
+	// Clear obsolete samples from the input, keeping the overlap for the next frame
 	if( numFramesAvailable )
 	{
-		mInputBuffer.PopFront( ( numFramesAvailable - 1 )*mIncrement + mWinLen );
+		StatsTimer timer( mStats.buffer_cycles );
+		input.PopFront( numFramesAvailable*mIncrement );
 	}
 
-	return mOutputBuffer;
+	stats_add( mStats.calls, 1 );
+	stats_set_occupancy( mStats, input.NumSamples() );
+
+	return numFramesAvailable;
 
 }
     
@@ -187,7 +432,7 @@ const std::vector< float >& STFTAnalysis< FFTSize >::GetWindow() const
 ///  The STFT analysis windowing function.
 ///
 {
-    return mWindow;
+    return mFrameAnalyser.GetWindow();
 }
 
 template< size_t FFTSize >
@@ -202,6 +447,65 @@ const size_t STFTAnalysis< FFTSize >::GetWinLen() const
     return mWinLen;
 }
 
+template< size_t FFTSize >
+const size_t STFTAnalysis< FFTSize >::GetAlgorithmicLatency() const
+///
+/// Get the delay from the first sample of a frame being pushed to the frame being output, as the
+/// rest of its window must be pushed first. The zero padding up to FFTSize adds no delay, as the
+/// window sits at the start of the FFT input. Pushing in chunks adds up to a chunk more, and the
+/// samples waiting for a frame at any moment are given by GetBufferedSamples.
+///
+/// @return
+///  The algorithmic latency in samples.
+///
+{
+    return mWinLen - 1;
+}
+
+template< size_t FFTSize >
+const size_t STFTAnalysis< FFTSize >::GetBufferedSamples() const
+///
+/// Get the number of samples pushed that are still held in the input buffer, i.e., the overlap
+/// with the next frame and any samples not yet enough to complete it. This does not include
+/// samples waiting in a buffer given to PullSamples.
+///
+/// @return
+///  The number of buffered samples.
+///
+{
+    return mInputBuffer.NumSamples();
+}
+
+template< size_t FFTSize >
+ProcessingStats STFTAnalysis< FFTSize >::GetStats() const
+///
+/// Get the statistics recorded by this object. These are only recorded when compiled with
+/// CUPCAKE_ENABLE_STATS, and otherwise are all zero.
+///
+/// @return
+///  The time spent buffering input, windowing and in FFTs, along with the number of frames
+///  produced, the bytes copied into the input buffer and written as frames, and the number
+///  of samples waiting in the input buffer.
+///
+{
+    ProcessingStats stats = mStats;
+    const ProcessingStats& frame_stats = mFrameAnalyser.GetStats();
+    stats.window_cycles = frame_stats.window_cycles;
+    stats.fft_cycles = frame_stats.fft_cycles;
+    stats.frames = frame_stats.frames;
+    return stats;
+}
+
+template< size_t FFTSize >
+void STFTAnalysis< FFTSize >::ResetStats()
+///
+/// Sets all recorded statistics back to zero.
+///
+{
+    mStats = ProcessingStats();
+    mFrameAnalyser.ResetStats();
+}
+
 } // namespace cupcake
 
 #endif // CUPCAKE_STFT_ANALYSIS_H
@@ -0,0 +1,219 @@
+///
+/// Created: 10/18/26 by agent
+///
+/// Class for windowing and transforming STFT frames from contiguous samples.
+///
+
+#ifndef CUPCAKE_STFT_FRAME_ANALYSER_H
+#define CUPCAKE_STFT_FRAME_ANALYSER_H
+
+// In module includes
+#include "ProcessingStats.h"
+#include "Kernels.h"
+#include "Arena.h"
+
+// Thirdparty includes
+#include "FFT.h"
+#include "vector_functions.h"
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <array>
+#include <memory>
+#include <assert.h>
+
+namespace cupcake
+{
+
+template< size_t FFTSize >
+class STFTFrameAnalyser
+///
+/// The per-frame part of the STFT - windowing and FFT - without any input buffering.
+/// It reads frames directly from contiguous samples, so it may be used on memory owned
+/// elsewhere, and it is small enough (a window, a working buffer and an FFT configuration)
+/// to have one per worker thread. An instance may only be used by one thread at a time.
+///
+{
+
+public:
+
+    STFTFrameAnalyser( const std::vector< float >& window, std::shared_ptr< Arena > arena=nullptr );
+    ~STFTFrameAnalyser();
+
+    static constexpr size_t GetOutputSize() { return veclib::get_output_FFT_size( FFTSize ); };
+
+    typedef std::array< std::complex< float >, GetOutputSize() > Frame;
+
+    void AnalyseFrames( const float* samples, size_t num_frames, size_t increment, Frame* output );
+    static size_t GetNumFrames( size_t num_samples, size_t win_len, size_t increment );
+
+    const std::vector< float >& GetWindow() const;
+    const size_t GetWinLen() const;
+
+    const ProcessingStats& GetStats() const;
+    void ResetStats();
+
+private:
+
+    //
+    // Configuration
+    //
+    const std::vector< float > mWindow;
+    const size_t mWinLen;
+
+    //
+    // Data
+    //
+    ArenaVector< float > mWorkingBuffer;
+
+    //
+    // Mechanics
+    //
+    veclib::FFTConfig mFFTConfig;
+
+    //
+    // Statistics
+    //
+    ProcessingStats mStats;
+
+};
+
+template< size_t FFTSize >
+STFTFrameAnalyser< FFTSize >::STFTFrameAnalyser( const std::vector< float >& window, std::shared_ptr< Arena > arena ) :
+    mWindow( window ),
+    mWinLen( window.size() ),
+    mWorkingBuffer( FFTSize, 0.0, ArenaAllocator< float >( std::move( arena ) ) ),
+    mFFTConfig()
+///
+/// Constructor.
+///
+/// @param window
+///  A vector of float values describing the windowing function (and hence windowing
+///  length) for each frame. This must be no longer than FFTSize.
+///
+/// @param arena
+///  An optional arena to allocate the working buffer from. If null, it is allocated from the heap.
+///
+{
+    static_assert( sizeof( Frame ) == GetOutputSize()*sizeof( std::complex< float > ), "Frames must be contiguous complex values" );
+    assert( mWinLen <= FFTSize );
+    veclib::make_FFT( FFTSize, mFFTConfig );
+}
+
+template< size_t FFTSize >
+STFTFrameAnalyser< FFTSize >::~STFTFrameAnalyser()
+///
+/// Destructor.
+///
+{
+    destroy_FFT( mFFTConfig );
+}
+
+template< size_t FFTSize >
+void STFTFrameAnalyser< FFTSize >::AnalyseFrames( const float* samples, size_t num_frames, size_t increment, Frame* output )
+///
+/// Windows and transforms a number of successive frames.
+///
+/// @param samples
+///  A pointer to the first sample of the first frame. There must be at least
+///  ( num_frames - 1 )*increment + window length samples available from here.
+///
+/// @param num_frames
+///  The number of frames to analyse.
+///
+/// @param increment
+///  The number of samples between the start of successive frames.
+///
+/// @param output
+///  A pointer to memory for num_frames output spectra.
+///
+{
+    for( size_t frame=0; frame<num_frames; ++frame )
+    {
+        // Multiply by window - the remainder of the working buffer stays zero padded.
+        {
+            StatsTimer timer( mStats.window_cycles );
+            kernels::vec_mult( samples + frame*increment, mWindow.data(), mWorkingBuffer.data(), mWinLen );
+        }
+
+        // Perform FFT
+        {
+            StatsTimer timer( mStats.fft_cycles );
+            veclib::FFT_not_in_place( mWorkingBuffer.data(), output[frame].data(), mFFTConfig );
+        }
+    }
+
+    stats_add( mStats.frames, num_frames );
+}
+
+template< size_t FFTSize >
+size_t STFTFrameAnalyser< FFTSize >::GetNumFrames( size_t num_samples, size_t win_len, size_t increment )
+///
+/// Computes the number of complete frames in a block of samples.
+///
+/// @param num_samples
+///  The number of contiguous samples.
+///
+/// @param win_len
+///  The length of each frame.
+///
+/// @param increment
+///  The number of samples between the start of successive frames.
+///
+/// @return
+///  The number of complete frames.
+///
+{
+    return num_samples >= win_len ? ( num_samples - win_len )/increment + 1 : 0;
+}
+
+template< size_t FFTSize >
+const std::vector< float >& STFTFrameAnalyser< FFTSize >::GetWindow() const
+///
+/// Get the windowing function applied before each FFT operation.
+///
+/// @return
+///  The analysis windowing function.
+///
+{
+    return mWindow;
+}
+
+template< size_t FFTSize >
+const size_t STFTFrameAnalyser< FFTSize >::GetWinLen() const
+///
+/// Get the length of the analysis window.
+///
+/// @return
+///  The length of the analysis window.
+///
+{
+    return mWinLen;
+}
+
+template< size_t FFTSize >
+const ProcessingStats& STFTFrameAnalyser< FFTSize >::GetStats() const
+///
+/// Get the statistics recorded by this object. These are only recorded when compiled with
+/// CUPCAKE_ENABLE_STATS, and otherwise are all zero.
+///
+/// @return
+///  The time spent windowing and in FFTs, and the number of frames analysed.
+///
+{
+    return mStats;
+}
+
+template< size_t FFTSize >
+void STFTFrameAnalyser< FFTSize >::ResetStats()
+///
+/// Sets all recorded statistics back to zero.
+///
+{
+    mStats = ProcessingStats();
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_STFT_FRAME_ANALYSER_H
@@ -11,6 +11,8 @@
 // In Module includes
 #include "STFTAnalysis.h"
 #include "OverlapAddBuffer.h"
+#include "LockFreeOverlapAddBuffer.h"
+#include "Kernels.h"
 
 // Thirdparty includes
 #include "FFT.h"
@@ -37,11 +39,19 @@ public:
     
     static constexpr size_t GetInputSize() { return veclib::get_output_FFT_size( FFTSize ); };
     
-    const std::vector< float >& PushFrames( const std::vector< std::array< std::complex< float >, GetInputSize() > >& STFTFrames );
+    typedef std::array< std::complex< float >, GetInputSize() > Frame;
+    typedef std::vector< Frame > FrameBuffer;
+    
+    const std::vector< float >& PushFrames( const FrameBuffer& STFTFrames );
+    size_t PushFrames( const FrameBuffer& STFTFrames, LockFreeOverlapAddBuffer< float >& output );
     
     const size_t GetIncrement() const;
     const std::vector< float >& GetWindow() const;
     const size_t GetWinLen() const;
+    const size_t GetAlgorithmicLatency() const;
+    const size_t GetBufferedSamples() const;
+    
+    static float ComputeNormalizationMultiplier( size_t sample_increment, const std::vector< float >& window );
     
 private:
     
@@ -58,6 +68,7 @@ private:
     std::vector< float > mTempBuffer;
     OverlapAddBuffer< float > mOverlapAddBuffer;
     std::vector< float > mOutputBuffer;
+    size_t mNumHeldSamples;         // Samples overlap-added but awaiting later frames.
     
     //
     // Mechanics
@@ -73,7 +84,6 @@ private:
     //
     // Helpers
     //
-    static float ComputeNormalizationMultiplier( size_t sample_increment, const std::vector< float >& window );
     void CheckParameters();
     
 };
@@ -86,6 +96,7 @@ STFTSynthesis< FFTSize >::STFTSynthesis( size_t sample_increment, const std::vec
     mTempBuffer( FFTSize ),
     mOverlapAddBuffer( MAX_NUM_INPUT_FRAMES*(mIncrement - 1) + mWinLen ),
     mOutputBuffer( mOverlapAddBuffer.Size() - mWinLen + mIncrement ),
+    mNumHeldSamples( 0 ),
     mFFTConfig(),
     mNormalisationMult( ComputeNormalizationMultiplier( mIncrement, mWindow ) )
 ///
@@ -111,6 +122,7 @@ STFTSynthesis< FFTSize >::STFTSynthesis( float overlap, const std::vector< float
     mTempBuffer( FFTSize ),
     mOverlapAddBuffer( MAX_NUM_INPUT_FRAMES*(mIncrement - 1) + mWinLen ),
     mOutputBuffer( mOverlapAddBuffer.Size() - mWinLen + mIncrement ),
+    mNumHeldSamples( 0 ),
     mFFTConfig(),
     mNormalisationMult( ComputeNormalizationMultiplier( mIncrement, mWindow ) )
 ///
@@ -137,6 +149,7 @@ STFTSynthesis< FFTSize >::STFTSynthesis( const STFTAnalysis< FFTSize >& analysis
     mTempBuffer( FFTSize ),
     mOverlapAddBuffer( MAX_NUM_INPUT_FRAMES*(mIncrement - 1) + mWinLen ),
     mOutputBuffer( mOverlapAddBuffer.Size() - mWinLen + mIncrement ),
+    mNumHeldSamples( 0 ),
     mFFTConfig(),
     mNormalisationMult( ComputeNormalizationMultiplier( mIncrement, mWindow ) )
 ///
@@ -162,7 +175,7 @@ STFTSynthesis< FFTSize >::~STFTSynthesis()
 }
     
 template< uint64_t FFTSize >
-const std::vector< float >& STFTSynthesis< FFTSize >::PushFrames( const std::vector< std::array< std::complex< float >, GetInputSize() > >& STFTFrames )
+const std::vector< float >& STFTSynthesis< FFTSize >::PushFrames( const FrameBuffer& STFTFrames )
 ///
 /// Push frames into the STFT synthesis object and synthesise the corresponding signal
 /// in the frequency domain using the overlap-add method. Currently this employs no
@@ -183,30 +196,81 @@ const std::vector< float >& STFTSynthesis< FFTSize >::PushFrames( const std::vec
     {
         
         // IFFT
-        mTempBuffer.resize( FFTSize );
         veclib::IFFT_not_in_place( spec.data(), mTempBuffer.data(), mFFTConfig );
         
-        // Truncate
-        mTempBuffer.resize( mWinLen );
-        
         // @todo [matthew.mccallum 05.16.17] : No synthesis window used here. There should really be one.
         
-        // Overlap-Add
-        mOverlapAddBuffer.PushSamples( mTempBuffer );
+        // Overlap-Add, truncated to the window length
+        mOverlapAddBuffer.PushSamples( mTempBuffer.data(), mWinLen );
         mOverlapAddBuffer.IncrementWritePosition( mIncrement );
         
     }
     
-    // Write to output
+    if( !STFTFrames.empty() )
+    {
+        mNumHeldSamples = mWinLen - mIncrement;
+    }
+    
+    // Write to output - this never exceeds the capacity reserved on construction, so it does not allocate
+    // while the buffer keeps that reservation. The Python binding takes the samples out of the buffer and
+    // restores its capacity itself, so on that path the allocation happens in the hand-off rather than here.
     mOutputBuffer.resize( mOverlapAddBuffer.NumSamples() );
     mOverlapAddBuffer.Read( mOutputBuffer );
     mOverlapAddBuffer.PopFront( mOutputBuffer.size() );
-    veclib::vec_mult_const_in_place( mOutputBuffer.data(), mNormalisationMult, mOutputBuffer.size() );
+    kernels::vec_mult_const_in_place( mOutputBuffer.data(), mNormalisationMult, mOutputBuffer.size() );
     
     return mOutputBuffer;
 
 }
 
+template< uint64_t FFTSize >
+size_t STFTSynthesis< FFTSize >::PushFrames( const FrameBuffer& STFTFrames, LockFreeOverlapAddBuffer< float >& output )
+///
+/// Push frames into the STFT synthesis object and overlap-add the synthesised signal directly
+/// into a lock-free buffer that is being drained by another thread (e.g. an audio callback).
+/// This must be called from the output buffer's producer thread. Each frame is normalised before
+/// it is added, so the samples before the output buffer's write position are final.
+///
+/// @param STFTFrames
+///  Several successive short term spectra of which to take the IFFT and perform the overlap-
+///  add operation. Spectra with increasing index are consecutive in time.
+///
+/// @param output
+///  The lock-free overlap-add buffer to add the synthesised signal into. Successive calls must
+///  use the same buffer.
+///
+/// @return
+///  The number of frames that were synthesised. This is less than STFTFrames.size() if the
+///  consumer has not yet freed enough space in the output, in which case the remaining frames
+///  should be pushed again later.
+///
+{
+    
+    size_t frame_num = 0;
+    for( ; frame_num<STFTFrames.size(); ++frame_num )
+    {
+        
+        if( output.SpaceRemaining() < mWinLen )
+        {
+            break;
+        }
+        
+        // IFFT
+        veclib::IFFT_not_in_place( STFTFrames[frame_num].data(), mTempBuffer.data(), mFFTConfig );
+        
+        // Truncate and normalise
+        kernels::vec_mult_const_in_place( mTempBuffer.data(), mNormalisationMult, mWinLen );
+        
+        // Overlap-Add
+        output.PushSamples( mTempBuffer.data(), mWinLen );
+        output.IncrementWritePosition( mIncrement );
+        
+    }
+    
+    return frame_num;
+    
+}
+
 template< uint64_t FFTSize >
 const size_t STFTSynthesis< FFTSize >::GetIncrement() const
 ///
@@ -245,6 +309,38 @@ const size_t STFTSynthesis< FFTSize >::GetWinLen() const
 {
     return mWinLen;
 }
+
+template< uint64_t FFTSize >
+const size_t STFTSynthesis< FFTSize >::GetAlgorithmicLatency() const
+///
+/// Get the delay from a frame being pushed to the last of its samples being output, in samples of
+/// output. Each frame's samples beyond the first hop wait for the frames that overlap them.
+///
+/// This does not add to the latency of an analysis-synthesis chain. A sample is output once the
+/// last frame covering it is pushed, and STFTAnalysis outputs that frame as soon as the sample has
+/// been pushed, so the end-to-end delay is that of the analysis alone, i.e.,
+/// STFTAnalysis::GetAlgorithmicLatency, the window length less one.
+///
+/// @return
+///  The algorithmic latency in samples.
+///
+{
+    return mWinLen - mIncrement;
+}
+
+template< uint64_t FFTSize >
+const size_t STFTSynthesis< FFTSize >::GetBufferedSamples() const
+///
+/// Get the number of samples held in the overlap-add buffer, awaiting the frames that overlap
+/// them, by the overload of PushFrames that returns its output. The other overload holds these
+/// samples in the lock-free buffer it is given instead.
+///
+/// @return
+///  The number of buffered samples.
+///
+{
+    return mNumHeldSamples;
+}
     
 template< uint64_t FFTSize >
 float STFTSynthesis< FFTSize >::ComputeNormalizationMultiplier( size_t sample_increment, const std::vector< float >& window )
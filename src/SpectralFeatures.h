@@ -0,0 +1,281 @@
+//
+// Created: 10/18/26 by agent
+//
+// Compact per-frame features - chroma, band energies, centroid and flux - of fast CQT output.
+//
+
+#ifndef CUPCAKE_SPECTRAL_FEATURES_H
+#define CUPCAKE_SPECTRAL_FEATURES_H
+
+// In module includes
+#include "Kernels.h"
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <array>
+#include <complex>
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+
+namespace cupcake
+{
+
+struct SpectralFeatureFrames
+///
+/// The features of a block of frames, with each feature held contiguously, frame by frame.
+///
+{
+    static const size_t NUM_CHROMA = 12;
+
+    size_t num_frames = 0;
+    size_t num_bands = 0;
+    std::vector< float > chroma;        // num_frames x 12 energies, per pitch class starting at C.
+    std::vector< float > bands;         // num_frames x num_bands energies, from low to high frequency.
+    std::vector< float > centroid;      // The centroid of the power spectrum of each frame, in Hz.
+    std::vector< float > flux;          // The increase in magnitude from the previous frame, summed over bins.
+};
+
+template< size_t FFT_SIZE >
+class SpectralFeatures
+///
+/// Reduces fast CQT (or STFT) frames to a handful of features per frame in a single pass over
+/// each frame.
+///
+/// Chroma and band energies are sums of power over bins. Each bin above the lowest frequency
+/// belongs to one pitch class and one band, and the bins of a pitch class (or band) lie in
+/// contiguous runs, so both are precomputed as short lists of runs of bins. This keeps the per
+/// frame work to one sweep over the bins, computing power, magnitude, flux and the centroid sums,
+/// then a sum over each run. Both are run by the kernels selected for this CPU (see Kernels.h),
+/// as without reassociation of the sums the compiler would not vectorise them.
+///
+/// Flux is measured against the previous frame processed, so an instance holds streaming state
+/// and frames must be processed in order.
+///
+{
+
+public:
+
+    static const size_t mInputSize = veclib::get_output_FFT_size( FFT_SIZE );
+    static const size_t NUM_CHROMA = SpectralFeatureFrames::NUM_CHROMA;
+
+    typedef std::array< std::complex< float >, mInputSize > Frame;
+
+    SpectralFeatures( float sample_rate, size_t num_bands=8, float min_frequency=27.5f, float tuning=440.0f );
+    ~SpectralFeatures();
+
+    SpectralFeatureFrames& Process( const Frame* frames, size_t num_frames );
+    void Reset();
+
+    const size_t GetNumBands() const;
+    const std::vector< float >& GetBandEdges() const;
+
+private:
+
+    struct Run
+    ///
+    /// A contiguous run of bins whose power is summed into one feature.
+    ///
+    {
+        size_t first_bin;
+        size_t end_bin;
+        size_t feature;
+    };
+
+    //
+    // Configuration
+    //
+    const size_t mNumBands;
+    std::vector< Run > mChromaRuns;
+    std::vector< Run > mBandRuns;
+    std::vector< float > mBandEdges;
+    std::vector< float > mFrequencies;
+
+    //
+    // Data
+    //
+    std::vector< float > mPower;
+    std::vector< float > mPreviousMagnitude;
+    SpectralFeatureFrames mOutput;
+
+    //
+    // Helpers
+    //
+    static void AddToRuns( std::vector< Run >& runs, size_t bin, size_t feature );
+
+};
+
+template< size_t FFT_SIZE >
+const size_t SpectralFeatures< FFT_SIZE >::mInputSize;
+
+template< size_t FFT_SIZE >
+const size_t SpectralFeatures< FFT_SIZE >::NUM_CHROMA;
+
+template< size_t FFT_SIZE >
+SpectralFeatures< FFT_SIZE >::SpectralFeatures( float sample_rate, size_t num_bands, float min_frequency, float tuning ) :
+    mNumBands( num_bands ),
+    mFrequencies( mInputSize ),
+    mPower( mInputSize, 0.0f ),
+    mPreviousMagnitude( mInputSize, 0.0f )
+///
+/// Constructor. Builds the maps from bins to pitch classes and bands.
+///
+/// @param sample_rate
+///  The sample rate of the analysed audio, in Hz.
+///
+/// @param num_bands
+///  The number of bands, spaced logarithmically from min_frequency to the Nyquist frequency.
+///
+/// @param min_frequency
+///  The lowest frequency, in Hz, included in the chroma and band energies. Bins below this are
+///  too coarse to resolve pitch.
+///
+/// @param tuning
+///  The frequency of A4, in Hz, from which pitch classes are measured.
+///
+{
+    assert( num_bands > 0 );
+    assert( min_frequency > 0.0f && min_frequency < sample_rate/2 );
+
+    const float nyquist = sample_rate/2;
+    const float log_range = std::log( nyquist/min_frequency );
+
+    mBandEdges.resize( num_bands + 1 );
+    for( size_t band=0; band<=num_bands; ++band )
+    {
+        mBandEdges[band] = min_frequency*std::exp( log_range*band/num_bands );
+    }
+
+    for( size_t bin=0; bin<mInputSize; ++bin )
+    {
+        const float frequency = bin*sample_rate/FFT_SIZE;
+        mFrequencies[bin] = frequency;
+        if( frequency < min_frequency )
+        {
+            continue;
+        }
+
+        const long midi_note = std::lround( 69 + 12*std::log2( frequency/tuning ) );
+        AddToRuns( mChromaRuns, bin, static_cast< size_t >( ( midi_note%12 + 12 )%12 ) );
+
+        const size_t band = static_cast< size_t >( num_bands*std::log( frequency/min_frequency )/log_range );
+        AddToRuns( mBandRuns, bin, std::min( band, num_bands - 1 ) );
+    }
+}
+
+template< size_t FFT_SIZE >
+SpectralFeatures< FFT_SIZE >::~SpectralFeatures() = default;
+
+template< size_t FFT_SIZE >
+SpectralFeatureFrames& SpectralFeatures< FFT_SIZE >::Process( const Frame* frames, size_t num_frames )
+///
+/// Computes the features of a block of frames, following on from the last frame processed.
+///
+/// @param frames
+///  The frames, e.g. the output of FastCQT::ApplyInPlace.
+///
+/// @param num_frames
+///  The number of frames.
+///
+/// @return
+///  The features of each frame. This is overwritten by the next call.
+///
+{
+    mOutput.num_frames = num_frames;
+    mOutput.num_bands = mNumBands;
+    mOutput.chroma.assign( num_frames*NUM_CHROMA, 0.0f );
+    mOutput.bands.assign( num_frames*mNumBands, 0.0f );
+    mOutput.centroid.resize( num_frames );
+    mOutput.flux.resize( num_frames );
+
+    const KernelTable& kernels = get_kernels();
+    for( size_t frame=0; frame<num_frames; ++frame )
+    {
+        // Power, magnitude, flux and centroid in one sweep over the bins.
+        float sums[3];
+        kernels.spectral_frame( frames[frame].data(), mFrequencies.data(), mPreviousMagnitude.data(), mPower.data(), mInputSize, sums );
+        const float total_power = sums[0];
+        const float weighted_power = sums[1];
+        mOutput.centroid[frame] = total_power > 0.0f ? weighted_power/total_power : 0.0f;
+        mOutput.flux[frame] = sums[2];
+
+        // Sum the power over each run of bins.
+        float* chroma = mOutput.chroma.data() + frame*NUM_CHROMA;
+        for( const Run& run : mChromaRuns )
+        {
+            chroma[run.feature] += kernels.sum( mPower.data() + run.first_bin, run.end_bin - run.first_bin );
+        }
+        float* bands = mOutput.bands.data() + frame*mNumBands;
+        for( const Run& run : mBandRuns )
+        {
+            bands[run.feature] += kernels.sum( mPower.data() + run.first_bin, run.end_bin - run.first_bin );
+        }
+    }
+
+    return mOutput;
+}
+
+template< size_t FFT_SIZE >
+void SpectralFeatures< FFT_SIZE >::Reset()
+///
+/// Forgets the previous frame, so the flux of the next frame is measured against silence, as for
+/// the first frame after construction.
+///
+{
+    std::fill( mPreviousMagnitude.begin(), mPreviousMagnitude.end(), 0.0f );
+}
+
+template< size_t FFT_SIZE >
+const size_t SpectralFeatures< FFT_SIZE >::GetNumBands() const
+///
+/// Get the number of band energies per frame.
+///
+/// @return
+///  The number of bands.
+///
+{
+    return mNumBands;
+}
+
+template< size_t FFT_SIZE >
+const std::vector< float >& SpectralFeatures< FFT_SIZE >::GetBandEdges() const
+///
+/// Get the frequencies bounding each band.
+///
+/// @return
+///  GetNumBands() + 1 frequencies in Hz, from the lowest frequency to the Nyquist frequency.
+///
+{
+    return mBandEdges;
+}
+
+template< size_t FFT_SIZE >
+void SpectralFeatures< FFT_SIZE >::AddToRuns( std::vector< Run >& runs, size_t bin, size_t feature )
+///
+/// Adds a bin to a list of runs, extending the last run if it is for the same feature and ends
+/// at this bin.
+///
+/// @param runs
+///  The runs, in increasing order of bin.
+///
+/// @param bin
+///  The bin to add.
+///
+/// @param feature
+///  The feature the bin contributes to.
+///
+{
+    if( !runs.empty() && runs.back().feature == feature && runs.back().end_bin == bin )
+    {
+        ++runs.back().end_bin;
+        return;
+    }
+    runs.push_back( { bin, bin + 1, feature } );
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_SPECTRAL_FEATURES_H
@@ -0,0 +1,392 @@
+//
+// Created: 10/18/26 by agent
+//
+// Fast wavelet analysis of many concurrent streams on a shared pool of threads.
+//
+
+#ifndef CUPCAKE_STREAM_ENGINE_H
+#define CUPCAKE_STREAM_ENGINE_H
+
+// In module includes
+#include "STFTFrameAnalyser.h"
+#include "FastCQT.h"
+#include "WorkStealingPool.h"
+#include "Arena.h"
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <array>
+#include <complex>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <assert.h>
+
+namespace cupcake
+{
+
+template< size_t FFT_SIZE >
+class StreamEngine
+///
+/// Computes the same frames as one FastWavelet per stream, for many streams at once.
+///
+/// Everything that does not change between streams is held once by the engine: the window, the
+/// fast CQT coefficients and, per worker thread, the FFT configuration and scratch memory. Each
+/// stream only keeps the samples that have not yet completed a frame, which is less than a window
+/// length. Frames are not buffered per stream either, they are handed to a sink as they are computed.
+///
+/// The stream tails, worker scratch memory and CQT coefficients may all be laid out in one Arena,
+/// which for many streams is best created with huge pages. Removed streams are kept for reuse by
+/// the next stream added, so adding and removing streams does not grow the arena.
+///
+/// Each call to Process splits the frames of every stream into blocks and runs them all on a
+/// work-stealing pool, so streams of very different lengths still keep every thread busy.
+///
+/// Thread safety: Process, AddStream and RemoveStream must not be called concurrently.
+///
+{
+
+public:
+
+    static const size_t mOutputSize = veclib::get_output_FFT_size( FFT_SIZE );
+
+    typedef std::array< std::complex< float >, mOutputSize > Frame;
+
+    // Receives a block of consecutive frames from one stream: the stream, the index of the first frame
+    // in the block (counted from when the stream was added), the frames and the number of frames.
+    typedef std::function< void( size_t stream, uint64_t first_frame, const Frame* frames, size_t num_frames ) > FrameSink;
+
+    struct StreamInput
+    ///
+    /// New samples for one stream. The samples only need to remain valid for the duration of Process.
+    ///
+    {
+        size_t stream;
+        const float* samples;
+        size_t num_samples;
+    };
+
+    StreamEngine( float overlap, const std::vector< float >& window, size_t num_threads=0, std::shared_ptr< Arena > arena=nullptr );
+    ~StreamEngine();
+
+    size_t AddStream();
+    void RemoveStream( size_t stream );
+
+    void Process( const StreamInput* inputs, size_t num_inputs, const FrameSink& sink );
+
+    const size_t GetIncrement() const;
+    const size_t GetNumStreams() const;
+    const size_t GetStreamStateBytes() const;
+
+private:
+
+    struct Stream
+    ///
+    /// The state of a single stream.
+    ///
+    {
+        ArenaVector< float > tail;          // Samples received but not yet part of a complete frame.
+        uint64_t num_frames;                // Frames produced so far.
+    };
+
+    struct Worker
+    ///
+    /// The scratch state of a single worker thread.
+    ///
+    {
+        Worker( const std::vector< float >& window, const std::shared_ptr< Arena >& arena ) :
+            analyser( window, arena ),
+            frame_samples( window.size(), 0.0f, ArenaAllocator< float >( arena ) ),
+            frames( FRAMES_PER_JOB, Frame(), ArenaAllocator< Frame >( arena ) )
+        {
+        }
+
+        STFTFrameAnalyser< FFT_SIZE > analyser;
+        ArenaVector< float > frame_samples;     // A frame that spans the tail and the new samples.
+        ArenaVector< Frame > frames;            // The output of the current job.
+    };
+
+    //
+    // Configuration
+    //
+    const std::vector< float > mWindow;
+    const size_t mWinLen;
+    const size_t mIncrement;
+
+    //
+    // Mechanics
+    //
+    std::shared_ptr< Arena > mArena;
+    const FastCQT< FFT_SIZE > mCQT;
+    WorkStealingPool mPool;
+    std::vector< std::unique_ptr< Worker > > mWorkers;
+
+    //
+    // Data
+    //
+    std::vector< std::unique_ptr< Stream > > mStreams;
+    std::vector< size_t > mFreeStreams;
+    std::vector< std::unique_ptr< Stream > > mSpareStreams;
+
+    //
+    // Constants
+    //
+    static const size_t FRAMES_PER_JOB = 32;
+
+    //
+    // Helpers
+    //
+    void RunJob( size_t worker, size_t stream, const float* samples, size_t num_samples, size_t first_frame, size_t num_frames, const FrameSink& sink );
+
+};
+
+template< size_t FFT_SIZE >
+const size_t StreamEngine< FFT_SIZE >::mOutputSize;
+
+template< size_t FFT_SIZE >
+StreamEngine< FFT_SIZE >::StreamEngine( float overlap, const std::vector< float >& window, size_t num_threads, std::shared_ptr< Arena > arena ) :
+    mWindow( window ),
+    mWinLen( window.size() ),
+    mIncrement( static_cast< size_t >( ( 1-overlap )*window.size() ) ),
+    mArena( std::move( arena ) ),
+    mCQT( window.size(), mArena ),
+    mPool( num_threads )
+///
+/// Constructor.
+///
+/// @param overlap
+///  The overlap of successive STFT windows as a fraction of windowing length, as for FastWavelet.
+///
+/// @param window
+///  The windowing function of the STFT operation, which must be no longer than FFT_SIZE.
+///
+/// @param num_threads
+///  The number of worker threads. Zero uses the number of hardware threads available.
+///
+/// @param arena
+///  An optional arena to allocate all streams and worker state from. If null, they are allocated
+///  from the heap.
+///
+{
+    assert( mWinLen <= FFT_SIZE );
+    assert( mIncrement > 0 );
+
+    for( size_t worker=0; worker<mPool.GetNumThreads(); ++worker )
+    {
+        mWorkers.emplace_back( new Worker( mWindow, mArena ) );
+    }
+}
+
+template< size_t FFT_SIZE >
+StreamEngine< FFT_SIZE >::~StreamEngine() = default;
+
+template< size_t FFT_SIZE >
+size_t StreamEngine< FFT_SIZE >::AddStream()
+///
+/// Adds a stream, starting with no samples.
+///
+/// @return
+///  The index identifying the stream. Indices of removed streams are reused.
+///
+{
+    std::unique_ptr< Stream > stream;
+    if( !mSpareStreams.empty() )
+    {
+        stream = std::move( mSpareStreams.back() );
+        mSpareStreams.pop_back();
+        stream->tail.clear();
+    }
+    else
+    {
+        stream.reset( new Stream{ ArenaVector< float >( ArenaAllocator< float >( mArena ) ), 0 } );
+        stream->tail.reserve( mWinLen );
+    }
+    stream->num_frames = 0;
+
+    if( !mFreeStreams.empty() )
+    {
+        const size_t index = mFreeStreams.back();
+        mFreeStreams.pop_back();
+        mStreams[index] = std::move( stream );
+        return index;
+    }
+
+    mStreams.push_back( std::move( stream ) );
+    return mStreams.size() - 1;
+}
+
+template< size_t FFT_SIZE >
+void StreamEngine< FFT_SIZE >::RemoveStream( size_t stream )
+///
+/// Removes a stream, discarding any samples it has not yet used.
+///
+/// @param stream
+///  The index of the stream, as returned by AddStream.
+///
+{
+    assert( stream < mStreams.size() && mStreams[stream] );
+    mSpareStreams.push_back( std::move( mStreams[stream] ) );
+    mFreeStreams.push_back( stream );
+}
+
+template< size_t FFT_SIZE >
+void StreamEngine< FFT_SIZE >::Process( const StreamInput* inputs, size_t num_inputs, const FrameSink& sink )
+///
+/// Pushes new samples into any number of streams and computes every frame they complete. Each
+/// stream's frames are those a FastWavelet would return when pushed the same samples, to within
+/// the rounding of the CQT sweeps, which may filter frames in different groups.
+/// This returns once every frame has been passed to the sink.
+///
+/// @param inputs
+///  The new samples for each stream. Each stream may appear at most once.
+///
+/// @param num_inputs
+///  The number of inputs.
+///
+/// @param sink
+///  Called with each block of frames as it is computed, from the worker threads. Blocks from
+///  different streams, and from the same stream, may arrive concurrently and in any order, so the
+///  sink must be thread safe. The frames are only valid for the duration of the call.
+///
+{
+    const size_t frames_per_job = FRAMES_PER_JOB;
+
+    for( size_t input=0; input<num_inputs; ++input )
+    {
+        const StreamInput& stream_input = inputs[input];
+        assert( stream_input.stream < mStreams.size() && mStreams[stream_input.stream] );
+
+        const size_t total_samples = mStreams[stream_input.stream]->tail.size() + stream_input.num_samples;
+        const size_t num_frames = STFTFrameAnalyser< FFT_SIZE >::GetNumFrames( total_samples, mWinLen, mIncrement );
+        for( size_t first_frame=0; first_frame<num_frames; first_frame+=frames_per_job )
+        {
+            const size_t job_frames = std::min( frames_per_job, num_frames - first_frame );
+            mPool.Submit( [this, stream_input, first_frame, job_frames, &sink]( size_t worker )
+            {
+                RunJob( worker, stream_input.stream, stream_input.samples, stream_input.num_samples, first_frame, job_frames, sink );
+            });
+        }
+    }
+
+    mPool.Wait();
+
+    // Keep only the samples that have not yet completed a frame. This is less than a window, so
+    // it never needs more than the memory reserved for the tail.
+    for( size_t input=0; input<num_inputs; ++input )
+    {
+        const StreamInput& stream_input = inputs[input];
+        Stream& stream = *mStreams[stream_input.stream];
+
+        const size_t total_samples = stream.tail.size() + stream_input.num_samples;
+        const size_t num_frames = STFTFrameAnalyser< FFT_SIZE >::GetNumFrames( total_samples, mWinLen, mIncrement );
+        const size_t next_frame_start = num_frames*mIncrement;
+        if( next_frame_start >= stream.tail.size() )
+        {
+            stream.tail.assign( stream_input.samples + next_frame_start - stream.tail.size(), stream_input.samples + stream_input.num_samples );
+        }
+        else
+        {
+            stream.tail.erase( stream.tail.begin(), stream.tail.begin() + next_frame_start );
+            stream.tail.insert( stream.tail.end(), stream_input.samples, stream_input.samples + stream_input.num_samples );
+        }
+        stream.num_frames += num_frames;
+    }
+}
+
+template< size_t FFT_SIZE >
+void StreamEngine< FFT_SIZE >::RunJob( size_t worker, size_t stream, const float* samples, size_t num_samples, size_t first_frame, size_t num_frames, const FrameSink& sink )
+///
+/// Computes a block of frames of one stream and passes them to the sink.
+///
+/// @param worker
+///  The index of the worker thread running this job.
+///
+/// @param stream
+///  The index of the stream.
+///
+/// @param samples
+///  The new samples of the stream, which follow on from its tail.
+///
+/// @param num_samples
+///  The number of new samples.
+///
+/// @param first_frame
+///  The first frame to compute, counted from the start of the tail.
+///
+/// @param num_frames
+///  The number of frames to compute.
+///
+/// @param sink
+///  Receives the frames.
+///
+{
+    Worker& state = *mWorkers[worker];
+    const Stream& stream_state = *mStreams[stream];
+    const ArenaVector< float >& tail = stream_state.tail;
+
+    assert( ( first_frame + num_frames - 1 )*mIncrement + mWinLen <= tail.size() + num_samples );
+
+    for( size_t frame=0; frame<num_frames; ++frame )
+    {
+        const size_t start = ( first_frame + frame )*mIncrement;
+        if( start >= tail.size() )
+        {
+            // This and all following frames lie wholly within the new samples, so read them in place.
+            state.analyser.AnalyseFrames( samples + start - tail.size(), num_frames - frame, mIncrement, state.frames.data() + frame );
+            break;
+        }
+
+        // Join the end of the tail and the start of the new samples.
+        auto next = std::copy( tail.begin() + start, tail.end(), state.frame_samples.begin() );
+        std::copy( samples, samples + ( state.frame_samples.end() - next ), next );
+        state.analyser.AnalyseFrames( state.frame_samples.data(), 1, mIncrement, state.frames.data() + frame );
+    }
+
+    mCQT.ApplyInPlace( state.frames.data(), num_frames );
+
+    sink( stream, stream_state.num_frames + first_frame, state.frames.data(), num_frames );
+}
+
+template< size_t FFT_SIZE >
+const size_t StreamEngine< FFT_SIZE >::GetIncrement() const
+///
+/// Get the number of samples between the start of successive frames.
+///
+/// @return
+///  The STFT increment.
+///
+{
+    return mIncrement;
+}
+
+template< size_t FFT_SIZE >
+const size_t StreamEngine< FFT_SIZE >::GetNumStreams() const
+///
+/// Get the number of streams currently added.
+///
+/// @return
+///  The number of streams.
+///
+{
+    return mStreams.size() - mFreeStreams.size();
+}
+
+template< size_t FFT_SIZE >
+const size_t StreamEngine< FFT_SIZE >::GetStreamStateBytes() const
+///
+/// Get the memory held for each stream, beyond that shared by all streams.
+///
+/// @return
+///  The number of bytes of state per stream.
+///
+{
+    return sizeof( Stream ) + sizeof( std::unique_ptr< Stream > ) + mWinLen*sizeof( float );
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_STREAM_ENGINE_H
@@ -0,0 +1,396 @@
+//
+// Created: 10/18/26 by agent
+//
+// Fast wavelet analysis of a single stream, with each stage running on its own thread.
+//
+
+#ifndef CUPCAKE_STREAMING_PIPELINE_H
+#define CUPCAKE_STREAMING_PIPELINE_H
+
+// In module includes
+#include "STFTAnalysis.h"
+#include "FastCQT.h"
+#include "SPSCQueue.h"
+#include "Arena.h"
+
+// Thirdparty includes
+#include "FFT.h"
+
+// Std Lib includes
+#include <vector>
+#include <array>
+#include <complex>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+namespace cupcake
+{
+
+template< size_t FFT_SIZE >
+class StreamingPipeline
+///
+/// Computes the same frames as FastWavelet::PushSamples, with its stages overlapped in time.
+///
+/// Samples pushed by the caller are split into blocks and passed along a chain of bounded SPSCQueues:
+///
+///  caller -> STFT thread (buffering, window and FFT) -> CQT thread (fast CQT) -> sink thread
+///
+/// so that, on a long stream, the STFT of one block, the CQT of the block before and the sink of the
+/// block before that all run at once. Each queue holds at most queue_capacity blocks, so when a later
+/// stage falls behind, the stages before it wait for space and, in the end, PushSamples waits too.
+/// Memory therefore stays bounded however fast the caller pushes, and spent blocks are handed back
+/// up the chain to be reused rather than freed.
+///
+/// The sink is called on the sink thread, with consecutive blocks of frames in order. The frames are
+/// only valid for the duration of the call. An exception thrown by any stage, including the sink,
+/// stops the remaining blocks reaching the sink, and is rethrown to the caller by every later call to
+/// PushSamples and by Finish, so that no samples are silently dropped after a failure.
+///
+/// Thread safety: PushSamples and Finish must only be called from one thread at a time.
+///
+{
+
+public:
+
+    static const size_t mOutputSize = veclib::get_output_FFT_size( FFT_SIZE );
+
+    typedef typename STFTAnalysis< FFT_SIZE >::Frame Frame;
+
+    // Receives a block of consecutive frames: the index of the first frame in the block, counted from
+    // the start of the stream, the frames and the number of frames.
+    typedef std::function< void( uint64_t first_frame, const Frame* frames, size_t num_frames ) > FrameSink;
+
+    StreamingPipeline( float overlap,
+                       const std::vector< float >& window,
+                       const FrameSink& sink,
+                       size_t queue_capacity=DEFAULT_QUEUE_CAPACITY,
+                       std::shared_ptr< Arena > arena=nullptr );
+    ~StreamingPipeline();
+
+    void PushSamples( const float* samples, size_t num_samples );
+    void Finish();
+
+    const size_t GetIncrement() const;
+
+    //
+    // Constants
+    //
+    static const size_t DEFAULT_QUEUE_CAPACITY = 4;
+    static const size_t MAX_BLOCK_SAMPLES = 8192;
+
+private:
+
+    struct FrameBlock
+    ///
+    /// A block of consecutive frames on their way to the sink.
+    ///
+    {
+        uint64_t first_frame = 0;
+        std::vector< Frame > frames;
+    };
+
+    //
+    // Configuration
+    //
+    const FrameSink mSink;
+
+    //
+    // Mechanics
+    //
+    STFTAnalysis< FFT_SIZE > mSTFT;
+    FastCQT< FFT_SIZE > mCQT;
+    SPSCQueue< std::vector< float > > mSampleQueue;     // Caller to STFT thread.
+    SPSCQueue< FrameBlock > mFrameQueue;                // STFT thread to CQT thread.
+    SPSCQueue< FrameBlock > mOutputQueue;               // CQT thread to sink thread.
+    SPSCQueue< std::vector< float > > mFreeSamples;     // Spent sample blocks, STFT thread to caller.
+    SPSCQueue< FrameBlock > mFreeFrames;                // Spent frame blocks, sink thread to STFT thread.
+
+    //
+    // Data
+    //
+    uint64_t mNumFrames;                // Frames produced by the STFT thread so far.
+    bool mFinished;
+
+    //
+    // Thread safety
+    //
+    std::atomic< bool > mFailed;
+    std::exception_ptr mError;
+    std::mutex mErrorMutex;
+    std::thread mSTFTThread;
+    std::thread mCQTThread;
+    std::thread mSinkThread;
+
+    //
+    // Helpers
+    //
+    void RunSTFT();
+    void RunCQT();
+    void RunSink();
+    void SetError( std::exception_ptr error );
+    void RethrowError();
+    void Stop();
+
+};
+
+template< size_t FFT_SIZE >
+const size_t StreamingPipeline< FFT_SIZE >::mOutputSize;
+
+template< size_t FFT_SIZE >
+const size_t StreamingPipeline< FFT_SIZE >::DEFAULT_QUEUE_CAPACITY;
+
+template< size_t FFT_SIZE >
+const size_t StreamingPipeline< FFT_SIZE >::MAX_BLOCK_SAMPLES;
+
+template< size_t FFT_SIZE >
+StreamingPipeline< FFT_SIZE >::StreamingPipeline( float overlap,
+                                                  const std::vector< float >& window,
+                                                  const FrameSink& sink,
+                                                  size_t queue_capacity,
+                                                  std::shared_ptr< Arena > arena ) :
+    mSink( sink ),
+    mSTFT( overlap, window, arena ),
+    mCQT( window.size(), arena ),
+    mSampleQueue( queue_capacity ),
+    mFrameQueue( queue_capacity ),
+    mOutputQueue( queue_capacity ),
+    mFreeSamples( queue_capacity + 2 ),
+    mFreeFrames( queue_capacity + 2 ),
+    mNumFrames( 0 ),
+    mFinished( false ),
+    mFailed( false )
+///
+/// Constructor. Starts the thread of each stage.
+///
+/// @param overlap
+///  The overlap of successive STFT windows as a fraction of windowing length.
+///
+/// @param window
+///  The windowing function of the STFT, which must be no longer than FFT_SIZE.
+///
+/// @param sink
+///  Receives every frame, in order, on the sink thread.
+///
+/// @param queue_capacity
+///  The number of blocks each queue between stages holds before the stage feeding it waits.
+///
+/// @param arena
+///  An optional arena for the STFT input buffer and working memory, and the CQT coefficients.
+///
+{
+    mSTFTThread = std::thread( &StreamingPipeline::RunSTFT, this );
+    mCQTThread = std::thread( &StreamingPipeline::RunCQT, this );
+    mSinkThread = std::thread( &StreamingPipeline::RunSink, this );
+}
+
+template< size_t FFT_SIZE >
+StreamingPipeline< FFT_SIZE >::~StreamingPipeline()
+///
+/// Destructor. Lets every sample already pushed reach the sink, then stops the threads. Any error
+/// that has not been rethrown is dropped.
+///
+{
+    Stop();
+}
+
+template< size_t FFT_SIZE >
+void StreamingPipeline< FFT_SIZE >::PushSamples( const float* samples, size_t num_samples )
+///
+/// Push samples to be analysed. This returns once the samples are queued for the STFT thread, which
+/// waits while the queue is full.
+///
+/// @param samples
+///  The samples, which are copied, so only need to remain valid for the duration of this call.
+///
+/// @param num_samples
+///  The number of samples.
+///
+{
+    if( mFinished )
+    {
+        throw std::logic_error( "Samples cannot be pushed after Finish" );
+    }
+    RethrowError();
+
+    for( size_t first=0; first<num_samples; first+=MAX_BLOCK_SAMPLES )
+    {
+        std::vector< float > block;
+        mFreeSamples.TryPop( block );
+        block.assign( samples + first, samples + std::min( num_samples, first + MAX_BLOCK_SAMPLES ) );
+        mSampleQueue.Push( block );
+    }
+}
+
+template< size_t FFT_SIZE >
+void StreamingPipeline< FFT_SIZE >::Finish()
+///
+/// Waits for every sample pushed to reach the sink, and stops the threads. No more samples may be
+/// pushed afterwards.
+///
+{
+    Stop();
+    RethrowError();
+}
+
+template< size_t FFT_SIZE >
+const size_t StreamingPipeline< FFT_SIZE >::GetIncrement() const
+///
+/// Get the number of samples between the starts of successive frames.
+///
+/// @return
+///  The STFT increment in samples.
+///
+{
+    return mSTFT.GetIncrement();
+}
+
+template< size_t FFT_SIZE >
+void StreamingPipeline< FFT_SIZE >::RunSTFT()
+///
+/// The body of the STFT thread.
+///
+{
+    std::vector< float > samples;
+    while( mSampleQueue.Pop( samples ) )
+    {
+        if( !mFailed.load( std::memory_order_relaxed ) )
+        {
+            try
+            {
+                auto& frames = mSTFT.PushSamples( samples.data(), samples.size() );
+                if( !frames.empty() )
+                {
+                    FrameBlock block;
+                    mFreeFrames.TryPop( block );
+                    block.first_frame = mNumFrames;
+                    block.frames.assign( frames.begin(), frames.end() );
+                    mNumFrames += frames.size();
+                    mFrameQueue.Push( block );
+                }
+            }
+            catch( ... )
+            {
+                SetError( std::current_exception() );
+            }
+        }
+        mFreeSamples.TryPush( samples );
+    }
+    mFrameQueue.Close();
+}
+
+template< size_t FFT_SIZE >
+void StreamingPipeline< FFT_SIZE >::RunCQT()
+///
+/// The body of the CQT thread.
+///
+{
+    FrameBlock block;
+    while( mFrameQueue.Pop( block ) )
+    {
+        if( !mFailed.load( std::memory_order_relaxed ) )
+        {
+            try
+            {
+                mCQT.ApplyInPlace( block.frames );
+            }
+            catch( ... )
+            {
+                SetError( std::current_exception() );
+            }
+        }
+        mOutputQueue.Push( block );
+    }
+    mOutputQueue.Close();
+}
+
+template< size_t FFT_SIZE >
+void StreamingPipeline< FFT_SIZE >::RunSink()
+///
+/// The body of the sink thread.
+///
+{
+    FrameBlock block;
+    while( mOutputQueue.Pop( block ) )
+    {
+        if( !mFailed.load( std::memory_order_relaxed ) )
+        {
+            try
+            {
+                mSink( block.first_frame, block.frames.data(), block.frames.size() );
+            }
+            catch( ... )
+            {
+                SetError( std::current_exception() );
+            }
+        }
+        mFreeFrames.TryPush( block );
+    }
+}
+
+template< size_t FFT_SIZE >
+void StreamingPipeline< FFT_SIZE >::SetError( std::exception_ptr error )
+///
+/// Keeps the first error thrown by any stage, after which the stages pass blocks along without
+/// processing them.
+///
+/// @param error
+///  The error.
+///
+{
+    std::lock_guard< std::mutex > lock( mErrorMutex );
+    if( !mError )
+    {
+        mError = error;
+    }
+    mFailed.store( true );
+}
+
+template< size_t FFT_SIZE >
+void StreamingPipeline< FFT_SIZE >::RethrowError()
+///
+/// Rethrows the first error thrown by any stage. The error is kept, so every call after a failure
+/// throws it.
+///
+{
+    if( !mFailed.load() )
+    {
+        return;
+    }
+    std::exception_ptr error;
+    {
+        std::lock_guard< std::mutex > lock( mErrorMutex );
+        error = mError;
+    }
+    if( error )
+    {
+        std::rethrow_exception( error );
+    }
+}
+
+template< size_t FFT_SIZE >
+void StreamingPipeline< FFT_SIZE >::Stop()
+///
+/// Closes the input and waits for each thread to finish its queue.
+///
+{
+    if( mFinished )
+    {
+        return;
+    }
+    mFinished = true;
+    mSampleQueue.Close();
+    mSTFTThread.join();
+    mCQTThread.join();
+    mSinkThread.join();
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_STREAMING_PIPELINE_H
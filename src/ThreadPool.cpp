@@ -0,0 +1,154 @@
+//
+// Created: 10/18/26 by agent
+//
+// A fixed pool of worker threads for data parallel loops.
+//
+
+// In module includes
+#include "ThreadPool.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <algorithm>
+
+using namespace cupcake;
+
+ThreadPool::ThreadPool( size_t num_threads ) :
+    mTask( nullptr ),
+    mNumTasks( 0 ),
+    mNextTask( 0 ),
+    mGeneration( 0 ),
+    mNumBusy( 0 ),
+    mStop( false )
+///
+/// Constructor.
+///
+/// @param num_threads
+///  The total number of threads that run each loop, including the calling thread.
+///  Zero uses the number of hardware threads available.
+///
+{
+    if( num_threads == 0 )
+    {
+        num_threads = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+
+    mThreads.reserve( num_threads - 1 );
+    for( size_t worker=1; worker<num_threads; ++worker )
+    {
+        mThreads.emplace_back( &ThreadPool::WorkerLoop, this, worker );
+    }
+}
+
+ThreadPool::~ThreadPool()
+///
+/// Destructor. Stops and joins all worker threads.
+///
+{
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mStop = true;
+    }
+    mStartCondition.notify_all();
+
+    for( auto& thread : mThreads )
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::ParallelFor( size_t num_tasks, const Task& task )
+///
+/// Runs a task for every index in [0, num_tasks) across all threads in the pool, returning once
+/// every task is complete. Calls from different threads are run one after the other.
+///
+/// @param num_tasks
+///  The number of tasks to run.
+///
+/// @param task
+///  The function to run for each task. It is passed the task index and the index of the worker
+///  running it, which is in [0, GetNumThreads()). No two tasks run on the same worker at once.
+///
+{
+    std::lock_guard< std::mutex > call_lock( mCallMutex );
+
+    if( num_tasks == 0 )
+    {
+        return;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mTask = &task;
+        mNumTasks = num_tasks;
+        mNextTask.store( 0 );
+        mNumBusy = mThreads.size();
+        ++mGeneration;
+    }
+    mStartCondition.notify_all();
+
+    RunTasks( 0 );
+
+    std::unique_lock< std::mutex > lock( mMutex );
+    mDoneCondition.wait( lock, [this](){ return mNumBusy == 0; } );
+    mTask = nullptr;
+}
+
+const size_t ThreadPool::GetNumThreads() const
+///
+/// Get the number of threads that run each loop, including the calling thread.
+///
+/// @return
+///  The number of workers.
+///
+{
+    return mThreads.size() + 1;
+}
+
+void ThreadPool::WorkerLoop( size_t worker )
+///
+/// The body of each worker thread. Waits for a loop to be started, helps run its tasks, and
+/// reports back when there are none left.
+///
+/// @param worker
+///  The index of this worker.
+///
+{
+    size_t generation = 0;
+    while( true )
+    {
+        {
+            std::unique_lock< std::mutex > lock( mMutex );
+            mStartCondition.wait( lock, [this, generation](){ return mStop || mGeneration != generation; } );
+            if( mStop )
+            {
+                return;
+            }
+            generation = mGeneration;
+        }
+
+        RunTasks( worker );
+
+        {
+            std::lock_guard< std::mutex > lock( mMutex );
+            --mNumBusy;
+        }
+        mDoneCondition.notify_one();
+    }
+}
+
+void ThreadPool::RunTasks( size_t worker )
+///
+/// Takes and runs tasks from the current loop until there are none left.
+///
+/// @param worker
+///  The index of the worker running the tasks.
+///
+{
+    for( size_t task=mNextTask.fetch_add( 1 ); task<mNumTasks; task=mNextTask.fetch_add( 1 ) )
+    {
+        (*mTask)( task, worker );
+    }
+}
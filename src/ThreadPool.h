@@ -0,0 +1,81 @@
+//
+// Created: 10/18/26 by agent
+//
+// A fixed pool of worker threads for data parallel loops.
+//
+
+#ifndef CUPCAKE_THREAD_POOL_H
+#define CUPCAKE_THREAD_POOL_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace cupcake
+{
+
+class ThreadPool
+///
+/// A set of worker threads that are started once and then reused for every parallel loop, so
+/// the cost of creating threads is not paid per call. The thread calling ParallelFor takes part
+/// in the loop as worker 0, so a pool of N threads starts N-1 of its own.
+///
+/// Tasks are handed out one at a time from a shared counter, so workers that finish early simply
+/// take more tasks. Each task is told which worker is running it, so callers can keep one set of
+/// scratch state per worker rather than per task.
+///
+{
+
+public:
+
+    ThreadPool( size_t num_threads=0 );
+    ~ThreadPool();
+
+    typedef std::function< void( size_t task, size_t worker ) > Task;
+
+    void ParallelFor( size_t num_tasks, const Task& task );
+
+    const size_t GetNumThreads() const;
+
+private:
+
+    //
+    // Mechanics
+    //
+    std::vector< std::thread > mThreads;
+    std::mutex mCallMutex;
+    std::mutex mMutex;
+    std::condition_variable mStartCondition;
+    std::condition_variable mDoneCondition;
+
+    //
+    // Data
+    //
+    const Task* mTask;
+    size_t mNumTasks;
+    std::atomic< size_t > mNextTask;
+    size_t mGeneration;
+    size_t mNumBusy;
+    bool mStop;
+
+    //
+    // Helpers
+    //
+    void WorkerLoop( size_t worker );
+    void RunTasks( size_t worker );
+
+};
+
+} // namespace cupcake
+
+#endif // CUPCAKE_THREAD_POOL_H
@@ -0,0 +1,494 @@
+//
+// Created: 10/18/26 by agent
+//
+// A content-addressed on-disk cache of FastWavelet transforms.
+//
+
+// In module includes
+#include "TransformCache.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <time.h>
+
+using namespace cupcake;
+
+namespace
+{
+
+const char CACHE_EXTENSION[] = ".cfs";
+const char TEMPORARY_EXTENSION[] = ".cfs.tmp.";                 // Followed by the writer's pid and a count.
+const int64_t STALE_TEMPORARY_NS = 10ll*60*1000000000;          // Temporary files untouched for this long were left by a crashed writer.
+const uint64_t EVICTION_HEADROOM = 10;                          // Eviction frees a further 1/EVICTION_HEADROOM of the limit.
+const uint64_t HASH_C1 = 0x87c37b91114253d5ull;
+const uint64_t HASH_C2 = 0x4cf5ad432745937full;
+
+uint64_t rotate_left( uint64_t x, int bits )
+{
+    return ( x << bits ) | ( x >> ( 64 - bits ) );
+}
+
+uint64_t final_mix( uint64_t x )
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+bool is_cache_entry( const std::string& name )
+{
+    const size_t extension_length = sizeof( CACHE_EXTENSION ) - 1;
+    return name.size() > extension_length && name.compare( name.size() - extension_length, extension_length, CACHE_EXTENSION ) == 0;
+}
+
+bool is_temporary( const std::string& name )
+{
+    return name.find( TEMPORARY_EXTENSION ) != std::string::npos;
+}
+
+int64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime( CLOCK_REALTIME, &now );
+    return static_cast< int64_t >( now.tv_sec )*1000000000 + now.tv_nsec;
+}
+
+struct CacheEntry
+///
+/// A file in the cache directory, as seen by eviction.
+///
+{
+    std::string path;
+    uint64_t size;
+    int64_t last_used;      // Modification time in nanoseconds.
+    bool temporary;         // A transform still being written, or left behind by a crashed writer.
+};
+
+std::vector< CacheEntry > list_entries( const std::string& directory )
+///
+/// Lists the transforms in a cache directory, along with the temporary files of transforms being
+/// written.
+///
+{
+    std::vector< CacheEntry > entries;
+    DIR* dir = opendir( directory.c_str() );
+    if( !dir )
+    {
+        return entries;
+    }
+
+    while( struct dirent* item = readdir( dir ) )
+    {
+        const std::string name( item->d_name );
+        const bool temporary = is_temporary( name );
+        if( !temporary && !is_cache_entry( name ) )
+        {
+            continue;
+        }
+
+        const std::string path = directory + "/" + name;
+        struct stat info;
+        if( stat( path.c_str(), &info ) != 0 )
+        {
+            continue;   // Removed by another cache since it was listed.
+        }
+#ifdef __APPLE__
+        const int64_t last_used = static_cast< int64_t >( info.st_mtimespec.tv_sec )*1000000000 + info.st_mtimespec.tv_nsec;
+#else
+        const int64_t last_used = static_cast< int64_t >( info.st_mtim.tv_sec )*1000000000 + info.st_mtim.tv_nsec;
+#endif
+        entries.push_back( { path, static_cast< uint64_t >( info.st_size ), last_used, temporary } );
+    }
+    closedir( dir );
+    return entries;
+}
+
+} // namespace
+
+
+//
+// Keys
+//
+
+std::string TransformKey::ToString() const
+///
+/// Formats the key as 32 hexadecimal digits.
+///
+/// @return
+///  The key as a string, as used in file names.
+///
+{
+    char text[33];
+    std::snprintf( text, sizeof( text ), "%016llx%016llx", static_cast< unsigned long long >( high ), static_cast< unsigned long long >( low ) );
+    return std::string( text );
+}
+
+TransformHasher::TransformHasher() :
+    mLane1( 0x9e3779b97f4a7c15ull ),
+    mLane2( 0x6a09e667f3bcc909ull ),
+    mNumBytes( 0 ),
+    mNumPending( 0 )
+///
+/// Constructor. Starts a hash of no bytes.
+///
+{
+}
+
+void TransformHasher::Update( const void* data, size_t num_bytes )
+///
+/// Adds bytes to the hash, following on from those already added.
+///
+/// @param data
+///  The bytes.
+///
+/// @param num_bytes
+///  The number of bytes.
+///
+{
+    const unsigned char* bytes = static_cast< const unsigned char* >( data );
+    mNumBytes += num_bytes;
+
+    // Complete a block left over from the last update.
+    if( mNumPending > 0 )
+    {
+        const size_t num_copied = std::min( num_bytes, sizeof( mPending ) - mNumPending );
+        std::memcpy( mPending + mNumPending, bytes, num_copied );
+        mNumPending += num_copied;
+        bytes += num_copied;
+        num_bytes -= num_copied;
+        if( mNumPending < sizeof( mPending ) )
+        {
+            return;
+        }
+
+        uint64_t words[2];
+        std::memcpy( words, mPending, sizeof( words ) );
+        MixBlock( words[0], words[1] );
+        mNumPending = 0;
+    }
+
+    for( ; num_bytes>=sizeof( mPending ); bytes+=sizeof( mPending ), num_bytes-=sizeof( mPending ) )
+    {
+        uint64_t words[2];
+        std::memcpy( words, bytes, sizeof( words ) );
+        MixBlock( words[0], words[1] );
+    }
+
+    std::memcpy( mPending, bytes, num_bytes );
+    mNumPending = num_bytes;
+}
+
+TransformKey TransformHasher::Finish() const
+///
+/// Computes the hash of all bytes added so far. More bytes may still be added afterwards.
+///
+/// @return
+///  The hash.
+///
+{
+    TransformHasher tail( *this );
+    if( tail.mNumPending > 0 )
+    {
+        std::memset( tail.mPending + tail.mNumPending, 0, sizeof( mPending ) - tail.mNumPending );
+        uint64_t words[2];
+        std::memcpy( words, tail.mPending, sizeof( words ) );
+        tail.MixBlock( words[0], words[1] );
+    }
+
+    uint64_t lane1 = tail.mLane1 ^ mNumBytes;
+    uint64_t lane2 = tail.mLane2 ^ mNumBytes;
+    lane1 += lane2;
+    lane2 += lane1;
+    lane1 = final_mix( lane1 );
+    lane2 = final_mix( lane2 );
+    lane1 += lane2;
+    lane2 += lane1;
+    return TransformKey{ lane1, lane2 };
+}
+
+void TransformHasher::MixBlock( uint64_t first, uint64_t second )
+///
+/// Mixes one 16 byte block into the two lanes of the hash.
+///
+{
+    first *= HASH_C1;
+    first = rotate_left( first, 31 );
+    first *= HASH_C2;
+    mLane1 ^= first;
+    mLane1 = rotate_left( mLane1, 27 ) + mLane2;
+    mLane1 = mLane1*5 + 0x52dce729;
+
+    second *= HASH_C2;
+    second = rotate_left( second, 33 );
+    second *= HASH_C1;
+    mLane2 ^= second;
+    mLane2 = rotate_left( mLane2, 31 ) + mLane1;
+    mLane2 = mLane2*5 + 0x38495ab5;
+}
+
+
+//
+// Cache
+//
+
+TransformCache::TransformCache( const std::string& directory, uint64_t max_bytes ) :
+    mDirectory( directory ),
+    mMaxBytes( max_bytes ),
+    mNumHits( 0 ),
+    mNumMisses( 0 ),
+    mSizeBytes( 0 )
+///
+/// Constructor. Measures the cache directory, evicting transforms if it is over the size limit.
+///
+/// @param directory
+///  The directory holding the cached transforms. It is created if it does not exist, though its
+///  parent must.
+///
+/// @param max_bytes
+///  The total size of the cached transforms, beyond which the least recently used are deleted.
+///
+{
+    if( mkdir( directory.c_str(), 0755 ) != 0 && errno != EEXIST )
+    {
+        throw std::runtime_error( "Could not create cache directory '" + directory + "': " + std::strerror( errno ) );
+    }
+    Evict();
+}
+
+TransformCache::~TransformCache()
+///
+/// Destructor. Cached transforms stay on disk for later caches.
+///
+{
+}
+
+std::shared_ptr< FrameStoreReader > TransformCache::Find( const TransformKey& key )
+///
+/// Looks up a transform, marking it as recently used if it is found.
+///
+/// @param key
+///  The key of the transform.
+///
+/// @return
+///  A reader mapping the transform, or null if it is not cached.
+///
+{
+    const std::string path = GetPath( key );
+    std::shared_ptr< FrameStoreReader > reader;
+    try
+    {
+        reader = std::make_shared< FrameStoreReader >( path );
+    }
+    catch( const std::runtime_error& )
+    {
+        // Missing, or evicted by another cache while being opened.
+    }
+
+    if( reader && reader->GetNumClips() != 1 )
+    {
+        // Not a transform written by a cache. Treat it as missing so that it is replaced.
+        reader.reset();
+    }
+    if( reader )
+    {
+        utimensat( AT_FDCWD, path.c_str(), nullptr, 0 );
+    }
+
+    std::lock_guard< std::mutex > lock( mMutex );
+    ++( reader ? mNumHits : mNumMisses );
+    return reader;
+}
+
+std::shared_ptr< FrameStoreReader > TransformCache::Insert( const TransformKey& key,
+                                                            size_t fft_size,
+                                                            size_t hop,
+                                                            const std::vector< float >& window,
+                                                            const std::complex< float >* frames,
+                                                            size_t num_frames )
+///
+/// Stores a transform, replacing any transform with the same key, then evicts transforms if the
+/// cache is over its size limit.
+///
+/// @param key
+///  The key of the transform.
+///
+/// @param fft_size
+///  The FFT size of the frames.
+///
+/// @param hop
+///  The number of samples between successive frames.
+///
+/// @param window
+///  The analysis window.
+///
+/// @param frames
+///  num_frames x ( fft_size/2 + 1 ) complex values, frame after frame.
+///
+/// @param num_frames
+///  The number of frames.
+///
+/// @return
+///  A reader mapping the stored transform. This remains valid even if the transform is evicted.
+///
+{
+    static std::atomic< uint64_t > num_inserts( 0 );
+    const std::string path = GetPath( key );
+    const std::string temporary_path = path + ".tmp." + std::to_string( getpid() ) + "." + std::to_string( num_inserts++ );
+
+    try
+    {
+        FrameStoreWriter writer( temporary_path, fft_size, hop, window );
+        writer.BeginClip( key.ToString() );
+        writer.WriteFrames( frames, num_frames );
+        writer.EndClip();
+    }
+    catch( ... )
+    {
+        std::remove( temporary_path.c_str() );
+        throw;
+    }
+    struct stat info;
+    const uint64_t added_bytes = stat( temporary_path.c_str(), &info ) == 0 ? static_cast< uint64_t >( info.st_size ) : 0;
+    const uint64_t replaced_bytes = stat( path.c_str(), &info ) == 0 ? static_cast< uint64_t >( info.st_size ) : 0;
+    if( std::rename( temporary_path.c_str(), path.c_str() ) != 0 )
+    {
+        std::remove( temporary_path.c_str() );
+        throw std::runtime_error( "Could not add '" + path + "' to the cache: " + std::strerror( errno ) );
+    }
+
+    std::shared_ptr< FrameStoreReader > reader = std::make_shared< FrameStoreReader >( path );
+
+    // The directory is only measured again once the running size goes over the limit.
+    std::lock_guard< std::mutex > lock( mMutex );
+    mSizeBytes += added_bytes - std::min( replaced_bytes, mSizeBytes );
+    if( mSizeBytes > mMaxBytes )
+    {
+        EvictLocked();
+    }
+    return reader;
+}
+
+void TransformCache::Evict()
+///
+/// Measures the cache directory, deleting temporary files left behind by crashed writers, then, if
+/// the cache is over its size limit, deletes the least recently used transforms until it is a
+/// little under the limit. Insert calls this itself whenever the size of the transforms it has added
+/// since the directory was last measured takes the cache over its limit.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    EvictLocked();
+}
+
+void TransformCache::EvictLocked()
+///
+/// Evict, for a caller holding mMutex.
+///
+{
+    std::vector< CacheEntry > entries = list_entries( mDirectory );
+    const int64_t stale_before = now_ns() - STALE_TEMPORARY_NS;
+    uint64_t total = 0;
+    for( auto entry=entries.begin(); entry!=entries.end(); )
+    {
+        if( entry->temporary && entry->last_used < stale_before )
+        {
+            unlink( entry->path.c_str() );
+            entry = entries.erase( entry );
+            continue;
+        }
+        total += entry->size;
+        ++entry;
+    }
+
+    // Temporary files of transforms being written take up space, but cannot be evicted. Evicting
+    // down to a little under the limit leaves room for a few inserts before the next measurement.
+    if( total > mMaxBytes )
+    {
+        const uint64_t target = mMaxBytes - mMaxBytes/EVICTION_HEADROOM;
+        std::sort( entries.begin(), entries.end(), []( const CacheEntry& a, const CacheEntry& b ){ return a.last_used < b.last_used; } );
+        for( auto entry=entries.begin(); entry!=entries.end() && total>target; ++entry )
+        {
+            if( !entry->temporary )
+            {
+                unlink( entry->path.c_str() );
+                total -= entry->size;
+            }
+        }
+    }
+    mSizeBytes = total;
+}
+
+const uint64_t TransformCache::GetMaxBytes() const
+///
+/// Get the size limit of the cache.
+///
+/// @return
+///  The size limit in bytes.
+///
+{
+    return mMaxBytes;
+}
+
+const uint64_t TransformCache::GetNumHits() const
+///
+/// Get the number of lookups that found a cached transform.
+///
+/// @return
+///  The number of hits.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mNumHits;
+}
+
+const uint64_t TransformCache::GetNumMisses() const
+///
+/// Get the number of lookups that did not find a cached transform.
+///
+/// @return
+///  The number of misses.
+///
+{
+    std::lock_guard< std::mutex > lock( mMutex );
+    return mNumMisses;
+}
+
+uint64_t TransformCache::GetSizeBytes() const
+///
+/// Get the total size of the transforms in the cache directory, including those cached by others.
+/// This measures the directory, so is not the running size used to decide when to evict.
+///
+/// @return
+///  The size in bytes.
+///
+{
+    uint64_t total = 0;
+    for( const CacheEntry& entry : list_entries( mDirectory ) )
+    {
+        total += entry.temporary ? 0 : entry.size;
+    }
+    return total;
+}
+
+std::string TransformCache::GetPath( const TransformKey& key ) const
+///
+/// Get the file in which a transform is cached.
+///
+{
+    return mDirectory + "/" + key.ToString() + CACHE_EXTENSION;
+}
@@ -0,0 +1,213 @@
+//
+// Created: 10/18/26 by agent
+//
+// A content-addressed on-disk cache of FastWavelet transforms.
+//
+
+#ifndef CUPCAKE_TRANSFORM_CACHE_H
+#define CUPCAKE_TRANSFORM_CACHE_H
+
+// In module includes
+#include "FastWavelet.h"
+#include "FrameStore.h"
+#include "ArrayView.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <complex>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace cupcake
+{
+
+struct TransformKey
+///
+/// A 128 bit hash identifying a transform by its input samples and configuration.
+///
+{
+    uint64_t high;
+    uint64_t low;
+
+    std::string ToString() const;
+    bool operator==( const TransformKey& other ) const { return high == other.high && low == other.low; };
+};
+
+class TransformHasher
+///
+/// Builds a TransformKey incrementally from blocks of bytes.
+///
+/// This is a fast, non-cryptographic hash in the style of MurmurHash3's 128 bit variant, reading
+/// 16 bytes at a time in two independent lanes. It identifies content that is the same, but gives
+/// no protection against inputs crafted to collide.
+///
+{
+
+public:
+
+    TransformHasher();
+
+    void Update( const void* data, size_t num_bytes );
+    TransformKey Finish() const;
+
+private:
+
+    //
+    // Data
+    //
+    uint64_t mLane1;
+    uint64_t mLane2;
+    uint64_t mNumBytes;
+    unsigned char mPending[16];     // Bytes not yet making up a whole block.
+    size_t mNumPending;
+
+    //
+    // Helpers
+    //
+    void MixBlock( uint64_t first, uint64_t second );
+
+};
+
+class TransformCache
+///
+/// Caches the transforms of whole clips in a directory of frame stores, one per transform, named
+/// by the hash of the clip's samples and the transform configuration (FFT size, hop, window and
+/// CQT coefficients). Repeated analysis of the same audio with the same parameters is then served
+/// by mapping the stored frames rather than computing them.
+///
+/// When the directory grows beyond its size limit, the least recently used transforms are deleted,
+/// where use is tracked through the modification times of the files. Rather than measuring the
+/// directory on every insert, the cache keeps a running size, measured on construction and on each
+/// eviction, and increased by each insert. Several caches, in this or other processes, may share a
+/// directory: entries are written to a temporary file and renamed into place, and a transform that
+/// is deleted while mapped remains readable until it is unmapped. Each cache only counts its own
+/// inserts between measurements, so a shared directory may exceed the limit until one of them
+/// next evicts. Temporary files left by crashed writers are deleted on eviction.
+///
+{
+
+public:
+
+    TransformCache( const std::string& directory, uint64_t max_bytes );
+    ~TransformCache();
+
+    template< size_t FFT_SIZE >
+    std::shared_ptr< FrameStoreReader > Transform( FastWavelet< FFT_SIZE >& wavelet, ArrayView< const float > audio );
+
+    template< size_t FFT_SIZE >
+    static TransformKey MakeKey( FastWavelet< FFT_SIZE >& wavelet, ArrayView< const float > audio );
+
+    std::shared_ptr< FrameStoreReader > Find( const TransformKey& key );
+    std::shared_ptr< FrameStoreReader > Insert( const TransformKey& key,
+                                                size_t fft_size,
+                                                size_t hop,
+                                                const std::vector< float >& window,
+                                                const std::complex< float >* frames,
+                                                size_t num_frames );
+    void Evict();
+
+    const uint64_t GetMaxBytes() const;
+    const uint64_t GetNumHits() const;
+    const uint64_t GetNumMisses() const;
+    uint64_t GetSizeBytes() const;
+
+private:
+
+    //
+    // Configuration
+    //
+    const std::string mDirectory;
+    const uint64_t mMaxBytes;
+
+    //
+    // Statistics
+    //
+    uint64_t mNumHits;
+    uint64_t mNumMisses;
+
+    //
+    // Data
+    //
+    uint64_t mSizeBytes;        // The size of the directory when last measured, plus that added since.
+
+    //
+    // Thread safety
+    //
+    mutable std::mutex mMutex;
+
+    //
+    // Helpers
+    //
+    std::string GetPath( const TransformKey& key ) const;
+    void EvictLocked();
+
+};
+
+template< size_t FFT_SIZE >
+std::shared_ptr< FrameStoreReader > TransformCache::Transform( FastWavelet< FFT_SIZE >& wavelet, ArrayView< const float > audio )
+///
+/// Gets the transform of a clip, computing and storing it only if it is not already cached.
+///
+/// @param wavelet
+///  The transform. The clip is transformed as though it were pushed through a freshly constructed
+///  FastWavelet with the same configuration (i.e. by TransformBatch), so the streaming state of
+///  this object is neither used nor modified.
+///
+/// @param audio
+///  The samples of the clip.
+///
+/// @return
+///  A reader mapping the transform, whose clip 0 holds its frames.
+///
+{
+    const TransformKey key = MakeKey( wavelet, audio );
+    std::shared_ptr< FrameStoreReader > cached = Find( key );
+    if( cached )
+    {
+        return cached;
+    }
+
+    const size_t num_frames = wavelet.GetNumFrames( audio.size() );
+    std::vector< std::complex< float > > frames( num_frames*FastWavelet< FFT_SIZE >::mOutputSize );
+    {
+        std::lock_guard< std::mutex > lock( wavelet.GetMutex() );
+        wavelet.TransformBatch( audio.data(), 1, audio.size(), nullptr, frames.data(), num_frames );
+    }
+    return Insert( key, FFT_SIZE, wavelet.GetIncrement(), wavelet.GetWindow(), frames.data(), num_frames );
+}
+
+template< size_t FFT_SIZE >
+TransformKey TransformCache::MakeKey( FastWavelet< FFT_SIZE >& wavelet, ArrayView< const float > audio )
+///
+/// Hashes a clip along with everything about the transform that affects its frames.
+///
+/// @param wavelet
+///  The transform.
+///
+/// @param audio
+///  The samples of the clip.
+///
+/// @return
+///  The key of the clip's transform.
+///
+{
+    const std::vector< float >& window = wavelet.GetWindow();
+    const std::vector< std::complex< float > >& coefficients = wavelet.GetCQTCoeffs();
+    const uint64_t config[] = { FFT_SIZE, wavelet.GetIncrement(), window.size(), coefficients.size(), audio.size() };
+
+    TransformHasher hasher;
+    hasher.Update( config, sizeof( config ) );
+    hasher.Update( window.data(), window.size()*sizeof( float ) );
+    hasher.Update( coefficients.data(), coefficients.size()*sizeof( std::complex< float > ) );
+    hasher.Update( audio.data(), audio.size()*sizeof( float ) );
+    return hasher.Finish();
+}
+
+} // namespace cupcake
+
+#endif // CUPCAKE_TRANSFORM_CACHE_H
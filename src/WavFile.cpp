@@ -0,0 +1,339 @@
+//
+// Created: 10/18/26 by agent
+//
+// A memory-mapped reader of PCM and floating point WAV files.
+//
+
+// In module includes
+#include "WavFile.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace cupcake;
+
+namespace
+{
+
+const uint16_t WAV_PCM = 0x0001;
+const uint16_t WAV_IEEE_FLOAT = 0x0003;
+const uint16_t WAV_EXTENSIBLE = 0xfffe;
+
+uint16_t read_u16( const unsigned char* bytes )
+{
+    return static_cast< uint16_t >( bytes[0] | ( bytes[1] << 8 ) );
+}
+
+uint32_t read_u32( const unsigned char* bytes )
+{
+    return static_cast< uint32_t >( bytes[0] ) | ( static_cast< uint32_t >( bytes[1] ) << 8 ) |
+           ( static_cast< uint32_t >( bytes[2] ) << 16 ) | ( static_cast< uint32_t >( bytes[3] ) << 24 );
+}
+
+struct DecodeInt8
+{
+    float operator()( const unsigned char* bytes ) const { return ( static_cast< int >( bytes[0] ) - 128 )/128.0f; }
+};
+
+struct DecodeInt16
+{
+    float operator()( const unsigned char* bytes ) const { return static_cast< int16_t >( read_u16( bytes ) )/32768.0f; }
+};
+
+struct DecodeInt24
+{
+    float operator()( const unsigned char* bytes ) const
+    {
+        const int32_t value = static_cast< int32_t >( ( static_cast< uint32_t >( bytes[0] ) << 8 ) | ( static_cast< uint32_t >( bytes[1] ) << 16 ) | ( static_cast< uint32_t >( bytes[2] ) << 24 ) );
+        return ( value >> 8 )/8388608.0f;
+    }
+};
+
+struct DecodeInt32
+{
+    float operator()( const unsigned char* bytes ) const { return static_cast< float >( static_cast< int32_t >( read_u32( bytes ) )/2147483648.0 ); }
+};
+
+struct DecodeFloat32
+{
+    float operator()( const unsigned char* bytes ) const
+    {
+        const uint32_t bits = read_u32( bytes );
+        float value;
+        std::memcpy( &value, &bits, sizeof( value ) );
+        return value;
+    }
+};
+
+struct DecodeFloat64
+{
+    float operator()( const unsigned char* bytes ) const
+    {
+        const uint64_t bits = read_u32( bytes ) | ( static_cast< uint64_t >( read_u32( bytes + 4 ) ) << 32 );
+        double value;
+        std::memcpy( &value, &bits, sizeof( value ) );
+        return static_cast< float >( value );
+    }
+};
+
+template< typename decode_type >
+void mix_down( const unsigned char* samples, size_t num_frames, size_t num_channels, size_t bytes_per_sample, float* output )
+///
+/// Decodes interleaved samples and averages the channels of each frame.
+///
+{
+    const decode_type decode;
+    const float scale = 1.0f/num_channels;
+    for( size_t frame=0; frame<num_frames; ++frame )
+    {
+        float sum = 0.0f;
+        for( size_t channel=0; channel<num_channels; ++channel, samples+=bytes_per_sample )
+        {
+            sum += decode( samples );
+        }
+        output[frame] = num_channels == 1 ? sum : sum*scale;
+    }
+}
+
+} // namespace
+
+WavFile::WavFile( const std::string& path ) :
+    mMapping( nullptr ),
+    mMappingSize( 0 ),
+    mSamples( nullptr ),
+    mNumFrames( 0 ),
+    mNumChannels( 0 ),
+    mSampleRate( 0 ),
+    mFormat( WAV_FORMAT_INT16 ),
+    mBytesPerSample( 0 )
+///
+/// Constructor. Maps a WAV file and reads its header.
+///
+/// @param path
+///  The path of the file. This throws std::runtime_error if it cannot be opened, or is not a WAV
+///  file in a supported format.
+///
+{
+    const int file = open( path.c_str(), O_RDONLY );
+    if( file < 0 )
+    {
+        throw std::runtime_error( "Could not open '" + path + "': " + std::strerror( errno ) );
+    }
+
+    struct stat info;
+    if( fstat( file, &info ) != 0 || info.st_size == 0 )
+    {
+        close( file );
+        throw std::runtime_error( "Not a WAV file: '" + path + "'" );
+    }
+    mMappingSize = static_cast< size_t >( info.st_size );
+
+    void* mapping = mmap( nullptr, mMappingSize, PROT_READ, MAP_SHARED, file, 0 );
+    close( file );
+    if( mapping == MAP_FAILED )
+    {
+        throw std::runtime_error( "Could not map '" + path + "': " + std::strerror( errno ) );
+    }
+    mMapping = static_cast< const unsigned char* >( mapping );
+
+    try
+    {
+        Parse( path );
+    }
+    catch( ... )
+    {
+        munmap( const_cast< unsigned char* >( mMapping ), mMappingSize );
+        throw;
+    }
+
+    // Samples are usually read from start to end.
+    madvise( const_cast< unsigned char* >( mMapping ), mMappingSize, MADV_SEQUENTIAL );
+}
+
+WavFile::~WavFile()
+///
+/// Destructor. Unmaps the file.
+///
+{
+    munmap( const_cast< unsigned char* >( mMapping ), mMappingSize );
+}
+
+void WavFile::ReadMono( size_t first_frame, size_t num_frames, float* output ) const
+///
+/// Decodes a range of the file's samples to floats in [-1, 1), averaging the channels.
+///
+/// @param first_frame
+///  The first sample of each channel to read.
+///
+/// @param num_frames
+///  The number of samples of each channel to read. first_frame + num_frames may be at most GetNumFrames().
+///
+/// @param output
+///  Memory for num_frames samples.
+///
+{
+    if( first_frame + num_frames > mNumFrames )
+    {
+        throw std::out_of_range( "Samples are beyond the end of the file" );
+    }
+
+    const unsigned char* samples = mSamples + first_frame*mNumChannels*mBytesPerSample;
+    switch( mFormat )
+    {
+        case WAV_FORMAT_INT8: mix_down< DecodeInt8 >( samples, num_frames, mNumChannels, mBytesPerSample, output ); break;
+        case WAV_FORMAT_INT16: mix_down< DecodeInt16 >( samples, num_frames, mNumChannels, mBytesPerSample, output ); break;
+        case WAV_FORMAT_INT24: mix_down< DecodeInt24 >( samples, num_frames, mNumChannels, mBytesPerSample, output ); break;
+        case WAV_FORMAT_INT32: mix_down< DecodeInt32 >( samples, num_frames, mNumChannels, mBytesPerSample, output ); break;
+        case WAV_FORMAT_FLOAT32: mix_down< DecodeFloat32 >( samples, num_frames, mNumChannels, mBytesPerSample, output ); break;
+        case WAV_FORMAT_FLOAT64: mix_down< DecodeFloat64 >( samples, num_frames, mNumChannels, mBytesPerSample, output ); break;
+    }
+}
+
+const float* WavFile::GetFloatSamples() const
+///
+/// Get the samples of a single channel, 32 bit float file directly from the mapping.
+///
+/// @return
+///  A pointer to GetNumFrames() samples, or null if the file must be decoded with ReadMono,
+///  because it has another format, more than one channel, or its samples are not aligned.
+///
+{
+    const bool aligned = reinterpret_cast< uintptr_t >( mSamples )%alignof( float ) == 0;
+    const uint16_t one = 1;
+    const bool little_endian = *reinterpret_cast< const unsigned char* >( &one ) == 1;
+    if( mFormat != WAV_FORMAT_FLOAT32 || mNumChannels != 1 || !aligned || !little_endian )
+    {
+        return nullptr;
+    }
+    return reinterpret_cast< const float* >( mSamples );
+}
+
+const size_t WavFile::GetNumFrames() const
+///
+/// Get the length of the file.
+///
+/// @return
+///  The number of samples in each channel.
+///
+{
+    return mNumFrames;
+}
+
+const size_t WavFile::GetNumChannels() const
+///
+/// Get the number of channels in the file.
+///
+/// @return
+///  The number of channels.
+///
+{
+    return mNumChannels;
+}
+
+const uint32_t WavFile::GetSampleRate() const
+///
+/// Get the sample rate of the file.
+///
+/// @return
+///  The sample rate in Hz.
+///
+{
+    return mSampleRate;
+}
+
+const WavSampleFormat WavFile::GetSampleFormat() const
+///
+/// Get the format in which the samples are stored.
+///
+/// @return
+///  The sample format.
+///
+{
+    return mFormat;
+}
+
+void WavFile::Parse( const std::string& path )
+///
+/// Finds the format and data chunks of the mapped file.
+///
+/// @param path
+///  The path of the file, for errors.
+///
+{
+    const unsigned char* end = mMapping + mMappingSize;
+    if( mMappingSize < 12 || std::memcmp( mMapping, "RIFF", 4 ) != 0 || std::memcmp( mMapping + 8, "WAVE", 4 ) != 0 )
+    {
+        throw std::runtime_error( "Not a WAV file: '" + path + "'" );
+    }
+
+    bool has_format = false;
+    for( const unsigned char* chunk=mMapping+12; chunk+8<=end; )
+    {
+        const uint32_t chunk_size = read_u32( chunk + 4 );
+        const unsigned char* body = chunk + 8;
+        const size_t available = static_cast< size_t >( end - body );
+
+        if( std::memcmp( chunk, "fmt ", 4 ) == 0 )
+        {
+            if( chunk_size < 16 || available < 16 )
+            {
+                throw std::runtime_error( "Corrupt WAV format in '" + path + "'" );
+            }
+            uint16_t format = read_u16( body );
+            mNumChannels = read_u16( body + 2 );
+            mSampleRate = read_u32( body + 4 );
+            const uint16_t bits = read_u16( body + 14 );
+            if( format == WAV_EXTENSIBLE && chunk_size >= 26 && available >= 26 )
+            {
+                format = read_u16( body + 24 );     // The first two bytes of the sub-format GUID.
+            }
+
+            if( format == WAV_PCM && bits == 8 ) mFormat = WAV_FORMAT_INT8;
+            else if( format == WAV_PCM && bits == 16 ) mFormat = WAV_FORMAT_INT16;
+            else if( format == WAV_PCM && bits == 24 ) mFormat = WAV_FORMAT_INT24;
+            else if( format == WAV_PCM && bits == 32 ) mFormat = WAV_FORMAT_INT32;
+            else if( format == WAV_IEEE_FLOAT && bits == 32 ) mFormat = WAV_FORMAT_FLOAT32;
+            else if( format == WAV_IEEE_FLOAT && bits == 64 ) mFormat = WAV_FORMAT_FLOAT64;
+            else throw std::runtime_error( "Unsupported WAV sample format in '" + path + "'" );
+
+            mBytesPerSample = bits/8;
+            if( mNumChannels == 0 )
+            {
+                throw std::runtime_error( "WAV file has no channels: '" + path + "'" );
+            }
+            has_format = true;
+        }
+        else if( std::memcmp( chunk, "data", 4 ) == 0 )
+        {
+            if( !has_format )
+            {
+                throw std::runtime_error( "WAV data comes before its format in '" + path + "'" );
+            }
+
+            // Files still being written may have a size that is zero or too large, so use what is there.
+            const size_t data_size = chunk_size == 0 ? available : std::min< size_t >( chunk_size, available );
+            mSamples = body;
+            mNumFrames = data_size/( mNumChannels*mBytesPerSample );
+            return;
+        }
+
+        // Chunks are padded to an even length.
+        if( available < chunk_size )
+        {
+            break;
+        }
+        chunk = body + chunk_size + ( chunk_size & 1 );
+    }
+
+    throw std::runtime_error( "No WAV data in '" + path + "'" );
+}
@@ -0,0 +1,91 @@
+//
+// Created: 10/18/26 by agent
+//
+// A memory-mapped reader of PCM and floating point WAV files.
+//
+
+#ifndef CUPCAKE_WAV_FILE_H
+#define CUPCAKE_WAV_FILE_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace cupcake
+{
+
+enum WavSampleFormat
+{
+    WAV_FORMAT_INT8,            // Unsigned 8 bit integers.
+    WAV_FORMAT_INT16,
+    WAV_FORMAT_INT24,           // Packed, 3 bytes per sample.
+    WAV_FORMAT_INT32,
+    WAV_FORMAT_FLOAT32,
+    WAV_FORMAT_FLOAT64
+};
+
+class WavFile
+///
+/// Maps a WAV file into memory and reads its samples in place.
+///
+/// Samples are not decoded when the file is opened. Instead, any range of them can be mixed down
+/// to mono floats on demand, so that several threads can each decode just the part of a long file
+/// they are working on. Single channel 32 bit float files need no decoding at all, and their samples
+/// are available directly from the mapping through GetFloatSamples.
+///
+/// Little endian files with PCM (8, 16, 24 or 32 bit) or IEEE float (32 or 64 bit) samples are
+/// supported, including those with a WAVE_FORMAT_EXTENSIBLE header.
+///
+{
+
+public:
+
+    WavFile( const std::string& path );
+    ~WavFile();
+
+    WavFile( const WavFile& ) = delete;
+    WavFile& operator=( const WavFile& ) = delete;
+
+    void ReadMono( size_t first_frame, size_t num_frames, float* output ) const;
+    const float* GetFloatSamples() const;
+
+    const size_t GetNumFrames() const;
+    const size_t GetNumChannels() const;
+    const uint32_t GetSampleRate() const;
+    const WavSampleFormat GetSampleFormat() const;
+
+private:
+
+    //
+    // Mechanics
+    //
+    const unsigned char* mMapping;
+    size_t mMappingSize;
+
+    //
+    // Data
+    //
+    const unsigned char* mSamples;      // The start of the data chunk.
+    size_t mNumFrames;                  // The number of samples per channel.
+    size_t mNumChannels;
+    uint32_t mSampleRate;
+    WavSampleFormat mFormat;
+    size_t mBytesPerSample;
+
+    //
+    // Helpers
+    //
+    void Parse( const std::string& path );
+
+};
+
+} // namespace cupcake
+
+#endif // CUPCAKE_WAV_FILE_H
@@ -0,0 +1,244 @@
+//
+// Created: 10/18/26 by agent
+//
+// A fixed pool of worker threads, each with its own queue of jobs, that steal from each other.
+//
+
+// In module includes
+#include "WorkStealingPool.h"
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <algorithm>
+
+using namespace cupcake;
+
+namespace
+{
+
+// The pool and worker index of the current thread, if it is a worker.
+thread_local const WorkStealingPool* tCurrentPool = nullptr;
+thread_local size_t tCurrentWorker = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool( size_t num_threads ) :
+    mNextQueue( 0 ),
+    mNumQueued( 0 ),
+    mNumPending( 0 ),
+    mStop( false )
+///
+/// Constructor.
+///
+/// @param num_threads
+///  The number of worker threads. Zero uses the number of hardware threads available.
+///
+{
+    if( num_threads == 0 )
+    {
+        num_threads = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+
+    mQueues.reserve( num_threads );
+    for( size_t worker=0; worker<num_threads; ++worker )
+    {
+        mQueues.emplace_back( new WorkerQueue() );
+    }
+
+    mThreads.reserve( num_threads );
+    for( size_t worker=0; worker<num_threads; ++worker )
+    {
+        mThreads.emplace_back( &WorkStealingPool::WorkerLoop, this, worker );
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+///
+/// Destructor. Runs any jobs still queued, then stops and joins all worker threads.
+///
+{
+    Wait();
+
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mStop = true;
+    }
+    mWorkCondition.notify_all();
+
+    for( auto& thread : mThreads )
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Submit( Job job )
+///
+/// Queues a job to be run by one of the workers. This may be called from any thread, including
+/// from within a job.
+///
+/// @param job
+///  The function to run. It is passed the index of the worker running it, which is in
+///  [0, GetNumThreads()). No two jobs run on the same worker at once.
+///
+{
+    const size_t queue = tCurrentPool == this ? tCurrentWorker : mNextQueue.fetch_add( 1 )%mQueues.size();
+
+    // Count the job before it is queued, so the counts never fall below the number of queued jobs.
+    ++mNumPending;
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        ++mNumQueued;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( mQueues[queue]->mutex );
+        mQueues[queue]->jobs.push_back( std::move( job ) );
+    }
+    mWorkCondition.notify_one();
+}
+
+void WorkStealingPool::SubmitRange( size_t num_tasks, RangeJob job )
+///
+/// Queues a range of tasks to be run by the workers. The range is split into one contiguous share
+/// per worker, which is queued on that worker's queue in a single step, so the pool is only locked
+/// once for the whole range. A worker runs its own share in order, and once it is done steals the
+/// tasks furthest from where other workers are up to. This may be called from any thread, including
+/// from within a job.
+///
+/// @param num_tasks
+///  The number of tasks.
+///
+/// @param job
+///  The function to run for each task. It is passed the index of the task, in [0, num_tasks), and
+///  the index of the worker running it, as for Submit.
+///
+{
+    if( num_tasks == 0 )
+    {
+        return;
+    }
+
+    // The tasks share one copy of the function.
+    const std::shared_ptr< const RangeJob > shared_job = std::make_shared< const RangeJob >( std::move( job ) );
+
+    mNumPending += num_tasks;
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mNumQueued += num_tasks;
+    }
+
+    const size_t num_queues = mQueues.size();
+    for( size_t queue=0; queue<num_queues; ++queue )
+    {
+        const size_t first = num_tasks*queue/num_queues;
+        const size_t end = num_tasks*( queue + 1 )/num_queues;
+
+        // A worker takes the newest job on its own queue first, so queue its share last task first.
+        std::lock_guard< std::mutex > lock( mQueues[queue]->mutex );
+        for( size_t task=end; task>first; --task )
+        {
+            mQueues[queue]->jobs.push_back( [shared_job, task]( size_t worker ){ ( *shared_job )( task - 1, worker ); } );
+        }
+    }
+    mWorkCondition.notify_all();
+}
+
+void WorkStealingPool::Wait()
+///
+/// Blocks until every job submitted so far, and every job those jobs submit, has completed.
+/// This must not be called from within a job.
+///
+{
+    std::unique_lock< std::mutex > lock( mMutex );
+    mDoneCondition.wait( lock, [this](){ return mNumPending == 0; } );
+}
+
+const size_t WorkStealingPool::GetNumThreads() const
+///
+/// Get the number of worker threads.
+///
+/// @return
+///  The number of workers.
+///
+{
+    return mThreads.size();
+}
+
+void WorkStealingPool::WorkerLoop( size_t worker )
+///
+/// The body of each worker thread. Runs jobs while there are any queued, and otherwise sleeps
+/// until more are submitted.
+///
+/// @param worker
+///  The index of this worker.
+///
+{
+    tCurrentPool = this;
+    tCurrentWorker = worker;
+
+    while( true )
+    {
+        if( TryRunJob( worker ) )
+        {
+            continue;
+        }
+
+        std::unique_lock< std::mutex > lock( mMutex );
+        mWorkCondition.wait( lock, [this](){ return mStop || mNumQueued > 0; } );
+        if( mStop )
+        {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::TryRunJob( size_t worker )
+///
+/// Runs the newest job on this worker's own queue or, failing that, the oldest job on another
+/// worker's queue.
+///
+/// @param worker
+///  The index of the worker looking for a job.
+///
+/// @return
+///  Whether a job was found and run.
+///
+{
+    Job job;
+    for( size_t offset=0; offset<mQueues.size() && !job; ++offset )
+    {
+        WorkerQueue& queue = *mQueues[( worker + offset )%mQueues.size()];
+        std::lock_guard< std::mutex > lock( queue.mutex );
+        if( queue.jobs.empty() )
+        {
+            continue;
+        }
+        if( offset == 0 )
+        {
+            job = std::move( queue.jobs.back() );
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            job = std::move( queue.jobs.front() );
+            queue.jobs.pop_front();
+        }
+    }
+
+    if( !job )
+    {
+        return false;
+    }
+
+    --mNumQueued;
+    job( worker );
+
+    if( mNumPending.fetch_sub( 1 ) == 1 )
+    {
+        std::lock_guard< std::mutex > lock( mMutex );
+        mDoneCondition.notify_all();
+    }
+    return true;
+}
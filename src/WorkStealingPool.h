@@ -0,0 +1,97 @@
+//
+// Created: 10/18/26 by agent
+//
+// A fixed pool of worker threads, each with its own queue of jobs, that steal from each other.
+//
+
+#ifndef CUPCAKE_WORK_STEALING_POOL_H
+#define CUPCAKE_WORK_STEALING_POOL_H
+
+// In module includes
+// None.
+
+// Thirdparty includes
+// None.
+
+// Std Lib includes
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace cupcake
+{
+
+class WorkStealingPool
+///
+/// A set of worker threads for running many small, independent jobs of uneven size.
+///
+/// Each worker has its own queue. Jobs submitted from outside the pool are spread across the
+/// queues in turn, and jobs submitted by a running job go to the queue of the worker running it.
+/// A range of many jobs is better submitted at once with SubmitRange, which gives each worker a
+/// contiguous share of the range up front, rather than contending on the pool once per job.
+/// A worker runs the newest job on its own queue, which is likely to still be in cache, and when
+/// that is empty it steals the oldest job from another worker. So no worker sits idle while
+/// there is work queued anywhere in the pool, without all workers contending on a single queue.
+///
+/// Unlike ThreadPool, the submitting thread does not take part in running jobs.
+///
+{
+
+public:
+
+    WorkStealingPool( size_t num_threads=0 );
+    ~WorkStealingPool();
+
+    typedef std::function< void( size_t worker ) > Job;
+    typedef std::function< void( size_t task, size_t worker ) > RangeJob;
+
+    void Submit( Job job );
+    void SubmitRange( size_t num_tasks, RangeJob job );
+    void Wait();
+
+    const size_t GetNumThreads() const;
+
+private:
+
+    struct WorkerQueue
+    ///
+    /// The jobs waiting to be run by one worker.
+    ///
+    {
+        std::mutex mutex;
+        std::deque< Job > jobs;
+    };
+
+    //
+    // Mechanics
+    //
+    std::vector< std::unique_ptr< WorkerQueue > > mQueues;
+    std::vector< std::thread > mThreads;
+    std::mutex mMutex;
+    std::condition_variable mWorkCondition;
+    std::condition_variable mDoneCondition;
+
+    //
+    // Data
+    //
+    std::atomic< size_t > mNextQueue;
+    std::atomic< size_t > mNumQueued;
+    std::atomic< size_t > mNumPending;
+    bool mStop;
+
+    //
+    // Helpers
+    //
+    void WorkerLoop( size_t worker );
+    bool TryRunJob( size_t worker );
+
+};
+
+} // namespace cupcake
+
+#endif // CUPCAKE_WORK_STEALING_POOL_H